@@ -0,0 +1,545 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core.h>
+#include <scm/log.h>
+#include <scm/core/math.h>
+#include <scm/core/platform/cpu_features.h>
+#include <scm/core/time/accum_timer.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_core/data_formats.h>
+#include <scm/gl_core/math.h>
+
+#include <scm/gl_util/data/imaging/block_compression.h>
+
+// block compression benchmark
+//  - decodes the output of every format, quality and simd level with an
+//    independent reference decoder and checks its psnr against the source
+//    image, the simd levels have to produce identical blocks
+//  - compares the psnr to reference encoders: the exhaustive (optimal) bc4
+//    endpoint search and a plain bounding box bc1 encoder
+//  - reports the compression time of a large image
+
+namespace {
+
+typedef scm::time::accum_timer<scm::time::high_res_timer>  timer_type;
+
+scm::uint32         bench_image_size;
+scm::uint32         bench_iterations;
+unsigned            bench_seed;
+
+static const std::string    scm_application_name = "schism: block compression benchmark";
+
+// test image: smooth gradients and waves with noise and hard edges, the alpha
+// channel contains transparent (< 128) regions
+void
+fill_test_image(const scm::math::vec2ui& dim, unsigned channels, unsigned seed, std::vector<scm::uint8>& data)
+{
+    boost::mt19937                                                      rand_gen(seed);
+    boost::uniform_int<>                                                rand_dist(-6, 6);
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    noise(rand_gen, rand_dist);
+
+    data.resize(static_cast<scm::size_t>(dim.x) * dim.y * channels);
+
+    for (unsigned y = 0; y < dim.y; ++y) {
+        for (unsigned x = 0; x < dim.x; ++x) {
+            const double fx   = static_cast<double>(x) / dim.x;
+            const double fy   = static_cast<double>(y) / dim.y;
+            const bool   edge = ((x / 24) + (y / 40)) % 3 == 0;
+
+            for (unsigned c = 0; c < channels; ++c) {
+                double v;
+                if (c == 3) {
+                    v = 255.0 * fy + (((x / 16) % 5 == 0) ? -140.0 : 0.0);
+                }
+                else {
+                    v =   100.0
+                        + 70.0 * std::sin(fx * (9.0 + 4.0 * c) + c) * std::cos(fy * (5.0 + 3.0 * c))
+                        + 60.0 * fx * (c == 1 ? -1.0 : 1.0)
+                        + (edge ? 50.0 * (c + 1) - 80.0 : 0.0);
+                }
+                v += noise();
+                data[(static_cast<scm::size_t>(y) * dim.x + x) * channels + c] = static_cast<scm::uint8>(std::max(0.0, std::min(255.0, v)));
+            }
+        }
+    }
+}
+
+// reference decoders /////////////////////////////////////////////////////////////////////////////
+
+int
+round_div(int n, int d)
+{
+    return static_cast<int>(std::floor(static_cast<double>(n) / d + 0.5));
+}
+
+// decodes a bc1 block to rgba
+void
+decode_bc1_reference(const scm::uint8* block, bool four_color_only, scm::uint8* rgba)
+{
+    const unsigned c[2] = { static_cast<unsigned>(block[0] | (block[1] << 8u)),
+                            static_cast<unsigned>(block[2] | (block[3] << 8u)) };
+    int            e[4][4];
+
+    for (int i = 0; i < 2; ++i) {
+        e[i][0] = static_cast<int>(((c[i] >> 11) & 31) * 255.0 / 31.0 + 0.5);
+        e[i][1] = static_cast<int>(((c[i] >>  5) & 63) * 255.0 / 63.0 + 0.5);
+        e[i][2] = static_cast<int>(( c[i]        & 31) * 255.0 / 31.0 + 0.5);
+        e[i][3] = 255;
+    }
+    for (int k = 0; k < 3; ++k) {
+        if (four_color_only || c[0] > c[1]) {
+            e[2][k] = round_div(2 * e[0][k] + e[1][k], 3);
+            e[3][k] = round_div(e[0][k] + 2 * e[1][k], 3);
+        }
+        else {
+            e[2][k] = round_div(e[0][k] + e[1][k], 2);
+            e[3][k] = 0;
+        }
+    }
+    e[2][3] = 255;
+    e[3][3] = (four_color_only || c[0] > c[1]) ? 255 : 0;
+
+    const unsigned indices = block[4] | (block[5] << 8u) | (block[6] << 16u) | (static_cast<unsigned>(block[7]) << 24u);
+    for (int i = 0; i < 16; ++i) {
+        const unsigned idx = (indices >> (2 * i)) & 3;
+        for (int k = 0; k < 4; ++k) {
+            rgba[i * 4 + k] = static_cast<scm::uint8>(e[idx][k]);
+        }
+    }
+}
+
+void
+bc4_palette_reference(int r0, int r1, int* p)
+{
+    p[0] = r0;
+    p[1] = r1;
+    if (r0 > r1) {
+        for (int i = 2; i < 8; ++i) p[i] = round_div((8 - i) * r0 + (i - 1) * r1, 7);
+    }
+    else {
+        for (int i = 2; i < 6; ++i) p[i] = round_div((6 - i) * r0 + (i - 1) * r1, 5);
+        p[6] = 0;
+        p[7] = 255;
+    }
+}
+
+// decodes a bc4 block into every stride-th value
+void
+decode_bc4_reference(const scm::uint8* block, scm::uint8* values, unsigned stride)
+{
+    int p[8];
+    bc4_palette_reference(block[0], block[1], p);
+
+    scm::uint64 indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<scm::uint64>(block[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        values[i * stride] = static_cast<scm::uint8>(p[(indices >> (3 * i)) & 7]);
+    }
+}
+
+// decodes the image to rgba, channels not stored in the format are left 0 (alpha 255)
+void
+decode_image_reference(const scm::math::vec2ui& dim, scm::gl::data_format fmt,
+                       const std::vector<scm::uint8>& blocks, std::vector<scm::uint8>& rgba)
+{
+    using namespace scm::gl;
+
+    const unsigned      bw         = (dim.x + 3) / 4;
+    const unsigned      bh         = (dim.y + 3) / 4;
+    const scm::size_t   block_size = compressed_block_size(fmt);
+
+    rgba.assign(static_cast<scm::size_t>(dim.x) * dim.y * 4, 0);
+
+    for (unsigned by = 0; by < bh; ++by) {
+        for (unsigned bx = 0; bx < bw; ++bx) {
+            const scm::uint8* b = &blocks[(static_cast<scm::size_t>(by) * bw + bx) * block_size];
+            scm::uint8        t[64];
+
+            std::fill(t, t + 64, scm::uint8(0));
+            for (int i = 0; i < 16; ++i) t[i * 4 + 3] = 255;
+
+            switch (fmt) {
+            case FORMAT_BC1_RGBA:   decode_bc1_reference(b, false, t); break;
+            case FORMAT_BC3_RGBA:   decode_bc1_reference(b + 8, true, t); decode_bc4_reference(b, t + 3, 4); break;
+            case FORMAT_BC4_R:      decode_bc4_reference(b, t, 4); break;
+            case FORMAT_BC5_RG:     decode_bc4_reference(b, t, 4); decode_bc4_reference(b + 8, t + 1, 4); break;
+            default:                break;
+            }
+
+            for (unsigned y = 0; y < 4 && by * 4 + y < dim.y; ++y) {
+                for (unsigned x = 0; x < 4 && bx * 4 + x < dim.x; ++x) {
+                    std::memcpy(&rgba[((static_cast<scm::size_t>(by) * 4 + y) * dim.x + bx * 4 + x) * 4], t + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
+
+// psnr of the first channels of the decoded image, texels transparent in the
+// source (alpha < 128) are skipped for 1-bit alpha formats
+double
+image_psnr(const std::vector<scm::uint8>& src, unsigned src_channels,
+           const std::vector<scm::uint8>& rgba, unsigned channels,
+           bool opaque_only = false)
+{
+    scm::size_t texels = 0;
+    double      sse    = 0.0;
+
+    for (scm::size_t i = 0; i < rgba.size() / 4; ++i) {
+        if (opaque_only && src[i * src_channels + 3] < 128) {
+            continue;
+        }
+        ++texels;
+        for (unsigned c = 0; c < channels; ++c) {
+            const double d = static_cast<double>(src[i * src_channels + c]) - rgba[i * 4 + c];
+            sse += d * d;
+        }
+    }
+    if (sse == 0.0) {
+        return (std::numeric_limits<double>::infinity());
+    }
+    return (10.0 * std::log10(255.0 * 255.0 * texels * channels / sse));
+}
+
+// reference encoders /////////////////////////////////////////////////////////////////////////////
+
+// exhaustive search over all endpoint pairs of both modes
+void
+encode_bc4_optimal(const scm::uint8* values, unsigned stride, scm::uint8* block)
+{
+    int         best_err = (std::numeric_limits<int>::max)();
+
+    for (int r0 = 0; r0 < 256; ++r0) {
+        for (int r1 = 0; r1 < 256; ++r1) {
+            int p[8];
+            int err = 0;
+
+            bc4_palette_reference(r0, r1, p);
+
+            scm::uint64 indices = 0;
+            for (int i = 0; i < 16 && err < best_err; ++i) {
+                int d_min = 256;
+                int k_min = 0;
+                for (int k = 0; k < 8; ++k) {
+                    const int d = std::abs(static_cast<int>(values[i * stride]) - p[k]);
+                    if (d < d_min) { d_min = d; k_min = k; }
+                }
+                err     += d_min * d_min;
+                indices |= static_cast<scm::uint64>(k_min) << (3 * i);
+            }
+            if (err < best_err) {
+                best_err = err;
+                block[0] = static_cast<scm::uint8>(r0);
+                block[1] = static_cast<scm::uint8>(r1);
+                for (int i = 0; i < 6; ++i) block[2 + i] = static_cast<scm::uint8>(indices >> (8 * i));
+            }
+        }
+    }
+}
+
+// bounding box endpoints, 4 color mode, nearest palette color
+void
+encode_bc1_bounding_box(const scm::uint8* rgba, scm::uint8* block)
+{
+    int cmin[3] = { 255, 255, 255 };
+    int cmax[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            cmin[c] = std::min(cmin[c], static_cast<int>(rgba[i * 4 + c]));
+            cmax[c] = std::max(cmax[c], static_cast<int>(rgba[i * 4 + c]));
+        }
+    }
+    unsigned e[2];
+    e[0] = ((cmax[0] * 31 + 127) / 255) << 11 | ((cmax[1] * 63 + 127) / 255) << 5 | ((cmax[2] * 31 + 127) / 255);
+    e[1] = ((cmin[0] * 31 + 127) / 255) << 11 | ((cmin[1] * 63 + 127) / 255) << 5 | ((cmin[2] * 31 + 127) / 255);
+
+    block[0] = static_cast<scm::uint8>(e[0]); block[1] = static_cast<scm::uint8>(e[0] >> 8);
+    block[2] = static_cast<scm::uint8>(e[1]); block[3] = static_cast<scm::uint8>(e[1] >> 8);
+
+    // palette color k is the decoded block with all indices k
+    scm::uint8 p[4][64];
+    for (int k = 0; k < 4; ++k) {
+        block[4] = block[5] = block[6] = block[7] = static_cast<scm::uint8>(k * 0x55);
+        decode_bc1_reference(block, false, p[k]);
+    }
+    unsigned indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        int d_min = (std::numeric_limits<int>::max)();
+        for (int k = 0; k < 4; ++k) {
+            int d = 0;
+            for (int c = 0; c < 3; ++c) {
+                const int t = static_cast<int>(rgba[i * 4 + c]) - p[k][c];
+                d += t * t;
+            }
+            if (d < d_min) { d_min = d; indices = (indices & ~(3u << (2 * i))) | (k << (2 * i)); }
+        }
+    }
+    for (int i = 0; i < 4; ++i) block[4 + i] = static_cast<scm::uint8>(indices >> (8 * i));
+}
+
+void
+encode_image_reference(const scm::math::vec2ui& dim, const std::vector<scm::uint8>& src, unsigned channels,
+                       scm::gl::data_format fmt, std::vector<scm::uint8>& blocks)
+{
+    using namespace scm::gl;
+
+    const unsigned      bw         = (dim.x + 3) / 4;
+    const unsigned      bh         = (dim.y + 3) / 4;
+    const scm::size_t   block_size = compressed_block_size(fmt);
+
+    blocks.resize(static_cast<scm::size_t>(bw) * bh * block_size);
+
+    for (unsigned by = 0; by < bh; ++by) {
+        for (unsigned bx = 0; bx < bw; ++bx) {
+            scm::uint8  t[64];
+            scm::uint8* b = &blocks[(static_cast<scm::size_t>(by) * bw + bx) * block_size];
+
+            for (unsigned i = 0; i < 16; ++i) {
+                const unsigned x = std::min(bx * 4 + i % 4, dim.x - 1);
+                const unsigned y = std::min(by * 4 + i / 4, dim.y - 1);
+                t[i * 4] = t[i * 4 + 1] = t[i * 4 + 2] = 0; t[i * 4 + 3] = 255;
+                for (unsigned c = 0; c < channels; ++c) {
+                    t[i * 4 + c] = src[(static_cast<scm::size_t>(y) * dim.x + x) * channels + c];
+                }
+            }
+            switch (fmt) {
+            case FORMAT_BC1_RGBA:   encode_bc1_bounding_box(t, b); break;
+            case FORMAT_BC4_R:      encode_bc4_optimal(t, 4, b); break;
+            case FORMAT_BC5_RG:     encode_bc4_optimal(t, 4, b); encode_bc4_optimal(t + 1, 4, b + 8); break;
+            default:                break;
+            }
+        }
+    }
+}
+
+// verification ///////////////////////////////////////////////////////////////////////////////////
+
+struct format_test
+{
+    const char*             _name;
+    scm::gl::data_format    _src_format;
+    unsigned                _src_channels;
+    scm::gl::data_format    _dst_format;
+    unsigned                _channels;      // compared channels
+    double                  _min_psnr[2];   // fast, normal
+}; // struct format_test
+
+const format_test format_tests[] = {
+    { "BC1 RGB",    scm::gl::FORMAT_RGB_8,  3, scm::gl::FORMAT_BC1_RGBA, 3, { 30.0, 33.0 } },
+    { "BC1 RGBA",   scm::gl::FORMAT_RGBA_8, 4, scm::gl::FORMAT_BC1_RGBA, 3, { 30.0, 33.0 } },
+    { "BC3 RGBA",   scm::gl::FORMAT_RGBA_8, 4, scm::gl::FORMAT_BC3_RGBA, 4, { 32.0, 35.0 } },
+    { "BC4 R",      scm::gl::FORMAT_R_8,    1, scm::gl::FORMAT_BC4_R,    1, { 38.0, 40.0 } },
+    { "BC5 RG",     scm::gl::FORMAT_RG_8,   2, scm::gl::FORMAT_BC5_RG,   2, { 38.0, 40.0 } }
+};
+
+const char* quality_names[] = { "fast", "normal" };
+
+bool
+verify_format(const format_test& ft)
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const vec2ui dims[] = { vec2ui(128, 96), vec2ui(37, 22), vec2ui(1, 5), vec2ui(6, 1) };
+    bool         ok     = true;
+
+    for (int q = 0; q < 2; ++q) {
+        double psnr = 0.0;
+
+        for (scm::size_t d = 0; d < sizeof(dims) / sizeof(vec2ui); ++d) {
+            std::vector<uint8> src;
+            fill_test_image(dims[d], ft._src_channels, bench_seed, src);
+
+            const scm::size_t  blocks_size = ((dims[d].x + 3) / 4) * ((dims[d].y + 3) / 4) * compressed_block_size(ft._dst_format);
+            std::vector<uint8> expected;
+            std::vector<uint8> rgba;
+
+            for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+                std::vector<uint8> blocks(blocks_size);
+                if (!util::compress_image_blocks(dims[d], ft._src_format, &src.front(), ft._dst_format, &blocks.front(),
+                                                 static_cast<util::block_compression_quality>(q), static_cast<cpu_simd_level>(l))) {
+                    ok = false;
+                    continue;
+                }
+                if (expected.empty()) {
+                    expected = blocks;
+                }
+                else if (blocks != expected) {
+                    std::cout << "verify " << ft._name << " " << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                              << ": blocks differ from the scalar encoder (" << dims[d] << ")" << std::endl;
+                    ok = false;
+                }
+            }
+
+            decode_image_reference(dims[d], ft._dst_format, expected, rgba);
+
+            // the 1-bit alpha of bc1 has to be exact
+            if (ft._dst_format == FORMAT_BC1_RGBA && ft._src_channels == 4) {
+                for (scm::size_t i = 0; i < rgba.size() / 4; ++i) {
+                    if ((src[i * 4 + 3] < 128) != (rgba[i * 4 + 3] == 0)) {
+                        std::cout << "verify " << ft._name << ": wrong 1-bit alpha (" << dims[d] << ")" << std::endl;
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+
+            if (d == 0) {
+                psnr = image_psnr(src, ft._src_channels, rgba, ft._channels,
+                                  ft._dst_format == FORMAT_BC1_RGBA && ft._src_channels == 4);
+            }
+        }
+
+        const bool psnr_ok = psnr >= ft._min_psnr[q];
+        ok = ok && psnr_ok;
+
+        std::cout << "verify " << std::setw(10) << std::left << ft._name
+                  << std::setw(8) << quality_names[q]
+                  << "psnr " << std::setw(7) << std::right << psnr << " dB (min " << ft._min_psnr[q] << ") "
+                  << (psnr_ok ? "ok" : "FAILED") << std::endl;
+    }
+
+    // reference encoders on the non transparent formats
+    if (   (ft._dst_format == FORMAT_BC1_RGBA && ft._src_channels == 3)
+        || ft._dst_format == FORMAT_BC4_R
+        || ft._dst_format == FORMAT_BC5_RG) {
+        const vec2ui       dim(32, 32);
+        std::vector<uint8> src;
+        std::vector<uint8> blocks(64 * compressed_block_size(ft._dst_format));
+        std::vector<uint8> ref_blocks;
+        std::vector<uint8> rgba;
+
+        fill_test_image(dim, ft._src_channels, bench_seed, src);
+
+        util::compress_image_blocks(dim, ft._src_format, &src.front(), ft._dst_format, &blocks.front(), util::BLOCK_COMPRESSION_NORMAL,
+                                    cpu_supported_simd_level());
+        decode_image_reference(dim, ft._dst_format, blocks, rgba);
+        const double psnr = image_psnr(src, ft._src_channels, rgba, ft._channels);
+
+        encode_image_reference(dim, src, ft._src_channels, ft._dst_format, ref_blocks);
+        decode_image_reference(dim, ft._dst_format, ref_blocks, rgba);
+        const double ref_psnr = image_psnr(src, ft._src_channels, rgba, ft._channels);
+
+        // within 1 dB of the optimal bc4 encoding, not worse than the bounding box bc1 encoding
+        const double tolerance = (ft._dst_format == FORMAT_BC1_RGBA) ? 0.0 : 1.0;
+        const bool   ref_ok    = psnr >= ref_psnr - tolerance;
+        ok = ok && ref_ok;
+
+        std::cout << "verify " << std::setw(10) << std::left << ft._name
+                  << std::setw(8) << "normal"
+                  << "psnr " << std::setw(7) << std::right << psnr << " dB, reference "
+                  << (ft._dst_format == FORMAT_BC1_RGBA ? "bounding box " : "optimal ") << ref_psnr << " dB "
+                  << (ref_ok ? "ok" : "FAILED") << std::endl;
+    }
+
+    return (ok);
+}
+
+void
+bench_format(const format_test& ft)
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const vec2ui        dim(bench_image_size);
+    std::vector<uint8>  src;
+    std::vector<uint8>  blocks(((dim.x + 3) / 4) * ((dim.y + 3) / 4) * compressed_block_size(ft._dst_format));
+
+    fill_test_image(dim, ft._src_channels, bench_seed, src);
+
+    for (int q = 0; q < 2; ++q) {
+        for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+            timer_type  op_timer;
+            for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+                op_timer.start();
+                util::compress_image_blocks(dim, ft._src_format, &src.front(), ft._dst_format, &blocks.front(),
+                                            static_cast<util::block_compression_quality>(q), static_cast<cpu_simd_level>(l));
+                op_timer.stop();
+            }
+            const double t = time::to_seconds(op_timer.accumulated_duration()) / bench_iterations;
+
+            std::cout << std::setw(10) << std::left << ft._name
+                      << std::setw(8)  << quality_names[q]
+                      << std::setw(10) << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                      << std::setw(8)  << std::right << t * 1000.0 << " ms"
+                      << std::setw(10) << (static_cast<double>(dim.x) * dim.y / (t * 1e6)) << " MTexel/s" << std::endl;
+        }
+    }
+}
+
+} // namespace
+
+static bool initialize_cmd_line(scm::core& c)
+{
+    using boost::program_options::options_description;
+    using boost::program_options::value;
+
+    options_description  cmd_options("program options");
+
+    cmd_options.add_options()
+        ("image-size",      value<scm::uint32>(&bench_image_size)->default_value(2048),                     "benchmark image edge length")
+        ("iterations,i",    value<scm::uint32>(&bench_iterations)->default_value(3),                        "timed runs per format")
+        ("seed",            value<unsigned>(&bench_seed)->default_value(5489u),                             "random seed for the test data");
+
+    c.add_command_line_options(cmd_options, scm_application_name);
+
+    return (true);
+}
+
+static void init_module()
+{
+    scm::module::initializer::add_pre_core_init_function(initialize_cmd_line);
+}
+
+static scm::module::static_initializer  static_initialize(init_module);
+
+int main(int argc, char **argv)
+{
+    // the usual
+    std::ios_base::sync_with_stdio(false);
+    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
+
+    using namespace scm;
+
+    std::cout << "supported simd level: " << cpu_simd_level_string(cpu_supported_simd_level()) << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    // verification ///////////////////////////////////////////////////////////////////////////////
+    bool verified = true;
+
+    for (scm::size_t f = 0; f < sizeof(format_tests) / sizeof(format_test); ++f) {
+        verified = verify_format(format_tests[f]) && verified;
+    }
+
+    // timing /////////////////////////////////////////////////////////////////////////////////////
+    std::cout << "compression of a " << bench_image_size << "^2 image" << std::endl;
+
+    for (scm::size_t f = 0; f < sizeof(format_tests) / sizeof(format_test); ++f) {
+        bench_format(format_tests[f]);
+    }
+
+    return (verified ? 0 : -1);
+}
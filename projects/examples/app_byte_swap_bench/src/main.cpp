@@ -0,0 +1,347 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core.h>
+#include <scm/log.h>
+#include <scm/core/math.h>
+#include <scm/core/platform/byte_swap.h>
+#include <scm/core/platform/cpu_features.h>
+#include <scm/core/time/accum_timer.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_util/data/volume/segy/segy_convert.h>
+
+// byte swapping and ibm float conversion benchmark
+//  - verifies the simd kernels of all supported levels bit exact against the
+//    original per value scalar code (random and special values, optionally
+//    all 2^32 ibm bit patterns)
+//  - reports the throughput of every kernel for all supported simd levels
+
+namespace {
+
+typedef scm::time::accum_timer<scm::time::high_res_timer>  timer_type;
+
+scm::uint32         bench_size_mib;
+scm::uint32         bench_iterations;
+bool                bench_exhaustive;
+unsigned            bench_seed;
+
+static const std::string    scm_application_name = "schism: byte swap benchmark";
+
+// reference implementation: the per value conversion used by volume_reader_segy before
+inline void
+ibm_to_ieee_reference(float* f)
+{
+    int fc;
+    int fmant;
+    int t;
+
+    memcpy(&fc, f, sizeof(int));
+    if (fc) {
+        fmant = 0x00ffffff & fc;
+        t = ((0x7f000000 & fc) >> 22) - 130;
+        if (t <= 0) {
+            fc = 0;
+        } else {
+            while (!(fmant & 0x00800000) && t != -1) {
+                --t;
+                fmant <<= 1;
+            }
+            if (t > 254) {
+                fc = (0x80000000 & fc) | 0x7f7fffff;
+            }
+            else if (t <= 0) {
+                fc = 0;
+            }
+            else {
+                fc = (0x80000000 & fc) | (t << 23) | (0x007fffff & fmant);
+            }
+        }
+        memcpy(f, &fc, sizeof(int));
+    }
+}
+
+void
+swap_bytes_array_ibm_to_ieee_reference(float* d, const float* s, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        float v = s[i];
+        scm::swap_bytes(&v);
+        ibm_to_ieee_reference(&v);
+        d[i] = v;
+    }
+}
+
+template<typename T>
+void
+swap_bytes_array_reference(T* d, const T* s, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        T v = s[i];
+        scm::swap_bytes(&v);
+        d[i] = v;
+    }
+}
+
+void
+swap_2(void* d, const void* s, scm::size_t n, scm::cpu_simd_level l)
+{
+    scm::detail::swap_bytes_array_2(d, s, n / 2, l);
+}
+
+void
+swap_4(void* d, const void* s, scm::size_t n, scm::cpu_simd_level l)
+{
+    scm::detail::swap_bytes_array_4(d, s, n / 4, l);
+}
+
+void
+swap_8(void* d, const void* s, scm::size_t n, scm::cpu_simd_level l)
+{
+    scm::detail::swap_bytes_array_8(d, s, n / 8, l);
+}
+
+void
+ibm_to_ieee(void* d, const void* s, scm::size_t n, scm::cpu_simd_level l)
+{
+    scm::gl::data::swap_bytes_array_ibm_to_ieee(reinterpret_cast<float*>(d), reinterpret_cast<const float*>(s), n / 4, l);
+}
+
+void
+swap_2_reference(void* d, const void* s, scm::size_t n)
+{
+    swap_bytes_array_reference(reinterpret_cast<scm::uint16*>(d), reinterpret_cast<const scm::uint16*>(s), n / 2);
+}
+
+void
+swap_4_reference(void* d, const void* s, scm::size_t n)
+{
+    swap_bytes_array_reference(reinterpret_cast<scm::uint32*>(d), reinterpret_cast<const scm::uint32*>(s), n / 4);
+}
+
+void
+swap_8_reference(void* d, const void* s, scm::size_t n)
+{
+    swap_bytes_array_reference(reinterpret_cast<scm::uint64*>(d), reinterpret_cast<const scm::uint64*>(s), n / 8);
+}
+
+void
+ibm_to_ieee_reference(void* d, const void* s, scm::size_t n)
+{
+    swap_bytes_array_ibm_to_ieee_reference(reinterpret_cast<float*>(d), reinterpret_cast<const float*>(s), n / 4);
+}
+
+typedef void (*kernel_func)(void*, const void*, scm::size_t, scm::cpu_simd_level);
+typedef void (*reference_func)(void*, const void*, scm::size_t);
+
+struct kernel
+{
+    const char*         _name;
+    kernel_func         _func;
+    reference_func      _reference;
+}; // struct kernel
+
+const kernel    kernels[] = {
+    { "swap_2",         swap_2,         swap_2_reference        },
+    { "swap_4",         swap_4,         swap_4_reference        },
+    { "swap_8",         swap_8,         swap_8_reference        },
+    { "ibm_to_ieee",    ibm_to_ieee,    ibm_to_ieee_reference   }
+};
+const scm::size_t kernel_count = sizeof(kernels) / sizeof(kernel);
+
+} // namespace
+
+static bool initialize_cmd_line(scm::core& c)
+{
+    using boost::program_options::options_description;
+    using boost::program_options::value;
+
+    options_description  cmd_options("program options");
+
+    cmd_options.add_options()
+        ("size,s",          value<scm::uint32>(&bench_size_mib)->default_value(256),                        "buffer size (MiB)")
+        ("iterations,i",    value<scm::uint32>(&bench_iterations)->default_value(10),                       "timed runs per kernel")
+        ("exhaustive,e",    value<bool>(&bench_exhaustive)->default_value(false),                           "verify the ibm conversion for all 2^32 bit patterns")
+        ("seed",            value<unsigned>(&bench_seed)->default_value(5489u),                             "random seed for the test data");
+
+    c.add_command_line_options(cmd_options, scm_application_name);
+
+    return (true);
+}
+
+static void init_module()
+{
+    scm::module::initializer::add_pre_core_init_function(initialize_cmd_line);
+}
+
+static scm::module::static_initializer  static_initialize(init_module);
+
+static bool
+verify(const kernel&        k,
+       scm::cpu_simd_level  l,
+       const scm::uint8*    src,
+       scm::size_t          size)
+{
+    // odd sizes and offsets exercise the unaligned heads and scalar tails
+    std::vector<scm::uint8>  result(size + 64);
+    std::vector<scm::uint8>  expected(size + 64);
+
+    for (scm::size_t off = 0; off < 64 && off < size; off += 8) {
+        const scm::size_t n = ((size - off - (off % 24)) / 8) * 8;
+
+        k._func(&result.front() + off, src + off, n, l);
+        k._reference(&expected.front() + off, src + off, n);
+
+        if (memcmp(&result.front() + off, &expected.front() + off, n) != 0) {
+            return (false);
+        }
+
+        // in place
+        memcpy(&result.front() + off, src + off, n);
+        k._func(&result.front() + off, &result.front() + off, n, l);
+
+        if (memcmp(&result.front() + off, &expected.front() + off, n) != 0) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+static bool
+verify_ibm_exhaustive(scm::cpu_simd_level l)
+{
+    const scm::size_t           batch = 1u << 20;
+    std::vector<scm::uint32>    src(batch);
+    std::vector<scm::uint32>    result(batch);
+    std::vector<scm::uint32>    expected(batch);
+
+    for (scm::uint64 b = 0; b < (1ull << 32); b += batch) {
+        for (scm::size_t i = 0; i < batch; ++i) {
+            src[i] = static_cast<scm::uint32>(b + i);
+        }
+        ibm_to_ieee(&result.front(), &src.front(), batch * 4, l);
+        ibm_to_ieee_reference(&expected.front(), &src.front(), batch * 4);
+
+        if (memcmp(&result.front(), &expected.front(), batch * 4) != 0) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+int main(int argc, char **argv)
+{
+    // the usual
+    std::ios_base::sync_with_stdio(false);
+    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
+
+    using namespace scm;
+
+    const cpu_simd_level    max_level   = cpu_supported_simd_level();
+    const scm::size_t       buffer_size = math::max<scm::size_t>(1, bench_size_mib) * 1024 * 1024;
+
+    std::cout << "supported simd level: " << cpu_simd_level_string(max_level) << std::endl;
+
+    // test data: random values mixed with ibm special values (zeros, denormal
+    // fractions, exponent extremes)
+    std::vector<scm::uint8> src(buffer_size);
+    std::vector<scm::uint8> dst(buffer_size);
+    {
+        boost::mt19937                                                      rand_gen(bench_seed);
+        boost::uniform_int<>                                                rand_dist(0, 255);
+        boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    die(rand_gen, rand_dist);
+
+        for (scm::size_t i = 0; i < buffer_size; ++i) {
+            src[i] = static_cast<scm::uint8>(die());
+        }
+
+        const scm::uint32 special_values[] = { 0x00000000u, 0x80000000u, 0x00000001u, 0x00800000u,
+                                               0x7fffffffu, 0xffffffffu, 0x41100000u, 0xc1100000u,
+                                               0x21000001u, 0x20ffffffu, 0x60000001u, 0x61ffffffu,
+                                               0x5f800000u, 0x00ffffffu, 0x7f000000u, 0x40000000u };
+        const scm::size_t  special_count    = sizeof(special_values) / sizeof(scm::uint32);
+
+        for (scm::size_t i = 0; i < special_count && (i + 1) * 4 <= buffer_size; ++i) {
+            scm::uint32 v = special_values[i];
+            swap_bytes(&v);
+            memcpy(&src[i * 4], &v, 4);
+        }
+    }
+
+    // verification ///////////////////////////////////////////////////////////////////////////////
+    bool verified = true;
+
+    for (int l = CPU_SIMD_NONE; l <= max_level; ++l) {
+        for (scm::size_t k = 0; k < kernel_count; ++k) {
+            const scm::size_t verify_size = math::min<scm::size_t>(buffer_size, 4 * 1024 * 1024 + 13);
+            const bool        ok          = verify(kernels[k], static_cast<cpu_simd_level>(l), &src.front(), verify_size);
+
+            std::cout << "verify " << std::setw(12) << std::left << kernels[k]._name
+                      << std::setw(8) << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                      << (ok ? "ok" : "MISMATCH") << std::endl;
+            verified = verified && ok;
+        }
+        if (bench_exhaustive) {
+            const bool ok = verify_ibm_exhaustive(static_cast<cpu_simd_level>(l));
+
+            std::cout << "verify " << std::setw(12) << std::left << "ibm (2^32)"
+                      << std::setw(8) << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                      << (ok ? "ok" : "MISMATCH") << std::endl;
+            verified = verified && ok;
+        }
+    }
+
+    // throughput /////////////////////////////////////////////////////////////////////////////////
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (scm::size_t k = 0; k < kernel_count; ++k) {
+        timer_type  op_timer;
+
+        kernels[k]._reference(&dst.front(), &src.front(), buffer_size);
+        for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+            op_timer.start();
+            kernels[k]._reference(&dst.front(), &src.front(), buffer_size);
+            op_timer.stop();
+        }
+        const double ref_time = time::to_seconds(op_timer.accumulated_duration());
+
+        std::cout << std::setw(12) << std::left << kernels[k]._name
+                  << std::setw(10) << "reference"
+                  << std::setw(8)  << std::right << (static_cast<double>(buffer_size) * bench_iterations) / (ref_time * 1e9) << " GB/s" << std::endl;
+
+        for (int l = CPU_SIMD_NONE; l <= max_level; ++l) {
+            op_timer.reset();
+
+            kernels[k]._func(&dst.front(), &src.front(), buffer_size, static_cast<cpu_simd_level>(l));
+            for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+                op_timer.start();
+                kernels[k]._func(&dst.front(), &src.front(), buffer_size, static_cast<cpu_simd_level>(l));
+                op_timer.stop();
+            }
+            const double t = time::to_seconds(op_timer.accumulated_duration());
+
+            std::cout << std::setw(12) << std::left << kernels[k]._name
+                      << std::setw(10) << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                      << std::setw(8)  << std::right << (static_cast<double>(buffer_size) * bench_iterations) / (t * 1e9) << " GB/s"
+                      << "  (x" << ref_time / t << ")" << std::endl;
+        }
+    }
+
+    return (verified ? 0 : -1);
+}
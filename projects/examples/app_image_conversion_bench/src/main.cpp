@@ -0,0 +1,625 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core.h>
+#include <scm/log.h>
+#include <scm/core/math.h>
+#include <scm/core/memory.h>
+#include <scm/core/platform/cpu_features.h>
+#include <scm/core/time/accum_timer.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_core/data_formats.h>
+#include <scm/gl_core/math.h>
+
+#include <scm/gl_util/data/imaging/image_conversion.h>
+#include <scm/gl_util/data/imaging/texture_data_util.h>
+
+// image conversion benchmark
+//  - checks the component conversions against exact references (exhaustive
+//    for the integer sources), every format pair of convert_image_format
+//    against a per pixel reference and all simd levels for identical output
+//  - checks the red/blue swap, the channel scaling and the vertical flip of
+//    uncompressed and block compressed images
+//  - reports the times for a large image, the flip is compared to a row
+//    exchange through a temporary allocated for every row pair
+
+namespace {
+
+typedef scm::time::accum_timer<scm::time::high_res_timer>  timer_type;
+
+scm::uint32         bench_image_size;
+scm::uint32         bench_iterations;
+unsigned            bench_seed;
+
+static const std::string    scm_application_name = "schism: image conversion benchmark";
+
+const scm::gl::data_format  conversion_formats[] = {
+    scm::gl::FORMAT_R_8,    scm::gl::FORMAT_RG_8,    scm::gl::FORMAT_RGB_8,    scm::gl::FORMAT_RGBA_8,
+    scm::gl::FORMAT_BGR_8,  scm::gl::FORMAT_BGRA_8,
+    scm::gl::FORMAT_R_16,   scm::gl::FORMAT_RG_16,   scm::gl::FORMAT_RGB_16,   scm::gl::FORMAT_RGBA_16,
+    scm::gl::FORMAT_R_32F,  scm::gl::FORMAT_RG_32F,  scm::gl::FORMAT_RGB_32F,  scm::gl::FORMAT_RGBA_32F
+};
+const scm::size_t           conversion_format_count = sizeof(conversion_formats) / sizeof(scm::gl::data_format);
+
+bool
+is_bgr(scm::gl::data_format fmt)
+{
+    return fmt == scm::gl::FORMAT_BGR_8 || fmt == scm::gl::FORMAT_BGRA_8;
+}
+
+// normalized value of component c (in memory order) of pixel p
+double
+read_component(scm::gl::data_format fmt, const std::vector<scm::uint8>& data, scm::size_t p, unsigned c)
+{
+    using namespace scm::gl;
+
+    const scm::size_t i = p * channel_count(fmt) + c;
+    switch (size_of_channel(fmt)) {
+        case 1:  return data[i] / 255.0;
+        case 2:  return reinterpret_cast<const scm::uint16*>(&data.front())[i] / 65535.0;
+        default: return reinterpret_cast<const float*>(&data.front())[i];
+    }
+}
+
+// normalized value of the named channel n (0 = red, ..., 3 = alpha)
+double
+read_channel(scm::gl::data_format fmt, const std::vector<scm::uint8>& data, scm::size_t p, unsigned n)
+{
+    const unsigned channels = scm::gl::channel_count(fmt);
+
+    if (n == 3 && channels < 4) {
+        return 1.0;
+    }
+    if (n >= channels) {
+        return 0.0;
+    }
+    return read_component(fmt, data, p, (is_bgr(fmt) && n < 3) ? 2 - n : n);
+}
+
+// expected value of channel n of pixel p after conversion to dst_fmt, integer
+// results in the value range of dst_fmt
+double
+expected_channel(scm::gl::data_format src_fmt, const std::vector<scm::uint8>& src, scm::size_t p, unsigned n,
+                 scm::gl::data_format dst_fmt)
+{
+    double v = read_channel(src_fmt, src, p, n);
+
+    switch (scm::gl::size_of_channel(dst_fmt)) {
+        case 1:  v = std::max(0.0, std::min(1.0, v)); return std::floor(v * 255.0   + 0.5);
+        case 2:  v = std::max(0.0, std::min(1.0, v)); return std::floor(v * 65535.0 + 0.5);
+        default: return static_cast<float>(v);
+    }
+}
+
+double
+stored_channel(scm::gl::data_format fmt, const std::vector<scm::uint8>& data, scm::size_t p, unsigned c)
+{
+    switch (scm::gl::size_of_channel(fmt)) {
+        case 1:  return read_component(fmt, data, p, c) * 255.0;
+        case 2:  return read_component(fmt, data, p, c) * 65535.0;
+        default: return read_component(fmt, data, p, c);
+    }
+}
+
+// test image: gradients and noise, float images include values outside [0, 1]
+void
+fill_test_image(const scm::math::vec2ui& dim, scm::gl::data_format fmt, scm::size_t pitch, unsigned seed,
+                std::vector<scm::uint8>& data)
+{
+    using namespace scm;
+
+    boost::mt19937                                                      rand_gen(seed);
+    boost::uniform_int<>                                                rand_dist(0, 65535);
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    noise(rand_gen, rand_dist);
+
+    const unsigned      channels = gl::channel_count(fmt);
+    const unsigned      csize    = gl::size_of_channel(fmt);
+
+    data.assign(pitch * dim.y, 0xcd);
+
+    for (unsigned y = 0; y < dim.y; ++y) {
+        uint8* row = &data[y * pitch];
+        for (unsigned i = 0; i < dim.x * channels; ++i) {
+            const int r = noise();
+            switch (csize) {
+                case 1: row[i] = static_cast<uint8>(r >> 8); break;
+                case 2: reinterpret_cast<uint16*>(row)[i] = static_cast<uint16>(r); break;
+                default: {
+                    // mostly in [0, 1], some out of range values
+                    const float f = static_cast<float>(r % 1200 - 100) / 1000.0f;
+                    memcpy(row + i * 4, &f, 4);
+                }
+            }
+        }
+    }
+}
+
+bool
+verify_components()
+{
+    using namespace scm;
+    using namespace scm::gl;
+
+    bool ok = true;
+
+    std::vector<uint16> all16(65536);
+    std::vector<uint8>  all8(256);
+    for (unsigned v = 0; v < 65536; ++v) all16[v] = static_cast<uint16>(v);
+    for (unsigned v = 0; v < 256;   ++v) all8[v]  = static_cast<uint8>(v);
+
+    // floats: exact grid values, ties, out of range and nan
+    std::vector<float>  floats;
+    for (unsigned v = 0; v < 256; ++v)   floats.push_back(v / 255.0f);
+    for (unsigned v = 0; v < 4096; ++v)  floats.push_back(static_cast<float>(v) / 4095.0f);
+    floats.push_back(-1.0f);
+    floats.push_back(2.0f);
+    floats.push_back(std::numeric_limits<float>::quiet_NaN());
+    floats.push_back(-std::numeric_limits<float>::infinity());
+    floats.push_back(std::numeric_limits<float>::infinity());
+
+    for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+        const cpu_simd_level    lev = static_cast<cpu_simd_level>(l);
+        const std::string       lname(cpu_simd_level_string(lev));
+
+        std::vector<uint8>  d8(65536);
+        std::vector<uint16> d16(65536);
+        std::vector<float>  df(65536);
+
+        util::detail::convert_components(&all16.front(), &d8.front(), all16.size(), lev);
+        for (unsigned v = 0; v < 65536; ++v) {
+            if (d8[v] != static_cast<uint8>(std::floor(v / 257.0 + 0.5))) {
+                std::cout << "verify uint16 -> uint8 " << lname << ": wrong result for " << v << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        util::detail::convert_components(&all8.front(), &d16.front(), all8.size(), lev);
+        for (unsigned v = 0; v < 256; ++v) {
+            if (d16[v] != v * 257) {
+                std::cout << "verify uint8 -> uint16 " << lname << ": wrong result for " << v << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        util::detail::convert_components(&all8.front(), &df.front(), all8.size(), lev);
+        for (unsigned v = 0; v < 256; ++v) {
+            if (df[v] != static_cast<float>(v) / 255.0f) {
+                std::cout << "verify uint8 -> float " << lname << ": wrong result for " << v << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        util::detail::convert_components(&all16.front(), &df.front(), all16.size(), lev);
+        for (unsigned v = 0; v < 65536; ++v) {
+            if (df[v] != static_cast<float>(v) / 65535.0f) {
+                std::cout << "verify uint16 -> float " << lname << ": wrong result for " << v << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        util::detail::convert_components(&floats.front(), &d8.front(), floats.size(), lev);
+        util::detail::convert_components(&floats.front(), &d16.front(), floats.size(), lev);
+        for (unsigned v = 0; v < floats.size(); ++v) {
+            const float     f   = (floats[v] == floats[v]) ? std::max(0.0f, std::min(1.0f, floats[v])) : 0.0f;
+            const double    e8  = std::floor(f * 255.0   + 0.5);
+            const double    e16 = std::floor(f * 65535.0 + 0.5);
+            if (std::abs(d8[v] - e8) > (v < 256 ? 0.0 : 1.0) || std::abs(d16[v] - e16) > 1.0) {
+                std::cout << "verify float -> uint8/16 " << lname << ": wrong result for " << floats[v] << std::endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    std::cout << "verify component conversions " << (ok ? "ok" : "FAILED") << std::endl;
+
+    return (ok);
+}
+
+bool
+verify_conversions()
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    // odd sizes exercise the scalar tails, the source rows are padded
+    const vec2ui    dims[] = { vec2ui(1, 1), vec2ui(37, 13), vec2ui(64, 5), vec2ui(333, 3) };
+    bool            ok     = true;
+
+    for (scm::size_t sf = 0; sf < conversion_format_count; ++sf) {
+        for (scm::size_t df = 0; df < conversion_format_count; ++df) {
+            const data_format   src_fmt = conversion_formats[sf];
+            const data_format   dst_fmt = conversion_formats[df];
+            bool                pair_ok = true;
+
+            for (scm::size_t d = 0; d < sizeof(dims) / sizeof(vec2ui); ++d) {
+                const scm::size_t   pitch = dims[d].x * size_of_format(src_fmt) + 5;
+                const scm::size_t   texels = static_cast<scm::size_t>(dims[d].x) * dims[d].y;
+                std::vector<uint8>  src;
+                std::vector<uint8>  tight;
+                std::vector<uint8>  expected;
+
+                fill_test_image(dims[d], src_fmt, pitch, bench_seed + static_cast<unsigned>(d), src);
+
+                tight.resize(texels * size_of_format(src_fmt));
+                for (unsigned y = 0; y < dims[d].y; ++y) {
+                    memcpy(&tight[y * dims[d].x * size_of_format(src_fmt)], &src[y * pitch], dims[d].x * size_of_format(src_fmt));
+                }
+
+                for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+                    std::vector<uint8> dst(texels * size_of_format(dst_fmt) + 16, 0xab);
+
+                    util::convert_image_format(dims[d], src_fmt, &src.front(), pitch, dst_fmt, &dst.front(),
+                                               static_cast<cpu_simd_level>(l));
+
+                    if (!std::equal(dst.end() - 16, dst.end(), std::vector<uint8>(16, 0xab).begin())) {
+                        std::cout << "verify " << format_string(src_fmt) << " -> " << format_string(dst_fmt)
+                                  << ": write past the end of the image (" << dims[d] << ")" << std::endl;
+                        pair_ok = false;
+                    }
+                    dst.resize(dst.size() - 16);
+
+                    if (expected.empty()) {
+                        expected = dst;
+                    }
+                    else if (dst != expected) {
+                        std::cout << "verify " << format_string(src_fmt) << " -> " << format_string(dst_fmt) << " "
+                                  << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                                  << ": output differs from the scalar conversion (" << dims[d] << ")" << std::endl;
+                        pair_ok = false;
+                    }
+                }
+
+                // float sources may round differently at exact ties
+                const double tolerance = (size_of_channel(src_fmt) == 4 && size_of_channel(dst_fmt) != 4) ? 1.0 : 1e-6;
+                const unsigned dst_channels = channel_count(dst_fmt);
+
+                for (scm::size_t p = 0; p < texels && pair_ok; ++p) {
+                    for (unsigned c = 0; c < dst_channels; ++c) {
+                        const unsigned n = (is_bgr(dst_fmt) && c < 3) ? 2 - c : c;
+                        const double   e = expected_channel(src_fmt, tight, p, n, dst_fmt);
+                        const double   v = stored_channel(dst_fmt, expected, p, c);
+                        if (std::abs(e - v) > tolerance) {
+                            std::cout << "verify " << format_string(src_fmt) << " -> " << format_string(dst_fmt)
+                                      << ": wrong value at texel " << p << " channel " << c
+                                      << " (" << v << ", expected " << e << ")" << std::endl;
+                            pair_ok = false;
+                            break;
+                        }
+                    }
+                }
+            }
+            ok = ok && pair_ok;
+        }
+    }
+
+    std::cout << "verify format conversions (" << conversion_format_count * conversion_format_count << " pairs) "
+              << (ok ? "ok" : "FAILED") << std::endl;
+
+    return (ok);
+}
+
+bool
+verify_in_place()
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const vec2ui    dim(77, 9);
+    const vec4f     scale(0.5f, 1.0f, 0.25f, 3.0f);
+    bool            ok = true;
+
+    for (scm::size_t f = 0; f < conversion_format_count; ++f) {
+        const data_format   fmt       = conversion_formats[f];
+        const unsigned      channels  = channel_count(fmt);
+        const scm::size_t   texels    = static_cast<scm::size_t>(dim.x) * dim.y;
+        const scm::size_t   row_bytes = dim.x * size_of_format(fmt);
+        std::vector<uint8>  src;
+
+        fill_test_image(dim, fmt, row_bytes, bench_seed, src);
+
+        std::vector<uint8>  swapped;
+        std::vector<uint8>  scaled;
+        std::vector<uint8>  flipped;
+
+        for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+            const cpu_simd_level lev = static_cast<cpu_simd_level>(l);
+
+            std::vector<uint8> s(src);
+            if (channels >= 3) {
+                util::swap_red_blue_channels(dim, fmt, &s.front(), lev);
+                if (swapped.empty()) swapped = s;
+                ok = ok && s == swapped;
+            }
+
+            s = src;
+            util::scale_image_channels(dim, fmt, &s.front(), scale, lev);
+            if (scaled.empty()) scaled = s;
+            ok = ok && s == scaled;
+
+            s = src;
+            util::flip_rows(&s.front(), row_bytes, dim.y, lev);
+            if (flipped.empty()) flipped = s;
+            ok = ok && s == flipped;
+        }
+
+        for (scm::size_t p = 0; p < texels; ++p) {
+            for (unsigned c = 0; c < channels; ++c) {
+                const unsigned  n  = (is_bgr(fmt) && c < 3) ? 2 - c : c;
+                const unsigned  sc = (channels >= 3 && (c == 0 || c == 2)) ? 2 - c : c;
+                const double    v  = stored_channel(fmt, src, p, c);
+
+                // red/blue swap
+                if (channels >= 3 && stored_channel(fmt, swapped, p, c) != stored_channel(fmt, src, p, sc)) {
+                    ok = false;
+                }
+
+                // scaling, integer results clamped and truncated
+                double e = v * scale[n];
+                if (size_of_channel(fmt) == 1) e = std::floor(std::min(255.0,   std::max(0.0, e)));
+                if (size_of_channel(fmt) == 2) e = std::floor(std::min(65535.0, std::max(0.0, e)));
+                if (std::abs(stored_channel(fmt, scaled, p, c) - e) > 1e-4 * std::max(1.0, std::abs(e))) {
+                    ok = false;
+                }
+
+                // vertical flip
+                const scm::size_t fp = (dim.y - 1 - p / dim.x) * dim.x + p % dim.x;
+                if (stored_channel(fmt, flipped, fp, c) != v) {
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    std::cout << "verify red/blue swap, channel scaling, row flip " << (ok ? "ok" : "FAILED") << std::endl;
+
+    return (ok);
+}
+
+// the 16 3bit indices of a bc4 block (row major)
+void
+bc4_indices(const scm::uint8* block, unsigned* indices)
+{
+    scm::uint64 bits = 0;
+    for (int i = 0; i < 6; ++i) {
+        bits |= static_cast<scm::uint64>(block[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        indices[i] = static_cast<unsigned>((bits >> (3 * i)) & 7);
+    }
+}
+
+bool
+verify_block_flip()
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const data_format   formats[] = { FORMAT_BC1_RGBA, FORMAT_BC3_RGBA, FORMAT_BC4_R, FORMAT_BC5_RG };
+    const vec2ui        dims[]    = { vec2ui(16, 16), vec2ui(20, 12), vec2ui(8, 2) };
+    bool                ok        = true;
+
+    boost::mt19937                                                      rand_gen(bench_seed);
+    boost::uniform_int<>                                                rand_dist(0, 255);
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    noise(rand_gen, rand_dist);
+
+    for (scm::size_t f = 0; f < sizeof(formats) / sizeof(data_format); ++f) {
+        for (scm::size_t d = 0; d < sizeof(dims) / sizeof(vec2ui); ++d) {
+            const unsigned      bw    = (dims[d].x + 3) / 4;
+            const unsigned      bh    = (dims[d].y + 3) / 4;
+            const unsigned      bs    = compressed_block_size(formats[f]);
+            const scm::size_t   bytes = static_cast<scm::size_t>(bw) * bh * bs;
+
+            shared_array<uint8> data(new uint8[bytes]);
+            for (scm::size_t i = 0; i < bytes; ++i) {
+                data[i] = static_cast<uint8>(noise());
+            }
+            const std::vector<uint8> src(data.get(), data.get() + bytes);
+
+            // flipping twice restores the image, every byte of every block
+            util::image_flip_vertical(data, formats[f], dims[d].x, dims[d].y);
+            const std::vector<uint8> once(data.get(), data.get() + bytes);
+            util::image_flip_vertical(data, formats[f], dims[d].x, dims[d].y);
+
+            if (!std::equal(src.begin(), src.end(), data.get())) {
+                std::cout << "verify flip " << format_string(formats[f]) << ": flipping twice changes the image ("
+                          << dims[d] << ")" << std::endl;
+                ok = false;
+            }
+
+            // the index rows of the bc4 blocks are reversed and the blocks move
+            // to the mirrored block row, the endpoints are unchanged
+            if (formats[f] == FORMAT_BC4_R) {
+                for (unsigned by = 0; by < bh; ++by) {
+                    for (unsigned bx = 0; bx < bw; ++bx) {
+                        const uint8* s = &src[(by * bw + bx) * bs];
+                        const uint8* o = &once[((bh - 1 - by) * bw + bx) * bs];
+                        unsigned     si[16];
+                        unsigned     oi[16];
+
+                        bc4_indices(s, si);
+                        bc4_indices(o, oi);
+
+                        bool block_ok = s[0] == o[0] && s[1] == o[1];
+                        for (int i = 0; i < 16; ++i) {
+                            block_ok = block_ok && oi[i] == si[(3 - i / 4) * 4 + i % 4];
+                        }
+                        if (!block_ok) {
+                            std::cout << "verify flip " << format_string(formats[f]) << ": wrong block (" << bx << ", " << by
+                                      << ", " << dims[d] << ")" << std::endl;
+                            ok = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "verify block compressed flip " << (ok ? "ok" : "FAILED") << std::endl;
+
+    return (ok);
+}
+
+// timing /////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename operation>
+double
+time_operation(const operation& op)
+{
+    timer_type op_timer;
+    for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+        op_timer.start();
+        op();
+        op_timer.stop();
+    }
+    return scm::time::to_seconds(op_timer.accumulated_duration()) / bench_iterations;
+}
+
+void
+report(const std::string& name, scm::cpu_simd_level l, double t, scm::size_t bytes)
+{
+    std::cout << std::setw(24) << std::left << name
+              << std::setw(10) << scm::cpu_simd_level_string(l)
+              << std::setw(8)  << std::right << t * 1000.0 << " ms"
+              << std::setw(10) << (bytes / (t * 1e9)) << " GB/s" << std::endl;
+}
+
+// a temporary allocated for every exchanged row pair
+void
+flip_rows_allocating(scm::uint8* data, scm::size_t row_bytes, scm::size_t rows)
+{
+    for (scm::size_t r = 0; r < rows / 2; ++r) {
+        scm::uint8* a   = data + r * row_bytes;
+        scm::uint8* b   = data + (rows - (r + 1)) * row_bytes;
+        scm::uint8* tmp = static_cast<scm::uint8*>(malloc(row_bytes));
+        memcpy(tmp, a, row_bytes);
+        memcpy(a, b, row_bytes);
+        memcpy(b, tmp, row_bytes);
+        free(tmp);
+    }
+}
+
+void
+bench_conversions()
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const vec2ui        dim(bench_image_size);
+    const scm::size_t   texels = static_cast<scm::size_t>(dim.x) * dim.y;
+
+    std::vector<uint8>  rgba8;
+    std::vector<uint8>  bgr8;
+    std::vector<uint8>  rgba32f;
+    std::vector<uint8>  dst(texels * 16);
+
+    fill_test_image(dim, FORMAT_RGBA_8,    dim.x * 4,  bench_seed, rgba8);
+    fill_test_image(dim, FORMAT_BGR_8,     dim.x * 3,  bench_seed, bgr8);
+    fill_test_image(dim, FORMAT_RGBA_32F,  dim.x * 16, bench_seed, rgba32f);
+
+    std::cout << "rgba8 flip (allocating)" << std::endl;
+    report("flip rgba8 allocating", CPU_SIMD_NONE,
+           time_operation([&]() { flip_rows_allocating(&rgba8.front(), dim.x * 4, dim.y); }), rgba8.size() * 2);
+
+    for (int i = CPU_SIMD_NONE; i <= cpu_supported_simd_level(); ++i) {
+        const cpu_simd_level l = static_cast<cpu_simd_level>(i);
+
+        report("flip rgba8", l,
+               time_operation([&]() { util::flip_rows(&rgba8.front(), dim.x * 4, dim.y, l); }), rgba8.size() * 2);
+        report("swap red/blue rgba8", l,
+               time_operation([&]() { util::swap_red_blue_channels(dim, FORMAT_RGBA_8, &rgba8.front(), l); }), rgba8.size() * 2);
+        report("swap red/blue bgr8", l,
+               time_operation([&]() { util::swap_red_blue_channels(dim, FORMAT_BGR_8, &bgr8.front(), l); }), bgr8.size() * 2);
+        report("bgr8 -> rgba8", l,
+               time_operation([&]() { util::convert_image_format(dim, FORMAT_BGR_8, &bgr8.front(), 0, FORMAT_RGBA_8, &dst.front(), l); }),
+               texels * 7);
+        report("rgba8 -> rgb8", l,
+               time_operation([&]() { util::convert_image_format(dim, FORMAT_RGBA_8, &rgba8.front(), 0, FORMAT_RGB_8, &dst.front(), l); }),
+               texels * 7);
+        report("rgba8 -> rgba32f", l,
+               time_operation([&]() { util::convert_image_format(dim, FORMAT_RGBA_8, &rgba8.front(), 0, FORMAT_RGBA_32F, &dst.front(), l); }),
+               texels * 20);
+        report("rgba32f -> rgba8", l,
+               time_operation([&]() { util::convert_image_format(dim, FORMAT_RGBA_32F, &rgba32f.front(), 0, FORMAT_RGBA_8, &dst.front(), l); }),
+               texels * 20);
+        report("scale rgba8", l,
+               time_operation([&]() { util::scale_image_channels(dim, FORMAT_RGBA_8, &rgba8.front(), vec4f(1.0f, 0.5f, 1.0f, 1.0f), l); }),
+               rgba8.size() * 2);
+    }
+}
+
+} // namespace
+
+static bool initialize_cmd_line(scm::core& c)
+{
+    using boost::program_options::options_description;
+    using boost::program_options::value;
+
+    options_description  cmd_options("program options");
+
+    cmd_options.add_options()
+        ("image-size",      value<scm::uint32>(&bench_image_size)->default_value(4096),                     "benchmark image edge length")
+        ("iterations,i",    value<scm::uint32>(&bench_iterations)->default_value(5),                        "timed runs per operation")
+        ("seed",            value<unsigned>(&bench_seed)->default_value(5489u),                             "random seed for the test data");
+
+    c.add_command_line_options(cmd_options, scm_application_name);
+
+    return (true);
+}
+
+static void init_module()
+{
+    scm::module::initializer::add_pre_core_init_function(initialize_cmd_line);
+}
+
+static scm::module::static_initializer  static_initialize(init_module);
+
+int main(int argc, char **argv)
+{
+    // the usual
+    std::ios_base::sync_with_stdio(false);
+    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
+
+    using namespace scm;
+
+    std::cout << "supported simd level: " << cpu_simd_level_string(cpu_supported_simd_level()) << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    // verification ///////////////////////////////////////////////////////////////////////////////
+    bool verified = true;
+
+    verified = verify_components()  && verified;
+    verified = verify_conversions() && verified;
+    verified = verify_in_place()    && verified;
+    verified = verify_block_flip()  && verified;
+
+    // timing /////////////////////////////////////////////////////////////////////////////////////
+    std::cout << "operations on a " << bench_image_size << "^2 image" << std::endl;
+
+    bench_conversions();
+
+    return (verified ? 0 : -1);
+}
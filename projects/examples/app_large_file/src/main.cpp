@@ -3,144 +3,371 @@
 // Distributed under the Modified BSD License, see license.txt.
 
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <string>
 #include <vector>
 
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <boost/program_options.hpp>
 #include <boost/random/mersenne_twister.hpp>
+#include <boost/random/random_number_generator.hpp>
 #include <boost/random/uniform_int.hpp>
 #include <boost/random/variate_generator.hpp>
+#include <boost/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
 
 #include <scm/core.h>
 #include <scm/log.h>
+#include <scm/core/math.h>
 #include <scm/core/pointer_types.h>
 #include <scm/core/io/file.h>
 #include <scm/core/time/accum_timer.h>
 #include <scm/core/time/high_res_timer.h>
 
+// storage benchmark
+//  - sequential/random reads or writes of fixed size blocks over a test file
+//  - every block operation is timed, the results are reported as json:
+//    throughput, iops and latency percentiles
+//  - the queue depth is the number of asynchronous requests each thread keeps
+//    in flight for unbuffered io (a block is split into queue_depth requests)
 
-int main(int argc, char **argv)
+namespace {
+
+typedef scm::time::accum_timer<scm::time::high_res_timer>  timer_type;
+
+std::string         bench_file_name;
+std::string         bench_mode;
+std::string         bench_access;
+std::string         bench_output;
+scm::uint32         bench_block_size_kib;
+scm::uint32         bench_file_size_mib;
+scm::uint32         bench_queue_depth;
+scm::uint32         bench_threads;
+bool                bench_direct_io;
+unsigned            bench_seed;
+
+struct thread_result
 {
-    // the usual
-    std::ios_base::sync_with_stdio(false);
-    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
+    thread_result() : _bytes(0), _errors(0) {}
+
+    std::vector<double>         _latencies;     // microseconds
+    scm::int64                  _bytes;
+    scm::int64                  _errors;
+}; // struct thread_result
+
+static const std::string    scm_application_name = "schism: storage benchmark";
+
+} // namespace
+
+static bool initialize_cmd_line(scm::core& c)
+{
+    using boost::program_options::options_description;
+    using boost::program_options::value;
+
+    options_description  cmd_options("program options");
+
+    cmd_options.add_options()
+        ("file,f",          value<std::string>(&bench_file_name)->default_value("large_file_test.data"),    "test file")
+        ("mode,m",          value<std::string>(&bench_mode)->default_value("seq-write"),                    "seq-read, seq-write, rand-read or rand-write")
+        ("access,a",        value<std::string>(&bench_access)->default_value("pread"),                      "pread or mmap (read modes only)")
+        ("block-size,b",    value<scm::uint32>(&bench_block_size_kib)->default_value(512),                  "block size (KiB)")
+        ("file-size,s",     value<scm::uint32>(&bench_file_size_mib)->default_value(1024),                  "file size (MiB)")
+        ("queue-depth,q",   value<scm::uint32>(&bench_queue_depth)->default_value(8),                       "asynchronous requests in flight per thread")
+        ("threads,t",       value<scm::uint32>(&bench_threads)->default_value(1),                           "number of threads")
+        ("direct,d",        value<bool>(&bench_direct_io)->default_value(true),                             "bypass the system cache (O_DIRECT)")
+        ("seed",            value<unsigned>(&bench_seed)->default_value(5489u),                             "random seed for the block order")
+        ("output,o",        value<std::string>(&bench_output)->default_value(""),                           "json output file (default: stdout)");
 
-    typedef scm::time::accum_timer<scm::time::high_res_timer>  timer_type;
+    c.add_command_line_options(cmd_options, scm_application_name);
 
-    // what we now try is to generate a very large file
-    //  - check if it is written correctly by reading it back!
-    //  - check if it memory runs full if we use the system cache
-    //  - check what difference it makes not using the file cache
-    //  - check if regular flush operations change the cache fillup
+    return (true);
+}
 
+static void init_module()
+{
+    scm::module::initializer::add_pre_core_init_function(initialize_cmd_line);
+}
+
+static scm::module::static_initializer  static_initialize(init_module);
+
+static void
+run_benchmark_thread(const std::vector<scm::io::file::offset_type>*  positions,
+                     scm::uint32                                     thread_index,
+                     bool                                            write_mode,
+                     scm::io::file::size_type                        block_size,
+                     scm::io::file::size_type                        io_buffer_size,
+                     thread_result*                                  result)
+{
     using namespace scm;
     using namespace scm::io;
 
-    std::string         out_file_name  = "e:/data/large_file_test_out_00.data";
-    shared_ptr<file>    out_file       = make_shared<file>();
+    // file cores are not thread safe, every thread uses its own file
+    file                file_handle;
+    file_mapping_ptr    mapping;
 
-    std::cout << "opening output file: " << out_file_name << std::endl;
-    if (!out_file->open(out_file_name,
-                        std::ios_base::out | std::ios_base::trunc,
-                        true /*disable system cache*/,
-                        512 * 1024)) {
-        std::cerr << "unable to open ouput file: " << out_file_name << std::endl;
-        return -1;
+    const std::ios_base::openmode open_mode = write_mode ? std::ios_base::out : std::ios_base::in;
+
+    if (!file_handle.open(bench_file_name, open_mode, bench_direct_io,
+                          static_cast<scm::uint32>(io_buffer_size), bench_queue_depth)) {
+        result->_errors = static_cast<scm::int64>(positions->size());
+        return;
+    }
+    if (bench_access == "mmap") {
+        mapping = file_handle.map(0, file_handle.size(), bench_mode == "rand-read" ? file_mapping::access_random
+                                                                                   : file_mapping::access_sequential);
+        if (!mapping) {
+            result->_errors = static_cast<scm::int64>(positions->size());
+            return;
+        }
     }
 
-    // the important constants ////////////////////////////////////////////////////////////////////
-    file::size_type     out_block_size   = out_file->vss_align_ceil(512ll * 1024);    // KiB
-    file::size_type     out_file_size    = 40ll * 1024 * 1024 * 1024;                 // GiB
-    bool                out_random_write = true;
+    // sector aligned block buffer
+    const file::size_type   alignment = file_handle.volume_sector_size();
+    std::vector<char>       buffer_memory(static_cast<std::size_t>(block_size + alignment));
+    char*                   buffer    = &buffer_memory.front();
+    buffer += (alignment - reinterpret_cast<scm::size_t>(buffer) % alignment) % alignment;
 
-    std::cout << "out_block_size:   " << out_block_size << std::endl
-              << "out_file_size:    " << out_file_size  << std::endl
-              << "out_random_write: " << (out_random_write ? "true" : "false") << std::endl;
+    if (write_mode) {
+        boost::mt19937                                                      rand_gen(bench_seed + thread_index);
+        boost::uniform_int<>                                                rand_dist(0, 255);
+        boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    die(rand_gen, rand_dist);
+
+        for (file::size_type i = 0; i < block_size; ++i) {
+            buffer[i] = static_cast<char>(die());
+        }
+    }
 
-    shared_array<char>  out_buffer(new char[out_block_size]);
+    timer_type  op_timer;
 
-    boost::mt19937       rand_gen;
-    boost::uniform_int<> rand_dist(0, 255);
-    boost::variate_generator<boost::mt19937&, boost::uniform_int<> > die(rand_gen, rand_dist);
+    result->_latencies.reserve(positions->size() / bench_threads + 1);
+
+    for (std::size_t i = thread_index; i < positions->size(); i += bench_threads) {
+        const file::offset_type pos = (*positions)[i];
+        file::size_type         r   = 0;
+
+        op_timer.start();
+        if (write_mode) {
+            r = file_handle.write(buffer, pos, block_size);
+        }
+        else if (mapping) {
+            std::memcpy(buffer, mapping->data() + pos, static_cast<std::size_t>(block_size));
+            r = block_size;
+        }
+        else {
+            r = file_handle.read(buffer, pos, block_size);
+        }
+        op_timer.stop();
 
-    std::cout << "generating output block of random data" << std::endl;
-    for (file::size_type i = 0; i < out_block_size; ++i) {
-        out_buffer[i] = die();
+        if (r != block_size) {
+            ++result->_errors;
+        }
+        else {
+            result->_bytes += r;
+        }
+        result->_latencies.push_back(time::to_microseconds(op_timer.last_time()));
     }
 
-    // writing file ///////////////////////////////////////////////////////////////////////////////
-    file::size_type     out_block_count = out_file_size / out_block_size;
-    std::vector<file::size_type> out_positions;
-    out_positions.reserve(out_block_count);
+    mapping.reset();
+    file_handle.close();
+}
+
+static bool
+prepare_file(scm::io::file::size_type file_size, bool write_mode)
+{
+    using namespace scm;
+    using namespace scm::io;
+
+    file    prep_file;
 
-    for (file::size_type out_pos = 0; out_pos < out_block_count; ++out_pos) {
-        out_positions[out_pos] = out_pos * out_block_size;
+    if (write_mode) {
+        // create the file at its final size, the blocks are reserved up front
+        if (!prep_file.open(bench_file_name, std::ios_base::out | std::ios_base::trunc, false)) {
+            return (false);
+        }
+        prep_file.seek(file_size, std::ios_base::beg);
+        bool ret = prep_file.set_end_of_file() == file_size;
+        prep_file.close();
+        return (ret);
     }
 
-    if (out_random_write) {
-        std::random_shuffle(out_positions.begin(), out_positions.end());
+    // read modes need existing data, only (re)write the file if it is too small
+    if (   prep_file.open(bench_file_name, std::ios_base::in, false)
+        && prep_file.size() >= file_size) {
+        return (true);
     }
+    prep_file.close();
 
-    timer_type          write_timer;
-    std::cout << "starting to write file..." << std::endl;
-    write_timer.start();
-    for (file::size_type out_pos = 0; out_pos < out_block_count; ++out_pos) {
-        if (out_file->write(out_buffer.get(), out_positions[out_pos], out_block_size) != out_block_size) {
-            std::cerr << "error writing to file at position: " << out_pos * out_block_size << std::endl;
-        }
-        if (out_pos % (out_block_count / 100) == 0) {
-            //write_timer.stop();
-            //write_timer.start();
-            std::cout << "writing file: " << std::fixed << 100.0 * (static_cast<double>(out_pos) / out_block_count) << "%";
-            std::cout << "\xd";
+    std::cout << "generating test file: " << bench_file_name << std::endl;
+    if (!prep_file.open(bench_file_name, std::ios_base::out | std::ios_base::trunc, false)) {
+        return (false);
+    }
+
+    const file::size_type   chunk_size = 4 * 1024 * 1024;
+    std::vector<char>       chunk(chunk_size);
+
+    boost::mt19937                                                      rand_gen(bench_seed);
+    boost::uniform_int<>                                                rand_dist(0, 255);
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    die(rand_gen, rand_dist);
+
+    for (file::size_type i = 0; i < chunk_size; ++i) {
+        chunk[i] = static_cast<char>(die());
+    }
+    for (file::offset_type pos = 0; pos < file_size; pos += chunk_size) {
+        const file::size_type n = math::min(chunk_size, file_size - pos);
+        if (prep_file.write(&chunk.front(), pos, n) != n) {
+            return (false);
         }
     }
-    write_timer.stop();
-    std::cout << "end writing file." << std::endl;
+    prep_file.flush_buffers();
+    prep_file.close();
 
-    out_file->close();
+    return (true);
+}
 
-    double  write_time = time::to_seconds(write_timer.accumulated_duration());
+static double
+percentile(const std::vector<double>& sorted_values, double p)
+{
+    if (sorted_values.empty()) {
+        return (0.0);
+    }
+    std::size_t i = static_cast<std::size_t>(p * static_cast<double>(sorted_values.size()));
+    return (sorted_values[std::min(i, sorted_values.size() - 1)]);
+}
 
-    std::cout << "write time: " << std::fixed << std::setprecision(3) << write_time << "s, "
-              << "write speed: " << (static_cast<double>(out_file_size) / (1024 * 1024)) / write_time << "MiB/s" << std::endl;
+int main(int argc, char **argv)
+{
+    // the usual
+    std::ios_base::sync_with_stdio(false);
+    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
 
+    using namespace scm;
+    using namespace scm::io;
 
-    // read back file and compare blocks //////////////////////////////////////////////////////////
-    shared_ptr<file>    in_file       = make_shared<file>();
+    const bool write_mode  = (bench_mode == "seq-write"  || bench_mode == "rand-write");
+    const bool random_mode = (bench_mode == "rand-read"  || bench_mode == "rand-write");
 
-    std::cout << "opening input file: " << out_file_name << std::endl;
-    if (!in_file->open(out_file_name,
-                       std::ios_base::in,
-                       true /*disable system cache*/,
-                       512 * 1024)) {
-        std::cerr << "unable to open input file: " << out_file_name << std::endl;
+    if (   bench_mode != "seq-read" && bench_mode != "rand-read"
+        && bench_mode != "seq-write" && bench_mode != "rand-write") {
+        std::cerr << "unknown benchmark mode: " << bench_mode << std::endl;
+        return -1;
+    }
+    if (bench_access != "pread" && bench_access != "mmap") {
+        std::cerr << "unknown access method: " << bench_access << std::endl;
+        return -1;
+    }
+    if (bench_access == "mmap" && write_mode) {
+        std::cerr << "mmap access is only supported for read modes" << std::endl;
         return -1;
     }
 
-    shared_array<char>  in_buffer(new char[out_block_size]);
+    bench_threads     = math::max(1u, bench_threads);
+    bench_queue_depth = math::max(1u, bench_queue_depth);
 
-    std::cout << "starting to reading file..." << std::endl;
-    for (file::size_type in_pos = 0; in_pos < out_block_count; ++in_pos) {
-        if (in_file->read(in_buffer.get(), in_pos * out_block_size, out_block_size) != out_block_size) {
-            std::cerr << "error reading to file at position: " << in_pos * out_block_size << std::endl;
-        }
-        if (in_pos % (out_block_count / 100) == 0) {
-            //write_timer.stop();
-            //write_timer.start();
-            std::cout << "reading file: " << std::fixed << 100.0 * (static_cast<double>(in_pos) / out_block_count) << "%";
-            std::cout << "\xd";
-        }
-        for (file::size_type i = 0; i < out_block_size; ++i) {
-            if (in_buffer[i] != out_buffer[i]) {
-                std::cerr << "found error at file position: " << in_pos * out_block_size << std::endl;
-            }
+    // the important constants ////////////////////////////////////////////////////////////////////
+    const file::size_type   block_size      = math::max<file::size_type>(1, static_cast<file::size_type>(bench_block_size_kib) * 1024);
+    const file::size_type   block_count     = math::max<file::size_type>(1, (static_cast<file::size_type>(bench_file_size_mib) * 1024 * 1024) / block_size);
+    const file::size_type   file_size       = block_count * block_size;
+    const file::size_type   io_buffer_size  = math::max<file::size_type>(4096, block_size / bench_queue_depth);
+
+    if (!prepare_file(file_size, write_mode)) {
+        std::cerr << "unable to prepare test file: " << bench_file_name << std::endl;
+        return -1;
+    }
+
+    std::vector<file::offset_type> positions(static_cast<std::size_t>(block_count));
+    for (file::size_type b = 0; b < block_count; ++b) {
+        positions[static_cast<std::size_t>(b)] = b * block_size;
+    }
+    if (random_mode) {
+        boost::mt19937                                      rand_gen(bench_seed);
+        boost::random_number_generator<boost::mt19937>      rand_index(rand_gen);
+        std::random_shuffle(positions.begin(), positions.end(), rand_index);
+    }
+
+    // run ////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<thread_result>  results(bench_threads);
+    boost::thread_group         threads;
+    timer_type                  wall_timer;
+
+    wall_timer.start();
+    for (scm::uint32 t = 0; t < bench_threads; ++t) {
+        threads.create_thread(boost::bind(run_benchmark_thread, &positions, t, write_mode,
+                                          block_size, io_buffer_size, &results[t]));
+    }
+    threads.join_all();
+    if (write_mode) {
+        // include getting the data to the device
+        file sync_file;
+        if (sync_file.open(bench_file_name, std::ios_base::out, false)) {
+            sync_file.flush_buffers();
         }
     }
-    std::cout << "end reading file." << std::endl;
+    wall_timer.stop();
 
-    out_file->close();
-    std::cout << "sick, sad world..." << std::endl;
+    // report /////////////////////////////////////////////////////////////////////////////////////
+    std::vector<double> latencies;
+    scm::int64          total_bytes  = 0;
+    scm::int64          total_errors = 0;
+
+    for (std::size_t t = 0; t < results.size(); ++t) {
+        latencies.insert(latencies.end(), results[t]._latencies.begin(), results[t]._latencies.end());
+        total_bytes  += results[t]._bytes;
+        total_errors += results[t]._errors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double latency_sum = 0.0;
+    for (std::size_t i = 0; i < latencies.size(); ++i) {
+        latency_sum += latencies[i];
+    }
+
+    const double wall_time  = time::to_seconds(wall_timer.accumulated_duration());
+    const double throughput = wall_time > 0.0 ? (static_cast<double>(total_bytes) / (1024.0 * 1024.0)) / wall_time : 0.0;
+    const double iops       = wall_time > 0.0 ? static_cast<double>(latencies.size()) / wall_time : 0.0;
+
+    std::ostringstream  json;
+    json << std::fixed << std::setprecision(3)
+         << "{" << std::endl
+         << "  \"file\": \""            << bench_file_name << "\"," << std::endl
+         << "  \"mode\": \""            << bench_mode << "\"," << std::endl
+         << "  \"access\": \""          << bench_access << "\"," << std::endl
+         << "  \"direct_io\": "         << (bench_direct_io ? "true" : "false") << "," << std::endl
+         << "  \"block_size\": "        << block_size << "," << std::endl
+         << "  \"file_size\": "         << file_size << "," << std::endl
+         << "  \"queue_depth\": "       << bench_queue_depth << "," << std::endl
+         << "  \"threads\": "           << bench_threads << "," << std::endl
+         << "  \"operations\": "        << latencies.size() << "," << std::endl
+         << "  \"errors\": "            << total_errors << "," << std::endl
+         << "  \"bytes\": "             << total_bytes << "," << std::endl
+         << "  \"time_s\": "            << wall_time << "," << std::endl
+         << "  \"throughput_mib_s\": "  << throughput << "," << std::endl
+         << "  \"iops\": "              << iops << "," << std::endl
+         << "  \"latency_us\": {" << std::endl
+         << "    \"min\": "             << (latencies.empty() ? 0.0 : latencies.front()) << "," << std::endl
+         << "    \"mean\": "            << (latencies.empty() ? 0.0 : latency_sum / latencies.size()) << "," << std::endl
+         << "    \"p50\": "             << percentile(latencies, 0.5) << "," << std::endl
+         << "    \"p99\": "             << percentile(latencies, 0.99) << "," << std::endl
+         << "    \"p99_9\": "           << percentile(latencies, 0.999) << "," << std::endl
+         << "    \"max\": "             << (latencies.empty() ? 0.0 : latencies.back()) << std::endl
+         << "  }" << std::endl
+         << "}" << std::endl;
+
+    if (bench_output.empty()) {
+        std::cout << json.str();
+    }
+    else {
+        std::ofstream json_file(bench_output.c_str());
+        json_file << json.str();
+        if (!json_file) {
+            std::cerr << "unable to write json output: " << bench_output << std::endl;
+            return -1;
+        }
+    }
 
-    return 0;
+    return (total_errors > 0 ? -1 : 0);
 }
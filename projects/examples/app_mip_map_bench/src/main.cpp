@@ -0,0 +1,622 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/numeric/conversion/bounds.hpp>
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core.h>
+#include <scm/log.h>
+#include <scm/core/math.h>
+#include <scm/core/platform/cpu_features.h>
+#include <scm/core/time/accum_timer.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_core/data_formats.h>
+#include <scm/gl_core/math.h>
+
+#include <scm/gl_util/data/imaging/mip_map_generation.h>
+
+// mip map generation benchmark
+//  - verifies the parallel simd mip map generation of all supported levels
+//    bit exact against the original single threaded per texel code for all
+//    supported formats and a set of odd and even volume dimensions
+//  - reports the time for building the mip map hierarchy of a volume for the
+//    common 1 and 4 channel formats
+
+namespace {
+
+typedef scm::time::accum_timer<scm::time::high_res_timer>  timer_type;
+
+scm::uint32         bench_size;
+scm::uint32         bench_image_size;
+scm::uint32         bench_iterations;
+unsigned            bench_seed;
+
+static const std::string    scm_application_name = "schism: mip map generation benchmark";
+
+// reference implementation: typed_generate_mip_slices before the row kernels
+template<typename vtype,
+         const unsigned vdim>
+void
+typed_generate_mip_slices_reference(const scm::math::vec3ui&   src_dim,
+                                    const scm::math::vec3ui&   dst_dim,
+                                    const scm::uint8*          src_data,
+                                          unsigned             src_z_first,
+                                          unsigned             z_begin,
+                                          unsigned             z_end,
+                                          scm::uint8*          dst_data)
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const vtype vmax = boost::numeric::bounds<vtype>::highest();
+    const vtype vmin = boost::numeric::bounds<vtype>::lowest();
+
+    typedef math::vec<vtype, vdim> varr;
+    typedef math::vec<float, vdim> tarr;
+
+    const int y_max_lines = 3;
+    const int z_max_lines = 3;
+
+    const vec3i  lsize  = vec3i(dst_dim);
+    const vec3i  slsize = vec3i(src_dim);
+    const int    sz0    = static_cast<int>(src_z_first);
+
+    varr*  ldata    = reinterpret_cast<varr*>(dst_data);
+
+    scoped_array<tarr>  tlines(new tarr[lsize.x * y_max_lines * z_max_lines]);
+
+    const int x_samples = min(slsize.x, (slsize.x & 1) ? 3 : 2);
+    const int y_samples = min(slsize.y, (slsize.y & 1) ? 3 : 2);
+    const int z_samples = min(slsize.z, (slsize.z & 1) ? 3 : 2);
+
+    for (int z = static_cast<int>(z_begin); z < static_cast<int>(z_end); ++z) {
+        for (int y = 0; y < lsize.y; ++y) {
+            const varr*  sldata  = reinterpret_cast<const varr*>(src_data);
+            memset(static_cast<void*>(tlines.get()), 0, lsize.x * y_max_lines * z_max_lines * sizeof(tarr));
+            for (int zs = 0; zs < z_samples; ++zs) {
+                for (int ys = 0; ys < y_samples; ++ys) {
+                    const varr* ld = sldata + ( static_cast<size_t>(2 * y + ys) * slsize.x
+                                              + static_cast<size_t>(2 * z + zs - sz0) * slsize.x * slsize.y);
+                    const int   lo = (ys + zs * y_max_lines) * lsize.x;
+                    if (x_samples == 1) {
+                        tlines[lo] = ld[0];
+                    }
+                    else if (x_samples == 2) {
+                        for (int x = 0; x < lsize.x; ++x) {
+                            tlines[lo + x] += ld[0];
+                            tlines[lo + x] += ld[1];
+                            tlines[lo + x] *= 0.5f;
+                            ld += 2;
+                        }
+                    }
+                    else {
+                        const float scale = 1.0f / (2.0f * lsize.x + 1.0f);
+                        for (int x = 0; x < lsize.x; ++x) {
+                            const float w0 = static_cast<float>(lsize.x - x);
+                            const float w1 = static_cast<float>(lsize.x);
+                            const float w2 = static_cast<float>(1 + x);
+
+                            tlines[lo + x] += w0 * tarr(ld[0]);
+                            tlines[lo + x] += w1 * tarr(ld[1]);
+                            tlines[lo + x] += w2 * tarr(ld[2]);
+                            tlines[lo + x] *= scale;
+                            ld += 2;
+                        }
+                    }
+                }
+            }
+            if (y_samples == 2) {
+                for (int zs = 0; zs < z_samples; ++zs) {
+                    const int lo = (zs * y_max_lines) * lsize.x;
+                    for (int x = 0; x < lsize.x; ++x) {
+                        tlines[lo + x] += tlines[lo + lsize.x + x];
+                        tlines[lo + x] *= 0.5f;
+                    }
+                }
+            }
+            else if (y_samples == 3) {
+                const float w0 = float(lsize.y - y);
+                const float w1 = float(lsize.y);
+                const float w2 = float(1 + y);
+                for (int zs = 0; zs < z_samples; ++zs) {
+                    const int lo      = (zs * y_max_lines) * lsize.x;
+                    const float scale = 1.0f / (2.0f * lsize.y + 1.0f);
+                    for (int x = 0; x < lsize.x; ++x) {
+                        tlines[lo + x]  = w0 * tlines[lo +               x];
+                        tlines[lo + x] += w1 * tlines[lo +     lsize.x + x];
+                        tlines[lo + x] += w2 * tlines[lo + 2 * lsize.x + x];
+                        tlines[lo + x] *= scale;
+                    }
+                }
+            }
+            if (z_samples == 2) {
+                const int lo1 = y_max_lines * lsize.x;
+                for (int x = 0; x < lsize.x; ++x) {
+                    tlines[x] += tlines[lo1 + x];
+                    tlines[x] *= 0.5f;
+                }
+            }
+            else if (z_samples == 3) {
+                const float w0 = float(lsize.z - z);
+                const float w1 = float(lsize.z);
+                const float w2 = float(1 + z);
+
+                const int lo1  =     y_max_lines * lsize.x;
+                const int lo2  = 2 * y_max_lines * lsize.x;
+                const float scale = 1.0f / (2.0f * lsize.z + 1.0f);
+
+                for (int x = 0; x < lsize.x; ++x) {
+                    tlines[x]  = w0 * tlines[      x];
+                    tlines[x] += w1 * tlines[lo1 + x];
+                    tlines[x] += w2 * tlines[lo2 + x];
+                    tlines[x] *= scale;
+                }
+            }
+            const size_t dst_off =   static_cast<size_t>(y) * lsize.x
+                                   + static_cast<size_t>(z - static_cast<int>(z_begin)) * lsize.x * lsize.y;
+            for (int x = 0; x < lsize.x; ++x) {
+                ldata[dst_off + x] = varr(clamp(tlines[x], tarr(vmin), tarr(vmax)));
+            }
+        }
+    }
+}
+
+template<typename vtype>
+void
+fill_random(std::vector<scm::uint8>& data, unsigned seed)
+{
+    boost::mt19937                                                      rand_gen(seed);
+    boost::uniform_int<>                                                rand_dist(0, static_cast<int>(boost::numeric::bounds<vtype>::highest()));
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<> >    die(rand_gen, rand_dist);
+
+    vtype* d = reinterpret_cast<vtype*>(&data.front());
+    for (scm::size_t i = 0; i < data.size() / sizeof(vtype); ++i) {
+        d[i] = static_cast<vtype>(die());
+    }
+}
+
+template<>
+void
+fill_random<float>(std::vector<scm::uint8>& data, unsigned seed)
+{
+    boost::mt19937                                                      rand_gen(seed);
+    boost::uniform_real<float>                                          rand_dist(-1000.0f, 1000.0f);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die(rand_gen, rand_dist);
+
+    float* d = reinterpret_cast<float*>(&data.front());
+    for (scm::size_t i = 0; i < data.size() / sizeof(float); ++i) {
+        d[i] = die();
+    }
+    // signed zeros and values close to the float range
+    const float special_values[] = { -0.0f, 0.0f, -0.0f, -0.0f, 3.0e38f, 3.3e38f, -3.3e38f, 1.0e-40f };
+    for (scm::size_t i = 0; i < sizeof(special_values) / sizeof(float) && i < data.size() / sizeof(float); ++i) {
+        d[i] = special_values[i];
+    }
+}
+
+// reference lanczos3 resampling in double precision with independently computed weights
+double
+lanczos3_reference(double t)
+{
+    const double pi = 3.14159265358979323846;
+
+    t = std::fabs(t);
+    if (t < 1e-8) return (1.0);
+    if (t >= 3.0) return (0.0);
+    return ((std::sin(pi * t) / (pi * t)) * (std::sin(pi * t / 3.0) / (pi * t / 3.0)));
+}
+
+void
+lanczos3_reference_weights(unsigned src_size, unsigned dst_size, std::vector<std::vector<double> >& weights)
+{
+    // window of all source texels inside the filter support, clipped at the borders
+    // and shifted inwards to keep a fixed tap count
+    const double scale   = static_cast<double>(dst_size) / src_size;
+    const double fscale  = (std::min)(1.0, scale);
+    const double support = 3.0 / fscale;
+    const int    taps    = (std::max)(1, (std::min)(static_cast<int>(src_size), static_cast<int>(std::ceil(2.0 * support))));
+
+    weights.assign(dst_size, std::vector<double>(src_size, 0.0));
+    for (unsigned x = 0; x < dst_size; ++x) {
+        const double center = (x + 0.5) / scale;
+        const int    first  = (std::max)(0, (std::min)(static_cast<int>(src_size) - taps,
+                                                       static_cast<int>(std::ceil(center - support - 0.5))));
+        double sum = 0.0;
+        for (int j = first; j < first + taps; ++j) {
+            weights[x][j] = lanczos3_reference((center - (j + 0.5)) * fscale);
+            sum += weights[x][j];
+        }
+        for (int j = first; j < first + taps; ++j) {
+            weights[x][j] /= sum;
+        }
+    }
+}
+
+template<typename vtype,
+         const unsigned vdim>
+void
+image_mip_level_lanczos_reference(const scm::math::vec2ui&   src_dim,
+                                  const scm::math::vec2ui&   dst_dim,
+                                  const scm::uint8*          src_data,
+                                        std::vector<double>& dst_data)
+{
+    std::vector<std::vector<double> > wx;
+    std::vector<std::vector<double> > wy;
+    lanczos3_reference_weights(src_dim.x, dst_dim.x, wx);
+    lanczos3_reference_weights(src_dim.y, dst_dim.y, wy);
+
+    const vtype* s = reinterpret_cast<const vtype*>(src_data);
+    dst_data.assign(static_cast<scm::size_t>(dst_dim.x) * dst_dim.y * vdim, 0.0);
+
+    for (unsigned y = 0; y < dst_dim.y; ++y) {
+        for (unsigned x = 0; x < dst_dim.x; ++x) {
+            for (unsigned k = 0; k < vdim; ++k) {
+                double t = 0.0;
+                for (unsigned sy = 0; sy < src_dim.y; ++sy) {
+                    if (wy[y][sy] == 0.0) continue;
+                    for (unsigned sx = 0; sx < src_dim.x; ++sx) {
+                        if (wx[x][sx] == 0.0) continue;
+                        t += wy[y][sy] * wx[x][sx] * s[(static_cast<scm::size_t>(sy) * src_dim.x + sx) * vdim + k];
+                    }
+                }
+                dst_data[(static_cast<scm::size_t>(y) * dst_dim.x + x) * vdim + k] = t;
+            }
+        }
+    }
+}
+
+template<typename vtype>
+void
+fill_random_image(std::vector<scm::uint8>& data, unsigned seed)
+{
+    fill_random<vtype>(data, seed);
+}
+
+template<>
+void
+fill_random_image<float>(std::vector<scm::uint8>& data, unsigned seed)
+{
+    // no values close to the float range, the negative lobes would overflow the reference comparison
+    boost::mt19937                                                      rand_gen(seed);
+    boost::uniform_real<float>                                          rand_dist(-1000.0f, 1000.0f);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die(rand_gen, rand_dist);
+
+    float* d = reinterpret_cast<float*>(&data.front());
+    for (scm::size_t i = 0; i < data.size() / sizeof(float); ++i) {
+        d[i] = die();
+    }
+}
+
+// lanczos levels are compared to the double precision reference (integer results
+// within one step, float results within 1e-2) and have to be identical for all
+// simd levels
+template<typename vtype,
+         const unsigned vdim>
+bool
+verify_image_format(const scm::math::vec2ui&   dim,
+                    scm::cpu_simd_level        l)
+{
+    using namespace scm;
+    using namespace scm::math;
+
+    const scm::size_t   texel_size = sizeof(vtype) * vdim;
+    const vec2ui        dst_dim    = gl::util::mip_level_dimensions(dim, 1);
+    const scm::size_t   dst_count  = static_cast<scm::size_t>(dst_dim.x) * dst_dim.y * vdim;
+    const double        tolerance  = std::numeric_limits<vtype>::is_integer ? 1.0 : 1e-2;
+
+    std::vector<uint8>  src(static_cast<scm::size_t>(dim.x) * dim.y * texel_size);
+    std::vector<uint8>  result(dst_count * sizeof(vtype));
+    std::vector<uint8>  result_scalar(dst_count * sizeof(vtype));
+    std::vector<double> expected;
+    fill_random_image<vtype>(src, bench_seed);
+
+    gl::util::typed_generate_image_mip_level<vtype, vdim>(dim, dst_dim, &src.front(), &result.front(),
+                                                          gl::util::MIP_FILTER_LANCZOS3, l);
+    gl::util::typed_generate_image_mip_level<vtype, vdim>(dim, dst_dim, &src.front(), &result_scalar.front(),
+                                                          gl::util::MIP_FILTER_LANCZOS3, CPU_SIMD_NONE);
+    image_mip_level_lanczos_reference<vtype, vdim>(dim, dst_dim, &src.front(), expected);
+
+    if (memcmp(&result.front(), &result_scalar.front(), result.size()) != 0) {
+        return (false);
+    }
+
+    const vtype*  r    = reinterpret_cast<const vtype*>(&result.front());
+    const double  vmin = static_cast<double>(boost::numeric::bounds<vtype>::lowest());
+    const double  vmax = static_cast<double>(boost::numeric::bounds<vtype>::highest());
+    for (scm::size_t i = 0; i < dst_count; ++i) {
+        const double e = (std::min)(vmax, (std::max)(vmin, expected[i]));
+        if (std::fabs(static_cast<double>(r[i]) - e) > tolerance) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+template<typename vtype,
+         const unsigned vdim>
+bool
+verify_image_format_dims(const char* name, scm::cpu_simd_level l)
+{
+    using namespace scm::math;
+
+    const vec2ui dims[] = { vec2ui(64, 64), vec2ui(37, 22), vec2ui(129, 67), vec2ui(1, 5),
+                            vec2ui(33, 1),  vec2ui(2, 2),   vec2ui(100, 3),  vec2ui(17, 255) };
+    bool         ok     = true;
+
+    for (scm::size_t d = 0; d < sizeof(dims) / sizeof(vec2ui); ++d) {
+        ok = verify_image_format<vtype, vdim>(dims[d], l) && ok;
+    }
+
+    std::cout << "verify image " << std::setw(10) << std::left << name
+              << std::setw(8) << scm::cpu_simd_level_string(l)
+              << (ok ? "ok" : "MISMATCH") << std::endl;
+
+    return (ok);
+}
+
+template<typename vtype,
+         const unsigned vdim>
+bool
+verify_format(const scm::math::vec3ui&   dim,
+              scm::cpu_simd_level        l)
+{
+    using namespace scm;
+    using namespace scm::math;
+
+    const scm::size_t texel_size = sizeof(vtype) * vdim;
+
+    std::vector<uint8>  src(static_cast<scm::size_t>(dim.x) * dim.y * dim.z * texel_size);
+    fill_random<vtype>(src, bench_seed);
+
+    vec3ui src_dim = dim;
+    for (unsigned m = 1; m < gl::util::max_mip_levels(dim); ++m) {
+        const vec3ui dst_dim = gl::util::mip_level_dimensions(dim, m);
+        const scm::size_t dst_size = static_cast<scm::size_t>(dst_dim.x) * dst_dim.y * dst_dim.z * texel_size;
+
+        std::vector<uint8> result(dst_size);
+        std::vector<uint8> expected(dst_size);
+
+        gl::util::typed_generate_mip_slices<vtype, vdim, 2>(src_dim, dst_dim, &src.front(), 0, 0, dst_dim.z, &result.front(), l);
+        typed_generate_mip_slices_reference<vtype, vdim>(src_dim, dst_dim, &src.front(), 0, 0, dst_dim.z, &expected.front());
+
+        if (memcmp(&result.front(), &expected.front(), dst_size) != 0) {
+            return (false);
+        }
+
+        // slice range with a source offset (as used by the streaming loaders)
+        if (dst_dim.z > 2) {
+            const unsigned z_begin     = dst_dim.z / 2;
+            const unsigned src_z_first = 2 * z_begin;
+            const scm::size_t dst_slice = static_cast<scm::size_t>(dst_dim.x) * dst_dim.y * texel_size;
+            const scm::size_t src_slice = static_cast<scm::size_t>(src_dim.x) * src_dim.y * texel_size;
+
+            gl::util::typed_generate_mip_slices<vtype, vdim, 2>(src_dim, dst_dim, &src.front() + src_z_first * src_slice,
+                                                                src_z_first, z_begin, dst_dim.z, &result.front(), l);
+            if (memcmp(&result.front(), &expected.front() + z_begin * dst_slice, (dst_dim.z - z_begin) * dst_slice) != 0) {
+                return (false);
+            }
+        }
+
+        src.swap(expected);
+        src_dim = dst_dim;
+    }
+
+    return (true);
+}
+
+template<typename vtype,
+         const unsigned vdim>
+bool
+verify_format_dims(const char* name, scm::cpu_simd_level l)
+{
+    using namespace scm::math;
+
+    const vec3ui dims[] = { vec3ui(64, 64, 64), vec3ui(37, 22, 13), vec3ui(129, 67, 33), vec3ui(1, 5, 3),
+                            vec3ui(33, 1, 2),   vec3ui(9, 9, 9),    vec3ui(2, 2, 2),     vec3ui(100, 3, 1) };
+    bool         ok     = true;
+
+    for (scm::size_t d = 0; d < sizeof(dims) / sizeof(vec3ui); ++d) {
+        ok = verify_format<vtype, vdim>(dims[d], l) && ok;
+    }
+
+    std::cout << "verify " << std::setw(10) << std::left << name
+              << std::setw(8) << scm::cpu_simd_level_string(l)
+              << (ok ? "ok" : "MISMATCH") << std::endl;
+
+    return (ok);
+}
+
+template<typename vtype,
+         const unsigned vdim>
+void
+bench_format(const char* name)
+{
+    using namespace scm;
+    using namespace scm::math;
+
+    const vec3ui        dim(bench_size);
+    const vec3ui        dst_dim    = gl::util::mip_level_dimensions(dim, 1);
+    const scm::size_t   texel_size = sizeof(vtype) * vdim;
+    const scm::size_t   src_size   = static_cast<scm::size_t>(dim.x) * dim.y * dim.z * texel_size;
+
+    std::vector<uint8>  src(src_size);
+    std::vector<uint8>  dst(static_cast<scm::size_t>(dst_dim.x) * dst_dim.y * dst_dim.z * texel_size);
+    fill_random<vtype>(src, bench_seed);
+
+    timer_type  op_timer;
+    for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+        op_timer.start();
+        typed_generate_mip_slices_reference<vtype, vdim>(dim, dst_dim, &src.front(), 0, 0, dst_dim.z, &dst.front());
+        op_timer.stop();
+    }
+    const double ref_time = time::to_seconds(op_timer.accumulated_duration()) / bench_iterations;
+
+    std::cout << std::setw(10) << std::left << name
+              << std::setw(10) << "reference"
+              << std::setw(8)  << std::right << ref_time * 1000.0 << " ms"
+              << std::setw(10) << (static_cast<double>(src_size) / (ref_time * 1e9)) << " GB/s" << std::endl;
+
+    for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+        op_timer.reset();
+        for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+            op_timer.start();
+            gl::util::typed_generate_mip_slices<vtype, vdim, 2>(dim, dst_dim, &src.front(), 0, 0, dst_dim.z, &dst.front(),
+                                                                static_cast<cpu_simd_level>(l));
+            op_timer.stop();
+        }
+        const double t = time::to_seconds(op_timer.accumulated_duration()) / bench_iterations;
+
+        std::cout << std::setw(10) << std::left << name
+                  << std::setw(10) << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                  << std::setw(8)  << std::right << t * 1000.0 << " ms"
+                  << std::setw(10) << (static_cast<double>(src_size) / (t * 1e9)) << " GB/s"
+                  << "  (x" << ref_time / t << ")" << std::endl;
+    }
+}
+
+template<typename vtype,
+         const unsigned vdim>
+void
+bench_image_format(const char* name)
+{
+    using namespace scm;
+    using namespace scm::math;
+
+    const vec2ui        dim(bench_image_size);
+    const vec2ui        dst_dim    = gl::util::mip_level_dimensions(dim, 1);
+    const scm::size_t   texel_size = sizeof(vtype) * vdim;
+    const scm::size_t   src_size   = static_cast<scm::size_t>(dim.x) * dim.y * texel_size;
+
+    std::vector<uint8>  src(src_size);
+    std::vector<uint8>  dst(static_cast<scm::size_t>(dst_dim.x) * dst_dim.y * texel_size);
+    fill_random_image<vtype>(src, bench_seed);
+
+    const gl::util::mip_filter_type filters[]      = { gl::util::MIP_FILTER_BOX, gl::util::MIP_FILTER_LANCZOS3 };
+    const char*                     filter_names[] = { "box", "lanczos3" };
+
+    for (int f = 0; f < 2; ++f) {
+        for (int l = CPU_SIMD_NONE; l <= cpu_supported_simd_level(); ++l) {
+            timer_type  op_timer;
+            for (scm::uint32 i = 0; i < bench_iterations; ++i) {
+                op_timer.start();
+                gl::util::typed_generate_image_mip_level<vtype, vdim>(dim, dst_dim, &src.front(), &dst.front(),
+                                                                      filters[f], static_cast<cpu_simd_level>(l));
+                op_timer.stop();
+            }
+            const double t = time::to_seconds(op_timer.accumulated_duration()) / bench_iterations;
+
+            std::cout << std::setw(10) << std::left << name
+                      << std::setw(10) << filter_names[f]
+                      << std::setw(10) << cpu_simd_level_string(static_cast<cpu_simd_level>(l))
+                      << std::setw(8)  << std::right << t * 1000.0 << " ms"
+                      << std::setw(10) << (static_cast<double>(src_size) / (t * 1e9)) << " GB/s" << std::endl;
+        }
+    }
+}
+
+} // namespace
+
+static bool initialize_cmd_line(scm::core& c)
+{
+    using boost::program_options::options_description;
+    using boost::program_options::value;
+
+    options_description  cmd_options("program options");
+
+    cmd_options.add_options()
+        ("size,s",          value<scm::uint32>(&bench_size)->default_value(256),                            "benchmark volume edge length")
+        ("image-size",      value<scm::uint32>(&bench_image_size)->default_value(4096),                     "benchmark image edge length")
+        ("iterations,i",    value<scm::uint32>(&bench_iterations)->default_value(3),                        "timed runs per format")
+        ("seed",            value<unsigned>(&bench_seed)->default_value(5489u),                             "random seed for the test data");
+
+    c.add_command_line_options(cmd_options, scm_application_name);
+
+    return (true);
+}
+
+static void init_module()
+{
+    scm::module::initializer::add_pre_core_init_function(initialize_cmd_line);
+}
+
+static scm::module::static_initializer  static_initialize(init_module);
+
+int main(int argc, char **argv)
+{
+    // the usual
+    std::ios_base::sync_with_stdio(false);
+    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
+
+    using namespace scm;
+
+    const cpu_simd_level    max_level = cpu_supported_simd_level();
+
+    std::cout << "supported simd level: " << cpu_simd_level_string(max_level) << std::endl;
+
+    // verification ///////////////////////////////////////////////////////////////////////////////
+    bool verified = true;
+
+    for (int i = CPU_SIMD_NONE; i <= max_level; ++i) {
+        const cpu_simd_level l = static_cast<cpu_simd_level>(i);
+
+        verified = verify_format_dims<uint8,  1>("R_8",      l) && verified;
+        verified = verify_format_dims<uint8,  2>("RG_8",     l) && verified;
+        verified = verify_format_dims<uint8,  3>("RGB_8",    l) && verified;
+        verified = verify_format_dims<uint8,  4>("RGBA_8",   l) && verified;
+        verified = verify_format_dims<uint16, 1>("R_16",     l) && verified;
+        verified = verify_format_dims<uint16, 4>("RGBA_16",  l) && verified;
+        verified = verify_format_dims<float,  1>("R_32F",    l) && verified;
+        verified = verify_format_dims<float,  2>("RG_32F",   l) && verified;
+        verified = verify_format_dims<float,  3>("RGB_32F",  l) && verified;
+        verified = verify_format_dims<float,  4>("RGBA_32F", l) && verified;
+    }
+    for (int i = CPU_SIMD_NONE; i <= max_level; ++i) {
+        const cpu_simd_level l = static_cast<cpu_simd_level>(i);
+
+        verified = verify_image_format_dims<uint8,  1>("R_8",      l) && verified;
+        verified = verify_image_format_dims<uint8,  3>("RGB_8",    l) && verified;
+        verified = verify_image_format_dims<uint8,  4>("RGBA_8",   l) && verified;
+        verified = verify_image_format_dims<uint16, 1>("R_16",     l) && verified;
+        verified = verify_image_format_dims<scm::int16, 1>("R_16S", l) && verified;
+        verified = verify_image_format_dims<float,  1>("R_32F",    l) && verified;
+        verified = verify_image_format_dims<float,  4>("RGBA_32F", l) && verified;
+    }
+
+    // timing of the first mip level //////////////////////////////////////////////////////////////
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "first mip level of a " << bench_size << "^3 volume" << std::endl;
+
+    bench_format<uint8,  1>("R_8");
+    bench_format<uint8,  4>("RGBA_8");
+    bench_format<uint16, 1>("R_16");
+    bench_format<float,  1>("R_32F");
+    bench_format<float,  4>("RGBA_32F");
+
+    // timing of the first level of a 2d image ////////////////////////////////////////////////////
+    std::cout << "first mip level of a " << bench_image_size << "^2 image" << std::endl;
+
+    bench_image_format<uint8,  1>("R_8");
+    bench_image_format<uint8,  4>("RGBA_8");
+    bench_image_format<float,  4>("RGBA_32F");
+
+    return (verified ? 0 : -1);
+}
@@ -0,0 +1,340 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/assign/list_of.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <scm/core.h>
+#include <scm/log.h>
+#include <scm/core/pointer_types.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_core.h>
+
+#include <scm/gl_util/data/imaging/async_texture_loader.h>
+#include <scm/gl_util/primitives/quad.h>
+
+#include <GL/freeglut.h>
+
+// loads a set of image files through the async_texture_loader while rendering,
+// the images are shown in a grid (the placeholder until they are uploaded)
+// - usage: ex_glut_async_texture_loading [image files]
+// - every frame uploads at most upload_budget bytes, the frame count and time
+//   until all images are ready are logged together with the loader statistics
+// - 'r' loads the images again, 'w' loads them again and waits for all decodes
+//   before rendering so only the upload frames are counted
+
+static int winx = 1024;
+static int winy = 1024;
+
+const scm::size_t   upload_budget  = 4 * 1024 * 1024;
+const unsigned      decode_threads = 2;
+
+class demo_app
+{
+public:
+    demo_app(const std::vector<std::string>& file_names)
+      : _file_names(file_names)
+      , _frame_count(0)
+      , _all_ready(false)
+    {
+        _projection_matrix = scm::math::mat4f::identity();
+    }
+    virtual ~demo_app();
+
+    bool initialize();
+    void load_textures(bool wait_decoded);
+    void display();
+    void resize(int w, int h);
+
+private:
+    std::vector<std::string>                    _file_names;
+
+    scm::shared_ptr<scm::gl::render_device>     _device;
+    scm::shared_ptr<scm::gl::render_context>    _context;
+
+    scm::gl::async_texture_loader_ptr           _loader;
+    std::vector<scm::gl::async_texture_loader::texture_handle_ptr> _handles;
+
+    scm::gl::program_ptr                        _texture_shader;
+    scm::shared_ptr<scm::gl::quad_geometry>     _quad;
+    scm::gl::depth_stencil_state_ptr            _depth_no_z;
+    scm::gl::blend_state_ptr                    _no_blend;
+    scm::gl::sampler_state_ptr                  _filter_lin_mip;
+
+    scm::math::mat4f                            _projection_matrix;
+
+    scm::time::high_res_timer                   _load_timer;
+    unsigned                                    _frame_count;
+    bool                                        _all_ready;
+
+}; // class demo_app
+
+namespace  {
+
+scm::scoped_ptr<demo_app> _application;
+
+} // namespace
+
+demo_app::~demo_app()
+{
+    _handles.clear();
+    _loader.reset();
+
+    _texture_shader.reset();
+    _quad.reset();
+    _depth_no_z.reset();
+    _no_blend.reset();
+    _filter_lin_mip.reset();
+
+    _context.reset();
+    _device.reset();
+}
+
+bool
+demo_app::initialize()
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+    using boost::assign::list_of;
+
+    _device.reset(new scm::gl::render_device());
+    _context = _device->main_context();
+
+    scm::out() << *_device << scm::log::end;
+
+    std::string v_texture = "\
+        #version 330\n\
+        \
+        uniform mat4 mvp;\
+        out vec2 tex_coord;\
+        layout(location = 0) in vec3 in_position;\
+        layout(location = 2) in vec2 in_texture_coord;\
+        void main()\
+        {\
+            gl_Position = mvp * vec4(in_position, 1.0);\
+            tex_coord = in_texture_coord;\
+        }\
+        ";
+    std::string f_texture = "\
+        #version 330\n\
+        \
+        in vec2 tex_coord;\
+        uniform sampler2D in_texture;\
+        layout(location = 0) out vec4 out_color;\
+        void main()\
+        {\
+            out_color = vec4(texture(in_texture, tex_coord).rgb, 1.0);\
+        }\
+        ";
+    _texture_shader = _device->create_program(list_of(_device->create_shader(STAGE_VERTEX_SHADER, v_texture))
+                                                     (_device->create_shader(STAGE_FRAGMENT_SHADER, f_texture)));
+
+    if (!_texture_shader) {
+        scm::err() << "error creating shader program" << log::end;
+        return (false);
+    }
+
+    _quad.reset(new quad_geometry(_device, vec2f(0.0f, 0.0f), vec2f(1.0f, 1.0f)));
+    _depth_no_z     = _device->create_depth_stencil_state(false, false);
+    _no_blend       = _device->create_blend_state(false, FUNC_ONE, FUNC_ZERO, FUNC_ONE, FUNC_ZERO);
+    _filter_lin_mip = _device->create_sampler_state(FILTER_MIN_MAG_MIP_LINEAR, WRAP_CLAMP_TO_EDGE);
+
+    // the decode threads share the process wide worker pool for the mip map generation
+    _loader.reset(new async_texture_loader(_device, decode_threads));
+
+    load_textures(false);
+
+    return (true);
+}
+
+void
+demo_app::load_textures(bool wait_decoded)
+{
+    // releasing the old handles drops their requests still pending
+    _handles.clear();
+    _frame_count = 0;
+    _all_ready   = false;
+
+    _load_timer.start();
+    for (std::vector<std::string>::const_iterator f = _file_names.begin(); f != _file_names.end(); ++f) {
+        _handles.push_back(_loader->load_texture_2d(*f, true));
+    }
+
+    if (wait_decoded) {
+        _loader->wait_decoded();
+        _load_timer.stop();
+        scm::out() << "all textures decoded (elapsed time: " << std::fixed << std::setprecision(3)
+                   << scm::time::to_seconds(_load_timer.get_time()) << "s)" << scm::log::end;
+        _load_timer.start();
+    }
+}
+
+void
+demo_app::display()
+{
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    // upload the decoded images within the frame budget
+    _loader->update(_context, upload_budget);
+    ++_frame_count;
+
+    if (!_all_ready && _loader->pending_count() == 0) {
+        _load_timer.stop();
+        _all_ready = true;
+
+        const async_texture_loader::statistics s = _loader->current_statistics();
+        scm::out() << "all textures loaded"
+                   << " (files: " << _file_names.size()
+                   << ", frames: " << _frame_count
+                   << ", elapsed time: " << std::fixed << std::setprecision(3)
+                   << scm::time::to_seconds(_load_timer.get_time()) << "s"
+                   << ", decoded: " << s._decoded
+                   << ", uploaded: " << s._uploaded
+                   << " (" << static_cast<double>(s._uploaded_bytes) / (1024.0 * 1024.0) << "MiB)"
+                   << ", failed: " << s._failed << ")" << scm::log::end;
+    }
+
+    _context->clear_default_color_buffer(FRAMEBUFFER_BACK, vec4f(.2f, .2f, .2f, 1.0f));
+    _context->clear_default_depth_stencil_buffer();
+
+    _context->reset();
+    {
+        context_state_objects_guard csg(_context);
+        context_texture_units_guard tug(_context);
+
+        const unsigned columns = max(1u, static_cast<unsigned>(ceil(sqrt(static_cast<float>(_handles.size())))));
+        const unsigned rows    = max(1u, (static_cast<unsigned>(_handles.size()) + columns - 1) / columns);
+        const vec2f    cell    = vec2f(1.0f / columns, 1.0f / rows);
+
+        _context->set_default_frame_buffer();
+        _context->set_depth_stencil_state(_depth_no_z);
+        _context->set_blend_state(_no_blend);
+
+        _texture_shader->uniform_sampler("in_texture", 0);
+        _context->bind_program(_texture_shader);
+
+        for (unsigned i = 0; i < _handles.size(); ++i) {
+            mat4f mvp = _projection_matrix;
+            translate(mvp, (i % columns) * cell.x, 1.0f - (i / columns + 1) * cell.y, 0.0f);
+            scale(mvp, 0.95f * cell.x, 0.95f * cell.y, 1.0f);
+
+            _texture_shader->uniform("mvp", mvp);
+            _context->bind_texture(_handles[i]->texture(), _filter_lin_mip, 0);
+
+            _quad->draw(_context);
+        }
+    }
+
+    glutSwapBuffers();
+}
+
+void
+demo_app::resize(int w, int h)
+{
+    winx = w;
+    winy = h;
+
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    _context->set_viewport(viewport(vec2ui(0, 0), vec2ui(w, h)));
+
+    scm::math::ortho_matrix(_projection_matrix, 0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
+}
+
+void
+glut_display()
+{
+    if (_application)
+        _application->display();
+}
+
+void
+glut_resize(int w, int h)
+{
+    if (_application)
+        _application->resize(w, h);
+}
+
+void
+glut_idle()
+{
+    glutPostRedisplay();
+}
+
+void
+glut_keyboard(unsigned char key, int x, int y)
+{
+    switch (key) {
+        case 27: {
+            _application.reset();
+            std::cout << "reset application" << std::endl;
+            exit (0);
+                 }
+            break;
+        case 'f':
+            glutFullScreenToggle();
+            break;
+        case 'r':
+            _application->load_textures(false);
+            break;
+        case 'w':
+            _application->load_textures(true);
+            break;
+        default:
+            break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    scm::shared_ptr<scm::core>      scm_core(new scm::core(argc, argv));
+
+    std::vector<std::string> file_names;
+    for (int i = 1; i < argc; ++i) {
+        file_names.push_back(argv[i]);
+    }
+    if (file_names.empty()) {
+        file_names = boost::assign::list_of<std::string>
+            ("../../../../ex_glut_basic/res/textures/0001MM_diff.jpg")
+            ("../../../../ex_glut_basic/res/textures/0001MM_disp.jpg")
+            ("../../../../ex_glut_basic/res/textures/0001MM_normal.jpg")
+            ("../../../../ex_glut_basic/res/textures/0001MM_spec.jpg");
+    }
+
+    _application.reset(new demo_app(file_names));
+
+    glutInit(&argc, argv);
+    glutInitContextVersion(4, 2);
+    glutInitContextProfile(GLUT_CORE_PROFILE);
+
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_DEPTH | GLUT_RGBA | GLUT_ALPHA);
+    glutInitWindowSize(winx, winy);
+    glutCreateWindow("async texture loading");
+
+    if (!_application->initialize()) {
+        std::cout << "error initializing gl context" << std::endl;
+        return (-1);
+    }
+
+    glutReshapeFunc(glut_resize);
+    glutDisplayFunc(glut_display);
+    glutKeyboardFunc(glut_keyboard);
+    glutIdleFunc(glut_idle);
+
+    glutMainLoop();
+
+    return (0);
+}
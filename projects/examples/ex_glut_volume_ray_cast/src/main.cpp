@@ -133,6 +133,7 @@ private:
 
     scm::gl::texture_3d_ptr             _volume_texture;
     scm::gl::texture_1d_ptr             _colormap_texture;
+    scm::gl::volume_occupancy_grid_ptr  _occupancy_grid;
 
     scm::gl::depth_stencil_state_ptr    _depth_less;
 
@@ -181,6 +182,7 @@ demo_app::~demo_app()
 
     _volume_texture.reset();
     _colormap_texture.reset();
+    _occupancy_grid.reset();
 
     _no_blend.reset();
     _blend_omsa.reset();
@@ -331,7 +333,9 @@ demo_app::initialize()
 
     volume_loader loader;
     
-    _volume_texture = loader.load_texture_3d(*_device, "../../../res/volume/Engine_w256_h256_d256_c1_b8.raw", false);
+    // the occupancy grid for empty space skipping is built while the volume is streamed
+    _volume_texture = loader.load_volume_data_streaming(*_device, "../../../res/volume/Engine_w256_h256_d256_c1_b8.raw",
+                                                        64 * 1024 * 1024, &_occupancy_grid, vec3ui(8u));
 
 
     //_volume_texture = load_volume(*_device, "f:/data/src/Lux_Christopher_20999_4_1_mm_WT_w512_h512_d202_c1_b16.raw");
@@ -344,6 +348,19 @@ demo_app::initialize()
     //_volume_texture = load_volume(*_device, "e:/data/volume/general volumes/foot_w256_h256_d256_c1_b8.raw");
     _colormap_texture = create_color_map(*_device, 512, _alpha_transfer, _color_transfer);
 
+    // empty space skipping for the iso threshold of the shader (s > 0.3), the
+    // ramp lookup table threshold is lowered by one entry to stay conservative
+    if (_occupancy_grid) {
+        std::vector<float> iso_lut(256);
+        for (unsigned i = 0; i < iso_lut.size(); ++i) {
+            iso_lut[i] = static_cast<float>(i) / (iso_lut.size() - 1);
+        }
+        _occupancy_grid->classify(&iso_lut.front(), static_cast<unsigned>(iso_lut.size()), vec2f(0.0f, 1.0f), 0.3f - 1.0f / (iso_lut.size() - 1));
+        if (!_occupancy_grid->update_texture(*_device, _context)) {
+            _occupancy_grid.reset();
+        }
+    }
+
     // initialize geometry ////////////////////////////////////////////////////////////////////////
     unsigned max_dim = max(max(_volume_texture->descriptor()._size.x,
                                _volume_texture->descriptor()._size.y),
@@ -543,6 +560,11 @@ demo_app::display()
             _shader_program->uniform_sampler("volume_texture",    0);
             _shader_program->uniform_sampler("color_map_texture", 1);
             _shader_program->uniform_sampler("depth_texture",     2);
+            _shader_program->uniform_sampler("occupancy_grid",    3);
+            _shader_program->uniform("empty_space_skipping",       _occupancy_grid ? true : false);
+            if (_occupancy_grid) {
+                _shader_program->uniform("os_to_occupancy_grid",   _occupancy_grid->texture_to_grid_scale() / _max_volume_bounds);
+            }
 
             _shader_program->uniform_buffer("transform_matrices", 0);
 
@@ -560,6 +582,9 @@ demo_app::display()
             _context->bind_texture(_colormap_texture, _filter_linear, 1);
             //_context->bind_texture(_depth_buffer, _filter_nearest, 2);
             _context->bind_texture(_color_buffer, _filter_nearest, 2);
+            if (_occupancy_grid) {
+                _context->bind_texture(_occupancy_grid->texture(), _filter_nearest, 3);
+            }
 
             _box->draw(_context, geometry::MODE_SOLID);
         }
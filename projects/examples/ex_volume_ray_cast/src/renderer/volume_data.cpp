@@ -22,6 +22,7 @@
 #include <scm/core/numeric_types.h>
 #include <scm/core/time/high_res_timer.h>
 
+#include <scm/gl_util/data/analysis/volume_statistics.h>
 #include <scm/gl_util/data/analysis/transfer_function/build_lookup_table.h>
 
 #include <scm/gl_core/math.h>
@@ -126,6 +127,7 @@ volume_data::~volume_data()
 
     _volume_raw.reset();
     _color_alpha_map.reset();
+    _occupancy_grid.reset();
 
     _volume_block.reset();
 }
@@ -268,6 +270,12 @@ volume_data::color_alpha_map() const
     return _color_alpha_map;
 }
 
+const gl::volume_occupancy_grid_ptr&
+volume_data::occupancy_grid() const
+{
+    return _occupancy_grid;
+}
+
 const volume_data::color_map_ptr&
 volume_data::color_map() const
 {
@@ -366,32 +374,40 @@ volume_data::load_volume(const gl::render_device_ptr& in_device,
 
     _min_value = 0.0f;
     _max_value = 1.0f;
-    if (is_float_type(data_format)) {
-        out() << "determining floating point value range..." << log::end;
+    if (util::volume_statistics::format_supported(data_format)) {
+        out() << "computing volume statistics and occupancy grid..." << log::end;
         timer.start();
 
-        float* fp_data = reinterpret_cast<float*>(read_buffer.get());
-        size_t dcount  = static_cast<scm::size_t>(data_dimensions.x) * data_dimensions.y * data_dimensions.z * channel_count(data_format);
-        _min_value = boost::numeric::bounds<float>::highest();//(std::numeric_limits<float>::max)();
-        _max_value = boost::numeric::bounds<float>::lowest();//(std::numeric_limits<float>::min)();
-
-        for (size_t i = 0; i < dcount; ++i) {
-            _min_value = min(_min_value, fp_data[i]);
-            _max_value = max(_max_value, fp_data[i]);
-        }
-
-        if (abs(_min_value) > abs(_max_value)) {
-            _max_value = abs(_min_value);
+        util::volume_statistics vol_stats(data_dimensions, data_format, 256, vec3ui(16u));
+        if (!vol_stats.compute(read_buffer.get())) {
+            err() << log::warning
+                  << "volume_data::load_volume(): unable to compute volume statistics, "
+                  << "using default value range and no empty space skipping." << log::end;
         }
         else {
-            _min_value = -abs(_max_value);
+            if (is_float_type(data_format)) {
+                _min_value = boost::numeric::bounds<float>::highest();
+                _max_value = boost::numeric::bounds<float>::lowest();
+                for (unsigned c = 0; c < vol_stats.channel_count(); ++c) {
+                    _min_value = min(_min_value, static_cast<float>(vol_stats.min_value(c)));
+                    _max_value = max(_max_value, static_cast<float>(vol_stats.max_value(c)));
+                }
+
+                if (abs(_min_value) > abs(_max_value)) {
+                    _max_value = abs(_min_value);
+                }
+                else {
+                    _min_value = -abs(_max_value);
+                }
+            }
+            _occupancy_grid = make_shared<volume_occupancy_grid>(vol_stats);
+
+            timer.stop();
+            out() << "computing volume statistics and occupancy grid done"
+                  << " (grid dimensions: " << _occupancy_grid->grid_dimensions()
+                  << ", elapsed time: " << std::fixed << std::setprecision(3)
+                  << time::to_seconds(timer.get_time()) << "s)" << log::end;
         }
-
-        timer.stop();
-        out() << "etermining floating point value range"
-              << " (elapsed time: " << std::fixed << std::setprecision(3)
-              << time::to_seconds(timer.get_time()) << "s)" << log::end;
-
     }
     out() << "min_value: " << _min_value << ", max_value: " << _max_value << log::end;
 
@@ -468,7 +484,7 @@ volume_data::create_color_alpha_map(const gl::render_device_ptr& in_device,
 }
 
 bool
-volume_data::update_color_alpha_map(const gl::render_context_ptr& context) const
+volume_data::update_color_alpha_map(const gl::render_context_ptr& context)
 {
     using namespace scm::gl;
     using namespace scm::math;
@@ -531,6 +547,24 @@ volume_data::update_color_alpha_map(const gl::render_context_ptr& context) const
         return false;
     }
 
+    if (_occupancy_grid) {
+        out() << "classifying occupancy grid..." << log::end;
+        timer.start();
+        _occupancy_grid->classify(alpha_lut.get(), in_size, vec2f(_min_value, _max_value));
+        res = _occupancy_grid->update_texture(context->parent_device(), context);
+        timer.stop();
+        out() << "classifying occupancy grid done"
+              << " (occupied bricks: " << _occupancy_grid->occupied_brick_count()
+              << ", elapsed time: " << std::fixed << std::setprecision(3)
+              << time::to_seconds(timer.get_time()) << "s)" << log::end;
+
+        if (!res) {
+            err() << log::error
+                  << "volume_data::update_color_alpha_map(): error during occupancy grid texture update." << log::end;
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -560,6 +594,9 @@ volume_data::update(const gl::render_context_ptr& context,
         _volume_block->_sampling_distance           = vec4f(sample_distance(), sample_distance() / sample_distance_ref(), 0.0, 0.0);
         _volume_block->_os_camera_position          = mv_matrix_inv.column(3) / mv_matrix_inv.column(3).w;
         _volume_block->_value_range                 = vec4f(min_value(), max_value(), max_value() - min_value(), 1.0f / (max_value() - min_value()));
+        if (_occupancy_grid) {
+            _volume_block->_os_to_occupancy_grid    = vec4f(_occupancy_grid->texture_to_grid_scale() / extends(), 0.0f);
+        }
 
         _volume_block->_m_matrix                     = transform();
         _volume_block->_m_matrix_inverse             = inverse(transform());
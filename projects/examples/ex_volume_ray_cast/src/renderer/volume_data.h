@@ -11,6 +11,7 @@
 #include <scm/core/math.h>
 
 #include <scm/gl_util/data/analysis/transfer_function/piecewise_function_1d.h>
+#include <scm/gl_util/data/volume/volume_occupancy_grid.h>
 
 #include <scm/gl_core/gl_core_fwd.h>
 #include <scm/gl_core/buffer_objects/uniform_buffer_adaptor.h>
@@ -42,6 +43,7 @@ public:
         math::vec4f _sampling_distance;  // yzw unused
         math::vec4f _os_camera_position;
         math::vec4f _value_range;
+        math::vec4f _os_to_occupancy_grid; // w unused
 
         math::mat4f _m_matrix;
         math::mat4f _m_matrix_inverse;
@@ -95,6 +97,7 @@ public:
 
     const gl::texture_3d_ptr&           volume_raw() const;
     const gl::texture_1d_ptr&           color_alpha_map() const;
+    const gl::volume_occupancy_grid_ptr& occupancy_grid() const;
 
     const color_map_ptr&                color_map() const;
     const alpha_map_ptr&                alpha_map() const;
@@ -109,7 +112,7 @@ protected:
                                                     const std::string&           in_file_name);
     gl::texture_1d_ptr                  create_color_alpha_map(const gl::render_device_ptr& in_device,
                                                                      unsigned               in_size) const;
-    bool                                update_color_alpha_map(const gl::render_context_ptr& context) const;
+    bool                                update_color_alpha_map(const gl::render_context_ptr& context);
 
 protected:
     math::vec3f                         _extends;
@@ -136,6 +139,7 @@ protected:
     gl::texture_buffer_ptr              _texture_handles;
     gl::texture_3d_ptr                  _volume_raw;
     gl::texture_1d_ptr                  _color_alpha_map;
+    gl::volume_occupancy_grid_ptr       _occupancy_grid;
     bool                                _color_alpha_map_dirty;
     gl::sampler_state_ptr               _sstate_linear;
 
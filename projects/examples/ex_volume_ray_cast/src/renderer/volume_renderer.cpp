@@ -4,6 +4,7 @@
 
 #include "volume_renderer.h"
 
+#include <cmath>
 #include <exception>
 #include <stdexcept>
 #include <sstream>
@@ -106,6 +107,16 @@ volume_renderer::draw(const gl::render_context_ptr& context,
 
     _program->uniform("volume_lod", vdata->selected_lod());
 
+    // the occupancy grid is classified against the color map, the brick ranges
+    // are dilated by one brick which covers the filter footprint of the mip
+    // levels up to log2(brick size) - 1
+    bool skip_empty_space = false;
+    if (mode == volume_color_map && vdata->occupancy_grid() && vdata->occupancy_grid()->texture()) {
+        const vec3ui& bdim = vdata->occupancy_grid()->brick_dimensions();
+        skip_empty_space   = vdata->selected_lod() <= std::log(static_cast<float>(min(min(bdim.x, bdim.y), bdim.z))) / std::log(2.0f) - 1.0f;
+    }
+    _program->uniform("empty_space_skipping", skip_empty_space);
+
     context_state_objects_guard     csg(context);
     context_texture_units_guard     tug(context);
     context_uniform_buffer_guard    ubg(context);
@@ -129,6 +140,9 @@ volume_renderer::draw(const gl::render_context_ptr& context,
 #else
     context->bind_texture(vdata->texture_handles(), _sstate_nearest, 4);
 #endif SCM_TEXT_NV_BINDLESS_TEXTURES != 1
+    if (skip_empty_space) {
+        context->bind_texture(vdata->occupancy_grid()->texture(), _sstate_nearest, 3);
+    }
 
     vdata->bbox_geometry()->draw(context, geometry::MODE_SOLID);
 }
@@ -173,6 +187,7 @@ volume_renderer::reload_shaders(const gl::render_device_ptr& device)
 
     _program->uniform_sampler("volume_raw",     0);
     _program->uniform_sampler("color_map",      2);
+    _program->uniform_sampler("occupancy_grid", 3);
 
     _program->uniform_buffer("camera_matrices",     0);
     _program->uniform_buffer("volume_uniform_data", 1);
@@ -14,6 +14,7 @@
 #include <scm/log.h>
 #include <scm/time.h>
 #include <scm/core/version.h>
+#include <scm/core/io/io_thread_pool.h>
 #include <scm/core/log/logger_state.h>
 #include <scm/core/log/listener_file.h>
 #include <scm/core/log/listener_ostream.h>
@@ -154,6 +155,14 @@ core::command_line_positions()
     return (_command_line_positions);
 }
 
+io::io_thread_pool&
+core::io_threads() const
+{
+    assert(_io_thread_pool);
+
+    return (*_io_thread_pool);
+}
+
 bool
 core::initialize(int argc, char **argv)
 {
@@ -171,7 +180,9 @@ core::initialize(int argc, char **argv)
     _system_state = ss_init;
 
     _command_line_options.add_options()
-            ("help", "show this help message");
+            ("help", "show this help message")
+            ("io-threads", boost::program_options::value<scm::int32>()->default_value(io::detail::default_io_thread_count),
+                           "number of threads executing asynchronous io requests");
 
     scm::out() << log::info
                << " - parsing command line options" << log::end;
@@ -181,6 +192,10 @@ core::initialize(int argc, char **argv)
         return (false);
     }
 
+    scm::out() << log::info
+               << " - starting io threads" << log::end;
+    _io_thread_pool.reset(new io::io_thread_pool(_command_line["io-threads"].as<scm::int32>()));
+
     scm::out() << log::info
                << " - running post core init functions" << log::end;
 
@@ -210,6 +225,12 @@ core::shutdown()
     }
 
     // shutdown core
+    if (_io_thread_pool) {
+        scm::out() << log::info
+                   << " - stopping io threads" << log::end;
+        _io_thread_pool->shutdown();
+        _io_thread_pool.reset();
+    }
 
     scm::out() << log::info
                << " - running post core shutdown functions" << log::end;
@@ -23,6 +23,11 @@
 #include <scm/core/module/initializer.h>
 
 namespace scm {
+namespace io {
+
+class io_thread_pool;
+
+} // namespace io
 
 class __scm_export(core) core : boost::noncopyable
 {
@@ -58,6 +63,10 @@ public:
                                                                      const std::string& module);
     command_line_position_desc&             command_line_positions();
 
+    // threads executing asynchronous io requests (e.g. file::read_async),
+    // the thread count is set through the 'io-threads' command line option
+    io::io_thread_pool&                     io_threads() const;
+
 protected:
     bool                                    initialize(int argc, char **argv);
     bool                                    shutdown();
@@ -75,6 +84,8 @@ protected:
     command_line_desc_container             _module_options;
     command_line_result                     _command_line;
 
+    scm::shared_ptr<io::io_thread_pool>     _io_thread_pool;
+
 private:
     static core*                            _instance;
 
@@ -0,0 +1,185 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "async_read_request.h"
+
+#include <cassert>
+#include <exception>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/chrono.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/log.h>
+#include <scm/core/io/file_core.h>
+
+namespace scm {
+namespace io {
+
+async_read_request::async_read_request(const shared_ptr<file_core>& fcore,
+                                       void*                        output_buffer,
+                                       offset_type                  start_position,
+                                       size_type                    num_bytes_to_read,
+                                       const completion_callback&   callback)
+  : _file_core(fcore)
+  , _output_buffer(output_buffer)
+  , _start_position(start_position)
+  , _num_bytes_to_read(num_bytes_to_read)
+  , _callback(callback)
+  , _state(request_pending)
+  , _bytes_read(0)
+  , _done(false)
+{
+    assert(_file_core);
+}
+
+async_read_request::~async_read_request()
+{
+}
+
+async_read_request::request_state
+async_read_request::state() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return (_state);
+}
+
+bool
+async_read_request::poll() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return (_done);
+}
+
+void
+async_read_request::wait() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (!_done) {
+        _finished.wait(lock);
+    }
+}
+
+bool
+async_read_request::wait(const time::time_duration& timeout) const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    const boost::chrono::steady_clock::time_point   deadline =   boost::chrono::steady_clock::now()
+                                                               + boost::chrono::nanoseconds(timeout.total_nanoseconds());
+
+    while (!_done) {
+        if (_finished.wait_until(lock, deadline) == boost::cv_status::timeout) {
+            return (_done);
+        }
+    }
+
+    return (true);
+}
+
+bool
+async_read_request::cancel()
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        if (_state != request_pending) {
+            return (_state == request_cancelled);
+        }
+        _state = request_running; // reserve the request for this thread
+    }
+    finish(request_cancelled, 0);
+
+    return (true);
+}
+
+size_type
+async_read_request::bytes_read() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return (_bytes_read);
+}
+
+void*
+async_read_request::output_buffer() const
+{
+    return (_output_buffer);
+}
+
+offset_type
+async_read_request::start_position() const
+{
+    return (_start_position);
+}
+
+size_type
+async_read_request::num_bytes_to_read() const
+{
+    return (_num_bytes_to_read);
+}
+
+void
+async_read_request::execute()
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        if (_state != request_pending) {
+            // cancelled
+            return;
+        }
+        _state = request_running;
+    }
+
+    size_type   r = 0;
+    {
+        // file cores are not thread safe, serialize all requests on the same file
+        boost::mutex::scoped_lock   file_lock(_file_core->request_mutex());
+
+        if (_file_core->is_open()) {
+            r = _file_core->read(_output_buffer, _start_position, _num_bytes_to_read);
+        }
+    }
+
+    // reading at the end of file is not an error
+    finish((r > 0 || r == -1 || _num_bytes_to_read <= 0) ? request_completed : request_failed, r);
+}
+
+void
+async_read_request::finish(request_state s, size_type r)
+{
+    // the callback sees the final state, waiters are released after the
+    // callback so the buffer is fully processed when wait() returns
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        _bytes_read = r;
+        _state      = s;
+    }
+
+    if (_callback) {
+        try {
+            _callback(*this);
+        }
+        catch (std::exception& e) {
+            scm::err() << log::error
+                       << "async_read_request::finish(): "
+                       << "unhandled exception in completion callback (" << e.what() << ")" << log::end;
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        _done = true;
+    }
+    _finished.notify_all();
+}
+
+} // namespace io
+} // namespace scm
@@ -0,0 +1,101 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_CORE_IO_ASYNC_READ_REQUEST_H_INCLUDED
+#define SCM_CORE_IO_ASYNC_READ_REQUEST_H_INCLUDED
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/memory.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/io/io_fwd.h>
+#include <scm/core/time/time_types.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace io {
+
+class file_core;
+
+// handle to a read operation issued through file::read_async
+// - the output buffer has to stay valid until the request is finished
+// - the completion callback is called exactly once when the request finishes
+//   (completed, failed or cancelled), either from an io thread or from the
+//   thread cancelling the request, so it should not block
+class __scm_export(core) async_read_request : boost::noncopyable
+{
+public:
+    typedef enum {
+        request_pending     = 0x00,
+        request_running,
+        request_completed,
+        request_failed,
+        request_cancelled
+    } request_state;
+
+    typedef boost::function<void (const async_read_request&)>   completion_callback;
+
+public:
+    async_read_request(const shared_ptr<file_core>& fcore,
+                       void*                        output_buffer,
+                       offset_type                  start_position,
+                       size_type                    num_bytes_to_read,
+                       const completion_callback&   callback);
+    virtual ~async_read_request();
+
+    request_state               state() const;
+
+    // true if the request is finished (completed, failed or cancelled)
+    bool                        poll() const;
+    void                        wait() const;
+    // returns false if the request did not finish in time
+    bool                        wait(const time::time_duration& timeout) const;
+
+    // cancel a request not yet picked up by an io thread, running requests
+    // can not be cancelled and false is returned
+    bool                        cancel();
+
+    // file::read result, only valid after completion
+    size_type                   bytes_read() const;
+
+    void*                       output_buffer() const;
+    offset_type                 start_position() const;
+    size_type                   num_bytes_to_read() const;
+
+    // executed by the io thread pool
+    void                        execute();
+
+private:
+    void                        finish(request_state s, size_type r);
+
+private:
+    shared_ptr<file_core>       _file_core;
+
+    void*                       _output_buffer;
+    offset_type                 _start_position;
+    size_type                   _num_bytes_to_read;
+
+    completion_callback         _callback;
+
+    mutable boost::mutex                _mutex;
+    mutable boost::condition_variable   _finished;
+    request_state                       _state;
+    size_type                           _bytes_read;
+    bool                                _done;          // set after the callback returned
+
+}; // class async_read_request
+
+} // namespace io
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_CORE_IO_ASYNC_READ_REQUEST_H_INCLUDED
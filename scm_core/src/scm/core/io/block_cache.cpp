@@ -0,0 +1,536 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "block_cache.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/log.h>
+#include <scm/core/math/math.h>
+
+#if SCM_PLATFORM == SCM_PLATFORM_WINDOWS
+#include <malloc.h>
+#endif // SCM_PLATFORM == SCM_PLATFORM_WINDOWS
+
+SCM_SINGLETON_PLACEMENT(core, scm::io::block_cache)
+
+namespace {
+
+const std::size_t page_memory_alignment = 4096;
+
+char*
+allocate_page_memory(scm::io::size_type size)
+{
+#if SCM_PLATFORM == SCM_PLATFORM_WINDOWS
+    return (static_cast<char*>(_aligned_malloc(static_cast<std::size_t>(size), page_memory_alignment)));
+#else
+    void* mem = 0;
+    if (0 != ::posix_memalign(&mem, page_memory_alignment, static_cast<std::size_t>(size))) {
+        return (0);
+    }
+    return (static_cast<char*>(mem));
+#endif
+}
+
+void
+free_page_memory(char* mem)
+{
+#if SCM_PLATFORM == SCM_PLATFORM_WINDOWS
+    _aligned_free(mem);
+#else
+    ::free(mem);
+#endif
+}
+
+} // namespace
+
+namespace scm {
+namespace io {
+
+block_cache_source::~block_cache_source()
+{
+}
+
+block_cache::statistics::statistics()
+  : _hits(0)
+  , _misses(0)
+  , _evictions(0)
+  , _read_ahead_pages(0)
+  , _read_ahead_hits(0)
+  , _bypassed_requests(0)
+  , _resident_bytes(0)
+{
+}
+
+block_cache::page_slot::page_slot()
+  : _data(0)
+  , _key(0, -1)
+  , _valid_bytes(0)
+  , _pins(0)
+  , _used(false)
+  , _loading(false)
+  , _referenced(false)
+  , _read_ahead(false)
+{
+}
+
+block_cache::file_state::file_state()
+  : _last_page(-2)
+  , _sequential_run(0)
+  , _read_ahead_end(0)
+{
+}
+
+block_cache::block_cache()
+  : _memory_budget(0)
+  , _page_size(detail::default_cache_page_size)
+  , _read_ahead_pages(0)
+  , _clock_hand(0)
+  , _pinned_pages(0)
+  , _read_ahead_busy(false)
+  , _shutdown(false)
+{
+}
+
+block_cache::~block_cache()
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        _shutdown = true;
+        _read_ahead_queue.clear();
+        _read_ahead_pending.notify_all();
+    }
+    if (_read_ahead_thread) {
+        _read_ahead_thread->join();
+        _read_ahead_thread.reset();
+    }
+    release_memory();
+}
+
+void
+block_cache::configure(size_type     memory_budget,
+                       size_type     page_size,
+                       scm::int32    read_ahead_pages)
+{
+    assert(page_size > 0);
+    assert(page_size % page_memory_alignment == 0);
+
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        // wait for all outstanding page accesses
+        _read_ahead_queue.clear();
+        while (_read_ahead_busy || _pinned_pages > 0) {
+            _page_loaded.wait(lock);
+        }
+
+        release_memory();
+
+        _memory_budget      = math::max<size_type>(0, memory_budget);
+        _page_size          = page_size;
+        _read_ahead_pages   = math::max(0, read_ahead_pages);
+
+        _slots.resize(static_cast<std::size_t>(_memory_budget / _page_size));
+        _free_slots.reserve(_slots.size());
+        for (scm::int32 i = static_cast<scm::int32>(_slots.size()) - 1; i >= 0; --i) {
+            _free_slots.push_back(i);
+        }
+    }
+
+    if (_read_ahead_pages > 0 && !_read_ahead_thread) {
+        _read_ahead_thread.reset(new boost::thread(boost::bind(&block_cache::read_ahead_thread, this)));
+    }
+}
+
+void
+block_cache::clear()
+{
+    configure(_memory_budget, _page_size, _read_ahead_pages);
+}
+
+bool
+block_cache::enabled() const
+{
+    return (_memory_budget >= _page_size);
+}
+
+size_type
+block_cache::memory_budget() const
+{
+    return (_memory_budget);
+}
+
+size_type
+block_cache::page_size() const
+{
+    return (_page_size);
+}
+
+scm::int32
+block_cache::read_ahead_pages() const
+{
+    return (_read_ahead_pages);
+}
+
+bool
+block_cache::cacheable(size_type num_bytes_to_read) const
+{
+    if (enabled() && num_bytes_to_read <= _memory_budget / 4) {
+        return (true);
+    }
+    else {
+        boost::mutex::scoped_lock   lock(_mutex);
+        ++const_cast<statistics&>(_statistics)._bypassed_requests;
+        return (false);
+    }
+}
+
+size_type
+block_cache::read(const block_cache_source_ptr&  source,
+                  void*                          output_buffer,
+                  offset_type                    start_position,
+                  size_type                      num_bytes_to_read)
+{
+    assert(source);
+
+    if (num_bytes_to_read <= 0) {
+        return (0);
+    }
+
+    const size_type file_size = source->size();
+
+    if (start_position >= file_size) {
+        // eof
+        return (-1);
+    }
+
+    num_bytes_to_read = math::min(num_bytes_to_read, file_size - start_position);
+
+    char*       output_byte_buffer  = reinterpret_cast<char*>(output_buffer);
+    size_type   bytes_read          = 0;
+
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    if (_slots.empty()) {
+        return (0);
+    }
+
+    // map the file identifier to a compact file index
+    scm::uint32             file = 0;
+    file_map::iterator      f    = _files.find(source->identifier());
+    if (f != _files.end()) {
+        file = f->second;
+    }
+    else {
+        file = static_cast<scm::uint32>(_file_states.size());
+        _files.insert(file_map::value_type(source->identifier(), file));
+        _file_states.push_back(file_state());
+    }
+
+    const scm::int64 first_page = start_position / _page_size;
+    const scm::int64 last_page  = (start_position + num_bytes_to_read - 1) / _page_size;
+
+    for (scm::int64 page = first_page; page <= last_page; ++page) {
+        scm::int32 slot = acquire_page(source, file, page, false, lock);
+
+        if (slot < 0) {
+            // all pages pinned or read error, the caller reads the rest directly
+            break;
+        }
+
+        const page_slot&    s           = _slots[slot];
+        const offset_type   page_offset = (start_position + bytes_read) - page * _page_size;
+        const size_type     copy_bytes  = math::min(s._valid_bytes - page_offset, num_bytes_to_read - bytes_read);
+
+        if (copy_bytes > 0) {
+            // the page is pinned, so we can copy without holding the lock
+            lock.unlock();
+            std::memcpy(output_byte_buffer + bytes_read, s._data + page_offset, static_cast<std::size_t>(copy_bytes));
+            lock.lock();
+
+            bytes_read += copy_bytes;
+        }
+        release_page(slot);
+
+        if (copy_bytes <= 0) {
+            break;
+        }
+    }
+
+    // sequential pattern detection
+    file_state& fs = _file_states[file];
+
+    if (first_page == fs._last_page || first_page == fs._last_page + 1) {
+        ++fs._sequential_run;
+    }
+    else {
+        fs._sequential_run = 0;
+        fs._read_ahead_end = 0;
+    }
+    fs._last_page = last_page;
+
+    if (fs._sequential_run > 0 && _read_ahead_pages > 0) {
+        const scm::int64 file_pages = (file_size + _page_size - 1) / _page_size;
+        const scm::int64 ra_begin   = math::max(last_page + 1, fs._read_ahead_end);
+        const scm::int64 ra_end     = math::min(last_page + 1 + _read_ahead_pages, file_pages);
+
+        for (scm::int64 page = ra_begin; page < ra_end; ++page) {
+            schedule_read_ahead(source, file, page);
+        }
+        fs._read_ahead_end = math::max(fs._read_ahead_end, ra_end);
+    }
+
+    return (bytes_read);
+}
+
+block_cache::statistics
+block_cache::current_statistics() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    statistics  stats = _statistics;
+
+    stats._resident_bytes = 0;
+    for (std::vector<page_slot>::const_iterator s = _slots.begin(); s != _slots.end(); ++s) {
+        if (s->_used) {
+            stats._resident_bytes += _page_size;
+        }
+    }
+
+    return (stats);
+}
+
+void
+block_cache::reset_statistics()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    _statistics = statistics();
+}
+
+scm::int32
+block_cache::acquire_page(const block_cache_source_ptr&      source,
+                          scm::uint32                        file,
+                          scm::int64                         page,
+                          bool                               read_ahead,
+                          boost::mutex::scoped_lock&         lock)
+{
+    const page_key  key(file, page);
+
+    // look for a resident page
+    for (page_map::iterator p = _pages.find(key); p != _pages.end(); p = _pages.find(key)) {
+        page_slot& s = _slots[p->second];
+
+        if (read_ahead) {
+            // nothing to do
+            return (-1);
+        }
+        if (s._loading) {
+            // another thread is loading this page
+            _page_loaded.wait(lock);
+            continue;
+        }
+
+        ++_statistics._hits;
+        if (s._read_ahead) {
+            ++_statistics._read_ahead_hits;
+            s._read_ahead = false;
+        }
+        s._referenced = true;
+        ++s._pins;
+        ++_pinned_pages;
+
+        return (p->second);
+    }
+
+    // page miss, load the page
+    if (!read_ahead) {
+        ++_statistics._misses;
+    }
+
+    scm::int32 slot = allocate_slot();
+    if (slot < 0) {
+        return (-1);
+    }
+
+    page_slot& s = _slots[slot];
+
+    if (s._data == 0) {
+        s._data = allocate_page_memory(_page_size);
+        if (s._data == 0) {
+            scm::err() << log::error
+                       << "block_cache::acquire_page(): "
+                       << "error allocating page memory (page size: " << _page_size << ")" << log::end;
+            _free_slots.push_back(slot);
+            return (-1);
+        }
+    }
+
+    s._key          = key;
+    s._used         = true;
+    s._loading      = true;
+    s._referenced   = true;
+    s._read_ahead   = read_ahead;
+    s._valid_bytes  = 0;
+    s._pins         = 1;
+    ++_pinned_pages;
+
+    _pages.insert(page_map::value_type(key, slot));
+
+    char*   page_data = s._data;
+
+    lock.unlock();
+    size_type page_bytes_read = source->read_page(page_data, page * _page_size, _page_size);
+    lock.lock();
+
+    page_slot& ls = _slots[slot];
+
+    ls._loading = false;
+    _page_loaded.notify_all();
+
+    if (page_bytes_read < 0) {
+        _pages.erase(key);
+        ls._used = false;
+        ls._pins = 0;
+        --_pinned_pages;
+        _free_slots.push_back(slot);
+
+        return (-1);
+    }
+
+    ls._valid_bytes = page_bytes_read;
+
+    if (read_ahead) {
+        ++_statistics._read_ahead_pages;
+    }
+
+    return (slot);
+}
+
+void
+block_cache::release_page(scm::int32 slot)
+{
+    assert(_slots[slot]._pins > 0);
+
+    --_slots[slot]._pins;
+    --_pinned_pages;
+
+    if (_pinned_pages == 0) {
+        _page_loaded.notify_all();
+    }
+}
+
+scm::int32
+block_cache::allocate_slot()
+{
+    if (!_free_slots.empty()) {
+        scm::int32 slot = _free_slots.back();
+        _free_slots.pop_back();
+        return (slot);
+    }
+
+    // CLOCK: referenced pages get a second chance, pinned pages are skipped
+    const scm::int32 slot_count = static_cast<scm::int32>(_slots.size());
+
+    for (scm::int32 n = 0; n < 2 * slot_count; ++n) {
+        scm::int32 slot = _clock_hand;
+        _clock_hand = (_clock_hand + 1) % slot_count;
+
+        page_slot& s = _slots[slot];
+
+        if (s._pins > 0 || s._loading) {
+            continue;
+        }
+        if (s._referenced) {
+            s._referenced = false;
+            continue;
+        }
+
+        _pages.erase(s._key);
+        s._used = false;
+        ++_statistics._evictions;
+
+        return (slot);
+    }
+
+    return (-1);
+}
+
+void
+block_cache::schedule_read_ahead(const block_cache_source_ptr&   source,
+                                 scm::uint32                     file,
+                                 scm::int64                      page)
+{
+    if (_pages.find(page_key(file, page)) != _pages.end()) {
+        return;
+    }
+
+    read_ahead_request  req;
+    req._source = source;
+    req._file   = file;
+    req._page   = page;
+
+    _read_ahead_queue.push_back(req);
+
+    // do not let the queue grow unbounded, old requests are the least useful
+    while (static_cast<scm::int32>(_read_ahead_queue.size()) > 4 * _read_ahead_pages) {
+        _read_ahead_queue.pop_front();
+    }
+
+    _read_ahead_pending.notify_one();
+}
+
+void
+block_cache::read_ahead_thread()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (true) {
+        while (!_shutdown && _read_ahead_queue.empty()) {
+            _read_ahead_pending.wait(lock);
+        }
+        if (_shutdown) {
+            break;
+        }
+
+        read_ahead_request  req = _read_ahead_queue.front();
+        _read_ahead_queue.pop_front();
+
+        _read_ahead_busy = true;
+
+        scm::int32 slot = acquire_page(req._source, req._file, req._page, true, lock);
+        if (slot >= 0) {
+            release_page(slot);
+        }
+
+        _read_ahead_busy = false;
+        _page_loaded.notify_all();
+    }
+}
+
+void
+block_cache::release_memory()
+{
+    for (std::vector<page_slot>::iterator s = _slots.begin(); s != _slots.end(); ++s) {
+        free_page_memory(s->_data);
+    }
+
+    _slots.clear();
+    _free_slots.clear();
+    _pages.clear();
+    _files.clear();
+    _file_states.clear();
+
+    _clock_hand = 0;
+}
+
+} // namespace io
+} // namespace scm
@@ -0,0 +1,192 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_CORE_IO_BLOCK_CACHE_H_INCLUDED
+#define SCM_CORE_IO_BLOCK_CACHE_H_INCLUDED
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/memory.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/unordered_containers.h>
+#include <scm/core/io/io_fwd.h>
+#include <scm/core/utilities/singleton.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace io {
+namespace detail {
+
+const scm::int64    default_cache_page_size         = 64 * 1024;
+const scm::int32    default_cache_read_ahead_pages  = 8;
+
+} // namespace detail
+
+// a file the block cache can fetch pages from
+// - read_page needs to be thread safe, it is called from the read-ahead thread
+// - the identifier has to change when the file contents change (e.g. contain
+//   device, inode, size and modification time) so stale pages are never hit
+class __scm_export(core) block_cache_source : boost::noncopyable
+{
+public:
+    virtual ~block_cache_source();
+
+    virtual const std::string&  identifier() const = 0;
+    virtual size_type           size() const = 0;
+    virtual size_type           read_page(void*         output_buffer,
+                                          offset_type   start_position,
+                                          size_type     num_bytes_to_read) const = 0;
+
+}; // class block_cache_source
+
+typedef shared_ptr<block_cache_source>      block_cache_source_ptr;
+
+// process-wide cache of fixed size, aligned file pages
+// - disabled by default, enabled by configuring a memory budget
+// - CLOCK eviction (second chance approximation of LRU)
+// - sequential access patterns trigger read-ahead in a background thread
+class __scm_export(core) block_cache : boost::noncopyable
+{
+public:
+    struct __scm_export(core) statistics
+    {
+        statistics();
+
+        scm::uint64             _hits;
+        scm::uint64             _misses;
+        scm::uint64             _evictions;
+        scm::uint64             _read_ahead_pages;
+        scm::uint64             _read_ahead_hits;
+        scm::uint64             _bypassed_requests;
+        size_type               _resident_bytes;
+    }; // struct statistics
+
+private:
+    typedef std::pair<scm::uint32, scm::int64>              page_key;
+    typedef scm::unordered_map<page_key, scm::int32>        page_map;
+    typedef scm::unordered_map<std::string, scm::uint32>    file_map;
+
+    struct page_slot
+    {
+        page_slot();
+
+        char*                   _data;
+        page_key                _key;
+        size_type               _valid_bytes;
+        scm::int32              _pins;
+        bool                    _used;
+        bool                    _loading;
+        bool                    _referenced;
+        bool                    _read_ahead;
+    }; // struct page_slot
+
+    struct file_state
+    {
+        file_state();
+
+        scm::int64              _last_page;
+        scm::int32              _sequential_run;
+        scm::int64              _read_ahead_end;
+    }; // struct file_state
+
+    struct read_ahead_request
+    {
+        block_cache_source_ptr  _source;
+        scm::uint32             _file;
+        scm::int64              _page;
+    }; // struct read_ahead_request
+
+public:
+    block_cache();
+    virtual ~block_cache();
+
+    // a memory budget of 0 disables the cache, the page size needs to be a
+    // multiple of the volume sector size to work with unbuffered files
+    void                        configure(size_type     memory_budget,
+                                          size_type     page_size        = detail::default_cache_page_size,
+                                          scm::int32    read_ahead_pages = detail::default_cache_read_ahead_pages);
+    void                        clear();
+
+    bool                        enabled() const;
+    size_type                   memory_budget() const;
+    size_type                   page_size() const;
+    scm::int32                  read_ahead_pages() const;
+
+    // requests larger than a quarter of the budget bypass the cache
+    bool                        cacheable(size_type num_bytes_to_read) const;
+
+    // returns the number of bytes served from the cache starting at start_position
+    // or -1 at the end of file, the caller reads a remaining tail directly (e.g.
+    // when all pages are pinned or a page read failed)
+    size_type                   read(const block_cache_source_ptr&  source,
+                                     void*                          output_buffer,
+                                     offset_type                    start_position,
+                                     size_type                      num_bytes_to_read);
+
+    statistics                  current_statistics() const;
+    void                        reset_statistics();
+
+private:
+    scm::int32                  acquire_page(const block_cache_source_ptr&      source,
+                                             scm::uint32                        file,
+                                             scm::int64                         page,
+                                             bool                               read_ahead,
+                                             boost::mutex::scoped_lock&         lock);
+    void                        release_page(scm::int32                         slot);
+    scm::int32                  allocate_slot();
+
+    void                        schedule_read_ahead(const block_cache_source_ptr&   source,
+                                                    scm::uint32                     file,
+                                                    scm::int64                      page);
+    void                        read_ahead_thread();
+
+    void                        release_memory();
+
+private:
+    mutable boost::mutex        _mutex;
+    boost::condition_variable   _page_loaded;
+    boost::condition_variable   _read_ahead_pending;
+
+    size_type                   _memory_budget;
+    size_type                   _page_size;
+    scm::int32                  _read_ahead_pages;
+
+    std::vector<page_slot>      _slots;
+    std::vector<scm::int32>     _free_slots;
+    scm::int32                  _clock_hand;
+    scm::int32                  _pinned_pages;
+    page_map                    _pages;
+
+    file_map                    _files;
+    std::vector<file_state>     _file_states;
+
+    std::deque<read_ahead_request>  _read_ahead_queue;
+    scm::shared_ptr<boost::thread>  _read_ahead_thread;
+    bool                            _read_ahead_busy;
+    bool                            _shutdown;
+
+    statistics                  _statistics;
+
+}; // class block_cache
+
+typedef singleton<block_cache>  global_block_cache;
+
+} // namespace io
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_CORE_IO_BLOCK_CACHE_H_INCLUDED
@@ -0,0 +1,560 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "async_io_linux.h"
+
+#if SCM_PLATFORM == SCM_PLATFORM_LINUX
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <linux/aio_abi.h>
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#   include <linux/io_uring.h>
+#   define SCM_IO_URING_SUPPORTED 1
+#else
+#   define SCM_IO_URING_SUPPORTED 0
+#endif
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#include <scm/log.h>
+#include <scm/core/math/math.h>
+
+namespace scm {
+namespace io {
+namespace detail {
+namespace {
+
+// io_uring ///////////////////////////////////////////////////////////////////////////////////////
+#if SCM_IO_URING_SUPPORTED == 1
+
+class async_io_context_io_uring : public async_io_context_linux
+{
+public:
+    async_io_context_io_uring(int fd, scm::int32 queue_depth)
+      : async_io_context_linux(fd, queue_depth)
+      , _ring_fd(-1)
+      , _sq_ring(MAP_FAILED)
+      , _sq_ring_size(0)
+      , _cq_ring(MAP_FAILED)
+      , _cq_ring_size(0)
+      , _sqes(MAP_FAILED)
+      , _sqes_size(0)
+    {
+    }
+    virtual ~async_io_context_io_uring() {
+        if (_ring_fd > -1) {
+            drain();
+        }
+        if (_sqes != MAP_FAILED) {
+            ::munmap(_sqes, _sqes_size);
+        }
+        if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring) {
+            ::munmap(_cq_ring, _cq_ring_size);
+        }
+        if (_sq_ring != MAP_FAILED) {
+            ::munmap(_sq_ring, _sq_ring_size);
+        }
+        if (_ring_fd > -1) {
+            ::close(_ring_fd);
+        }
+    }
+
+    bool initialize() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(io_uring_params));
+
+        _ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(_queue_depth), &params));
+        if (_ring_fd < 0) {
+            // ENOSYS on older kernels, EPERM if disabled through sysctl or seccomp
+            return (false);
+        }
+
+        _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_ring_size = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            _sq_ring_size = _cq_ring_size = math::max(_sq_ring_size, _cq_ring_size);
+        }
+
+        _sq_ring = ::mmap(0, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+        if (_sq_ring == MAP_FAILED) {
+            return (false);
+        }
+        if (single_mmap) {
+            _cq_ring = _sq_ring;
+        }
+        else {
+            _cq_ring = ::mmap(0, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+            if (_cq_ring == MAP_FAILED) {
+                return (false);
+            }
+        }
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes      = ::mmap(0, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+        if (_sqes == MAP_FAILED) {
+            return (false);
+        }
+
+        char* sq = static_cast<char*>(_sq_ring);
+        char* cq = static_cast<char*>(_cq_ring);
+
+        _sq_head    = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        _sq_tail    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        _sq_mask    = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        _sq_array   = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        _cq_head    = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        _cq_tail    = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        _cq_mask    = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        _cqes       = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        return (true);
+    }
+
+    engine_type engine() const {
+        return (engine_io_uring);
+    }
+
+    bool submit_read(async_request_linux* req) {
+        return (submit(IORING_OP_READV, req));
+    }
+
+    bool submit_write(async_request_linux* req) {
+        return (submit(IORING_OP_WRITEV, req));
+    }
+
+    bool query_results(std::vector<async_result_linux>& results,
+                       int                              max_results) {
+        assert(_requests_in_flight > 0);
+
+        unsigned head = *_cq_head;
+        unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+
+        while (head == tail) {
+            int ret = static_cast<int>(::syscall(__NR_io_uring_enter, _ring_fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0));
+            if (ret < 0 && errno != EINTR) {
+                scm::err() << log::error
+                           << "async_io_context_io_uring::query_results(): "
+                           << "error waiting for completion events (errno: " << errno << ")" << log::end;
+                return (false);
+            }
+            tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        }
+
+        while (head != tail && static_cast<int>(results.size()) < max_results) {
+            const io_uring_cqe& cqe = _cqes[head & *_cq_mask];
+
+            async_result_linux  res;
+            res._request         = reinterpret_cast<async_request_linux*>(static_cast<uintptr_t>(cqe.user_data));
+            res._bytes_processed = cqe.res < 0 ? 0 : cqe.res;
+            res._error           = cqe.res < 0 ? -cqe.res : 0;
+
+            results.push_back(res);
+            ++head;
+            --_requests_in_flight;
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+        return (true);
+    }
+
+private:
+    bool submit(unsigned char op, async_request_linux* req) {
+        unsigned tail  = *_sq_tail;
+        unsigned index = tail & *_sq_mask;
+
+        req->_iovec.iov_base = req->buffer();
+        req->_iovec.iov_len  = static_cast<size_t>(req->bytes_to_process());
+
+        io_uring_sqe& sqe = static_cast<io_uring_sqe*>(_sqes)[index];
+        std::memset(&sqe, 0, sizeof(io_uring_sqe));
+
+        sqe.opcode    = op;
+        sqe.fd        = _fd;
+        sqe.addr      = reinterpret_cast<uintptr_t>(&req->_iovec);
+        sqe.len       = 1;
+        sqe.off       = req->position();
+        sqe.user_data = reinterpret_cast<uintptr_t>(req);
+
+        _sq_array[index] = index;
+        __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        int ret = 0;
+        do {
+            ret = static_cast<int>(::syscall(__NR_io_uring_enter, _ring_fd, 1, 0, 0, 0, 0));
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret != 1) {
+            scm::err() << log::error
+                       << "async_io_context_io_uring::submit(): "
+                       << "error submitting request (errno: " << errno << ")" << log::end;
+            return (false);
+        }
+        ++_requests_in_flight;
+
+        return (true);
+    }
+
+private:
+    int                 _ring_fd;
+
+    void*               _sq_ring;
+    size_t              _sq_ring_size;
+    void*               _cq_ring;
+    size_t              _cq_ring_size;
+    void*               _sqes;
+    size_t              _sqes_size;
+
+    unsigned*           _sq_head;
+    unsigned*           _sq_tail;
+    unsigned*           _sq_mask;
+    unsigned*           _sq_array;
+    unsigned*           _cq_head;
+    unsigned*           _cq_tail;
+    unsigned*           _cq_mask;
+    io_uring_cqe*       _cqes;
+
+}; // class async_io_context_io_uring
+
+#endif // SCM_IO_URING_SUPPORTED == 1
+
+// kernel native aio //////////////////////////////////////////////////////////////////////////////
+class async_io_context_kernel_aio : public async_io_context_linux
+{
+public:
+    async_io_context_kernel_aio(int fd, scm::int32 queue_depth)
+      : async_io_context_linux(fd, queue_depth)
+      , _aio_context(0)
+      , _control_blocks(queue_depth)
+      , _free_control_blocks()
+    {
+        for (std::size_t i = 0; i < _control_blocks.size(); ++i) {
+            _free_control_blocks.push_back(&_control_blocks[i]);
+        }
+    }
+    virtual ~async_io_context_kernel_aio() {
+        if (_aio_context != 0) {
+            drain();
+            ::syscall(__NR_io_destroy, _aio_context);
+        }
+    }
+
+    bool initialize() {
+        if (::syscall(__NR_io_setup, static_cast<unsigned>(_queue_depth), &_aio_context) < 0) {
+            _aio_context = 0;
+            return (false);
+        }
+        return (true);
+    }
+
+    engine_type engine() const {
+        return (engine_kernel_aio);
+    }
+
+    bool submit_read(async_request_linux* req) {
+        return (submit(IOCB_CMD_PREAD, req));
+    }
+
+    bool submit_write(async_request_linux* req) {
+        return (submit(IOCB_CMD_PWRITE, req));
+    }
+
+    bool query_results(std::vector<async_result_linux>& results,
+                       int                              max_results) {
+        assert(_requests_in_flight > 0);
+
+        std::vector<io_event> events(math::min(max_results, _requests_in_flight));
+        int                   ret = 0;
+
+        do {
+            ret = static_cast<int>(::syscall(__NR_io_getevents, _aio_context, 1, static_cast<long>(events.size()), &events[0], 0));
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret < 0) {
+            scm::err() << log::error
+                       << "async_io_context_kernel_aio::query_results(): "
+                       << "error waiting for completion events (errno: " << errno << ")" << log::end;
+            return (false);
+        }
+
+        for (int i = 0; i < ret; ++i) {
+            iocb* cb = reinterpret_cast<iocb*>(static_cast<uintptr_t>(events[i].obj));
+
+            async_result_linux  res;
+            res._request         = reinterpret_cast<async_request_linux*>(static_cast<uintptr_t>(events[i].data));
+            res._bytes_processed = events[i].res < 0 ? 0 : events[i].res;
+            res._error           = events[i].res < 0 ? static_cast<int>(-events[i].res) : 0;
+
+            results.push_back(res);
+            _free_control_blocks.push_back(cb);
+            --_requests_in_flight;
+        }
+
+        return (true);
+    }
+
+private:
+    bool submit(unsigned short op, async_request_linux* req) {
+        assert(!_free_control_blocks.empty());
+
+        iocb* cb = _free_control_blocks.back();
+        std::memset(cb, 0, sizeof(iocb));
+
+        cb->aio_lio_opcode = op;
+        cb->aio_fildes     = static_cast<__u32>(_fd);
+        cb->aio_buf        = reinterpret_cast<uintptr_t>(req->buffer());
+        cb->aio_nbytes     = static_cast<__u64>(req->bytes_to_process());
+        cb->aio_offset     = req->position();
+        cb->aio_data       = reinterpret_cast<uintptr_t>(req);
+
+        int ret = 0;
+        do {
+            ret = static_cast<int>(::syscall(__NR_io_submit, _aio_context, 1, &cb));
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret != 1) {
+            scm::err() << log::error
+                       << "async_io_context_kernel_aio::submit(): "
+                       << "error submitting request (errno: " << errno << ")" << log::end;
+            return (false);
+        }
+        _free_control_blocks.pop_back();
+        ++_requests_in_flight;
+
+        return (true);
+    }
+
+private:
+    aio_context_t           _aio_context;
+    std::vector<iocb>       _control_blocks;
+    std::vector<iocb*>      _free_control_blocks;
+
+}; // class async_io_context_kernel_aio
+
+// synchronous fallback ///////////////////////////////////////////////////////////////////////////
+class async_io_context_synchronous : public async_io_context_linux
+{
+public:
+    async_io_context_synchronous(int fd, scm::int32 queue_depth)
+      : async_io_context_linux(fd, queue_depth)
+    {
+    }
+    virtual ~async_io_context_synchronous() {
+    }
+
+    engine_type engine() const {
+        return (engine_synchronous);
+    }
+
+    bool submit_read(async_request_linux* req) {
+        async_result_linux  res;
+        res._request = req;
+
+        ssize_t ret = 0;
+        do {
+            ret = ::pread64(_fd, req->buffer(), static_cast<size_t>(req->bytes_to_process()), req->position());
+        } while (ret < 0 && errno == EINTR);
+
+        res._bytes_processed = ret < 0 ? 0 : ret;
+        res._error           = ret < 0 ? errno : 0;
+
+        _finished.push_back(res);
+        ++_requests_in_flight;
+
+        return (true);
+    }
+
+    bool submit_write(async_request_linux* req) {
+        async_result_linux  res;
+        res._request = req;
+
+        ssize_t ret = 0;
+        do {
+            ret = ::pwrite64(_fd, req->buffer(), static_cast<size_t>(req->bytes_to_process()), req->position());
+        } while (ret < 0 && errno == EINTR);
+
+        res._bytes_processed = ret < 0 ? 0 : ret;
+        res._error           = ret < 0 ? errno : 0;
+
+        _finished.push_back(res);
+        ++_requests_in_flight;
+
+        return (true);
+    }
+
+    bool query_results(std::vector<async_result_linux>& results,
+                       int                              max_results) {
+        assert(_requests_in_flight > 0);
+
+        while (!_finished.empty() && static_cast<int>(results.size()) < max_results) {
+            results.push_back(_finished.front());
+            _finished.pop_front();
+            --_requests_in_flight;
+        }
+
+        return (true);
+    }
+
+private:
+    std::deque<async_result_linux>  _finished;
+
+}; // class async_io_context_synchronous
+
+} // namespace
+
+// async_request_linux ////////////////////////////////////////////////////////////////////////////
+async_request_linux::async_request_linux(const file::size_type size,
+                                         const scm::int32      alignment)
+  : _position(0)
+  , _bytes_to_process(0)
+  , _rw_buffer(0)
+  , _rw_buffer_size(size)
+{
+    void* buf = 0;
+    if (0 != ::posix_memalign(&buf, static_cast<size_t>(alignment), static_cast<size_t>(size))) {
+        scm::err() << log::error
+                   << "async_request_linux::async_request_linux(): "
+                   << "error allocating aligned request buffer "
+                   << "(size: " << size << ", alignment: " << alignment << ")" << log::end;
+        _rw_buffer_size = 0;
+    }
+    _rw_buffer = static_cast<file::char_type*>(buf);
+
+    _iovec.iov_base = _rw_buffer;
+    _iovec.iov_len  = 0;
+}
+
+async_request_linux::~async_request_linux()
+{
+    ::free(_rw_buffer);
+}
+
+void
+async_request_linux::position(const file::offset_type pos)
+{
+    _position = pos;
+}
+
+file::offset_type
+async_request_linux::position() const
+{
+    return (_position);
+}
+
+void
+async_request_linux::bytes_to_process(const file::size_type size)
+{
+    assert(size <= _rw_buffer_size);
+    _bytes_to_process = size;
+}
+
+file::size_type
+async_request_linux::bytes_to_process() const
+{
+    return (_bytes_to_process);
+}
+
+file::char_type*
+async_request_linux::buffer() const
+{
+    return (_rw_buffer);
+}
+
+file::size_type
+async_request_linux::buffer_size() const
+{
+    return (_rw_buffer_size);
+}
+
+// async_io_context_linux /////////////////////////////////////////////////////////////////////////
+async_io_context_linux::async_io_context_linux(int fd, scm::int32 queue_depth)
+  : _fd(fd)
+  , _queue_depth(queue_depth)
+  , _requests_in_flight(0)
+{
+}
+
+async_io_context_linux::~async_io_context_linux()
+{
+    assert(_requests_in_flight == 0);
+}
+
+scm::shared_ptr<async_io_context_linux>
+async_io_context_linux::create(int          fd,
+                               scm::int32   queue_depth)
+{
+    assert(fd > -1);
+    assert(queue_depth > 0);
+
+#if SCM_IO_URING_SUPPORTED == 1
+    {
+        scm::shared_ptr<async_io_context_io_uring> ctx(new async_io_context_io_uring(fd, queue_depth));
+        if (ctx->initialize()) {
+            return (ctx);
+        }
+    }
+#endif // SCM_IO_URING_SUPPORTED == 1
+    {
+        scm::shared_ptr<async_io_context_kernel_aio> ctx(new async_io_context_kernel_aio(fd, queue_depth));
+        if (ctx->initialize()) {
+            return (ctx);
+        }
+    }
+
+    return (scm::make_shared<async_io_context_synchronous>(fd, queue_depth));
+}
+
+const char*
+async_io_context_linux::engine_name() const
+{
+    switch (engine()) {
+        case engine_io_uring:       return ("io_uring");
+        case engine_kernel_aio:     return ("kernel aio");
+        case engine_synchronous:    return ("synchronous");
+        default:                    return ("unknown");
+    }
+}
+
+void
+async_io_context_linux::drain()
+{
+    std::vector<async_result_linux> results;
+
+    while (_requests_in_flight > 0) {
+        results.clear();
+        if (!query_results(results, _requests_in_flight)) {
+            scm::err() << log::error
+                       << "async_io_context_linux::drain(): "
+                       << "error waiting for outstanding requests "
+                       << "(" << _requests_in_flight << " requests in flight)" << log::end;
+            break;
+        }
+    }
+}
+
+scm::int32
+async_io_context_linux::requests_in_flight() const
+{
+    return (_requests_in_flight);
+}
+
+scm::int32
+async_io_context_linux::queue_depth() const
+{
+    return (_queue_depth);
+}
+
+} // namespace detail
+} // namespace io
+} // namespace scm
+
+#endif // SCM_PLATFORM == SCM_PLATFORM_LINUX
@@ -0,0 +1,119 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_CORE_IO_DETAIL_ASYNC_IO_LINUX_H_INCLUDED
+#define SCM_CORE_IO_DETAIL_ASYNC_IO_LINUX_H_INCLUDED
+
+#include <scm/core/platform/platform.h>
+
+#if SCM_PLATFORM == SCM_PLATFORM_LINUX
+
+#include <sys/uio.h>
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <scm/core/memory.h>
+#include <scm/core/io/file.h>
+
+namespace scm {
+namespace io {
+namespace detail {
+
+// a single asynchronous request using a volume sector aligned buffer
+// - the buffer is owned by the request and reused between requests
+struct async_request_linux : boost::noncopyable
+{
+    async_request_linux(const file::size_type size,
+                        const scm::int32      alignment);
+    ~async_request_linux();
+
+    void                                position(const file::offset_type pos);
+    file::offset_type                   position() const;
+
+    void                                bytes_to_process(const file::size_type size);
+    file::size_type                     bytes_to_process() const;
+
+    file::char_type*                    buffer() const;
+    file::size_type                     buffer_size() const;
+
+    // the io vector handed to the kernel, needs to stay valid while in flight
+    ::iovec                             _iovec;
+
+private:
+    file::offset_type                   _position;
+    file::size_type                     _bytes_to_process;
+
+    file::char_type*                    _rw_buffer;
+    file::size_type                     _rw_buffer_size;
+
+}; // struct async_request_linux
+
+typedef scm::shared_ptr<async_request_linux>    async_request_linux_ptr;
+
+struct async_result_linux
+{
+    async_result_linux() : _bytes_processed(0), _error(0), _request(0) {}
+
+    file::size_type         _bytes_processed;
+    int                     _error;
+    async_request_linux*    _request;
+}; // struct async_result_linux
+
+// abstract asynchronous io engine on top of a file descriptor
+// - io_uring (kernel >= 5.1), kernel native aio, synchronous pread/pwrite
+// - the engines are accessed directly through the system calls, so no
+//   external libraries (liburing, libaio) are required for building
+class async_io_context_linux : boost::noncopyable
+{
+public:
+    typedef enum {
+        engine_io_uring     = 0x00,
+        engine_kernel_aio,
+        engine_synchronous
+    } engine_type;
+
+public:
+    virtual ~async_io_context_linux();
+
+    // create the best engine available on the running system
+    static scm::shared_ptr<async_io_context_linux>  create(int          fd,
+                                                           scm::int32   queue_depth);
+
+    virtual engine_type         engine() const = 0;
+    const char*                 engine_name() const;
+
+    virtual bool                submit_read(async_request_linux* req) = 0;
+    virtual bool                submit_write(async_request_linux* req) = 0;
+
+    // wait for at least one request to finish, returns up to max_results results
+    virtual bool                query_results(std::vector<async_result_linux>& results,
+                                              int                              max_results) = 0;
+
+    // wait for all outstanding requests, results are discarded
+    void                        drain();
+
+    scm::int32                  requests_in_flight() const;
+    scm::int32                  queue_depth() const;
+
+protected:
+    async_io_context_linux(int fd, scm::int32 queue_depth);
+
+protected:
+    const int                   _fd;
+    const scm::int32            _queue_depth;
+    scm::int32                  _requests_in_flight;
+
+}; // class async_io_context_linux
+
+typedef scm::shared_ptr<async_io_context_linux> async_io_context_linux_ptr;
+
+} // namespace detail
+} // namespace io
+} // namespace scm
+
+#endif // SCM_PLATFORM == SCM_PLATFORM_LINUX
+
+#endif // SCM_CORE_IO_DETAIL_ASYNC_IO_LINUX_H_INCLUDED
@@ -0,0 +1,204 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "write_behind_writer.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/log.h>
+#include <scm/core/math/math.h>
+
+namespace {
+
+const std::size_t write_buffer_alignment = 4096;
+
+} // namespace
+
+namespace scm {
+namespace io {
+namespace detail {
+
+write_behind_writer::write_behind_writer(const file_ptr&     f,
+                                         scm::uint32         buffer_count,
+                                         scm::uint32         buffer_size)
+  : _file(f)
+  , _buffer_size(0)
+  , _current_buffer(-1)
+  , _failed(false)
+  , _shutdown(false)
+{
+    assert(_file);
+
+    // use full volume sectors to keep unbuffered writes free of read-modify-write cycles
+    _buffer_size = math::max<file::size_type>(_file->vss_align_ceil(buffer_size), _file->volume_sector_size());
+
+    _buffers.resize(math::max(2u, buffer_count));
+    for (scm::int32 i = 0; i < static_cast<scm::int32>(_buffers.size()); ++i) {
+        buffer& b = _buffers[i];
+
+        b._memory.resize(static_cast<std::size_t>(_buffer_size) + write_buffer_alignment);
+        std::size_t misalignment = reinterpret_cast<std::size_t>(&b._memory.front()) % write_buffer_alignment;
+        b._data = &b._memory.front() + (misalignment > 0 ? write_buffer_alignment - misalignment : 0);
+
+        _free_buffers.push_back(i);
+    }
+
+    _writer_thread.reset(new boost::thread(boost::bind(&write_behind_writer::writer_thread, this)));
+}
+
+write_behind_writer::~write_behind_writer()
+{
+    flush();
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+        _shutdown = true;
+    }
+    _buffer_queued.notify_all();
+    _writer_thread->join();
+}
+
+file::size_type
+write_behind_writer::write(const void*           input_buffer,
+                           file::offset_type     start_position,
+                           file::size_type       num_bytes_to_write)
+{
+    const char*         input_byte_buffer   = reinterpret_cast<const char*>(input_buffer);
+    file::offset_type   position            = start_position;
+    file::size_type     bytes_remaining     = num_bytes_to_write;
+
+    while (bytes_remaining > 0) {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        if (_failed) {
+            return (-1);
+        }
+        if (_current_buffer >= 0) {
+            const buffer& b = _buffers[_current_buffer];
+            if (   b._size > 0
+                && b._position + b._size != position) {
+                // not sequential, write out what we have
+                submit_current();
+            }
+        }
+        if (_current_buffer < 0) {
+            while (_free_buffers.empty() && !_failed) {
+                _buffer_written.wait(lock);
+            }
+            if (_failed) {
+                return (-1);
+            }
+            _current_buffer = _free_buffers.front();
+            _free_buffers.pop_front();
+        }
+
+        buffer& b = _buffers[_current_buffer];
+        if (b._size == 0) {
+            b._position = position;
+        }
+
+        // the current buffer is only touched by the writing thread, copy without the lock
+        lock.unlock();
+
+        const file::size_type copy_bytes = math::min(bytes_remaining, _buffer_size - b._size);
+        std::memcpy(b._data + b._size, input_byte_buffer, static_cast<std::size_t>(copy_bytes));
+
+        b._size             += copy_bytes;
+        position            += copy_bytes;
+        input_byte_buffer   += copy_bytes;
+        bytes_remaining     -= copy_bytes;
+
+        if (b._size == _buffer_size) {
+            lock.lock();
+            submit_current();
+        }
+    }
+
+    return (num_bytes_to_write);
+}
+
+bool
+write_behind_writer::flush()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    if (   _current_buffer >= 0
+        && _buffers[_current_buffer]._size > 0) {
+        submit_current();
+    }
+    while (!_queued_buffers.empty()) {
+        _buffer_written.wait(lock);
+    }
+
+    return (!_failed);
+}
+
+file::size_type
+write_behind_writer::buffer_size() const
+{
+    return (_buffer_size);
+}
+
+scm::uint32
+write_behind_writer::buffer_count() const
+{
+    return (static_cast<scm::uint32>(_buffers.size()));
+}
+
+void
+write_behind_writer::submit_current()
+{
+    // requires _mutex to be locked
+    assert(_current_buffer >= 0);
+
+    _queued_buffers.push_back(_current_buffer);
+    _current_buffer = -1;
+
+    _buffer_queued.notify_one();
+}
+
+void
+write_behind_writer::writer_thread()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (true) {
+        while (!_shutdown && _queued_buffers.empty()) {
+            _buffer_queued.wait(lock);
+        }
+        if (_queued_buffers.empty()) {
+            break;
+        }
+
+        // the buffer stays queued until written, so flush waits for it
+        buffer& b = _buffers[_queued_buffers.front()];
+
+        lock.unlock();
+        file::size_type bytes_written = _file->write(b._data, b._position, b._size);
+        lock.lock();
+
+        if (bytes_written != b._size) {
+            scm::err() << log::error
+                       << "write_behind_writer::writer_thread(): "
+                       << "error writing to file "
+                       << "(position " << b._position << ", size " << b._size << ") "
+                       << "'" << _file->file_path() << "'" << log::end;
+            _failed = true;
+        }
+
+        b._size = 0;
+        _free_buffers.push_back(_queued_buffers.front());
+        _queued_buffers.pop_front();
+
+        _buffer_written.notify_all();
+    }
+}
+
+} // namespace detail
+} // namespace io
+} // namespace scm
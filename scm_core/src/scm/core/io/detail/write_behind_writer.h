@@ -0,0 +1,93 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_CORE_IO_DETAIL_WRITE_BEHIND_WRITER_H_INCLUDED
+#define SCM_CORE_IO_DETAIL_WRITE_BEHIND_WRITER_H_INCLUDED
+
+#include <deque>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/memory.h>
+#include <scm/core/io/file.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace io {
+namespace detail {
+
+const scm::uint32   default_write_behind_buffer_size    = 4u * 1024u * 1024u;
+
+// collects writes in a small set of aligned buffers (double or triple
+// buffering) which are written out by a background thread
+// - sequential writes are coalesced into full buffers, a write to a
+//   non-contiguous position starts a new buffer
+// - buffers are written in submission order, so overlapping writes keep
+//   their order
+// - errors of the background writes are reported by the next write or flush
+class __scm_export(core) write_behind_writer : boost::noncopyable
+{
+    struct buffer
+    {
+        buffer() : _data(0), _position(0), _size(0) {}
+
+        std::vector<char>       _memory;
+        char*                   _data;
+        file::offset_type       _position;
+        file::size_type         _size;
+    }; // struct buffer
+
+public:
+    write_behind_writer(const file_ptr&     f,
+                        scm::uint32         buffer_count,
+                        scm::uint32         buffer_size = default_write_behind_buffer_size);
+    virtual ~write_behind_writer();
+
+    // returns num_bytes_to_write or -1 if a previous background write failed
+    file::size_type             write(const void*           input_buffer,
+                                      file::offset_type     start_position,
+                                      file::size_type       num_bytes_to_write);
+    // wait for all buffered data to reach the file
+    bool                        flush();
+
+    file::size_type             buffer_size() const;
+    scm::uint32                 buffer_count() const;
+
+private:
+    void                        submit_current();
+    void                        writer_thread();
+
+private:
+    file_ptr                    _file;
+    file::size_type             _buffer_size;
+
+    std::vector<buffer>         _buffers;
+    std::deque<scm::int32>      _free_buffers;
+    std::deque<scm::int32>      _queued_buffers;
+    scm::int32                  _current_buffer;
+
+    boost::mutex                _mutex;
+    boost::condition_variable   _buffer_queued;
+    boost::condition_variable   _buffer_written;
+    scm::shared_ptr<boost::thread>  _writer_thread;
+    bool                        _failed;
+    bool                        _shutdown;
+
+}; // class write_behind_writer
+
+} // namespace detail
+} // namespace io
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_CORE_IO_DETAIL_WRITE_BEHIND_WRITER_H_INCLUDED
@@ -6,6 +6,13 @@
 
 #include <cassert>
 
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core.h>
+#include <scm/core/io/io_thread_pool.h>
+
 #include <scm/core/io/file_core.h>
 #include <scm/core/io/file_core_win32.h>
 #include <scm/core/io/file_core_linux.h>
@@ -47,6 +54,7 @@ file::open(const std::string&       file_path,
            scm::uint32              async_io_requests)
 {
     assert(_file_core);
+    boost::mutex::scoped_lock   lock(_file_core->request_mutex());
     return _file_core->open(file_path,
                             open_mode,
                             disable_system_cache,
@@ -65,6 +73,7 @@ void
 file::close()
 {
     assert(_file_core);
+    boost::mutex::scoped_lock   lock(_file_core->request_mutex());
     _file_core->close();
 }
 
@@ -74,6 +83,7 @@ file::read(void*        output_buffer,
            size_type    num_bytes_to_read)
 {
     assert(_file_core);
+    boost::mutex::scoped_lock   lock(_file_core->request_mutex());
     return _file_core->read(output_buffer, start_position, num_bytes_to_read);
 }
 
@@ -83,9 +93,44 @@ file::write(const void* input_buffer,
             size_type   num_bytes_to_write)
 {
     assert(_file_core);
+    boost::mutex::scoped_lock   lock(_file_core->request_mutex());
     return _file_core->write(input_buffer, start_position, num_bytes_to_write);
 }
 
+file::size_type
+file::read_batch(const read_extent_array& extents)
+{
+    assert(_file_core);
+    boost::mutex::scoped_lock   lock(_file_core->request_mutex());
+    return _file_core->read_batch(extents);
+}
+
+async_read_request_ptr
+file::read_async(void*                                           output_buffer,
+                 offset_type                                     start_position,
+                 size_type                                       num_bytes_to_read,
+                 const async_read_request::completion_callback&  callback)
+{
+    assert(_file_core);
+
+    async_read_request_ptr  req(new async_read_request(_file_core,
+                                                       output_buffer,
+                                                       start_position,
+                                                       num_bytes_to_read,
+                                                       callback));
+
+    if (   core::check_instance()
+        && core::instance().system_state() == core::ss_running) {
+        core::instance().io_threads().submit(boost::bind(&async_read_request::execute, req));
+    }
+    else {
+        // no core io threads available, complete the request synchronously
+        req->execute();
+    }
+
+    return (req);
+}
+
 bool
 file::flush_buffers() const
 {
@@ -97,9 +142,19 @@ file::offset_type
 file::set_end_of_file()
 {
     assert(_file_core);
+    boost::mutex::scoped_lock   lock(_file_core->request_mutex());
     return _file_core->set_end_of_file();
 }
 
+file_mapping_ptr
+file::map(offset_type     offset,
+          size_type       size,
+          unsigned        hints) const
+{
+    assert(_file_core);
+    return _file_core->map(offset, size, hints);
+}
+
 // fixed functionality
 scm::int32
 file::volume_sector_size() const
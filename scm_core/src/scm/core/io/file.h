@@ -7,11 +7,14 @@
 
 #include <ios>
 #include <string>
+#include <vector>
 
 #include <scm/core/numeric_types.h>
 #include <scm/core/memory.h>
 
 #include <scm/core/io/io_fwd.h>
+#include <scm/core/io/async_read_request.h>
+#include <scm/core/io/file_mapping.h>
 
 #include <scm/core/platform/platform.h>
 #include <scm/core/utilities/platform_warning_disable.h>
@@ -22,6 +25,7 @@ namespace detail {
 
 const scm::uint32   default_io_block_size           = 32768u;
 const scm::uint32   default_asynchronous_requests   = 8u;
+const scm::int64    default_read_batch_gap_size     = 4096;    // gaps up to this size are read over
 
 } // namespace detail
 
@@ -34,6 +38,20 @@ public:
     typedef scm::io::size_type      size_type;
     typedef scm::io::offset_type    offset_type;
 
+    // a single scatter/gather read request: size bytes from the file
+    // at offset into the memory at buffer
+    struct read_extent
+    {
+        read_extent() : _offset(0), _buffer(0), _size(0) {}
+        read_extent(offset_type o, void* b, size_type s) : _offset(o), _buffer(b), _size(s) {}
+
+        offset_type     _offset;
+        void*           _buffer;
+        size_type       _size;
+    }; // struct read_extent
+
+    typedef std::vector<read_extent>    read_extent_array;
+
 public:
     file();
     virtual ~file();
@@ -54,11 +72,28 @@ public:
     size_type                   write(const void*    input_buffer,
                                       offset_type    start_position,
                                       size_type      num_bytes_to_write);
+    // read a batch of extents, neighboring extents are coalesced into as
+    // few system calls as possible, returns the sum of the bytes read
+    size_type                   read_batch(const read_extent_array& extents);
+    // issue a read on the io threads of scm::core and return immediately, the
+    // request keeps the file open until it is finished (see async_read_request)
+    async_read_request_ptr      read_async(void*           output_buffer,
+                                           offset_type     start_position,
+                                           size_type       num_bytes_to_read,
+                                           const async_read_request::completion_callback&
+                                                           callback = async_read_request::completion_callback());
     bool                        flush_buffers() const;
     offset_type                 seek(offset_type                off,
                                      std::ios_base::seek_dir    way);
     offset_type                 set_end_of_file();
 
+    // map a read-only view of the range [offset, offset + size) into memory,
+    // hints is a combination of file_mapping::access_hint flags
+    file_mapping_ptr            map(offset_type     offset,
+                                    size_type       size,
+                                    unsigned        hints = file_mapping::access_sequential
+                                                          | file_mapping::access_will_need) const;
+
     scm::int32                  volume_sector_size() const;
     offset_type                 vss_align_floor(const offset_type in_val) const;
     offset_type                 vss_align_ceil(const offset_type in_val) const;
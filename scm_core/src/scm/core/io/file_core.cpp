@@ -16,6 +16,30 @@ file_core::~file_core()
 {
 }
 
+file_core::size_type
+file_core::read_batch(const read_extent_array& extents)
+{
+    // generic implementation, platforms supporting vectored io override this
+    size_type   bytes_read = 0;
+
+    for (read_extent_array::const_iterator e = extents.begin(); e != extents.end(); ++e) {
+        if (e->_size <= 0) {
+            continue;
+        }
+        size_type extent_bytes_read = read(e->_buffer, e->_offset, e->_size);
+
+        if (extent_bytes_read != e->_size) {
+            if (extent_bytes_read > 0) {
+                bytes_read += extent_bytes_read;
+            }
+            break;
+        }
+        bytes_read += extent_bytes_read;
+    }
+
+    return (bytes_read);
+}
+
 // fixed functionality
 file_core::offset_type
 file_core::seek(offset_type                off,
@@ -86,6 +110,12 @@ file_core::vss_align_ceil(const offset_type in_val) const
             + (in_val % _volume_sector_size > 0 ? 1 : 0)) * _volume_sector_size);
 }
 
+boost::mutex&
+file_core::request_mutex() const
+{
+    return (_request_mutex);
+}
+
 void
 file_core::reset_values()
 {
@@ -6,6 +6,7 @@
 #define SCM_CORE_IO_FILE_CORE_H_INCLUDED
 
 #include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <scm/core/io/file.h>
 
@@ -18,6 +19,8 @@ public:
     typedef file::size_type     size_type;
     typedef file::offset_type   offset_type;
     typedef file::char_type     char_type;
+    typedef file::read_extent           read_extent;
+    typedef file::read_extent_array     read_extent_array;
 
 public:
     file_core();
@@ -37,11 +40,16 @@ public:
     virtual size_type           write(const void*    input_buffer,
                                       offset_type    start_position,
                                       size_type      num_bytes_to_write) = 0;
+    virtual size_type           read_batch(const read_extent_array& extents);
 
     virtual bool                flush_buffers() const = 0;
 
     virtual offset_type         set_end_of_file() = 0;
 
+    virtual file_mapping_ptr    map(offset_type     offset,
+                                    size_type       size,
+                                    unsigned        hints) const = 0;
+
     // fixed functionality
     offset_type                 seek(offset_type                off,
                                      std::ios_base::seek_dir    way);
@@ -54,6 +62,10 @@ public:
     offset_type                 vss_align_floor(const offset_type in_val) const;
     offset_type                 vss_align_ceil(const offset_type in_val) const;
 
+    // file cores are not thread safe, this mutex serializes the requests
+    // issued through file from different threads (e.g. file::read_async)
+    boost::mutex&               request_mutex() const;
+
 protected:
     virtual void                reset_values();
     virtual bool                async_io_mode() const;
@@ -70,6 +82,9 @@ protected:
     scm::int32                  _async_requests;
     scm::int32                  _async_request_buffer_size;
 
+private:
+    mutable boost::mutex        _request_mutex;
+
 }; // class file_core
 
 } // namepspace io
@@ -8,10 +8,18 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <sstream>
 
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
@@ -22,6 +30,9 @@
 #include <scm/core/time/high_res_timer.h>
 #include <scm/core/utilities/foreach.h>
 
+#include <scm/core/io/block_cache.h>
+#include <scm/core/io/detail/async_io_linux.h>
+
 namespace scm {
 namespace io {
 namespace detail {
@@ -72,6 +83,11 @@ file_open(const std::string& fn, int open_flags, mode_t create_mode) {
     if (fd > -1) {
         return (file_adopter(fd, fn));
     }
+    else if (errno == EINVAL && (open_flags & O_DIRECT)) {
+        // the file system does not support direct io (e.g. tmpfs on older kernels),
+        // leave it to the caller to retry without O_DIRECT
+        return (file_core_linux::handle());
+    }
     else {
         std::string ret_error;
         switch (errno) {
@@ -92,11 +108,88 @@ file_open(const std::string& fn, int open_flags, mode_t create_mode) {
     }
 }
 
+scm::int32
+volume_sector_size(int fd)
+{
+    // O_DIRECT requires buffers, offsets and lengths to be aligned to the logical
+    // block size of the underlying device. we use the preferred block size of the
+    // file system which is a multiple of the logical block size.
+    const scm::int32 default_sector_size = 4096;
+
+    struct stat64   file_stat;
+    if (0 != ::fstat64(fd, &file_stat)) {
+        return (default_sector_size);
+    }
+
+    scm::int32 block_size = static_cast<scm::int32>(file_stat.st_blksize);
+    if (   block_size < 512
+        || block_size > 64 * 1024
+        || (block_size & (block_size - 1)) != 0) {
+        return (default_sector_size);
+    }
+
+    return (block_size);
+}
+
+class block_cache_source_linux : public block_cache_source
+{
+public:
+    block_cache_source_linux(const file_core_linux::handle& h, const std::string& fn)
+      : _file_handle(h)
+      , _file_size(0)
+    {
+        struct stat64   file_stat;
+        if (0 == ::fstat64(*_file_handle, &file_stat)) {
+            std::ostringstream  id;
+            id << file_stat.st_dev << ":" << file_stat.st_ino << ":" << file_stat.st_size << ":"
+               << file_stat.st_mtim.tv_sec << "." << file_stat.st_mtim.tv_nsec;
+            _identifier = id.str();
+            _file_size  = file_stat.st_size;
+        }
+        else {
+            _identifier = fn;
+        }
+    }
+    virtual ~block_cache_source_linux() {}
+
+    const std::string&  identifier() const { return (_identifier); }
+    size_type           size() const { return (_file_size); }
+
+    size_type read_page(void* output_buffer, offset_type start_position, size_type num_bytes_to_read) const {
+        char*       output_byte_buffer = reinterpret_cast<char*>(output_buffer);
+        size_type   bytes_read         = 0;
+
+        while (bytes_read < num_bytes_to_read) {
+            ssize_t r = ::pread64(*_file_handle, output_byte_buffer + bytes_read,
+                                  num_bytes_to_read - bytes_read, start_position + bytes_read);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return (-1);
+            }
+            if (r == 0) {
+                break; // eof
+            }
+            bytes_read += r;
+        }
+
+        return (bytes_read);
+    }
+
+private:
+    const file_core_linux::handle   _file_handle; // keeps the descriptor open for pending read-ahead
+    std::string                     _identifier;
+    size_type                       _file_size;
+
+}; // class block_cache_source_linux
+
 } // namespace detail
 
 
 file_core_linux::file_core_linux()
   : file_core()
+  , _direct_io(false)
 {
 }
 
@@ -182,12 +275,28 @@ file_core_linux::open(const std::string&       file_path,
     }
 
     if (disable_system_cache) {
-        //flags_and_attributes |= FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED;
-        // TODO implement async I/O
+        // bypass the page cache, all transfers need to be volume sector aligned
+        open_flags |= O_DIRECT;
+
+        // partially written sectors are read back before writing them out
+        if ((open_flags & O_ACCMODE) == O_WRONLY) {
+            open_flags = (open_flags & ~O_ACCMODE) | O_RDWR;
+        }
     }
 
     // do open
     _file_handle = detail::file_open(complete_input_file_path.string(), open_flags, create_mode);
+    _direct_io   = (open_flags & O_DIRECT) && _file_handle;
+
+    if (!_file_handle && (open_flags & O_DIRECT)) {
+        scm::out() << log::warning
+                   << "file_core_linux::open(): "
+                   << "direct io not supported, falling back to system buffered io on file "
+                   << "'" << complete_input_file_path.string() << "'" << log::end;
+
+        open_flags   &= ~O_DIRECT;
+        _file_handle  = detail::file_open(complete_input_file_path.string(), open_flags, create_mode);
+    }
 
     if (!_file_handle) {
         scm::err() << log::error
@@ -198,6 +307,31 @@ file_core_linux::open(const std::string&       file_path,
         return (false);
     }
 
+    _volume_sector_size = detail::volume_sector_size(*_file_handle);
+
+    assert(_volume_sector_size != 0);
+
+    if (disable_system_cache) {
+        // calculate the correct read write buffer size (round up to full multiple of bytes per sector)
+        _async_request_buffer_size  = static_cast<scm::int32>(vss_align_ceil(read_write_buffer_size));
+        _async_requests             = math::max<scm::int32>(1, read_write_asynchronous_requests);
+
+        assert(_async_request_buffer_size % _volume_sector_size == 0);
+
+        _async_io_context = detail::async_io_context_linux::create(*_file_handle, _async_requests);
+
+        _async_request_pool.clear();
+        for (scm::int32 i = 0; i < _async_requests; ++i) {
+            detail::async_request_linux_ptr new_request(new detail::async_request_linux(_async_request_buffer_size,
+                                                                                        _volume_sector_size));
+            if (new_request->buffer_size() != _async_request_buffer_size) {
+                reset_values();
+                return (false);
+            }
+            _async_request_pool.push_back(new_request);
+        }
+    }
+
     if (   open_mode & std::ios_base::ate
         || open_mode & std::ios_base::app) {
 
@@ -208,6 +342,11 @@ file_core_linux::open(const std::string&       file_path,
     _open_mode  = open_mode;
     _file_size  = actual_file_size();
 
+    if (   (open_mode & std::ios_base::in)
+        && !(open_mode & std::ios_base::out)) {
+        _cache_source.reset(new detail::block_cache_source_linux(_file_handle, _file_path));
+    }
+
     return (true);
 }
 
@@ -226,7 +365,22 @@ void
 file_core_linux::close()
 {
     if (is_open()) {
-        // in async write mode truncate the file
+        if (_async_io_context) {
+            _async_io_context->drain();
+        }
+        // if we are non system buffered, it is possible to be too large
+        // because of volume sector size alignment restrictions
+        if (   async_io_mode()
+            && _open_mode & std::ios_base::out) {
+            if (_file_size != actual_file_size()) {
+                if (0 != ftruncate64(*_file_handle, _file_size)) {
+                    scm::err() << log::error
+                               << "file_core_linux::close(): "
+                               << "error truncating end of file: "
+                               << "'" << _file_path << "'" << log::end;
+                }
+            }
+        }
     }
     reset_values();
 }
@@ -250,13 +404,45 @@ file_core_linux::read(void*       output_buffer,
         return (0);
     }
 
-//    // non system buffered read operation
-//    if (async_io_mode()) {
-//        bytes_read = read_async(output_buffer, num_bytes_to_read);
-//    }
-//    // normal system buffered operation
-//    else
-    {
+    // block cache for read-only files
+    if (_cache_source) {
+        block_cache& cache = global_block_cache::get();
+
+        if (   cache.enabled()
+            && cache.cacheable(num_bytes_to_read)
+            && (!_direct_io || cache.page_size() % _volume_sector_size == 0)) {
+
+            size_type cached_bytes = cache.read(_cache_source, output_buffer, start_position, num_bytes_to_read);
+
+            if (cached_bytes < 0) {
+                // eof
+                return (-1);
+            }
+
+            _position += cached_bytes;
+
+            if (   cached_bytes == num_bytes_to_read
+                || _position >= _file_size) {
+                return (cached_bytes);
+            }
+
+            // read the remaining tail directly
+            output_byte_buffer += cached_bytes;
+            num_bytes_to_read  -= cached_bytes;
+            bytes_read          = cached_bytes;
+        }
+    }
+
+    // non system buffered read operation
+    if (async_io_mode()) {
+        size_type async_bytes_read = read_async(output_byte_buffer, _position, num_bytes_to_read);
+        if (async_bytes_read > 0) {
+            return (bytes_read + async_bytes_read);
+        }
+        return (bytes_read > 0 ? bytes_read : async_bytes_read);
+    }
+    // normal system buffered operation
+    else {
         ssize_t file_bytes_read = 0;
 
         file_bytes_read = ::pread64(*_file_handle, output_byte_buffer, num_bytes_to_read, _position);
@@ -265,16 +451,16 @@ file_core_linux::read(void*       output_buffer,
             scm::err() << log::error
                        << "file_core_linux::read(): "
                        << "error reading from file " << _file_path << log::end;
-            return (0);
+            return (bytes_read);
         }
 
         if (file_bytes_read == 0) {
             // eof
-            return (-1);
+            return (bytes_read > 0 ? bytes_read : -1);
         }
         if (file_bytes_read <= num_bytes_to_read) {
             _position           += file_bytes_read;
-            bytes_read           = file_bytes_read;
+            bytes_read          += file_bytes_read;
         }
         else {
             scm::err() << log::error
@@ -306,17 +492,13 @@ file_core_linux::write(const void* input_buffer,
     offset_type     bytes_written       = 0;
 
     _position = start_position;
-//    // non system buffered read operation
-//    if (async_io_mode()) {
-//        //scm::err() << log::error
-//        //           << "file_win::write(): "
-//        //           << "file was opened for async read operations (async write not supported)" << log::end;
-//        //return (0);
-//        bytes_written = write_async(input_buffer, num_bytes_to_write);
-//    }
-//    // normal system buffered operation
-//    else
-    {
+
+    // non system buffered write operation
+    if (async_io_mode()) {
+        bytes_written = write_async(input_buffer, start_position, num_bytes_to_write);
+    }
+    // normal system buffered operation
+    else {
         ssize_t file_bytes_written  = 0;
 
         file_bytes_written = ::pwrite64(*_file_handle, input_byte_buffer, num_bytes_to_write, _position);
@@ -331,6 +513,10 @@ file_core_linux::write(const void* input_buffer,
         if (file_bytes_written <= num_bytes_to_write) {
             _position           += file_bytes_written;
             bytes_written        = file_bytes_written;
+
+            if (_file_size < _position) {
+                _file_size = _position;
+            }
         }
         else {
             scm::err() << log::error
@@ -342,18 +528,211 @@ file_core_linux::write(const void* input_buffer,
     return (bytes_written);
 }
 
+file_core_linux::size_type
+file_core_linux::read_batch(const read_extent_array& extents)
+{
+    assert(is_open());
+
+    // sort the extents by file position, overlapping extents are
+    // never coalesced and always start a new span
+    std::vector<const read_extent*>     sorted_extents;
+    sorted_extents.reserve(extents.size());
+
+    for (read_extent_array::const_iterator e = extents.begin(); e != extents.end(); ++e) {
+        if (e->_size > 0) {
+            sorted_extents.push_back(&(*e));
+        }
+    }
+    if (sorted_extents.empty()) {
+        return (0);
+    }
+
+    std::stable_sort(sorted_extents.begin(), sorted_extents.end(),
+                     boost::bind(&read_extent::_offset, _1) < boost::bind(&read_extent::_offset, _2));
+
+    // in async mode spans are read through the aligned request buffers into a staging buffer,
+    // so we allow larger gaps but limit the span size to the request window
+    const size_type max_gap_size  = async_io_mode() ? _async_request_buffer_size
+                                                    : detail::default_read_batch_gap_size;
+    const size_type max_span_size = async_io_mode() ? static_cast<size_type>(_async_request_buffer_size) * _async_requests
+                                                    : (std::numeric_limits<size_type>::max)();
+
+    size_type   bytes_read  = 0;
+    std::size_t span_begin  = 0;
+
+    while (span_begin < sorted_extents.size()) {
+        offset_type span_start  = sorted_extents[span_begin]->_offset;
+        offset_type span_end    = span_start + sorted_extents[span_begin]->_size;
+        std::size_t span_last   = span_begin + 1;
+
+        while (   span_last < sorted_extents.size()
+               && sorted_extents[span_last]->_offset >= span_end
+               && sorted_extents[span_last]->_offset - span_end <= max_gap_size
+               && sorted_extents[span_last]->_offset + sorted_extents[span_last]->_size - span_start <= max_span_size) {
+            span_end = sorted_extents[span_last]->_offset + sorted_extents[span_last]->_size;
+            ++span_last;
+        }
+
+        const read_extent*const*    first = &sorted_extents[0] + span_begin;
+        const read_extent*const*    last  = &sorted_extents[0] + span_last;
+
+        size_type span_bytes_read = async_io_mode() ? read_span_staged(first, last)
+                                                    : read_span_vectored(first, last);
+        if (span_bytes_read < 0) {
+            break;
+        }
+        bytes_read += span_bytes_read;
+        span_begin  = span_last;
+    }
+
+    return (bytes_read);
+}
+
+file_core_linux::size_type
+file_core_linux::read_span_vectored(const read_extent*const*   first,
+                                    const read_extent*const*   last)
+{
+    offset_type             span_start  = (*first)->_offset;
+    offset_type             span_end    = span_start;
+    std::vector<::iovec>    io_vectors;
+
+    io_vectors.reserve(2 * (last - first));
+
+    // the gaps between the extents are read into a shared scratch buffer
+    for (const read_extent*const* e = first; e != last; ++e) {
+        if ((*e)->_offset > span_end) {
+            size_type gap_size = (*e)->_offset - span_end;
+            if (static_cast<size_type>(_batch_gap_buffer.size()) < gap_size) {
+                _batch_gap_buffer.resize(static_cast<std::size_t>(gap_size));
+            }
+            ::iovec gap_vector = { &_batch_gap_buffer[0], static_cast<size_t>(gap_size) };
+            io_vectors.push_back(gap_vector);
+        }
+        ::iovec extent_vector = { (*e)->_buffer, static_cast<size_t>((*e)->_size) };
+        io_vectors.push_back(extent_vector);
+
+        span_end = (*e)->_offset + (*e)->_size;
+    }
+
+    offset_type     read_position = span_start;
+    std::size_t     next_vector   = 0;
+
+    while (next_vector < io_vectors.size()) {
+        int     vector_count    = static_cast<int>(math::min<std::size_t>(io_vectors.size() - next_vector, IOV_MAX));
+        ssize_t vec_bytes_read  = ::preadv64(*_file_handle, &io_vectors[next_vector], vector_count, read_position);
+
+        if (vec_bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            scm::err() << log::error
+                       << "file_core_linux::read_span_vectored(): "
+                       << "error reading from file "
+                       << "(file: "      << _file_path
+                       << ", position: " << std::hex << "0x" << read_position
+                       << ", error: "    << std::dec << std::strerror(errno) << ")" << log::end;
+            return (-1);
+        }
+        if (vec_bytes_read == 0) {
+            // eof
+            break;
+        }
+
+        read_position += vec_bytes_read;
+
+        // advance the io vectors past the data read, handles short reads
+        size_type bytes_left = vec_bytes_read;
+        while (bytes_left > 0) {
+            ::iovec& v = io_vectors[next_vector];
+            if (bytes_left >= static_cast<size_type>(v.iov_len)) {
+                bytes_left -= v.iov_len;
+                ++next_vector;
+            }
+            else {
+                v.iov_base  = static_cast<char_type*>(v.iov_base) + bytes_left;
+                v.iov_len  -= static_cast<size_t>(bytes_left);
+                bytes_left  = 0;
+            }
+        }
+    }
+
+    _position = read_position;
+
+    // count only the bytes that landed in the extents
+    size_type bytes_read = 0;
+    for (const read_extent*const* e = first; e != last; ++e) {
+        bytes_read += math::max<size_type>(0, math::min<offset_type>(read_position, (*e)->_offset + (*e)->_size) - (*e)->_offset);
+    }
+
+    return (bytes_read);
+}
+
+file_core_linux::size_type
+file_core_linux::read_span_staged(const read_extent*const*     first,
+                                  const read_extent*const*     last)
+{
+    offset_type     span_start  = (*first)->_offset;
+    offset_type     span_end    = (*(last - 1))->_offset + (*(last - 1))->_size;
+    size_type       span_size   = span_end - span_start;
+
+    if (static_cast<size_type>(_batch_staging_buffer.size()) < span_size) {
+        _batch_staging_buffer.resize(static_cast<std::size_t>(span_size));
+    }
+
+    size_type span_bytes_read = read_async(&_batch_staging_buffer[0], span_start, span_size);
+
+    if (span_bytes_read < 0) {
+        // eof
+        return (0);
+    }
+
+    size_type bytes_read = 0;
+    for (const read_extent*const* e = first; e != last; ++e) {
+        size_type extent_bytes = math::max<size_type>(0, math::min<size_type>((*e)->_size,
+                                                                              span_bytes_read - ((*e)->_offset - span_start)));
+        if (extent_bytes > 0) {
+            std::memcpy((*e)->_buffer, &_batch_staging_buffer[0] + ((*e)->_offset - span_start), static_cast<size_t>(extent_bytes));
+            bytes_read += extent_bytes;
+        }
+    }
+
+    return (bytes_read);
+}
+
 bool
 file_core_linux::flush_buffers() const
 {
     assert(is_open());
 
-    return (true);//FlushFileBuffers(_file_handle.get()) == TRUE ? true : false);
+    if (_async_io_context) {
+        _async_io_context->drain();
+    }
+
+    // metadata not required to read back the data (e.g. timestamps) is not synchronized
+    if (0 != ::fdatasync(*_file_handle)) {
+        scm::err() << log::error
+                   << "file_core_linux::flush_buffers(): "
+                   << "error flushing file buffers (errno " << errno << ") "
+                   << "'" << _file_path << "'" << log::end;
+        return (false);
+    }
+
+    return (true);
 }
 
 file_core_linux::offset_type
 file_core_linux::set_end_of_file()
 {
     if (is_open()) {
+        // reserve the blocks of a growing file up front, this keeps large files
+        // from fragmenting and saves the block allocation on the following writes
+        const size_type current_size = actual_file_size();
+        if (   _position > current_size
+            && 0 == ::fallocate64(*_file_handle, 0, current_size, _position - current_size)) {
+            _file_size = _position;
+            return (_position);
+        }
+        // fallocate is not supported by all file systems, fall back to truncation
         if (0 != ftruncate64(*_file_handle, _position)) {
 //            std::string ret_error;
 //            switch (errno) {
@@ -372,12 +751,402 @@ file_core_linux::set_end_of_file()
             return (-1);
         }
 
+        _file_size = _position;
+
         return (_position);
     }
 
     return (1);
 }
 
+file_mapping_ptr
+file_core_linux::map(offset_type     offset,
+                     size_type       size,
+                     unsigned        hints) const
+{
+    assert(is_open());
+
+    if (   offset < 0
+        || size   <= 0
+        || offset + size > _file_size) {
+        scm::err() << log::error
+                   << "file_core_linux::map(): "
+                   << "requested range outside of file "
+                   << "(offset: " << offset << ", size: " << size << ", file size: " << _file_size << ")"
+                   << " on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    // the mapping offset needs to be page aligned
+    const offset_type   page_size   = ::sysconf(_SC_PAGESIZE);
+    const offset_type   map_offset  = (offset / page_size) * page_size;
+    const size_type     map_size    = size + (offset - map_offset);
+
+    if (static_cast<scm::uint64>(map_size) > static_cast<scm::uint64>(std::numeric_limits<size_t>::max())) {
+        scm::err() << log::error
+                   << "file_core_linux::map(): "
+                   << "requested range too large for address space "
+                   << "(size: " << size << ")"
+                   << " on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    int map_flags = MAP_SHARED;
+    if (hints & file_mapping::access_populate) {
+        map_flags |= MAP_POPULATE;
+    }
+
+    void* region = ::mmap64(0, static_cast<size_t>(map_size), PROT_READ, map_flags, *_file_handle, map_offset);
+
+    if (region == MAP_FAILED) {
+        scm::err() << log::error
+                   << "file_core_linux::map(): "
+                   << "error mapping file range "
+                   << "(offset: " << offset << ", size: " << size << ", error: " << std::strerror(errno) << ")"
+                   << " on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    file_mapping::region_ptr    region_ptr(region, boost::bind(::munmap, _1, static_cast<size_t>(map_size)));
+
+    // access hints are advisory only, errors are ignored
+    if (hints & file_mapping::access_sequential) {
+        ::madvise(region, static_cast<size_t>(map_size), MADV_SEQUENTIAL);
+    }
+    if (hints & file_mapping::access_random) {
+        ::madvise(region, static_cast<size_t>(map_size), MADV_RANDOM);
+    }
+    if (hints & file_mapping::access_will_need) {
+        ::madvise(region, static_cast<size_t>(map_size), MADV_WILLNEED);
+    }
+#if defined(MADV_HUGEPAGE)
+    if (hints & file_mapping::access_huge_pages) {
+        ::madvise(region, static_cast<size_t>(map_size), MADV_HUGEPAGE);
+    }
+#endif // defined(MADV_HUGEPAGE)
+
+    return (make_shared<file_mapping>(region_ptr,
+                                      static_cast<const char_type*>(region) + (offset - map_offset),
+                                      offset,
+                                      size));
+}
+
+file_core_linux::size_type
+file_core_linux::read_async(void*       output_buffer,
+                            offset_type start_position,
+                            size_type   num_bytes_to_read)
+{
+    assert(async_io_mode());
+    assert(_async_io_context);
+
+    using detail::async_request_linux;
+    using detail::async_request_linux_ptr;
+    using detail::async_result_linux;
+
+    typedef std::queue<async_request_linux*>    request_queue;
+
+    request_queue           free_requests;
+    scm::int32              running_requests = 0;
+
+    char_type* output_byte_buffer   = reinterpret_cast<char_type*>(output_buffer);
+
+    _position   = start_position;
+
+    if (_position >= _file_size) {
+        // eof
+        return (-1);
+    }
+
+    size_type   position_vss            = vss_align_floor(_position);
+    size_type   bytes_to_read_vss       = vss_align_ceil(math::min(_position  - position_vss + num_bytes_to_read,
+                                                                   _file_size - position_vss));
+    size_type   bytes_to_copy           = math::min(num_bytes_to_read, _file_size - _position);
+
+    size_type   bytes_read              = 0;
+    size_type   read_end_position_vss   = position_vss + bytes_to_read_vss;
+    size_type   next_read_request_pos   = position_vss;
+
+    scm::int32  allocate_requests       = math::min<scm::int32>(static_cast<scm::int32>(_async_request_pool.size()),
+                                                                static_cast<scm::int32>(bytes_to_read_vss / _async_request_buffer_size + 1));
+
+    for (scm::int32 i = 0; i < allocate_requests; ++i) {
+        free_requests.push(_async_request_pool[i].get());
+    }
+
+    std::vector<async_result_linux>  results;
+    results.reserve(allocate_requests);
+
+    do {
+        // fill up request queue
+        while (!free_requests.empty() && next_read_request_pos < read_end_position_vss) {
+            async_request_linux* read_request = free_requests.front();
+            free_requests.pop();
+
+            size_type bytes_left            = read_end_position_vss - next_read_request_pos;
+            size_type request_bytes_to_read = math::min<size_type>(bytes_left, _async_request_buffer_size);
+
+            read_request->position(next_read_request_pos);
+            read_request->bytes_to_process(request_bytes_to_read);
+
+            next_read_request_pos += request_bytes_to_read;
+
+            if (!_async_io_context->submit_read(read_request)) {
+                _async_io_context->drain();
+                return (bytes_read);
+            }
+            ++running_requests;
+
+            assert(static_cast<scm::int32>(free_requests.size()) + running_requests == allocate_requests);
+        }
+
+        // ok now wait for requests to be filled
+        if (running_requests > 0) {
+            results.clear();
+
+            if (!_async_io_context->query_results(results, allocate_requests)) {
+                _async_io_context->drain();
+                return (bytes_read);
+            }
+
+            assert(!results.empty());
+
+            // evaluate io results
+            foreach (const async_result_linux& result, results) {
+                async_request_linux* request = result._request;
+
+                --running_requests;
+                free_requests.push(request);
+
+                if (result._error != 0) {
+                    scm::err() << log::error
+                               << "file_core_linux::read_async(): error reading from file "
+                               << "(file: "      << _file_path
+                               << ", position: " << std::hex << "0x" << request->position()
+                               << ", error: "    << std::dec << std::strerror(result._error) << ")" << log::end;
+
+                    _async_io_context->drain();
+                    return (bytes_read);
+                }
+                if (result._bytes_processed != request->bytes_to_process()) {
+                    if (request->position() + result._bytes_processed < _file_size) {
+                        scm::err() << log::error
+                                   << "file_core_linux::read_async(): read result with different than requested length "
+                                   << "(requested: " << request->bytes_to_process()
+                                   << ", read: " << result._bytes_processed << ")" << log::end;
+
+                        _async_io_context->drain();
+                        return (bytes_read);
+                    }
+                }
+                // copy the data from the request buffer to the outbuffer
+                size_type   target_off      = request->position() - _position;
+                size_type   copy_write_off  = math::max<size_type>(0,  target_off);
+                size_type   copy_read_off   = math::max<size_type>(0, -target_off);
+                size_type   copy_read_bytes = math::min<size_type>(result._bytes_processed - copy_read_off,
+                                                                   bytes_to_copy           - copy_write_off);
+
+                if (copy_read_bytes > 0) {
+                    std::memcpy(output_byte_buffer + copy_write_off,
+                                request->buffer()  + copy_read_off,
+                                static_cast<size_t>(copy_read_bytes));
+
+                    bytes_read += copy_read_bytes;
+                }
+            }
+        }
+    } while (!(running_requests == 0 && next_read_request_pos >= read_end_position_vss));
+
+    if (!_direct_io) {
+        // we fell back to system buffered access, at least do not pollute the cache
+        ::posix_fadvise64(*_file_handle, position_vss, bytes_to_read_vss, POSIX_FADV_DONTNEED);
+    }
+
+    _position += bytes_read;
+
+    return (bytes_read);
+}
+
+file_core_linux::size_type
+file_core_linux::write_async(const void* input_buffer,
+                             offset_type start_position,
+                             size_type   num_bytes_to_write)
+{
+    assert(async_io_mode());
+    assert(_async_io_context);
+
+    using detail::async_request_linux;
+    using detail::async_request_linux_ptr;
+    using detail::async_result_linux;
+
+    typedef std::queue<async_request_linux*>    request_queue;
+
+    request_queue           free_requests;
+    scm::int32              running_requests = 0;
+
+    const char_type* input_byte_buffer  = reinterpret_cast<const char_type*>(input_buffer);
+
+    _position = start_position;
+
+    if (num_bytes_to_write <= 0) {
+        return (0);
+    }
+
+    offset_type write_end_position      = _position + num_bytes_to_write;
+    size_type   position_vss            = vss_align_floor(_position);
+    size_type   position_end_vss        = vss_align_ceil(write_end_position);
+    size_type   bytes_to_write_vss      = position_end_vss - position_vss;
+
+    size_type   bytes_written           = 0;
+    size_type   next_write_request_pos  = position_vss;
+
+    scm::int32  allocate_requests       = math::min<scm::int32>(static_cast<scm::int32>(_async_request_pool.size()),
+                                                                static_cast<scm::int32>(bytes_to_write_vss / _async_request_buffer_size + 1));
+
+    for (scm::int32 i = 0; i < allocate_requests; ++i) {
+        free_requests.push(_async_request_pool[i].get());
+    }
+
+    std::vector<async_result_linux>  results;
+    results.reserve(allocate_requests);
+
+    do {
+        // fill up request queue
+        while (!free_requests.empty() && next_write_request_pos < position_end_vss) {
+            async_request_linux* write_request = free_requests.front();
+            free_requests.pop();
+
+            size_type bytes_left                = position_end_vss - next_write_request_pos;
+            size_type request_bytes_to_write    = math::min<size_type>(bytes_left, _async_request_buffer_size);
+
+            write_request->position(next_write_request_pos);
+            write_request->bytes_to_process(request_bytes_to_write);
+
+            next_write_request_pos += request_bytes_to_write;
+
+            // partially covered sectors at the begin and end need to be read first
+            if (!prefetch_partial_sectors(write_request, _position, write_end_position)) {
+                _async_io_context->drain();
+                return (bytes_written);
+            }
+
+            // copy the request data to the request buffer
+            offset_type copy_begin          = math::max<offset_type>(write_request->position(), _position);
+            offset_type copy_end            = math::min<offset_type>(write_request->position() + request_bytes_to_write,
+                                                                     write_end_position);
+
+            std::memcpy(write_request->buffer()   + (copy_begin - write_request->position()),
+                        input_byte_buffer         + (copy_begin - _position),
+                        static_cast<size_t>(copy_end - copy_begin));
+
+            if (!_async_io_context->submit_write(write_request)) {
+                _async_io_context->drain();
+                return (bytes_written);
+            }
+            ++running_requests;
+
+            assert(static_cast<scm::int32>(free_requests.size()) + running_requests == allocate_requests);
+        }
+
+        // ok now wait for requests to be written
+        if (running_requests > 0) {
+            results.clear();
+
+            if (!_async_io_context->query_results(results, allocate_requests)) {
+                _async_io_context->drain();
+                return (bytes_written);
+            }
+
+            assert(!results.empty());
+
+            // evaluate io results
+            foreach (const async_result_linux& result, results) {
+                async_request_linux* request = result._request;
+
+                --running_requests;
+                free_requests.push(request);
+
+                if (   result._error != 0
+                    || result._bytes_processed != request->bytes_to_process()) {
+                    scm::err() << log::error
+                               << "file_core_linux::write_async(): write result with different than requested length "
+                               << "(requested: " << request->bytes_to_process()
+                               << ", written: "  << result._bytes_processed
+                               << (result._error != 0 ? ", error: " : "")
+                               << (result._error != 0 ? std::strerror(result._error) : "") << ")" << log::end;
+
+                    _async_io_context->drain();
+                    return (bytes_written);
+                }
+
+                offset_type data_begin = math::max<offset_type>(request->position(), _position);
+                offset_type data_end   = math::min<offset_type>(request->position() + request->bytes_to_process(),
+                                                                write_end_position);
+                bytes_written += data_end - data_begin;
+            }
+        }
+    } while (!(running_requests == 0 && next_write_request_pos >= position_end_vss));
+
+    if (!_direct_io) {
+        // we fell back to system buffered access, at least do not pollute the cache
+        ::posix_fadvise64(*_file_handle, position_vss, bytes_to_write_vss, POSIX_FADV_DONTNEED);
+    }
+
+    _position += bytes_written;
+
+    if (_file_size < _position) {
+        _file_size = _position;
+    }
+
+    return (bytes_written);
+}
+
+bool
+file_core_linux::prefetch_partial_sectors(detail::async_request_linux*   req,
+                                          offset_type                    write_begin,
+                                          offset_type                    write_end) const
+{
+    offset_type request_begin   = req->position();
+    offset_type request_end     = req->position() + req->bytes_to_process();
+
+    offset_type head_sector     = (request_begin < write_begin) ? request_begin                  : -1;
+    offset_type tail_sector     = (request_end   > write_end)   ? vss_align_floor(write_end)    : -1;
+
+    if (head_sector == tail_sector) {
+        tail_sector = -1;
+    }
+
+    const offset_type partial_sectors[] = { head_sector, tail_sector };
+
+    for (int s = 0; s < 2; ++s) {
+        if (partial_sectors[s] < 0) {
+            continue;
+        }
+
+        char_type*  sector_buffer = req->buffer() + (partial_sectors[s] - request_begin);
+
+        std::memset(sector_buffer, 0, _volume_sector_size);
+
+        if (partial_sectors[s] < _file_size) {
+            ssize_t sector_bytes_read = 0;
+            do {
+                sector_bytes_read = ::pread64(*_file_handle, sector_buffer, _volume_sector_size, partial_sectors[s]);
+            } while (sector_bytes_read < 0 && errno == EINTR);
+
+            if (sector_bytes_read < 0) {
+                scm::err() << log::error
+                           << "file_core_linux::prefetch_partial_sectors(): "
+                           << "error reading partially written sector "
+                           << "(file: "      << _file_path
+                           << ", position: " << std::hex << "0x" << partial_sectors[s]
+                           << ", error: "    << std::dec << std::strerror(errno) << ")" << log::end;
+                return (false);
+            }
+        }
+    }
+
+    return (true);
+}
+
 file_core_linux::size_type
 file_core_linux::actual_file_size() const
 {
@@ -437,6 +1206,12 @@ file_core_linux::reset_values()
 {
     file_core::reset_values();
 
+    // destroy the io context before closing the file it is operating on
+    _async_io_context.reset();
+    _async_request_pool.clear();
+    _cache_source.reset();
+
+    _direct_io = false;
     _file_handle.reset();
 }
 
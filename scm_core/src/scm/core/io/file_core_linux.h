@@ -18,6 +18,17 @@
 
 namespace scm {
 namespace io {
+namespace detail {
+
+struct async_request_linux;
+class  async_io_context_linux;
+
+typedef scm::shared_ptr<async_request_linux>    async_request_linux_ptr;
+typedef scm::shared_ptr<async_io_context_linux> async_io_context_linux_ptr;
+
+} // namespace detail
+
+class block_cache_source;
 
 class file_core_linux : public file_core
 {
@@ -43,13 +54,33 @@ public:
     size_type                   write(const void*    input_buffer,
                                       offset_type    start_position,
                                       size_type      num_bytes_to_write);
+    size_type                   read_batch(const read_extent_array& extents);
 
     bool                        flush_buffers() const;
 
 	offset_type			        set_end_of_file();
+
+    file_mapping_ptr            map(offset_type     offset,
+                                    size_type       size,
+                                    unsigned        hints) const;
     // end file_core interface
 
 private:
+    size_type                   read_async(void*        output_buffer,
+                                           offset_type  start_position,
+                                           size_type    num_bytes_to_read);
+    size_type                   write_async(const void* input_buffer,
+                                            offset_type start_position,
+                                            size_type   num_bytes_to_write);
+    size_type                   read_span_vectored(const read_extent*const*   first,
+                                                   const read_extent*const*   last);
+    size_type                   read_span_staged(const read_extent*const*     first,
+                                                 const read_extent*const*     last);
+
+    bool                        prefetch_partial_sectors(detail::async_request_linux*   req,
+                                                         offset_type                    write_begin,
+                                                         offset_type                    write_end) const;
+
     size_type                   actual_file_size() const;
     bool                        set_file_pointer(offset_type new_pos);
 
@@ -57,6 +88,16 @@ private:
 
 private:
     handle                      _file_handle;
+    bool                        _direct_io;
+
+    // pages of read-only files are served through the global block cache
+    shared_ptr<block_cache_source>                      _cache_source;
+
+    detail::async_io_context_linux_ptr                  _async_io_context;
+    std::vector<detail::async_request_linux_ptr>        _async_request_pool;
+
+    std::vector<char_type>      _batch_gap_buffer;
+    std::vector<char_type>      _batch_staging_buffer;
 
 }; // class file_core_linux
 
@@ -571,6 +571,77 @@ file_core_win32::set_end_of_file()
     return (-1);
 }
 
+file_mapping_ptr
+file_core_win32::map(offset_type     offset,
+                     size_type       size,
+                     unsigned        hints) const
+{
+    assert(_file_handle);
+    assert(_file_handle.get() != INVALID_HANDLE_VALUE);
+
+    if (   offset < 0
+        || size   <= 0
+        || offset + size > _file_size) {
+        scm::err() << log::error
+                   << "file_core_win32::map(): "
+                   << "requested range outside of file "
+                   << "(offset: " << offset << ", size: " << size << ", file size: " << _file_size << ")"
+                   << " on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    // the view offset needs to be aligned to the allocation granularity
+    SYSTEM_INFO     system_info;
+    GetSystemInfo(&system_info);
+
+    const offset_type   granularity = system_info.dwAllocationGranularity;
+    const offset_type   map_offset  = (offset / granularity) * granularity;
+    const size_type     map_size    = size + (offset - map_offset);
+
+    if (static_cast<scm::uint64>(map_size) > static_cast<scm::uint64>((std::numeric_limits<SIZE_T>::max)())) {
+        scm::err() << log::error
+                   << "file_core_win32::map(): "
+                   << "requested range too large for address space "
+                   << "(size: " << size << ")"
+                   << " on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    // the mapping object is kept alive by the view, so we can close it right away
+    handle  mapping(CreateFileMapping(_file_handle.get(), 0, PAGE_READONLY, 0, 0, 0),
+                    boost::bind<BOOL>(CloseHandle, _1));
+
+    if (mapping.get() == NULL) {
+        scm::err() << log::error
+                   << "file_core_win32::map(): "
+                   << "error creating file mapping object "
+                   << "on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    LARGE_INTEGER   l;
+    l.QuadPart = map_offset;
+
+    void* region = MapViewOfFile(mapping.get(), FILE_MAP_READ, l.HighPart, l.LowPart, static_cast<SIZE_T>(map_size));
+
+    if (region == NULL) {
+        scm::err() << log::error
+                   << "file_core_win32::map(): "
+                   << "error mapping file range "
+                   << "(offset: " << offset << ", size: " << size << ")"
+                   << " on file '" << _file_path << "'" << log::end;
+        return (file_mapping_ptr());
+    }
+
+    // access hints are not supported for mapped views, the system
+    // cache manager handles read-ahead on its own
+    file_mapping::region_ptr    region_ptr(region, boost::bind<BOOL>(UnmapViewOfFile, _1));
+
+    return (make_shared<file_mapping>(region_ptr,
+                                      static_cast<const char_type*>(region) + (offset - map_offset),
+                                      offset,
+                                      size));
+}
 
 file_core_win32::size_type
 file_core_win32::read_async(void*       output_buffer,
@@ -54,6 +54,10 @@ public:
     bool                        flush_buffers() const;
 
 	offset_type                 set_end_of_file();
+
+    file_mapping_ptr            map(offset_type     offset,
+                                    size_type       size,
+                                    unsigned        hints) const;
     // end file_core interface
 
 private:
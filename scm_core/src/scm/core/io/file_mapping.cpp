@@ -0,0 +1,80 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "file_mapping.h"
+
+#include <cassert>
+
+#include <scm/core/platform/platform.h>
+
+#if SCM_PLATFORM == SCM_PLATFORM_LINUX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // SCM_PLATFORM == SCM_PLATFORM_LINUX
+
+namespace scm {
+namespace io {
+
+file_mapping::file_mapping(const region_ptr&      region,
+                           const char_type*       data,
+                           offset_type            offset,
+                           size_type              size)
+  : _region(region)
+  , _data(data)
+  , _offset(offset)
+  , _size(size)
+{
+    assert(_region);
+    assert(_data != 0);
+}
+
+file_mapping::~file_mapping()
+{
+    _region.reset();
+}
+
+const file_mapping::char_type*
+file_mapping::data() const
+{
+    return _data;
+}
+
+offset_type
+file_mapping::offset() const
+{
+    return _offset;
+}
+
+size_type
+file_mapping::size() const
+{
+    return _size;
+}
+
+void
+file_mapping::will_need(offset_type offset,
+                        size_type   size) const
+{
+    if (   offset <  0
+        || offset >= _size
+        || size   <= 0) {
+        return;
+    }
+    if (size > _size - offset) {
+        size = _size - offset;
+    }
+
+#if SCM_PLATFORM == SCM_PLATFORM_LINUX
+    // the advised range needs to start page aligned, the mapped region starts
+    // at a page boundary at or before data()
+    const size_t    page_size   = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t    begin       = reinterpret_cast<size_t>(_data + offset);
+    const size_t    page_begin  = (begin / page_size) * page_size;
+
+    ::madvise(reinterpret_cast<void*>(page_begin), static_cast<size_t>(size) + (begin - page_begin), MADV_WILLNEED);
+#endif // SCM_PLATFORM == SCM_PLATFORM_LINUX
+}
+
+} // namespace io
+} // namespace scm
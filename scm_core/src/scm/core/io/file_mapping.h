@@ -0,0 +1,68 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_IO_FILE_MAPPING_H_INCLUDED
+#define SCM_IO_FILE_MAPPING_H_INCLUDED
+
+#include <boost/noncopyable.hpp>
+
+#include <scm/core/numeric_types.h>
+#include <scm/core/memory.h>
+
+#include <scm/core/io/io_fwd.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace io {
+
+// read-only view of a file region mapped into the address space
+// - the mapping stays valid as long as a reference to it is held,
+//   independent of the file it was created from
+class __scm_export(core) file_mapping : boost::noncopyable
+{
+public:
+    typedef char                    char_type;
+    typedef shared_ptr<void>        region_ptr;
+
+    typedef enum {
+        access_normal       = 0x00,
+        access_sequential   = 0x01,     // aggressive read-ahead, early page release
+        access_random       = 0x02,     // no read-ahead
+        access_will_need    = 0x04,     // start reading in the mapped range asynchronously
+        access_huge_pages   = 0x08,     // back the mapping by huge pages if supported
+        access_populate     = 0x10      // read in the whole range when mapping (blocking)
+    } access_hint;
+
+public:
+    file_mapping(const region_ptr&      region,
+                 const char_type*       data,
+                 offset_type            offset,
+                 size_type              size);
+    ~file_mapping();
+
+    const char_type*            data() const;
+    offset_type                 offset() const;
+    size_type                   size() const;
+
+    // start reading in a range (relative to data()) asynchronously, advisory
+    // only (ignored where not supported)
+    void                        will_need(offset_type offset,
+                                          size_type   size) const;
+
+private:
+    region_ptr                  _region;    // releases the mapped region on destruction
+    const char_type*            _data;
+    offset_type                 _offset;
+    size_type                   _size;
+
+}; // class file_mapping
+
+} // namespace io
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_IO_FILE_MAPPING_H_INCLUDED
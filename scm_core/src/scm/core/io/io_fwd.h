@@ -11,6 +11,8 @@ namespace scm {
 namespace io {
 
 class file;
+class file_mapping;
+class async_read_request;
 
 typedef scm::int64      size_type;
 typedef size_type       offset_type;
@@ -20,6 +22,9 @@ typedef shared_ptr<const file>  file_const_ptr;
 typedef weak_ptr<file>          file_weak_ptr;
 typedef weak_ptr<const file>    file_weak_const_ptr;
 
+typedef shared_ptr<const file_mapping>  file_mapping_ptr;
+typedef shared_ptr<async_read_request>  async_read_request_ptr;
+
 } // namespace io
 } // namespace scm
 
@@ -0,0 +1,110 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "io_thread_pool.h"
+
+#include <exception>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/log.h>
+#include <scm/core/math/math.h>
+
+namespace scm {
+namespace io {
+
+io_thread_pool::io_thread_pool(scm::int32 thread_count)
+  : _thread_count(math::max(1, thread_count))
+  , _shutdown(false)
+{
+    for (scm::int32 i = 0; i < _thread_count; ++i) {
+        _threads.create_thread(boost::bind(&io_thread_pool::worker, this));
+    }
+}
+
+io_thread_pool::~io_thread_pool()
+{
+    shutdown();
+}
+
+void
+io_thread_pool::submit(const task& t)
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        if (_shutdown) {
+            lock.unlock();
+            // no workers left, execute in the calling thread
+            t();
+            return;
+        }
+        _tasks.push_back(t);
+    }
+    _task_pending.notify_one();
+}
+
+void
+io_thread_pool::shutdown()
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        if (_shutdown) {
+            return;
+        }
+        _shutdown = true;
+    }
+    _task_pending.notify_all();
+    _threads.join_all();
+}
+
+scm::int32
+io_thread_pool::thread_count() const
+{
+    return (_thread_count);
+}
+
+scm::size_t
+io_thread_pool::pending_tasks() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return (_tasks.size());
+}
+
+void
+io_thread_pool::worker()
+{
+    while (true) {
+        task    next_task;
+        {
+            boost::mutex::scoped_lock   lock(_mutex);
+
+            while (!_shutdown && _tasks.empty()) {
+                _task_pending.wait(lock);
+            }
+            if (_tasks.empty()) {
+                // shutdown and no outstanding work
+                break;
+            }
+            next_task = _tasks.front();
+            _tasks.pop_front();
+        }
+
+        try {
+            next_task();
+        }
+        catch (std::exception& e) {
+            scm::err() << log::error
+                       << "io_thread_pool::worker(): "
+                       << "unhandled exception in io task (" << e.what() << ")" << log::end;
+        }
+    }
+}
+
+} // namespace io
+} // namespace scm
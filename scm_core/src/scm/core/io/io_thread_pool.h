@@ -0,0 +1,68 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_CORE_IO_IO_THREAD_POOL_H_INCLUDED
+#define SCM_CORE_IO_IO_THREAD_POOL_H_INCLUDED
+
+#include <deque>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/numeric_types.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace io {
+namespace detail {
+
+const scm::int32    default_io_thread_count = 2;
+
+} // namespace detail
+
+// small pool of threads executing blocking io tasks in submission order
+// - owned by scm::core (core::io_threads()), started during core initialization
+// - outstanding tasks are still executed when the pool shuts down
+class __scm_export(core) io_thread_pool : boost::noncopyable
+{
+public:
+    typedef boost::function<void ()>    task;
+
+public:
+    io_thread_pool(scm::int32 thread_count = detail::default_io_thread_count);
+    virtual ~io_thread_pool();
+
+    void                        submit(const task& t);
+    void                        shutdown();
+
+    scm::int32                  thread_count() const;
+    scm::size_t                 pending_tasks() const;
+
+private:
+    void                        worker();
+
+private:
+    mutable boost::mutex        _mutex;
+    boost::condition_variable   _task_pending;
+
+    std::deque<task>            _tasks;
+    boost::thread_group         _threads;
+    scm::int32                  _thread_count;
+    bool                        _shutdown;
+
+}; // class io_thread_pool
+
+} // namespace io
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_CORE_IO_IO_THREAD_POOL_H_INCLUDED
@@ -14,6 +14,7 @@
 
 #include <scm/core/numeric_types.h>
 #include <scm/core/io/file.h>
+#include <scm/core/io/detail/write_behind_writer.h>
 
 namespace scm {
 namespace io {
@@ -29,11 +30,15 @@ public:
 
     // ctor / dtor
     large_file();
+    // write_behind_buffers > 0 enables write-behind buffering (2: double, 3: triple buffering),
+    // writes are collected in buffers of write_behind_buffer_size bytes written out by a background thread
     large_file(const std::string&       file_path,
                std::ios_base::openmode  open_mode                           = std::ios_base::in | std::ios_base::out,
                bool                     disable_system_cache                = true,
                scm::uint32              read_write_buffer_size              = detail::default_io_block_size,
-               scm::uint32              read_write_asynchronous_requests    = detail::default_asynchronous_requests);
+               scm::uint32              read_write_asynchronous_requests    = detail::default_asynchronous_requests,
+               scm::uint32              write_behind_buffers                = 0,
+               scm::uint32              write_behind_buffer_size            = detail::default_write_behind_buffer_size);
     large_file(const large_file& rhs);
     virtual ~large_file();
 
@@ -48,15 +53,22 @@ public:
                                  std::ios_base::openmode    open_mode                           = std::ios_base::in | std::ios_base::out,
                                  bool                       disable_system_cache                = true,
                                  scm::uint32                read_write_buffer_size              = detail::default_io_block_size,
-                                 scm::uint32                read_write_asynchronous_requests    = detail::default_asynchronous_requests);
+                                 scm::uint32                read_write_asynchronous_requests    = detail::default_asynchronous_requests,
+                                 scm::uint32                write_behind_buffers                = 0,
+                                 scm::uint32                write_behind_buffer_size            = detail::default_write_behind_buffer_size);
 
     bool                    is_open() const;
     void                    close();
     std::streamsize         optimal_buffer_size() const;
 
+    // wait for pending write-behind buffers, sync_to_disk additionally
+    // flushes the system buffers of the file to the storage device
+    bool                    flush(bool sync_to_disk = false);
+
 private:
-    boost::shared_ptr<file>     _impl;
-    file::offset_type           _position;
+    boost::shared_ptr<file>                         _impl;
+    boost::shared_ptr<detail::write_behind_writer>  _write_behind;
+    file::offset_type                               _position;
 
 }; // class large_file
 
@@ -125,17 +137,22 @@ public:
     using large_file<char_t>::is_open;
     using large_file<char_t>::close;
     using large_file<char_t>::optimal_buffer_size;
+    using large_file<char_t>::flush;
 
     large_file_sink(const std::string&       file_path,
                       std::ios_base::openmode  open_mode                            = std::ios_base::out,
                       bool                     disable_system_cache                 = true,
                       scm::uint32              read_write_buffer_size               = detail::default_io_block_size,
-                      scm::uint32              read_write_asynchronous_requests     = detail::default_asynchronous_requests)
+                      scm::uint32              read_write_asynchronous_requests     = detail::default_asynchronous_requests,
+                      scm::uint32              write_behind_buffers                 = 0,
+                      scm::uint32              write_behind_buffer_size             = detail::default_write_behind_buffer_size)
         : large_file<char_t>(file_path,
                              open_mode & ~std::ios_base::in,
                              disable_system_cache,
                              read_write_buffer_size,
-                             read_write_asynchronous_requests)
+                             read_write_asynchronous_requests,
+                             write_behind_buffers,
+                             write_behind_buffer_size)
     {
     }
     large_file_sink(const large_file_sink& rhs)
@@ -146,13 +163,17 @@ public:
                                  std::ios_base::openmode    open_mode                           = std::ios_base::out,
                                  bool                       disable_system_cache                = true,
                                  scm::uint32                read_write_buffer_size              = detail::default_io_block_size,
-                                 scm::uint32                read_write_asynchronous_requests    = detail::default_asynchronous_requests)
+                                 scm::uint32                read_write_asynchronous_requests    = detail::default_asynchronous_requests,
+                                 scm::uint32                write_behind_buffers                = 0,
+                                 scm::uint32                write_behind_buffer_size            = detail::default_write_behind_buffer_size)
     {
         large_file<char_t>::open(file_path,
                                  open_mode & ~std::ios_base::in,
                                  disable_system_cache,
                                  read_write_buffer_size,
-                                 read_write_asynchronous_requests);
+                                 read_write_asynchronous_requests,
+                                 write_behind_buffers,
+                                 write_behind_buffer_size);
     }
 
 }; // class large_file_sink
@@ -20,15 +20,20 @@ large_file<char_t>::large_file(const std::string&       file_path,
                                std::ios_base::openmode  open_mode,
                                bool                     disable_system_cache,
                                scm::uint32              read_write_buffer_size,
-                               scm::uint32              read_write_asynchronous_requests)
+                               scm::uint32              read_write_asynchronous_requests,
+                               scm::uint32              write_behind_buffers,
+                               scm::uint32              write_behind_buffer_size)
 {
     _impl.reset(new file());
 
-    open(file_path, open_mode, disable_system_cache, read_write_buffer_size, read_write_asynchronous_requests);
+    open(file_path, open_mode, disable_system_cache, read_write_buffer_size, read_write_asynchronous_requests,
+         write_behind_buffers, write_behind_buffer_size);
 }
 
 template <typename char_t>
 large_file<char_t>::large_file(const large_file<char_t>& rhs)
+  : _write_behind(rhs._write_behind)
+  , _position(rhs._position)
 {
     _impl.reset(new file(*rhs._impl.get()));
 }
@@ -43,6 +48,10 @@ template <typename char_t>
 std::streamsize
 large_file<char_t>::read(char_type* s, std::streamsize n)
 {
+    if (_write_behind && !_write_behind->flush()) {
+        return (-1);
+    }
+
     file::char_type* char_buf = reinterpret_cast<file::char_type*>(s);
     file::size_type r = _impl->read(char_buf, _position, n);
     _position += r;
@@ -55,7 +64,11 @@ std::streamsize
 large_file<char_t>::write(const char_type* s, std::streamsize n)
 {
     const file::char_type* char_buf = reinterpret_cast<const file::char_type*>(s);
-    file::size_type r = _impl->write(char_buf, _position, n);
+    file::size_type r = _write_behind ? _write_behind->write(char_buf, _position, n)
+                                      : _impl->write(char_buf, _position, n);
+    if (r < 0) {
+        return (-1);
+    }
     _position += r;
 
     return r;
@@ -66,6 +79,14 @@ std::streampos
 large_file<char_t>::seek(boost::iostreams::stream_offset    off,
                          std::ios_base::seek_dir            way)
 {
+    if (_write_behind) {
+        // the file does not know about pending writes
+        switch (way) {
+            case std::ios_base::beg: _position = off;                           return _position;
+            case std::ios_base::cur: _position = _position + off;               return _position;
+            default:                 _write_behind->flush();                    break;
+        }
+    }
     _position = _impl->seek(off, way);
     return _position;
 }
@@ -76,11 +97,18 @@ large_file<char_t>::open(const std::string&         file_path,
                          std::ios_base::openmode    open_mode,
                          bool                       disable_system_cache,
                          scm::uint32                read_write_buffer_size,
-                         scm::uint32                read_write_asynchronous_requests)
+                         scm::uint32                read_write_asynchronous_requests,
+                         scm::uint32                write_behind_buffers,
+                         scm::uint32                write_behind_buffer_size)
 {
+    _write_behind.reset();
     if (!_impl->open(file_path, open_mode, disable_system_cache, read_write_buffer_size, read_write_asynchronous_requests)) {
         throw std::ios_base::failure("large_file<char_type>::open(): error opening file");
     }
+    if (   write_behind_buffers > 0
+        && open_mode & std::ios_base::out) {
+        _write_behind.reset(new detail::write_behind_writer(_impl, write_behind_buffers, write_behind_buffer_size));
+    }
     _position = 0;
 }
 
@@ -95,6 +123,10 @@ template <typename char_t>
 void
 large_file<char_t>::close()
 {
+    if (_write_behind) {
+        _write_behind->flush();
+        _write_behind.reset();
+    }
     _impl->close();
 }
 
@@ -105,5 +137,21 @@ large_file<char_t>::optimal_buffer_size() const
     return (_impl->optimal_buffer_size());
 }
 
+template <typename char_t>
+bool
+large_file<char_t>::flush(bool sync_to_disk)
+{
+    bool ret = true;
+
+    if (_write_behind) {
+        ret = _write_behind->flush();
+    }
+    if (sync_to_disk) {
+        ret = _impl->flush_buffers() && ret;
+    }
+
+    return (ret);
+}
+
 } // namespace io
 } // namespace scm
@@ -0,0 +1,144 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "byte_swap.h"
+
+#include <scm/core/math/common.h>
+
+#if SCM_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+namespace {
+
+template<int size>
+void
+swap_bytes_array_scalar(scm::uint8* d, const scm::uint8* s, scm::size_t c);
+
+template<>
+void
+swap_bytes_array_scalar<2>(scm::uint8* d, const scm::uint8* s, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        scm::uint16 v;
+        memcpy(&v, s + 2 * i, 2);
+        v = static_cast<scm::uint16>((v >> 8) | (v << 8));
+        memcpy(d + 2 * i, &v, 2);
+    }
+}
+
+template<>
+void
+swap_bytes_array_scalar<4>(scm::uint8* d, const scm::uint8* s, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        scm::uint32 v;
+        memcpy(&v, s + 4 * i, 4);
+        scm::swap_bytes_4(&v, &v);
+        memcpy(d + 4 * i, &v, 4);
+    }
+}
+
+template<>
+void
+swap_bytes_array_scalar<8>(scm::uint8* d, const scm::uint8* s, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        scm::uint64 v;
+        memcpy(&v, s + 8 * i, 8);
+        scm::swap_bytes_8(&v, &v);
+        memcpy(d + 8 * i, &v, 8);
+    }
+}
+
+#if SCM_SIMD_X86
+
+// pshufb masks reversing the bytes of every 2, 4 or 8 byte element
+const char swap_mask_2[16] = {  1,  0,  3,  2,  5,  4,  7,  6,  9,  8, 11, 10, 13, 12, 15, 14 };
+const char swap_mask_4[16] = {  3,  2,  1,  0,  7,  6,  5,  4, 11, 10,  9,  8, 15, 14, 13, 12 };
+const char swap_mask_8[16] = {  7,  6,  5,  4,  3,  2,  1,  0, 15, 14, 13, 12, 11, 10,  9,  8 };
+
+template<int size>
+SCM_SIMD_TARGET("sse4.1")
+void
+swap_bytes_array_sse41(scm::uint8* d, const scm::uint8* s, scm::size_t c)
+{
+    const char*     mask_data   = size == 2 ? swap_mask_2 : (size == 4 ? swap_mask_4 : swap_mask_8);
+    const __m128i   mask        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_data));
+    const scm::size_t vec_count = (c * size) / 16;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16 * i), _mm_shuffle_epi8(v, mask));
+    }
+
+    const scm::size_t done = (vec_count * 16) / size;
+    swap_bytes_array_scalar<size>(d + done * size, s + done * size, c - done);
+}
+
+template<int size>
+SCM_SIMD_TARGET("avx2")
+void
+swap_bytes_array_avx2(scm::uint8* d, const scm::uint8* s, scm::size_t c)
+{
+    // vpshufb shuffles within 128bit lanes, both lanes use the same mask
+    const char*     mask_data   = size == 2 ? swap_mask_2 : (size == 4 ? swap_mask_4 : swap_mask_8);
+    const __m128i   mask128     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_data));
+    const __m256i   mask        = _mm256_broadcastsi128_si256(mask128);
+    const scm::size_t vec_count = (c * size) / 32;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 32 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + 32 * i), _mm256_shuffle_epi8(v, mask));
+    }
+
+    const scm::size_t done = (vec_count * 32) / size;
+    swap_bytes_array_scalar<size>(d + done * size, s + done * size, c - done);
+}
+
+#endif // SCM_SIMD_X86
+
+template<int size>
+void
+swap_bytes_array_dispatch(void* d, const void* s, scm::size_t c, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    uint8*          d8  = reinterpret_cast<uint8*>(d);
+    const uint8*    s8  = reinterpret_cast<const uint8*>(s);
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:     swap_bytes_array_avx2<size>(d8, s8, c);     break;
+        case CPU_SIMD_SSE4_1:   swap_bytes_array_sse41<size>(d8, s8, c);    break;
+#endif // SCM_SIMD_X86
+        default:                swap_bytes_array_scalar<size>(d8, s8, c);   break;
+    }
+}
+
+} // namespace
+
+namespace scm {
+namespace detail {
+
+void
+swap_bytes_array_2(void* d, const void* s, scm::size_t c, cpu_simd_level l)
+{
+    swap_bytes_array_dispatch<2>(d, s, c, l);
+}
+
+void
+swap_bytes_array_4(void* d, const void* s, scm::size_t c, cpu_simd_level l)
+{
+    swap_bytes_array_dispatch<4>(d, s, c, l);
+}
+
+void
+swap_bytes_array_8(void* d, const void* s, scm::size_t c, cpu_simd_level l)
+{
+    swap_bytes_array_dispatch<8>(d, s, c, l);
+}
+
+} // namespace detail
+} // namespace scm
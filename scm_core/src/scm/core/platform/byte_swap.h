@@ -6,11 +6,14 @@
 #define SCM_CORE_BYTE_SWAP_H_INCLUDED
 
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
 
 #include <boost/static_assert.hpp>
 
 #include <scm/core/numeric_types.h>
 #include <scm/core/platform/platform.h>
+#include <scm/core/platform/cpu_features.h>
 
 #if SCM_PLATFORM == SCM_PLATFORM_WINDOWS
 #   if _MSC_VER >= 1400
@@ -147,26 +150,69 @@ swap_bytes(T* d)
     do_swap_bytes<T, sizeof(T)>()(d, d);
 }
 
+namespace detail {
+
+// array byte swapping using the given simd level (clamped to the supported
+// level), d and s may point to the same array
+__scm_export(core) void swap_bytes_array_2(void* d, const void* s, scm::size_t c, cpu_simd_level l);
+__scm_export(core) void swap_bytes_array_4(void* d, const void* s, scm::size_t c, cpu_simd_level l);
+__scm_export(core) void swap_bytes_array_8(void* d, const void* s, scm::size_t c, cpu_simd_level l);
+
+template<size_t st>
+struct do_swap_bytes_array;
+
+template<>
+struct do_swap_bytes_array<1>
+{
+    inline void operator()(void* d, const void* s, scm::size_t c) {
+        if (d != s) {
+            memcpy(d, s, c);
+        }
+    }
+};
+
+template<>
+struct do_swap_bytes_array<2>
+{
+    inline void operator()(void* d, const void* s, scm::size_t c) {
+        swap_bytes_array_2(d, s, c, cpu_supported_simd_level());
+    }
+};
+
+template<>
+struct do_swap_bytes_array<4>
+{
+    inline void operator()(void* d, const void* s, scm::size_t c) {
+        swap_bytes_array_4(d, s, c, cpu_supported_simd_level());
+    }
+};
+
+template<>
+struct do_swap_bytes_array<8>
+{
+    inline void operator()(void* d, const void* s, scm::size_t c) {
+        swap_bytes_array_8(d, s, c, cpu_supported_simd_level());
+    }
+};
+
+} // namespace detail
+
 template<typename T>
 inline void
 swap_bytes_array(T* d, scm::size_t c)
 {
     BOOST_STATIC_ASSERT(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
     
-    for (scm::size_t i = 0; i < c; ++i) {
-        do_swap_bytes<T, sizeof(T)>()(d + i, d + i);
-    }
+    detail::do_swap_bytes_array<sizeof(T)>()(d, d, c);
 }
 
 template<typename T>
 inline void
-swap_bytes_array(T* d, T* s, scm::size_t c)
+swap_bytes_array(T* d, const T* s, scm::size_t c)
 {
     BOOST_STATIC_ASSERT(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
     
-    for (scm::size_t i = 0; i < c; ++i) {
-        do_swap_bytes<T, sizeof(T)>()(d + i, s + i);
-    }
+    detail::do_swap_bytes_array<sizeof(T)>()(d, s, c);
 }
 
 } // namespace scm
@@ -0,0 +1,83 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "cpu_features.h"
+
+#if SCM_SIMD_X86 && SCM_COMPILER == SCM_COMPILER_MSVC
+#   include <intrin.h>
+#   include <immintrin.h>
+#endif
+
+namespace {
+
+scm::cpu_simd_level
+detect_simd_level()
+{
+    using namespace scm;
+
+#if SCM_SIMD_X86
+#   if SCM_COMPILER == SCM_COMPILER_GNUC
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        return CPU_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return CPU_SIMD_SSE4_1;
+    }
+#   elif SCM_COMPILER == SCM_COMPILER_MSVC
+    int info[4];
+
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse41   = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    const bool f16c    = (info[2] & (1 << 29)) != 0;
+
+    bool avx2 = false;
+    if (max_leaf >= 7 && osxsave && avx) {
+        // the os has to save the ymm registers
+        if ((_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0 && f16c;
+        }
+    }
+    if (avx2) {
+        return CPU_SIMD_AVX2;
+    }
+    if (sse41) {
+        return CPU_SIMD_SSE4_1;
+    }
+#   endif
+#endif // SCM_SIMD_X86
+
+    return CPU_SIMD_NONE;
+}
+
+} // namespace
+
+namespace scm {
+
+cpu_simd_level
+cpu_supported_simd_level()
+{
+    static const cpu_simd_level supported_level = detect_simd_level();
+
+    return supported_level;
+}
+
+const char*
+cpu_simd_level_string(cpu_simd_level l)
+{
+    switch (l) {
+        case CPU_SIMD_NONE:     return "scalar";
+        case CPU_SIMD_SSE4_1:   return "sse4.1";
+        case CPU_SIMD_AVX2:     return "avx2";
+        default:                return "unknown";
+    }
+}
+
+} // namespace scm
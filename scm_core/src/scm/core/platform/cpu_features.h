@@ -0,0 +1,39 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_CORE_CPU_FEATURES_H_INCLUDED
+#define SCM_CORE_CPU_FEATURES_H_INCLUDED
+
+#include <scm/core/platform/platform.h>
+
+// x86 simd kernels are compiled for their instruction set on a per function
+// basis and selected at runtime, the remaining code is built for the base isa
+#if    defined(__x86_64__) || defined(__i386__) \
+    || defined(_M_X64)     || defined(_M_IX86)
+#   define SCM_SIMD_X86                 1
+#else
+#   define SCM_SIMD_X86                 0
+#endif
+
+#if SCM_COMPILER == SCM_COMPILER_GNUC
+#   define SCM_SIMD_TARGET(isa)         __attribute__ ((target(isa)))
+#else
+#   define SCM_SIMD_TARGET(isa)
+#endif
+
+namespace scm {
+
+enum cpu_simd_level {
+    CPU_SIMD_NONE       = 0,
+    CPU_SIMD_SSE4_1,
+    CPU_SIMD_AVX2                   // avx2 including f16c half float conversion
+}; // enum cpu_simd_level
+
+// highest simd level supported by the cpu and operating system (detected once)
+__scm_export(core) cpu_simd_level   cpu_supported_simd_level();
+__scm_export(core) const char*      cpu_simd_level_string(cpu_simd_level l);
+
+} // namespace scm
+
+#endif // SCM_CORE_CPU_FEATURES_H_INCLUDED
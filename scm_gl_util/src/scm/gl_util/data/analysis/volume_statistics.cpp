@@ -0,0 +1,754 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_statistics.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <boost/numeric/conversion/bounds.hpp>
+
+#include <scm/core/memory.h>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/data/volume/volume_reader.h>
+#include <scm/gl_util/utilities/parallel_for.h>
+
+namespace {
+
+// independent accumulators per loop iteration, the compiler maps them to
+// simd registers (the fixed accumulation order keeps this legal for float
+// min/max and sums without relaxed floating point semantics)
+const unsigned lane_count = 8;
+
+enum component_type {
+    COMPONENT_NULL = 0,
+    COMPONENT_UINT8,
+    COMPONENT_INT8,
+    COMPONENT_UINT16,
+    COMPONENT_INT16,
+    COMPONENT_UINT32,
+    COMPONENT_INT32,
+    COMPONENT_FLOAT
+}; // enum component_type
+
+component_type
+component_type_of(scm::gl::data_format fmt)
+{
+    using namespace scm::gl;
+
+    switch (fmt) {
+    case FORMAT_R_8:    case FORMAT_RG_8:    case FORMAT_RGB_8:    case FORMAT_RGBA_8:
+    case FORMAT_R_8UI:  case FORMAT_RG_8UI:  case FORMAT_RGB_8UI:  case FORMAT_RGBA_8UI:
+    case FORMAT_BGR_8:  case FORMAT_BGRA_8:  case FORMAT_SRGB_8:   case FORMAT_SRGBA_8:
+        return COMPONENT_UINT8;
+    case FORMAT_R_8S:   case FORMAT_RG_8S:   case FORMAT_RGB_8S:   case FORMAT_RGBA_8S:
+    case FORMAT_R_8I:   case FORMAT_RG_8I:   case FORMAT_RGB_8I:   case FORMAT_RGBA_8I:
+        return COMPONENT_INT8;
+    case FORMAT_R_16:   case FORMAT_RG_16:   case FORMAT_RGB_16:   case FORMAT_RGBA_16:
+    case FORMAT_R_16UI: case FORMAT_RG_16UI: case FORMAT_RGB_16UI: case FORMAT_RGBA_16UI:
+        return COMPONENT_UINT16;
+    case FORMAT_R_16S:  case FORMAT_RG_16S:  case FORMAT_RGB_16S:  case FORMAT_RGBA_16S:
+    case FORMAT_R_16I:  case FORMAT_RG_16I:  case FORMAT_RGB_16I:  case FORMAT_RGBA_16I:
+        return COMPONENT_INT16;
+    case FORMAT_R_32UI: case FORMAT_RG_32UI: case FORMAT_RGB_32UI: case FORMAT_RGBA_32UI:
+        return COMPONENT_UINT32;
+    case FORMAT_R_32I:  case FORMAT_RG_32I:  case FORMAT_RGB_32I:  case FORMAT_RGBA_32I:
+        return COMPONENT_INT32;
+    case FORMAT_R_32F:  case FORMAT_RG_32F:  case FORMAT_RGB_32F:  case FORMAT_RGBA_32F:
+        return COMPONENT_FLOAT;
+    default:
+        return COMPONENT_NULL;
+    }
+}
+
+// order preserving mapping of float values to unsigned integer keys
+inline
+scm::uint32
+float_key(float f)
+{
+    scm::uint32 b;
+    memcpy(&b, &f, sizeof(float));
+    return (b & 0x80000000u) ? ~b : (b | 0x80000000u);
+}
+
+inline
+float
+key_float(scm::uint32 k)
+{
+    const scm::uint32 b = (k & 0x80000000u) ? (k & 0x7fffffffu) : ~k;
+    float f;
+    memcpy(&f, &b, sizeof(float));
+    return f;
+}
+
+// fine value buckets for histograms over the data value range, one bucket per
+// value for 8 and 16 bit components, the upper bits of the float key else
+const unsigned float_bucket_bits = 18;
+
+template<typename vtype> struct value_buckets {
+    static const unsigned   count = 1u << float_bucket_bits;
+    static unsigned         bucket(vtype v) { return float_key(static_cast<float>(v)) >> (32 - float_bucket_bits); }
+};
+template<> struct value_buckets<scm::uint8> {
+    static const unsigned   count = 1u << 8;
+    static unsigned         bucket(scm::uint8 v) { return v; }
+};
+template<> struct value_buckets<scm::int8> {
+    static const unsigned   count = 1u << 8;
+    static unsigned         bucket(scm::int8 v) { return static_cast<scm::uint8>(v) ^ 0x80u; }
+};
+template<> struct value_buckets<scm::uint16> {
+    static const unsigned   count = 1u << 16;
+    static unsigned         bucket(scm::uint16 v) { return v; }
+};
+template<> struct value_buckets<scm::int16> {
+    static const unsigned   count = 1u << 16;
+    static unsigned         bucket(scm::int16 v) { return static_cast<scm::uint16>(v) ^ 0x8000u; }
+};
+
+unsigned
+bucket_count(component_type ct)
+{
+    switch (ct) {
+    case COMPONENT_UINT8:
+    case COMPONENT_INT8:    return 1u << 8;
+    case COMPONENT_UINT16:
+    case COMPONENT_INT16:   return 1u << 16;
+    default:                return 1u << float_bucket_bits;
+    }
+}
+
+double
+bucket_value(component_type ct, unsigned b)
+{
+    switch (ct) {
+    case COMPONENT_UINT8:   return static_cast<double>(b);
+    case COMPONENT_INT8:    return static_cast<double>(static_cast<int>(b) - 0x80);
+    case COMPONENT_UINT16:  return static_cast<double>(b);
+    case COMPONENT_INT16:   return static_cast<double>(static_cast<int>(b) - 0x8000);
+    default:                return static_cast<double>(key_float(  (b << (32 - float_bucket_bits))
+                                                                 | (1u << (31 - float_bucket_bits))));
+    }
+}
+
+// exact integer sums for 8 and 16 bit components
+template<typename vtype> struct sum_type          { typedef double        type; };
+template<> struct sum_type<scm::uint8>            { typedef scm::int64    type; };
+template<> struct sum_type<scm::int8>             { typedef scm::int64    type; };
+template<> struct sum_type<scm::uint16>           { typedef scm::int64    type; };
+template<> struct sum_type<scm::int16>            { typedef scm::int64    type; };
+
+// NaN values (float components only) are skipped by all statistics
+template<typename vtype> inline bool    is_nan(vtype)       { return false; }
+template<>               inline bool    is_nan(float v)     { return v != v; }
+
+// NaN values fail both comparisons and never replace the initial bounds
+template<typename vtype, const unsigned cdim>
+inline
+void
+segment_range(const vtype* p, unsigned n, unsigned c, vtype& out_min, vtype& out_max)
+{
+    vtype lmin[lane_count];
+    vtype lmax[lane_count];
+    for (unsigned k = 0; k < lane_count; ++k) {
+        lmin[k] = boost::numeric::bounds<vtype>::highest();
+        lmax[k] = boost::numeric::bounds<vtype>::lowest();
+    }
+
+    unsigned i = 0;
+    for (; i + lane_count <= n; i += lane_count) {
+        const vtype* lp = p + i * cdim + c;
+        for (unsigned k = 0; k < lane_count; ++k) {
+            const vtype v = lp[k * cdim];
+            lmin[k] = v < lmin[k] ? v : lmin[k];
+            lmax[k] = lmax[k] < v ? v : lmax[k];
+        }
+    }
+    for (; i < n; ++i) {
+        const vtype v = p[i * cdim + c];
+        lmin[0] = v < lmin[0] ? v : lmin[0];
+        lmax[0] = lmax[0] < v ? v : lmax[0];
+    }
+
+    out_min = lmin[0];
+    out_max = lmax[0];
+    for (unsigned k = 1; k < lane_count; ++k) {
+        out_min = lmin[k] < out_min ? lmin[k] : out_min;
+        out_max = out_max < lmax[k] ? lmax[k] : out_max;
+    }
+}
+
+// count of non-NaN values, their mean and sum of squared differences from the
+// mean (two passes over the cached row)
+template<typename vtype, const unsigned cdim>
+inline
+void
+row_moments(const vtype* p, unsigned n, unsigned c, scm::uint64& out_count, double& out_mean, double& out_m2)
+{
+    typedef typename sum_type<vtype>::type stype;
+
+    stype    lsum[lane_count];
+    unsigned lcount[lane_count];
+    for (unsigned k = 0; k < lane_count; ++k) {
+        lsum[k]   = stype(0);
+        lcount[k] = 0;
+    }
+
+    unsigned i = 0;
+    for (; i + lane_count <= n; i += lane_count) {
+        const vtype* lp = p + i * cdim + c;
+        for (unsigned k = 0; k < lane_count; ++k) {
+            const vtype v = lp[k * cdim];
+            lsum[k]   += is_nan(v) ? stype(0) : static_cast<stype>(v);
+            lcount[k] += is_nan(v) ? 0u : 1u;
+        }
+    }
+    for (; i < n; ++i) {
+        const vtype v = p[i * cdim + c];
+        lsum[0]   += is_nan(v) ? stype(0) : static_cast<stype>(v);
+        lcount[0] += is_nan(v) ? 0u : 1u;
+    }
+
+    stype    sum   = stype(0);
+    unsigned count = 0;
+    for (unsigned k = 0; k < lane_count; ++k) {
+        sum   += lsum[k];
+        count += lcount[k];
+    }
+
+    out_count = count;
+    out_mean  = 0.0;
+    out_m2    = 0.0;
+    if (count == 0) {
+        return;
+    }
+    const double mean = static_cast<double>(sum) / static_cast<double>(count);
+
+    double lm2[lane_count];
+    for (unsigned k = 0; k < lane_count; ++k) {
+        lm2[k] = 0.0;
+    }
+
+    i = 0;
+    for (; i + lane_count <= n; i += lane_count) {
+        const vtype* lp = p + i * cdim + c;
+        for (unsigned k = 0; k < lane_count; ++k) {
+            const vtype  v = lp[k * cdim];
+            const double d = is_nan(v) ? 0.0 : static_cast<double>(v) - mean;
+            lm2[k] += d * d;
+        }
+    }
+    for (; i < n; ++i) {
+        const vtype  v = p[i * cdim + c];
+        const double d = is_nan(v) ? 0.0 : static_cast<double>(v) - mean;
+        lm2[0] += d * d;
+    }
+
+    out_mean = mean;
+    for (unsigned k = 0; k < lane_count; ++k) {
+        out_m2 += lm2[k];
+    }
+}
+
+void
+init_channel_state(scm::gl::util::volume_statistics::channel_state& s, unsigned value_count_size)
+{
+    s._min   = boost::numeric::bounds<double>::highest();
+    s._max   = boost::numeric::bounds<double>::lowest();
+    s._count = 0;
+    s._mean  = 0.0;
+    s._m2    = 0.0;
+    s._value_counts.assign(value_count_size, 0);
+}
+
+// parallel variance merge (chan et al.)
+void
+merge_moments(scm::gl::util::volume_statistics::channel_state& s,
+              scm::uint64 n, double mean, double m2)
+{
+    if (n == 0) {
+        return;
+    }
+    const scm::uint64 tn = s._count + n;
+    const double      d  = mean - s._mean;
+
+    s._mean  += d * static_cast<double>(n) / static_cast<double>(tn);
+    s._m2    += m2 + d * d * (static_cast<double>(s._count) * static_cast<double>(n) / static_cast<double>(tn));
+    s._count  = tn;
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace util {
+
+volume_statistics::volume_statistics(const math::vec3ui&   volume_dimensions,
+                                     const data_format     volume_format,
+                                     const unsigned        histogram_bins,
+                                     const math::vec3ui&   brick_dimensions,
+                                     const math::vec2d&    histogram_range)
+  : _volume_dimensions(volume_dimensions)
+  , _volume_format(volume_format)
+  , _channel_count(static_cast<unsigned>(gl::channel_count(volume_format)))
+  , _histogram_bins(math::max(1u, histogram_bins))
+  , _histogram_range(histogram_range)
+  , _fixed_histogram_range(histogram_range.x < histogram_range.y)
+  , _brick_dimensions(math::max(brick_dimensions, math::vec3ui(1u)))
+  , _accumulating(false)
+  , _histograms_dirty(true)
+{
+    _brick_grid_dimensions = (_volume_dimensions + _brick_dimensions - math::vec3ui(1u)) / _brick_dimensions;
+
+    if (!format_supported(_volume_format)) {
+        glerr() << log::error
+                << "volume_statistics::volume_statistics(): unsupported volume format ("
+                << format_string(_volume_format) << ")." << log::end;
+        _channel_count = 0;
+    }
+
+    reset();
+}
+
+volume_statistics::~volume_statistics()
+{
+}
+
+bool
+volume_statistics::format_supported(const data_format fmt)
+{
+    return component_type_of(fmt) != COMPONENT_NULL;
+}
+
+void
+volume_statistics::reset()
+{
+    const unsigned value_count_size = _fixed_histogram_range ? _histogram_bins
+                                                             : bucket_count(component_type_of(_volume_format));
+
+    _channels.resize(_channel_count);
+    for (unsigned c = 0; c < _channel_count; ++c) {
+        init_channel_state(_channels[c], value_count_size);
+    }
+
+    const scm::size_t brick_count =   static_cast<scm::size_t>(_brick_grid_dimensions.x)
+                                    * _brick_grid_dimensions.y * _brick_grid_dimensions.z;
+    _brick_ranges.assign(brick_count * _channel_count, math::vec2d(boost::numeric::bounds<double>::highest(),
+                                                                   boost::numeric::bounds<double>::lowest()));
+    _histograms.clear();
+    _histograms_dirty = true;
+
+    std::vector<channel_state>().swap(_thread_channels);
+    _accumulating = false;
+}
+
+bool
+volume_statistics::accumulate(const math::vec3ui&  block_origin,
+                              const math::vec3ui&  block_dimensions,
+                              const void*          data)
+{
+    using namespace scm::math;
+
+    if (_channel_count == 0) {
+        glerr() << log::error
+                << "volume_statistics::accumulate(): unsupported volume format ("
+                << format_string(_volume_format) << ")." << log::end;
+        return false;
+    }
+    if (   block_dimensions.x == 0 || block_dimensions.y == 0 || block_dimensions.z == 0
+        || block_origin.x + block_dimensions.x > _volume_dimensions.x
+        || block_origin.y + block_dimensions.y > _volume_dimensions.y
+        || block_origin.z + block_dimensions.z > _volume_dimensions.z) {
+        glerr() << log::error
+                << "volume_statistics::accumulate(): block outside of volume (origin: " << block_origin
+                << ", dimensions: " << block_dimensions << ", volume dimensions: " << _volume_dimensions << ")." << log::end;
+        return false;
+    }
+
+    _histograms_dirty = true;
+
+    // single blocks merge their partial results right away
+    const bool single_block = !_accumulating;
+    if (single_block) {
+        begin_accumulation();
+    }
+
+    bool accum_ok = false;
+    switch (component_type_of(_volume_format)) {
+    case COMPONENT_UINT8:   accum_ok = accumulate_channels<scm::uint8>(block_origin, block_dimensions, data);  break;
+    case COMPONENT_INT8:    accum_ok = accumulate_channels<scm::int8>(block_origin, block_dimensions, data);   break;
+    case COMPONENT_UINT16:  accum_ok = accumulate_channels<scm::uint16>(block_origin, block_dimensions, data); break;
+    case COMPONENT_INT16:   accum_ok = accumulate_channels<scm::int16>(block_origin, block_dimensions, data);  break;
+    case COMPONENT_UINT32:  accum_ok = accumulate_channels<scm::uint32>(block_origin, block_dimensions, data); break;
+    case COMPONENT_INT32:   accum_ok = accumulate_channels<scm::int32>(block_origin, block_dimensions, data);  break;
+    case COMPONENT_FLOAT:   accum_ok = accumulate_channels<float>(block_origin, block_dimensions, data);       break;
+    default:                accum_ok = false;                                                                  break;
+    }
+
+    if (single_block) {
+        end_accumulation();
+    }
+
+    return accum_ok;
+}
+
+void
+volume_statistics::begin_accumulation()
+{
+    if (_accumulating) {
+        merge_thread_channels();
+    }
+    _accumulating = true;
+}
+
+void
+volume_statistics::end_accumulation()
+{
+    merge_thread_channels();
+    _accumulating = false;
+}
+
+void
+volume_statistics::merge_thread_channels()
+{
+    using namespace scm::math;
+
+    for (size_t t = 0; t < _thread_channels.size(); ++t) {
+        const channel_state& ts = _thread_channels[t];
+        channel_state&       s  = _channels[t % _channel_count];
+
+        merge_moments(s, ts._count, ts._mean, ts._m2);
+        s._min = min(s._min, ts._min);
+        s._max = max(s._max, ts._max);
+        for (size_t i = 0; i < ts._value_counts.size(); ++i) {
+            s._value_counts[i] += ts._value_counts[i];
+        }
+    }
+
+    // the partial results are allocated again by the next accumulation
+    std::vector<channel_state>().swap(_thread_channels);
+    _histograms_dirty = true;
+}
+
+template<typename vtype>
+bool
+volume_statistics::accumulate_channels(const math::vec3ui&  block_origin,
+                                       const math::vec3ui&  block_dimensions,
+                                       const void*          data)
+{
+    switch (_channel_count) {
+    case 1:     return accumulate_typed<vtype, 1>(block_origin, block_dimensions, data);
+    case 2:     return accumulate_typed<vtype, 2>(block_origin, block_dimensions, data);
+    case 3:     return accumulate_typed<vtype, 3>(block_origin, block_dimensions, data);
+    case 4:     return accumulate_typed<vtype, 4>(block_origin, block_dimensions, data);
+    default:    return false;
+    }
+}
+
+template<typename vtype, const unsigned cdim>
+bool
+volume_statistics::accumulate_typed(const math::vec3ui&  block_origin,
+                                    const math::vec3ui&  block_dimensions,
+                                    const void*          data)
+{
+    using namespace scm::math;
+
+    // one task per row of bricks (y, z) touched by the block, so every brick
+    // range is written by a single thread
+    const vec3ui   bmin       = block_origin / _brick_dimensions;
+    const vec3ui   bmax       = (block_origin + block_dimensions - vec3ui(1u)) / _brick_dimensions;
+    const unsigned task_rows  = bmax.y - bmin.y + 1;
+    const size_t   task_count = static_cast<size_t>(task_rows) * (bmax.z - bmin.z + 1);
+
+    const size_t   workers          = util::parallel_worker_count(task_count);
+    const unsigned value_count_size = static_cast<unsigned>(_channels[0]._value_counts.size());
+
+    // the per thread partial results live until end_accumulation()
+    if (_thread_channels.size() < workers * cdim) {
+        const size_t first_new = _thread_channels.size();
+        _thread_channels.resize(workers * cdim);
+        for (size_t s = first_new; s < _thread_channels.size(); ++s) {
+            init_channel_state(_thread_channels[s], value_count_size);
+        }
+    }
+    channel_state* thread_states = &_thread_channels.front();
+
+    const vtype*   src_data   = reinterpret_cast<const vtype*>(data);
+    const bool     fixed      = _fixed_histogram_range;
+    const double   hist_lo    = _histogram_range.x;
+    const double   hist_scale = fixed ? _histogram_bins / (_histogram_range.y - _histogram_range.x) : 0.0;
+    const double   hist_last  = static_cast<double>(_histogram_bins - 1);
+    const vec3ui   bdim       = _brick_dimensions;
+    const vec3ui   bgrid      = _brick_grid_dimensions;
+    vec2d*         branges    = &_brick_ranges.front();
+
+    util::parallel_for(task_count, [&](size_t task, size_t thread_index) {
+        const unsigned by = bmin.y + static_cast<unsigned>(task % task_rows);
+        const unsigned bz = bmin.z + static_cast<unsigned>(task / task_rows);
+
+        const unsigned y_begin = max(block_origin.y, by * bdim.y);
+        const unsigned y_end   = min(block_origin.y + block_dimensions.y, (by + 1) * bdim.y);
+        const unsigned z_begin = max(block_origin.z, bz * bdim.z);
+        const unsigned z_end   = min(block_origin.z + block_dimensions.z, (bz + 1) * bdim.z);
+        const unsigned x_end   = block_origin.x + block_dimensions.x;
+        const unsigned n       = block_dimensions.x;
+
+        channel_state* states = &thread_states[thread_index * cdim];
+        vec2d*         brow   = branges + (static_cast<size_t>(bz) * bgrid.y + by) * bgrid.x * cdim;
+
+        for (unsigned z = z_begin; z < z_end; ++z) {
+            for (unsigned y = y_begin; y < y_end; ++y) {
+                const vtype* row = src_data + (  static_cast<size_t>(z - block_origin.z) * block_dimensions.y
+                                               + (y - block_origin.y)) * block_dimensions.x * cdim;
+
+                for (unsigned c = 0; c < cdim; ++c) {
+                    channel_state& s = states[c];
+                    scm::uint64    row_count;
+                    double         row_mean;
+                    double         row_m2;
+
+                    row_moments<vtype, cdim>(row, n, c, row_count, row_mean, row_m2);
+                    merge_moments(s, row_count, row_mean, row_m2);
+
+                    scm::uint64* counts = &s._value_counts.front();
+                    if (fixed) {
+                        for (unsigned i = 0; i < n; ++i) {
+                            const vtype v = row[i * cdim + c];
+                            if (is_nan(v)) {
+                                continue;
+                            }
+                            const double b = (static_cast<double>(v) - hist_lo) * hist_scale;
+                            ++counts[static_cast<unsigned>(!(b > 0.0) ? 0.0 : (b > hist_last ? hist_last : b))];
+                        }
+                    }
+                    else {
+                        for (unsigned i = 0; i < n; ++i) {
+                            const vtype v = row[i * cdim + c];
+                            if (is_nan(v)) {
+                                continue;
+                            }
+                            ++counts[value_buckets<vtype>::bucket(v)];
+                        }
+                    }
+                }
+
+                // brick ranges along the row
+                for (unsigned x = block_origin.x; x < x_end;) {
+                    const unsigned bx    = x / bdim.x;
+                    const unsigned sx    = min(x_end, (bx + 1) * bdim.x);
+                    const vtype*   sdata = row + static_cast<size_t>(x - block_origin.x) * cdim;
+
+                    for (unsigned c = 0; c < cdim; ++c) {
+                        vtype smin;
+                        vtype smax;
+                        segment_range<vtype, cdim>(sdata, sx - x, c, smin, smax);
+                        if (smax < smin) {
+                            continue; // NaN values only
+                        }
+
+                        vec2d& r = brow[bx * cdim + c];
+                        r.x = min(r.x, static_cast<double>(smin));
+                        r.y = max(r.y, static_cast<double>(smax));
+
+                        states[c]._min = min(states[c]._min, static_cast<double>(smin));
+                        states[c]._max = max(states[c]._max, static_cast<double>(smax));
+                    }
+                    x = sx;
+                }
+            }
+        }
+    });
+
+    return true;
+}
+
+bool
+volume_statistics::compute(const void* volume_data)
+{
+    reset();
+    return accumulate(math::vec3ui(0u), _volume_dimensions, volume_data);
+}
+
+bool
+volume_statistics::compute(volume_reader&      reader,
+                           const scm::size_t   slab_budget)
+{
+    using namespace scm::math;
+
+    reset();
+
+    if (reader.dimensions() != _volume_dimensions || reader.format() != _volume_format) {
+        glerr() << log::error
+                << "volume_statistics::compute(): reader does not match statistics volume (dimensions: "
+                << reader.dimensions() << ", format: " << format_string(reader.format()) << ")." << log::end;
+        return false;
+    }
+    if (_channel_count == 0) {
+        glerr() << log::error
+                << "volume_statistics::compute(): unsupported volume format ("
+                << format_string(_volume_format) << ")." << log::end;
+        return false;
+    }
+
+    // the partial results of all slabs are merged once at the end
+    begin_accumulation();
+
+    bool accum_ok = true;
+    bool read_ok  = stream_volume_slabs(reader, slab_budget,
+        [&](unsigned z_first, unsigned z_count, const uint8* data) -> bool {
+            accum_ok = accumulate(vec3ui(0, 0, z_first), vec3ui(_volume_dimensions.x, _volume_dimensions.y, z_count), data);
+            return accum_ok;
+        });
+
+    end_accumulation();
+
+    if (!read_ok && accum_ok) {
+        glerr() << log::error
+                << "volume_statistics::compute(): unable to read volume data." << log::end;
+        return false;
+    }
+
+    return accum_ok;
+}
+
+const math::vec3ui&
+volume_statistics::volume_dimensions() const
+{
+    return _volume_dimensions;
+}
+
+data_format
+volume_statistics::volume_format() const
+{
+    return _volume_format;
+}
+
+unsigned
+volume_statistics::channel_count() const
+{
+    return _channel_count;
+}
+
+scm::uint64
+volume_statistics::voxel_count() const
+{
+    return _channels.empty() ? 0 : _channels[0]._count;
+}
+
+double
+volume_statistics::min_value(const unsigned channel) const
+{
+    assert(channel < _channel_count);
+    return _channels[channel]._min;
+}
+
+double
+volume_statistics::max_value(const unsigned channel) const
+{
+    assert(channel < _channel_count);
+    return _channels[channel]._max;
+}
+
+double
+volume_statistics::mean(const unsigned channel) const
+{
+    assert(channel < _channel_count);
+    return _channels[channel]._mean;
+}
+
+double
+volume_statistics::variance(const unsigned channel) const
+{
+    assert(channel < _channel_count);
+    const channel_state& s = _channels[channel];
+    return s._count > 0 ? s._m2 / static_cast<double>(s._count) : 0.0;
+}
+
+const math::vec2d
+volume_statistics::histogram_range(const unsigned channel) const
+{
+    assert(channel < _channel_count);
+    if (_fixed_histogram_range) {
+        return _histogram_range;
+    }
+    return math::vec2d(_channels[channel]._min, _channels[channel]._max);
+}
+
+const volume_statistics::histogram_type&
+volume_statistics::histogram(const unsigned channel) const
+{
+    assert(channel < _channel_count);
+    if (_histograms_dirty) {
+        update_histograms();
+    }
+    return _histograms[channel];
+}
+
+const math::vec3ui&
+volume_statistics::brick_dimensions() const
+{
+    return _brick_dimensions;
+}
+
+const math::vec3ui&
+volume_statistics::brick_grid_dimensions() const
+{
+    return _brick_grid_dimensions;
+}
+
+const math::vec2d&
+volume_statistics::brick_range(const math::vec3ui&  brick,
+                               const unsigned       channel) const
+{
+    assert(channel < _channel_count);
+    assert(brick.x < _brick_grid_dimensions.x && brick.y < _brick_grid_dimensions.y && brick.z < _brick_grid_dimensions.z);
+
+    const scm::size_t b = (static_cast<scm::size_t>(brick.z) * _brick_grid_dimensions.y + brick.y) * _brick_grid_dimensions.x + brick.x;
+    return _brick_ranges[b * _channel_count + channel];
+}
+
+void
+volume_statistics::update_histograms() const
+{
+    const component_type ct = component_type_of(_volume_format);
+
+    _histograms.resize(_channel_count);
+    for (unsigned c = 0; c < _channel_count; ++c) {
+        const channel_state& s = _channels[c];
+        histogram_type&      h = _histograms[c];
+
+        if (_fixed_histogram_range) {
+            h = s._value_counts;
+            continue;
+        }
+
+        // distribute the fine value buckets over the bins of the data range
+        h.assign(_histogram_bins, 0);
+        if (s._count == 0) {
+            continue;
+        }
+
+        const double lo    = s._min;
+        const double hi    = s._max;
+        const double scale = hi > lo ? _histogram_bins / (hi - lo) : 0.0;
+        const double last  = static_cast<double>(_histogram_bins - 1);
+
+        for (unsigned i = 0; i < static_cast<unsigned>(s._value_counts.size()); ++i) {
+            if (s._value_counts[i] == 0) {
+                continue;
+            }
+            const double v = math::clamp(bucket_value(ct, i), lo, hi);
+            const double b = (v - lo) * scale;
+            h[static_cast<unsigned>(!(b > 0.0) ? 0.0 : (b > last ? last : b))] += s._value_counts[i];
+        }
+    }
+
+    _histograms_dirty = false;
+}
+
+} // namespace util
+} // namespace gl
+} // namespace scm
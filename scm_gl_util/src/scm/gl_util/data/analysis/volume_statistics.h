@@ -0,0 +1,140 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_STATISTICS_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_STATISTICS_H_INCLUDED
+
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+
+#include <scm/gl_core/data_formats.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+class volume_reader;
+
+namespace util {
+
+// value statistics of a volume computed in a single multi-threaded pass
+// - per channel min/max, mean/variance, an n-bin histogram and the min/max
+//   of every brick of a regular brick grid over the volume
+// - the volume can be passed as a whole or as non-overlapping blocks in any
+//   order (e.g. slabs streamed from a volume_reader), the results are
+//   available at any time and cover all blocks accumulated so far
+// - values are the raw channel values of the data format (no normalization),
+//   supported are 8, 16 and 32 bit integer and 32 bit float formats with one
+//   to four channels, NaN values are skipped (not part of any result, the
+//   voxel count included, bricks of NaN values only stay empty)
+// - without an explicit histogram range the histogram covers the value range
+//   of the data, it is exact for 8 and 16 bit formats and built from 2^18
+//   buckets on the float value bits for 32 bit formats (voxels closer than
+//   1/1024 of their value to a bin border may be counted in the neighbor bin)
+class __scm_export(gl_util) volume_statistics
+{
+public:
+    typedef std::vector<scm::uint64>    histogram_type;
+
+public:
+    volume_statistics(const math::vec3ui&   volume_dimensions,
+                      const data_format     volume_format,
+                      const unsigned        histogram_bins    = 256,
+                      const math::vec3ui&   brick_dimensions  = math::vec3ui(32u),
+                      const math::vec2d&    histogram_range   = math::vec2d(1.0, 0.0));
+    ~volume_statistics();
+
+    static bool                 format_supported(const data_format fmt);
+
+    // data holds the tightly packed voxels of the block (x fastest)
+    bool                        accumulate(const math::vec3ui&  block_origin,
+                                           const math::vec3ui&  block_dimensions,
+                                           const void*          data);
+    // blocks accumulated between begin_accumulation() and end_accumulation()
+    // share one set of per thread partial results, merged once at the end
+    // (the channel results cover these blocks only after end_accumulation(),
+    // a single accumulate() call outside of such a pair merges right away)
+    void                        begin_accumulation();
+    void                        end_accumulation();
+    bool                        compute(const void*             volume_data);
+    // reads the volume in slabs of z-slices of at most slab_budget bytes, the
+    // next slab is read while the current one is processed
+    bool                        compute(volume_reader&          reader,
+                                        const scm::size_t       slab_budget = 64 * 1024 * 1024);
+    void                        reset();
+
+    const math::vec3ui&         volume_dimensions() const;
+    data_format                 volume_format() const;
+    unsigned                    channel_count() const;
+    scm::uint64                 voxel_count() const;
+
+    double                      min_value(const unsigned channel = 0) const;
+    double                      max_value(const unsigned channel = 0) const;
+    double                      mean(const unsigned channel = 0) const;
+    double                      variance(const unsigned channel = 0) const;
+
+    const math::vec2d           histogram_range(const unsigned channel = 0) const;
+    const histogram_type&       histogram(const unsigned channel = 0) const;
+
+    const math::vec3ui&         brick_dimensions() const;
+    const math::vec3ui&         brick_grid_dimensions() const;
+    // (min, max) of the brick, (max, lowest) for bricks without accumulated voxels
+    const math::vec2d&          brick_range(const math::vec3ui&  brick,
+                                            const unsigned       channel = 0) const;
+
+public:
+    struct channel_state {
+        double                  _min;
+        double                  _max;
+        scm::uint64             _count;
+        double                  _mean;
+        double                  _m2;                // sum of squared differences from the mean
+        histogram_type          _value_counts;      // histogram bins or fine value buckets
+    }; // struct channel_state
+
+private:
+    template<typename vtype>
+    bool                        accumulate_channels(const math::vec3ui&  block_origin,
+                                                    const math::vec3ui&  block_dimensions,
+                                                    const void*          data);
+    template<typename vtype, const unsigned cdim>
+    bool                        accumulate_typed(const math::vec3ui&  block_origin,
+                                                 const math::vec3ui&  block_dimensions,
+                                                 const void*          data);
+    void                        merge_thread_channels();
+    void                        update_histograms() const;
+
+private:
+    math::vec3ui                _volume_dimensions;
+    data_format                 _volume_format;
+    unsigned                    _channel_count;
+
+    unsigned                    _histogram_bins;
+    math::vec2d                 _histogram_range;
+    bool                        _fixed_histogram_range;
+
+    math::vec3ui                _brick_dimensions;
+    math::vec3ui                _brick_grid_dimensions;
+
+    std::vector<channel_state>  _channels;
+    std::vector<channel_state>  _thread_channels;   // per worker thread and channel while accumulating
+    bool                        _accumulating;
+    std::vector<math::vec2d>    _brick_ranges;      // per brick and channel
+
+    mutable std::vector<histogram_type> _histograms;
+    mutable bool                _histograms_dirty;
+
+}; // class volume_statistics
+
+} // namespace util
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_VOLUME_STATISTICS_H_INCLUDED
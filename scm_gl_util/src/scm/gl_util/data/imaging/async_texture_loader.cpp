@@ -0,0 +1,470 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "async_texture_loader.h"
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/math.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_core/log.h>
+#include <scm/gl_core/render_device.h>
+#include <scm/gl_core/texture_objects.h>
+
+#include <scm/gl_util/data/imaging/texture_image_cache.h>
+#include <scm/gl_util/data/imaging/texture_image_data.h>
+#include <scm/gl_util/data/imaging/texture_loader.h>
+#include <scm/gl_util/data/imaging/texture_loader_dds.h>
+
+namespace {
+
+scm::gl::data_format
+upload_internal_format(scm::gl::data_format fmt, scm::gl::data_format force_fmt)
+{
+    using namespace scm::gl;
+
+    if (force_fmt != FORMAT_NULL) {
+        return force_fmt;
+    }
+    // as texture_loader, bgr(a) images are stored as rgb(a) textures
+    switch (fmt) {
+        case FORMAT_BGR_8:  return FORMAT_RGB_8;
+        case FORMAT_BGRA_8: return FORMAT_RGBA_8;
+        default:            return fmt;
+    }
+}
+
+scm::size_t
+level_byte_size(scm::gl::data_format fmt, const scm::math::vec3ui& size, unsigned layers)
+{
+    using namespace scm::gl;
+
+    scm::size_t s = 0;
+    if (is_compressed_format(fmt)) {
+        s =   static_cast<scm::size_t>((size.x + 3) / 4) * ((size.y + 3) / 4)
+            * compressed_block_size(fmt);
+    }
+    else {
+        s = static_cast<scm::size_t>(size.x) * size.y * size_of_format(fmt);
+    }
+    return s * size.z * layers;
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+struct async_texture_loader::load_request
+{
+    load_request()
+      : _cube_map(false)
+      , _create_mips(false)
+      , _force_internal_format(FORMAT_NULL)
+      , _next_level(0)
+    {}
+
+    texture_handle_ptr                  _handle;
+    bool                                _cube_map;
+    std::vector<std::string>            _file_names;
+    bool                                _create_mips;
+    data_format                         _force_internal_format;
+
+    std::vector<texture_image_data_ptr> _images;        // decoded images (one per cube face), empty on failure
+    texture_image_ptr                   _texture;       // texture being uploaded
+    unsigned                            _next_level;    // next 2d mip level to upload
+}; // struct async_texture_loader::load_request
+
+async_texture_loader::texture_handle::texture_handle(const std::string&       file_name,
+                                                     const texture_image_ptr& placeholder)
+  : _file_name(file_name)
+  , _texture(placeholder)
+  , _state(LOAD_PENDING)
+{
+}
+
+const texture_image_ptr&
+async_texture_loader::texture_handle::texture() const
+{
+    return _texture;
+}
+
+async_texture_loader::load_state
+async_texture_loader::texture_handle::state() const
+{
+    return _state;
+}
+
+bool
+async_texture_loader::texture_handle::ready() const
+{
+    return _state == LOAD_READY;
+}
+
+const std::string&
+async_texture_loader::texture_handle::file_name() const
+{
+    return _file_name;
+}
+
+async_texture_loader::statistics::statistics()
+  : _requests(0)
+  , _decoded(0)
+  , _uploaded(0)
+  , _uploaded_bytes(0)
+  , _failed(0)
+  , _dropped(0)
+{
+}
+
+async_texture_loader::async_texture_loader(const render_device_ptr&   device,
+                                           const unsigned             decode_threads,
+                                           const std::string&         cache_directory)
+  : _device(device)
+  , _decoding(0)
+  , _pending(0)
+  , _shutdown(false)
+{
+    // neutral grey placeholders
+    std::vector<uint8>  texel(4, 128);
+    texel[3] = 255;
+
+    std::vector<void*>  texel_data(1, &texel.front());
+
+    _placeholder_2d   = _device->create_texture_2d(math::vec2ui(1u), FORMAT_RGBA_8, 1, 1, 1,
+                                                   FORMAT_RGBA_8, texel_data);
+    _placeholder_cube = _device->create_texture_cube(math::vec2ui(1u), FORMAT_RGBA_8, 1, FORMAT_RGBA_8,
+                                                     texel_data, texel_data, texel_data,
+                                                     texel_data, texel_data, texel_data);
+    if (!_placeholder_2d || !_placeholder_cube) {
+        glerr() << log::error
+                << "async_texture_loader::async_texture_loader(): unable to create placeholder textures." << log::end;
+    }
+
+    if (!cache_directory.empty()) {
+        _image_cache.reset(new texture_image_cache(cache_directory));
+    }
+
+    for (unsigned t = 0; t < math::max(1u, decode_threads); ++t) {
+        _decode_threads.push_back(scm::shared_ptr<boost::thread>(
+            new boost::thread(boost::bind(&async_texture_loader::decode_thread, this))));
+    }
+}
+
+async_texture_loader::~async_texture_loader()
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        _shutdown = true;
+        _decode_queue.clear();
+        _request_pending.notify_all();
+    }
+    for (std::size_t t = 0; t < _decode_threads.size(); ++t) {
+        _decode_threads[t]->join();
+    }
+    _decode_threads.clear();
+    _upload_queue.clear();
+}
+
+async_texture_loader::texture_handle_ptr
+async_texture_loader::load_texture_2d(const std::string&   file_name,
+                                      bool                 create_mips,
+                                      const data_format    force_internal_format)
+{
+    load_request_ptr r(new load_request);
+
+    r->_file_names.push_back(file_name);
+    r->_create_mips            = create_mips;
+    r->_force_internal_format  = force_internal_format;
+
+    return queue_request(r, _placeholder_2d);
+}
+
+async_texture_loader::texture_handle_ptr
+async_texture_loader::load_texture_cube(const std::string&   file_name_px,
+                                        const std::string&   file_name_nx,
+                                        const std::string&   file_name_py,
+                                        const std::string&   file_name_ny,
+                                        const std::string&   file_name_pz,
+                                        const std::string&   file_name_nz,
+                                        bool                 create_mips,
+                                        const data_format    force_internal_format)
+{
+    load_request_ptr r(new load_request);
+
+    r->_cube_map = true;
+    r->_file_names.push_back(file_name_px);
+    r->_file_names.push_back(file_name_nx);
+    r->_file_names.push_back(file_name_py);
+    r->_file_names.push_back(file_name_ny);
+    r->_file_names.push_back(file_name_pz);
+    r->_file_names.push_back(file_name_nz);
+    r->_create_mips            = create_mips;
+    r->_force_internal_format  = force_internal_format;
+
+    return queue_request(r, _placeholder_cube);
+}
+
+scm::size_t
+async_texture_loader::update(const render_context_ptr& context,
+                             const scm::size_t         byte_budget,
+                             const double              time_budget_ms)
+{
+    time::high_res_timer    upload_timer;
+    scm::size_t             bytes = 0;
+
+    upload_timer.start();
+
+    for (;;) {
+        load_request_ptr    r;
+        {
+            boost::mutex::scoped_lock   lock(_mutex);
+            if (_upload_queue.empty()) {
+                break;
+            }
+            r = _upload_queue.front();
+        }
+
+        const bool dropped = r->_handle.unique();   // the caller lost interest
+        bool       done    = false;
+        bool       failed  = false;
+
+        if (dropped) {
+            // nothing to upload
+        }
+        else if (r->_images.empty() || !upload_step(context, *r, bytes)) {
+            r->_handle->_state = LOAD_FAILED;
+            failed = true;
+        }
+        else if (   (r->_cube_map)
+                 || (r->_next_level >= static_cast<unsigned>(r->_images.front()->mip_level_count()))) {
+            r->_handle->_texture = r->_texture;
+            r->_handle->_state   = LOAD_READY;
+            done = true;
+        }
+        else {
+            r->_handle->_state   = LOAD_UPLOADING;
+        }
+
+        if (done || failed || dropped) {
+            boost::mutex::scoped_lock   lock(_mutex);
+            _upload_queue.pop_front();
+            --_pending;
+            if      (done)      ++_statistics._uploaded;
+            else if (failed)    ++_statistics._failed;
+            else                ++_statistics._dropped;
+        }
+
+        if (byte_budget > 0 && bytes >= byte_budget) {
+            break;
+        }
+        if (time_budget_ms > 0.0) {
+            upload_timer.intermediate_stop();
+            if (time::to_milliseconds(upload_timer.get_time()) >= time_budget_ms) {
+                break;
+            }
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+        _statistics._uploaded_bytes += bytes;
+    }
+
+    return bytes;
+}
+
+void
+async_texture_loader::wait_decoded() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (!_decode_queue.empty() || _decoding > 0) {
+        _request_decoded.wait(lock);
+    }
+}
+
+scm::size_t
+async_texture_loader::pending_count() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+    return _pending;
+}
+
+const texture_2d_ptr&
+async_texture_loader::placeholder_texture_2d() const
+{
+    return _placeholder_2d;
+}
+
+const texture_cube_ptr&
+async_texture_loader::placeholder_texture_cube() const
+{
+    return _placeholder_cube;
+}
+
+async_texture_loader::statistics
+async_texture_loader::current_statistics() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+    return _statistics;
+}
+
+async_texture_loader::texture_handle_ptr
+async_texture_loader::queue_request(const load_request_ptr&  r,
+                                    const texture_image_ptr& placeholder)
+{
+    r->_handle.reset(new texture_handle(r->_file_names.front(), placeholder));
+
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    _decode_queue.push_back(r);
+    ++_pending;
+    ++_statistics._requests;
+    _request_pending.notify_one();
+
+    return r->_handle;
+}
+
+bool
+async_texture_loader::decode(load_request& r) const
+{
+    for (std::size_t f = 0; f < r._file_names.size(); ++f) {
+        std::string             file_extension = boost::filesystem::path(r._file_names[f]).extension().string();
+        texture_image_data_ptr  img;
+
+        boost::algorithm::to_lower(file_extension);
+
+        if (file_extension == ".dds") {
+            img = texture_loader_dds().load_image_data(r._file_names[f]);
+        }
+        else {
+            img = texture_loader(_image_cache).load_image_data(r._file_names[f], r._create_mips);
+        }
+
+        if (!img || img->mip_level_count() < 1 || img->mip_level(0).size().z != 1) {
+            glerr() << log::error
+                    << "async_texture_loader::decode(): unable to load 2d image (file: " << r._file_names[f] << ")." << log::end;
+            return false;
+        }
+        if (   !r._images.empty()
+            && (   img->format()                != r._images.front()->format()
+                || img->mip_level_count()       != r._images.front()->mip_level_count()
+                || img->array_layers()          != 1
+                || img->mip_level(0).size()     != r._images.front()->mip_level(0).size())) {
+            glerr() << log::error
+                    << "async_texture_loader::decode(): all six cube map images must have the same format "
+                    << "(file: " << r._file_names[f] << ")." << log::end;
+            return false;
+        }
+        r._images.push_back(img);
+    }
+
+    return true;
+}
+
+bool
+async_texture_loader::upload_step(const render_context_ptr& context,
+                                  load_request&             r,
+                                  scm::size_t&              bytes) const
+{
+    const texture_image_data&   img        = *r._images.front();
+    const data_format           int_format = upload_internal_format(img.format(), r._force_internal_format);
+    const math::vec2ui          size       = math::vec2ui(img.mip_level(0).size().x, img.mip_level(0).size().y);
+    const unsigned              levels     = static_cast<unsigned>(img.mip_level_count());
+
+    if (r._cube_map) {
+        std::vector<void*>  face_data[6];
+
+        for (int f = 0; f < 6; ++f) {
+            for (unsigned l = 0; l < levels; ++l) {
+                face_data[f].push_back(r._images[f]->mip_level(l).data().get());
+                bytes += level_byte_size(img.format(), r._images[f]->mip_level(l).size(), 1);
+            }
+        }
+
+        r._texture = _device->create_texture_cube(size, int_format, levels, img.format(),
+                                                  face_data[0], face_data[1], face_data[2],
+                                                  face_data[3], face_data[4], face_data[5]);
+        if (!r._texture) {
+            glerr() << log::error << "async_texture_loader::upload_step(): "
+                    << "unable to create texture object (file: " << r._handle->file_name() << ")" << log::end;
+            return false;
+        }
+        return true;
+    }
+
+    if (!r._texture) {
+        r._texture = _device->create_texture_2d(size, int_format, levels, img.array_layers());
+        if (!r._texture) {
+            glerr() << log::error << "async_texture_loader::upload_step(): "
+                    << "unable to create texture object (file: " << r._handle->file_name() << ")" << log::end;
+            return false;
+        }
+    }
+
+    const texture_image_data::level&    lev = img.mip_level(r._next_level);
+    const texture_region                region(math::vec3ui(0u), math::vec3ui(lev.size().x, lev.size().y, img.array_layers()));
+
+    if (!context->update_sub_texture(r._texture, region, r._next_level, img.format(), lev.data().get())) {
+        glerr() << log::error << "async_texture_loader::upload_step(): "
+                << "unable to upload mip level " << r._next_level << " (file: " << r._handle->file_name() << ")" << log::end;
+        return false;
+    }
+
+    bytes += level_byte_size(img.format(), lev.size(), img.array_layers());
+    ++r._next_level;
+
+    return true;
+}
+
+void
+async_texture_loader::decode_thread()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (!_shutdown) {
+        if (_decode_queue.empty()) {
+            _request_pending.wait(lock);
+            continue;
+        }
+
+        load_request_ptr r = _decode_queue.front();
+        _decode_queue.pop_front();
+
+        if (r->_handle.unique()) {
+            // dropped before decoding
+            --_pending;
+            ++_statistics._dropped;
+            _request_decoded.notify_all();
+            continue;
+        }
+
+        ++_decoding;
+        lock.unlock();
+        const bool decode_ok = decode(*r);
+        lock.lock();
+        --_decoding;
+
+        if (decode_ok) {
+            ++_statistics._decoded;
+        }
+        else {
+            r->_images.clear();
+        }
+        _upload_queue.push_back(r);
+        _request_decoded.notify_all();
+    }
+
+    _request_decoded.notify_all();
+}
+
+} // namespace gl
+} // namespace scm
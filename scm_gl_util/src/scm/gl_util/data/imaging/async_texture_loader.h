@@ -0,0 +1,171 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_ASYNC_TEXTURE_LOADER_H_INCLUDED
+#define SCM_GL_UTIL_ASYNC_TEXTURE_LOADER_H_INCLUDED
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/memory.h>
+#include <scm/core/numeric_types.h>
+
+#include <scm/gl_core/data_formats.h>
+#include <scm/gl_core/render_device/render_device_fwd.h>
+#include <scm/gl_core/texture_objects/texture_objects_fwd.h>
+
+#include <scm/gl_util/data/imaging/imaging_fwd.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+class async_texture_loader;
+
+typedef shared_ptr<async_texture_loader>    async_texture_loader_ptr;
+
+// loads textures without stalling the render thread
+// - image files are decoded (and their mip maps built) on worker threads, .dds
+//   files through texture_loader_dds, all other files through texture_loader
+// - a load returns a handle referring to a placeholder texture until the texture
+//   is completely uploaded
+// - update() is called once per frame on the render thread, it uploads the decoded
+//   textures in request order until the byte or time budget of the frame is used
+//   up (2d textures one mip level at a time, cube maps at once)
+// - handles only change in update(), query them on the render thread
+// - requests whose handles were released by the caller are dropped
+// - with a cache directory the decoded images are cached as by texture_loader
+class __scm_export(gl_util) async_texture_loader : boost::noncopyable
+{
+public:
+    enum load_state {
+        LOAD_PENDING        = 0x00,     // queued or decoding
+        LOAD_UPLOADING,                 // decoded, upload in progress
+        LOAD_READY,                     // texture() is the loaded texture
+        LOAD_FAILED                     // texture() stays the placeholder
+    }; // enum load_state
+
+    class __scm_export(gl_util) texture_handle : boost::noncopyable
+    {
+    public:
+        texture_handle(const std::string&       file_name,
+                       const texture_image_ptr& placeholder);
+
+        const texture_image_ptr&    texture() const;
+        load_state                  state() const;
+        bool                        ready() const;
+        const std::string&          file_name() const;
+
+    private:
+        std::string                 _file_name;
+        texture_image_ptr           _texture;
+        load_state                  _state;
+
+        friend class async_texture_loader;
+    }; // class texture_handle
+
+    typedef shared_ptr<texture_handle>  texture_handle_ptr;
+
+    struct __scm_export(gl_util) statistics
+    {
+        statistics();
+
+        scm::uint64             _requests;
+        scm::uint64             _decoded;
+        scm::uint64             _uploaded;
+        scm::uint64             _uploaded_bytes;
+        scm::uint64             _failed;
+        scm::uint64             _dropped;
+    }; // struct statistics
+
+private:
+    struct load_request;
+
+    typedef shared_ptr<load_request>        load_request_ptr;
+    typedef std::deque<load_request_ptr>    request_queue;
+
+public:
+    // the mip map generation of the decodes runs on the process wide pool of
+    // util::parallel_for, which the decode threads join instead of each starting
+    // their own threads, the decode threads mainly overlap file io and decoding
+    async_texture_loader(const render_device_ptr&   device,
+                         const unsigned             decode_threads = 2,
+                         const std::string&         cache_directory = std::string());
+    virtual ~async_texture_loader();
+
+    texture_handle_ptr          load_texture_2d(const std::string&   file_name,
+                                                bool                 create_mips,
+                                                const data_format    force_internal_format = FORMAT_NULL);
+    texture_handle_ptr          load_texture_cube(const std::string&   file_name_px,
+                                                  const std::string&   file_name_nx,
+                                                  const std::string&   file_name_py,
+                                                  const std::string&   file_name_ny,
+                                                  const std::string&   file_name_pz,
+                                                  const std::string&   file_name_nz,
+                                                  bool                 create_mips,
+                                                  const data_format    force_internal_format = FORMAT_NULL);
+
+    // performs at least one upload step if a texture is decoded, a budget of 0 is
+    // unlimited, returns the number of bytes uploaded
+    scm::size_t                 update(const render_context_ptr& context,
+                                       const scm::size_t         byte_budget,
+                                       const double              time_budget_ms = 0.0);
+
+    // blocks until all requests are decoded
+    void                        wait_decoded() const;
+    // requests not yet ready or failed
+    scm::size_t                 pending_count() const;
+
+    const texture_2d_ptr&       placeholder_texture_2d() const;
+    const texture_cube_ptr&     placeholder_texture_cube() const;
+
+    statistics                  current_statistics() const;
+
+private:
+    texture_handle_ptr          queue_request(const load_request_ptr& r,
+                                              const texture_image_ptr& placeholder);
+    bool                        decode(load_request& r) const;
+    bool                        upload_step(const render_context_ptr& context,
+                                            load_request&             r,
+                                            scm::size_t&              bytes) const;
+    void                        decode_thread();
+
+private:
+    render_device_ptr           _device;
+    texture_image_cache_ptr     _image_cache;
+    texture_2d_ptr              _placeholder_2d;
+    texture_cube_ptr            _placeholder_cube;
+
+    mutable boost::mutex        _mutex;
+    boost::condition_variable   _request_pending;
+    mutable boost::condition_variable   _request_decoded;
+
+    request_queue               _decode_queue;
+    request_queue               _upload_queue;      // decoded, front is being uploaded
+    scm::size_t                 _decoding;
+    scm::size_t                 _pending;
+    bool                        _shutdown;
+
+    std::vector<scm::shared_ptr<boost::thread> >    _decode_threads;
+
+    statistics                  _statistics;
+
+}; // class async_texture_loader
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_ASYNC_TEXTURE_LOADER_H_INCLUDED
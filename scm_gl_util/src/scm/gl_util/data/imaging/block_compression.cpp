@@ -0,0 +1,866 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if SCM_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/utilities/parallel_for.h>
+
+// the encoders work on blocks of 4x4 texels gathered into rgba order, only the
+// index selection (the inner loop of every endpoint candidate) is vectorized,
+// it uses integer distances so the output is identical for every simd level
+
+namespace {
+
+using scm::uint8;
+using scm::uint16;
+using scm::uint32;
+using scm::uint64;
+using scm::int32;
+
+const unsigned block_texels = 16;
+
+// scalar kernels /////////////////////////////////////////////////////////////////////////////////
+
+void
+bc1_select_colors_scalar(const uint8* texels, const uint8* palette, unsigned palette_size,
+                         uint8* indices, int32* errors)
+{
+    for (unsigned i = 0; i < block_texels; ++i) {
+        const uint8* t = texels + i * 4;
+        int32        best_err = (std::numeric_limits<int32>::max)();
+        uint8        best_idx = 0;
+
+        for (unsigned k = 0; k < palette_size; ++k) {
+            const uint8* p  = palette + k * 4;
+            const int32  dr = static_cast<int32>(t[0]) - p[0];
+            const int32  dg = static_cast<int32>(t[1]) - p[1];
+            const int32  db = static_cast<int32>(t[2]) - p[2];
+            const int32  e  = dr * dr + dg * dg + db * db;
+
+            if (e < best_err) {
+                best_err = e;
+                best_idx = static_cast<uint8>(k);
+            }
+        }
+        indices[i] = best_idx;
+        errors[i]  = best_err;
+    }
+}
+
+void
+bc4_select_values_scalar(const uint8* values, const uint8* palette, uint8* indices, int32* errors)
+{
+    for (unsigned i = 0; i < block_texels; ++i) {
+        int32 best_dist = 256;
+        uint8 best_idx  = 0;
+
+        for (unsigned k = 0; k < 8; ++k) {
+            const int32 d = std::abs(static_cast<int32>(values[i]) - palette[k]);
+            if (d < best_dist) {
+                best_dist = d;
+                best_idx  = static_cast<uint8>(k);
+            }
+        }
+        indices[i] = best_idx;
+        errors[i]  = best_dist * best_dist;
+    }
+}
+
+#if SCM_SIMD_X86
+
+// sse4.1 kernels /////////////////////////////////////////////////////////////////////////////////
+
+SCM_SIMD_TARGET("sse4.1")
+void
+bc1_select_colors_sse41(const uint8* texels, const uint8* palette, unsigned palette_size,
+                        uint8* indices, int32* errors)
+{
+    // two texels per vector as 16bit rgba, the alpha lanes are masked out
+    const __m128i zero     = _mm_setzero_si128();
+    const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+    __m128i pal[4];
+    for (unsigned k = 0; k < palette_size; ++k) {
+        const uint8* p = palette + k * 4;
+        pal[k] = _mm_set_epi16(0, p[2], p[1], p[0], 0, p[2], p[1], p[0]);
+    }
+
+    for (unsigned q = 0; q < block_texels; q += 4) {
+        const __m128i t   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + q * 4));
+        const __m128i t01 = _mm_and_si128(_mm_unpacklo_epi8(t, zero), rgb_mask);
+        const __m128i t23 = _mm_and_si128(_mm_unpackhi_epi8(t, zero), rgb_mask);
+
+        __m128i best_err = _mm_set1_epi32((std::numeric_limits<int32>::max)());
+        __m128i best_idx = zero;
+
+        for (unsigned k = 0; k < palette_size; ++k) {
+            const __m128i d01 = _mm_sub_epi16(t01, pal[k]);
+            const __m128i d23 = _mm_sub_epi16(t23, pal[k]);
+            const __m128i e   = _mm_hadd_epi32(_mm_madd_epi16(d01, d01), _mm_madd_epi16(d23, d23));
+            const __m128i lt  = _mm_cmpgt_epi32(best_err, e);
+
+            best_err = _mm_min_epi32(best_err, e);
+            best_idx = _mm_blendv_epi8(best_idx, _mm_set1_epi32(k), lt);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(errors + q), best_err);
+
+        const __m128i idx = _mm_packus_epi16(_mm_packus_epi32(best_idx, zero), zero);
+        const int     i4  = _mm_cvtsi128_si32(idx);
+        std::memcpy(indices + q, &i4, 4);
+    }
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+bc4_select_values_sse41(const uint8* values, const uint8* palette, uint8* indices, int32* errors)
+{
+    // the whole block fits one vector of 8bit values
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    const __m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+
+    __m128i best_dist = ones;
+    __m128i best_idx  = zero;
+
+    for (unsigned k = 0; k < 8; ++k) {
+        const __m128i p  = _mm_set1_epi8(static_cast<char>(palette[k]));
+        const __m128i d  = _mm_or_si128(_mm_subs_epu8(v, p), _mm_subs_epu8(p, v));
+        const __m128i m  = _mm_min_epu8(d, best_dist);
+        const __m128i lt = _mm_andnot_si128(_mm_cmpeq_epi8(m, best_dist), ones);
+
+        best_dist = m;
+        best_idx  = _mm_blendv_epi8(best_idx, _mm_set1_epi8(static_cast<char>(k)), lt);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), best_idx);
+
+    // squares of 8bit distances fit unsigned 16bit
+    const __m128i d_lo = _mm_unpacklo_epi8(best_dist, zero);
+    const __m128i d_hi = _mm_unpackhi_epi8(best_dist, zero);
+    const __m128i e_lo = _mm_mullo_epi16(d_lo, d_lo);
+    const __m128i e_hi = _mm_mullo_epi16(d_hi, d_hi);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(errors     ), _mm_unpacklo_epi16(e_lo, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(errors +  4), _mm_unpackhi_epi16(e_lo, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(errors +  8), _mm_unpacklo_epi16(e_hi, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(errors + 12), _mm_unpackhi_epi16(e_hi, zero));
+}
+
+// avx2 kernels ///////////////////////////////////////////////////////////////////////////////////
+
+SCM_SIMD_TARGET("avx2")
+void
+bc1_select_colors_avx2(const uint8* texels, const uint8* palette, unsigned palette_size,
+                       uint8* indices, int32* errors)
+{
+    // four texels per vector as 16bit rgba, the horizontal add interleaves the
+    // 128bit lanes, the results are put back in order after the palette loop
+    const __m256i rgb_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+
+    __m256i pal[4];
+    for (unsigned k = 0; k < palette_size; ++k) {
+        const uint8* p = palette + k * 4;
+        pal[k] = _mm256_set_epi16(0, p[2], p[1], p[0], 0, p[2], p[1], p[0],
+                                  0, p[2], p[1], p[0], 0, p[2], p[1], p[0]);
+    }
+
+    for (unsigned q = 0; q < block_texels; q += 8) {
+        const __m256i t03 = _mm256_and_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + q * 4))),      rgb_mask);
+        const __m256i t47 = _mm256_and_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + q * 4 + 16))), rgb_mask);
+
+        __m256i best_err = _mm256_set1_epi32((std::numeric_limits<int32>::max)());
+        __m256i best_idx = _mm256_setzero_si256();
+
+        for (unsigned k = 0; k < palette_size; ++k) {
+            const __m256i d03 = _mm256_sub_epi16(t03, pal[k]);
+            const __m256i d47 = _mm256_sub_epi16(t47, pal[k]);
+            const __m256i e   = _mm256_hadd_epi32(_mm256_madd_epi16(d03, d03), _mm256_madd_epi16(d47, d47));
+            const __m256i lt  = _mm256_cmpgt_epi32(best_err, e);
+
+            best_err = _mm256_min_epi32(best_err, e);
+            best_idx = _mm256_blendv_epi8(best_idx, _mm256_set1_epi32(k), lt);
+        }
+
+        // texel order t0 t1 t4 t5 | t2 t3 t6 t7 to t0 .. t7
+        best_err = _mm256_permute4x64_epi64(best_err, _MM_SHUFFLE(3, 1, 2, 0));
+        best_idx = _mm256_permute4x64_epi64(best_idx, _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(errors + q), best_err);
+
+        const __m128i idx16 = _mm_packus_epi32(_mm256_castsi256_si128(best_idx), _mm256_extracti128_si256(best_idx, 1));
+        const __m128i idx8  = _mm_packus_epi16(idx16, _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(indices + q), idx8);
+    }
+}
+
+#endif // SCM_SIMD_X86
+
+// block encoders /////////////////////////////////////////////////////////////////////////////////
+
+struct block_source
+{
+    const uint8*    _data;
+    unsigned        _width;
+    unsigned        _height;
+    unsigned        _channels;
+    bool            _swizzled;  // bgr(a) channel order
+}; // struct block_source
+
+// gather the block at (bx, by) into rgba order, missing channels are 0 (alpha 255)
+void
+gather_block(const block_source& src, unsigned bx, unsigned by, uint8* texels)
+{
+    using namespace scm::math;
+
+    for (unsigned y = 0; y < 4; ++y) {
+        const unsigned sy = min(by * 4 + y, src._height - 1);
+        for (unsigned x = 0; x < 4; ++x) {
+            const unsigned sx = min(bx * 4 + x, src._width - 1);
+            const uint8*   s  = src._data + (static_cast<scm::size_t>(sy) * src._width + sx) * src._channels;
+            uint8*         t  = texels + (y * 4 + x) * 4;
+
+            t[0] = 0; t[1] = 0; t[2] = 0; t[3] = 255;
+            for (unsigned c = 0; c < src._channels; ++c) {
+                t[c] = s[c];
+            }
+            if (src._swizzled) {
+                std::swap(t[0], t[2]);
+            }
+        }
+    }
+}
+
+void
+extract_channel(const uint8* texels, unsigned c, uint8* values)
+{
+    for (unsigned i = 0; i < block_texels; ++i) {
+        values[i] = texels[i * 4 + c];
+    }
+}
+
+void
+select_colors(const uint8* texels, const uint8* palette, unsigned palette_size,
+              uint8* indices, int32* errors, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:     bc1_select_colors_avx2(texels, palette, palette_size, indices, errors);     break;
+        case CPU_SIMD_SSE4_1:   bc1_select_colors_sse41(texels, palette, palette_size, indices, errors);    break;
+#endif // SCM_SIMD_X86
+        default:                bc1_select_colors_scalar(texels, palette, palette_size, indices, errors);   break;
+    }
+}
+
+void
+select_values(const uint8* values, const uint8* palette, uint8* indices, int32* errors, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    // a block is a single sse vector, avx2 has nothing to add
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:
+        case CPU_SIMD_SSE4_1:   bc4_select_values_sse41(values, palette, indices, errors);  break;
+#endif // SCM_SIMD_X86
+        default:                bc4_select_values_scalar(values, palette, indices, errors); break;
+    }
+}
+
+// bc1 color blocks ///////////////////////////////////////////////////////////////////////////////
+
+struct bc1_candidate
+{
+    uint16      _c0;
+    uint16      _c1;
+    uint8       _indices[block_texels];
+    int32       _error;
+}; // struct bc1_candidate
+
+uint16
+pack_565(const float* c)
+{
+    using namespace scm::math;
+
+    const int r = clamp(static_cast<int>(c[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+    const int g = clamp(static_cast<int>(c[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+    const int b = clamp(static_cast<int>(c[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+
+    return static_cast<uint16>((r << 11) | (g << 5) | b);
+}
+
+void
+unpack_565(uint16 v, int* c)
+{
+    const int r = (v >> 11) & 0x1f;
+    const int g = (v >>  5) & 0x3f;
+    const int b =  v        & 0x1f;
+
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+}
+
+// the decoded palette, c0 > c1 (or bc3 color blocks) selects the 4 color
+// mode, otherwise the 3 color mode with transparent black at index 3
+unsigned
+bc1_palette(uint16 c0, uint16 c1, bool four_color_only, uint8* palette)
+{
+    int e0[3];
+    int e1[3];
+
+    unpack_565(c0, e0);
+    unpack_565(c1, e1);
+
+    const bool four_color = four_color_only || c0 > c1;
+
+    for (unsigned c = 0; c < 3; ++c) {
+        palette[     c] = static_cast<uint8>(e0[c]);
+        palette[4  + c] = static_cast<uint8>(e1[c]);
+        if (four_color) {
+            palette[8  + c] = static_cast<uint8>((2 * e0[c] + e1[c] + 1) / 3);
+            palette[12 + c] = static_cast<uint8>((e0[c] + 2 * e1[c] + 1) / 3);
+        }
+        else {
+            palette[8  + c] = static_cast<uint8>((e0[c] + e1[c] + 1) / 2);
+            palette[12 + c] = 0;
+        }
+    }
+    palette[3] = palette[7] = palette[11] = 255;
+    palette[15] = four_color ? 255 : 0;
+
+    return four_color ? 4 : 3;
+}
+
+// evaluate the endpoints a and b, ordered for the 4 color mode or for the 3
+// color mode of blocks with transparent texels
+void
+bc1_evaluate(const uint8*           texels,
+             unsigned               transparent,
+             bool                   four_color_only,
+             const float*           a,
+             const float*           b,
+             scm::cpu_simd_level    l,
+             bc1_candidate&         cand)
+{
+    uint16 c0 = pack_565(a);
+    uint16 c1 = pack_565(b);
+
+    if ((transparent == 0) == (c0 < c1)) {
+        std::swap(c0, c1);
+    }
+
+    uint8    palette[16];
+    unsigned palette_size = bc1_palette(c0, c1, four_color_only, palette);
+    int32    errors[block_texels];
+
+    // transparent texels only select index 3
+    select_colors(texels, palette, transparent != 0 ? 3 : palette_size, cand._indices, errors, l);
+
+    cand._c0    = c0;
+    cand._c1    = c1;
+    cand._error = 0;
+    for (unsigned i = 0; i < block_texels; ++i) {
+        if (transparent & (1u << i)) {
+            cand._indices[i] = 3;
+        }
+        else {
+            cand._error += errors[i];
+        }
+    }
+}
+
+// endpoints along the principal axis of the opaque texels
+void
+bc1_principal_endpoints(const uint8* texels, unsigned transparent, float* a, float* b)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    float cmin[3] = { 255.0f, 255.0f, 255.0f };
+    float cmax[3] = { 0.0f, 0.0f, 0.0f };
+    float count   = 0.0f;
+
+    for (unsigned i = 0; i < block_texels; ++i) {
+        if (transparent & (1u << i)) continue;
+        for (unsigned c = 0; c < 3; ++c) {
+            const float v = texels[i * 4 + c];
+            mean[c] += v;
+            cmin[c]  = scm::math::min(cmin[c], v);
+            cmax[c]  = scm::math::max(cmax[c], v);
+        }
+        count += 1.0f;
+    }
+    for (unsigned c = 0; c < 3; ++c) {
+        mean[c] /= count;
+    }
+
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned i = 0; i < block_texels; ++i) {
+        if (transparent & (1u << i)) continue;
+        const float r = texels[i * 4    ] - mean[0];
+        const float g = texels[i * 4 + 1] - mean[1];
+        const float b = texels[i * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // power iteration starting at the bounding box diagonal
+    float axis[3] = { cmax[0] - cmin[0], cmax[1] - cmin[1], cmax[2] - cmin[2] };
+    for (unsigned it = 0; it < 4; ++it) {
+        const float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        const float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        const float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        const float m = scm::math::max(std::fabs(x), scm::math::max(std::fabs(y), std::fabs(z)));
+
+        if (m < 1e-6f) break;
+        axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+    }
+
+    // the texels with the extreme projections onto the axis
+    float    pmin = (std::numeric_limits<float>::max)();
+    float    pmax = -(std::numeric_limits<float>::max)();
+    unsigned imin = 0;
+    unsigned imax = 0;
+    for (unsigned i = 0; i < block_texels; ++i) {
+        if (transparent & (1u << i)) continue;
+        const float p = texels[i * 4] * axis[0] + texels[i * 4 + 1] * axis[1] + texels[i * 4 + 2] * axis[2];
+        if (p < pmin) { pmin = p; imin = i; }
+        if (p > pmax) { pmax = p; imax = i; }
+    }
+    for (unsigned c = 0; c < 3; ++c) {
+        a[c] = texels[imax * 4 + c];
+        b[c] = texels[imin * 4 + c];
+    }
+}
+
+// least squares endpoints for the indices of the candidate
+bool
+bc1_refine_endpoints(const uint8* texels, unsigned transparent, bool four_color_only,
+                     const bc1_candidate& cand, float* a, float* b)
+{
+    static const float weights4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    static const float weights3[4] = { 1.0f, 0.0f, 1.0f / 2.0f, 0.0f };
+
+    const float* w = (four_color_only || cand._c0 > cand._c1) ? weights4 : weights3;
+
+    float aa = 0.0f;
+    float bb = 0.0f;
+    float ab = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+
+    for (unsigned i = 0; i < block_texels; ++i) {
+        if (transparent & (1u << i)) continue;
+        const float wa = w[cand._indices[i]];
+        const float wb = 1.0f - wa;
+
+        aa += wa * wa;
+        bb += wb * wb;
+        ab += wa * wb;
+        for (unsigned c = 0; c < 3; ++c) {
+            ax[c] += wa * texels[i * 4 + c];
+            bx[c] += wb * texels[i * 4 + c];
+        }
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    for (unsigned c = 0; c < 3; ++c) {
+        a[c] = scm::math::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+        b[c] = scm::math::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+void
+write_bc1_block(const bc1_candidate& cand, uint8* block)
+{
+    uint32 indices = 0;
+    for (unsigned i = 0; i < block_texels; ++i) {
+        indices |= static_cast<uint32>(cand._indices[i]) << (2 * i);
+    }
+
+    block[0] = static_cast<uint8>(cand._c0);
+    block[1] = static_cast<uint8>(cand._c0 >> 8);
+    block[2] = static_cast<uint8>(cand._c1);
+    block[3] = static_cast<uint8>(cand._c1 >> 8);
+    for (unsigned i = 0; i < 4; ++i) {
+        block[4 + i] = static_cast<uint8>(indices >> (8 * i));
+    }
+}
+
+void
+encode_bc1_block(const uint8*                       texels,
+                 bool                               use_alpha,
+                 bool                               four_color_only,
+                 scm::gl::util::block_compression_quality quality,
+                 scm::cpu_simd_level                l,
+                 uint8*                             block)
+{
+    unsigned transparent = 0;
+    if (use_alpha) {
+        for (unsigned i = 0; i < block_texels; ++i) {
+            if (texels[i * 4 + 3] < 128) transparent |= 1u << i;
+        }
+    }
+
+    bc1_candidate best;
+
+    if (transparent == 0xffff) {
+        // equal endpoints select the 3 color mode
+        best._c0 = best._c1 = 0;
+        std::fill(best._indices, best._indices + block_texels, static_cast<uint8>(3));
+        write_bc1_block(best, block);
+        return;
+    }
+
+    float a[3];
+    float b[3];
+
+    if (quality == scm::gl::util::BLOCK_COMPRESSION_FAST) {
+        // bounding box inset by 1/16 of its extent
+        float cmin[3] = { 255.0f, 255.0f, 255.0f };
+        float cmax[3] = { 0.0f, 0.0f, 0.0f };
+        for (unsigned i = 0; i < block_texels; ++i) {
+            if (transparent & (1u << i)) continue;
+            for (unsigned c = 0; c < 3; ++c) {
+                cmin[c] = scm::math::min(cmin[c], static_cast<float>(texels[i * 4 + c]));
+                cmax[c] = scm::math::max(cmax[c], static_cast<float>(texels[i * 4 + c]));
+            }
+        }
+        for (unsigned c = 0; c < 3; ++c) {
+            const float inset = (cmax[c] - cmin[c]) / 16.0f;
+            a[c] = cmax[c] - inset;
+            b[c] = cmin[c] + inset;
+        }
+        bc1_evaluate(texels, transparent, four_color_only, a, b, l, best);
+    }
+    else {
+        bc1_principal_endpoints(texels, transparent, a, b);
+        bc1_evaluate(texels, transparent, four_color_only, a, b, l, best);
+
+        for (unsigned it = 0; it < 2 && best._error > 0; ++it) {
+            bc1_candidate cand;
+            if (!bc1_refine_endpoints(texels, transparent, four_color_only, best, a, b)) {
+                break;
+            }
+            bc1_evaluate(texels, transparent, four_color_only, a, b, l, cand);
+            if (cand._error >= best._error) {
+                break;
+            }
+            best = cand;
+        }
+    }
+
+    write_bc1_block(best, block);
+}
+
+// bc4 value blocks (also bc3 alpha and bc5 channels) /////////////////////////////////////////////
+
+struct bc4_candidate
+{
+    uint8       _r0;
+    uint8       _r1;
+    uint8       _indices[block_texels];
+    int32       _error;
+}; // struct bc4_candidate
+
+// the decoded palette, r0 > r1 selects the 8 value mode, otherwise the 6 value
+// mode with 0 and 255 at index 6 and 7
+void
+bc4_palette(uint8 r0, uint8 r1, uint8* palette)
+{
+    palette[0] = r0;
+    palette[1] = r1;
+    if (r0 > r1) {
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = static_cast<uint8>(((8 - i) * r0 + (i - 1) * r1 + 3) / 7);
+        }
+    }
+    else {
+        for (int i = 2; i < 6; ++i) {
+            palette[i] = static_cast<uint8>(((6 - i) * r0 + (i - 1) * r1 + 2) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void
+bc4_evaluate(const uint8* values, int r0, int r1, bool eight_values, scm::cpu_simd_level l, bc4_candidate& cand)
+{
+    r0 = scm::math::clamp(r0, 0, 255);
+    r1 = scm::math::clamp(r1, 0, 255);
+
+    if (eight_values == (r0 < r1)) {
+        std::swap(r0, r1);
+    }
+
+    uint8 palette[8];
+    int32 errors[block_texels];
+
+    cand._r0 = static_cast<uint8>(r0);
+    cand._r1 = static_cast<uint8>(r1);
+
+    bc4_palette(cand._r0, cand._r1, palette);
+    select_values(values, palette, cand._indices, errors, l);
+
+    cand._error = 0;
+    for (unsigned i = 0; i < block_texels; ++i) {
+        cand._error += errors[i];
+    }
+}
+
+bool
+bc4_refine_endpoints(const uint8* values, const bc4_candidate& cand, int& r0, int& r1)
+{
+    float w[8];
+    if (cand._r0 > cand._r1) {
+        for (int i = 0; i < 8; ++i) {
+            w[i] = (i == 0) ? 1.0f : (i == 1) ? 0.0f : float(8 - i) / 7.0f;
+        }
+    }
+    else {
+        for (int i = 0; i < 6; ++i) {
+            w[i] = (i == 0) ? 1.0f : (i == 1) ? 0.0f : float(6 - i) / 5.0f;
+        }
+        w[6] = w[7] = -1.0f; // fixed values, not part of the fit
+    }
+
+    float aa = 0.0f;
+    float bb = 0.0f;
+    float ab = 0.0f;
+    float ax = 0.0f;
+    float bx = 0.0f;
+
+    for (unsigned i = 0; i < block_texels; ++i) {
+        const float wa = w[cand._indices[i]];
+        if (wa < 0.0f) continue;
+        const float wb = 1.0f - wa;
+
+        aa += wa * wa;
+        bb += wb * wb;
+        ab += wa * wb;
+        ax += wa * values[i];
+        bx += wb * values[i];
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    r0 = static_cast<int>(std::floor((ax * bb - bx * ab) / det + 0.5f));
+    r1 = static_cast<int>(std::floor((bx * aa - ax * ab) / det + 0.5f));
+    return true;
+}
+
+void
+write_bc4_block(const bc4_candidate& cand, uint8* block)
+{
+    uint64 indices = 0;
+    for (unsigned i = 0; i < block_texels; ++i) {
+        indices |= static_cast<uint64>(cand._indices[i]) << (3 * i);
+    }
+
+    block[0] = cand._r0;
+    block[1] = cand._r1;
+    for (unsigned i = 0; i < 6; ++i) {
+        block[2 + i] = static_cast<uint8>(indices >> (8 * i));
+    }
+}
+
+void
+refine_bc4_candidate(const uint8* values, bool eight_values, unsigned iterations,
+                     scm::cpu_simd_level l, bc4_candidate& best)
+{
+    for (unsigned it = 0; it < iterations && best._error > 0; ++it) {
+        bc4_candidate cand;
+        int           r0;
+        int           r1;
+        if (!bc4_refine_endpoints(values, best, r0, r1)) {
+            break;
+        }
+        bc4_evaluate(values, r0, r1, eight_values, l, cand);
+        if (cand._error >= best._error) {
+            break;
+        }
+        best = cand;
+    }
+}
+
+void
+encode_bc4_block(const uint8*                       values,
+                 scm::gl::util::block_compression_quality quality,
+                 scm::cpu_simd_level                l,
+                 uint8*                             block)
+{
+    int vmin = 255;
+    int vmax = 0;
+    int imin = 255;     // inner range without 0 and 255
+    int imax = 0;
+
+    for (unsigned i = 0; i < block_texels; ++i) {
+        const int v = values[i];
+        vmin = scm::math::min(vmin, v);
+        vmax = scm::math::max(vmax, v);
+        if (v != 0 && v != 255) {
+            imin = scm::math::min(imin, v);
+            imax = scm::math::max(imax, v);
+        }
+    }
+
+    bc4_candidate best;
+    bc4_evaluate(values, vmax, vmin, true, l, best);
+
+    if (quality != scm::gl::util::BLOCK_COMPRESSION_FAST) {
+        refine_bc4_candidate(values, true, 2, l, best);
+
+        // blocks reaching 0 or 255 may be represented better in the 6 value mode
+        if (best._error > 0 && (vmin == 0 || vmax == 255)) {
+            bc4_candidate cand;
+
+            if (imin > imax) {
+                imin = imax = vmin;
+            }
+            bc4_evaluate(values, imin, imax, false, l, cand);
+            refine_bc4_candidate(values, false, 1, l, cand);
+
+            if (cand._error < best._error) {
+                best = cand;
+            }
+        }
+    }
+
+    write_bc4_block(best, block);
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace util {
+namespace detail {
+
+void
+bc1_select_colors(const uint8*      texels,
+                  const uint8*      palette,
+                  unsigned          palette_size,
+                  uint8*            indices,
+                  int32*            errors,
+                  cpu_simd_level    l)
+{
+    select_colors(texels, palette, palette_size, indices, errors, l);
+}
+
+void
+bc4_select_values(const uint8*      values,
+                  const uint8*      palette,
+                  uint8*            indices,
+                  int32*            errors,
+                  cpu_simd_level    l)
+{
+    select_values(values, palette, indices, errors, l);
+}
+
+} // namespace detail
+
+bool
+compress_image_blocks(const math::vec2ui&        src_dim,
+                            data_format          src_fmt,
+                      const uint8*               src_data,
+                            data_format          dst_fmt,
+                            uint8*               dst_data,
+                            block_compression_quality quality,
+                            cpu_simd_level       l)
+{
+    using namespace scm::math;
+
+    if (!block_compression_supported(src_fmt, dst_fmt)) {
+        glerr() << log::error
+                << "compress_image_blocks(): error unsupported format combination ("
+                << format_string(src_fmt) << " to " << format_string(dst_fmt) << ")." << log::end;
+        return false;
+    }
+
+    if (src_dim.x == 0 || src_dim.y == 0) {
+        return true;
+    }
+
+    block_source src;
+    src._data     = src_data;
+    src._width    = src_dim.x;
+    src._height   = src_dim.y;
+    src._channels = channel_count(src_fmt);
+    src._swizzled = (src_fmt == FORMAT_BGR_8 || src_fmt == FORMAT_BGRA_8);
+
+    const unsigned    blocks_x   = (src_dim.x + 3) / 4;
+    const unsigned    blocks_y   = (src_dim.y + 3) / 4;
+    const scm::size_t block_size = compressed_block_size(dst_fmt);
+
+    // block rows of at least ~1024 blocks per task
+    const unsigned    rows_per_task = max(1u, 1024u / blocks_x);
+    const scm::size_t task_count    = (blocks_y + rows_per_task - 1) / rows_per_task;
+
+    util::parallel_for(task_count, [&](scm::size_t task, scm::size_t) {
+        uint8 texels[block_texels * 4];
+        uint8 values[block_texels];
+
+        const unsigned by_begin = static_cast<unsigned>(task) * rows_per_task;
+        const unsigned by_end   = min(blocks_y, by_begin + rows_per_task);
+
+        for (unsigned by = by_begin; by < by_end; ++by) {
+            uint8* block = dst_data + static_cast<scm::size_t>(by) * blocks_x * block_size;
+
+            for (unsigned bx = 0; bx < blocks_x; ++bx, block += block_size) {
+                gather_block(src, bx, by, texels);
+
+                switch (dst_fmt) {
+                case FORMAT_BC1_RGBA:
+                case FORMAT_BC1_SRGBA:
+                    encode_bc1_block(texels, src._channels == 4, false, quality, l, block);
+                    break;
+                case FORMAT_BC3_RGBA:
+                case FORMAT_BC3_SRGBA:
+                    extract_channel(texels, 3, values);
+                    encode_bc4_block(values, quality, l, block);
+                    encode_bc1_block(texels, false, true, quality, l, block + 8);
+                    break;
+                case FORMAT_BC4_R:
+                    extract_channel(texels, 0, values);
+                    encode_bc4_block(values, quality, l, block);
+                    break;
+                case FORMAT_BC5_RG:
+                    extract_channel(texels, 0, values);
+                    encode_bc4_block(values, quality, l, block);
+                    extract_channel(texels, 1, values);
+                    encode_bc4_block(values, quality, l, block + 8);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    });
+
+    return true;
+}
+
+} // namespace util
+} // namespace gl
+} // namespace scm
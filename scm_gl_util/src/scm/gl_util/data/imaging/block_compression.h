@@ -0,0 +1,67 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_BLOCK_COMPRESSION_H_INCLUDED
+#define SCM_GL_UTIL_BLOCK_COMPRESSION_H_INCLUDED
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/platform/cpu_features.h>
+
+#include <scm/gl_core/data_formats.h>
+
+#include <scm/gl_util/data/imaging/texture_data_util.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+namespace util {
+namespace detail {
+
+// index selection kernels of the block encoders, vectorized for the simd level
+// with identical results for every level
+// - bc1_select_colors picks for each of the 16 rgba texels the closest of the
+//   first palette_size colors of the rgba palette (squared rgb distance)
+// - bc4_select_values picks for each of the 16 values the closest of the 8
+//   palette values
+// - ties resolve to the lower index, errors receives the squared distances
+__scm_export(gl_util) void  bc1_select_colors(const uint8*      texels,
+                                              const uint8*      palette,
+                                              unsigned          palette_size,
+                                              uint8*            indices,
+                                              int32*            errors,
+                                              cpu_simd_level    l);
+__scm_export(gl_util) void  bc4_select_values(const uint8*      values,
+                                              const uint8*      palette,
+                                              uint8*            indices,
+                                              int32*            errors,
+                                              cpu_simd_level    l);
+
+} // namespace detail
+
+// compress a 2d image (rows tightly packed) to dst_fmt, the block rows are
+// distributed over all hardware threads
+// - source formats: FORMAT_R_8, FORMAT_RG_8, FORMAT_RGB_8, FORMAT_RGBA_8,
+//   FORMAT_BGR_8 and FORMAT_BGRA_8
+// - destination formats: FORMAT_BC1_RGBA, FORMAT_BC3_RGBA (and their srgb
+//   variants), FORMAT_BC4_R (red channel) and FORMAT_BC5_RG (red and green)
+// - bc1 uses 1-bit alpha (alpha < 128 is transparent) for sources with alpha
+// - partial blocks at the right and bottom border replicate the edge texels
+bool __scm_export(gl_util)  compress_image_blocks(const math::vec2ui&        src_dim,
+                                                        data_format          src_fmt,
+                                                  const uint8*               src_data,
+                                                        data_format          dst_fmt,
+                                                        uint8*               dst_data,
+                                                        block_compression_quality quality,
+                                                        cpu_simd_level       l);
+
+} // namespace util
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_BLOCK_COMPRESSION_H_INCLUDED
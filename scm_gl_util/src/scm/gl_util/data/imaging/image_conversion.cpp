@@ -0,0 +1,916 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "image_conversion.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if SCM_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+#include <scm/gl_util/utilities/parallel_for.h>
+
+// the conversions work row by row, rows are distributed over all hardware
+// threads in ranges of about task_bytes, every kernel has a scalar tail for
+// the remainder of a row so no row is ever read or written out of bounds
+
+namespace {
+
+using scm::uint8;
+using scm::uint16;
+using scm::int32;
+using scm::uint32;
+
+const scm::size_t task_bytes = 256 * 1024;
+
+enum component_type {
+    COMPONENT_UINT8     = 0x00,
+    COMPONENT_UINT16,
+    COMPONENT_FLOAT
+}; // enum component_type
+
+struct pixel_layout
+{
+    unsigned        _channels;
+    component_type  _type;
+    bool            _bgr;
+}; // struct pixel_layout
+
+bool
+layout_of(scm::gl::data_format fmt, pixel_layout& out)
+{
+    using namespace scm::gl;
+
+    const pixel_layout layouts[] = {
+        { 1, COMPONENT_UINT8,  false }, { 2, COMPONENT_UINT8,  false }, { 3, COMPONENT_UINT8,  false }, { 4, COMPONENT_UINT8,  false },
+        { 3, COMPONENT_UINT8,  true  }, { 4, COMPONENT_UINT8,  true  },
+        { 1, COMPONENT_UINT16, false }, { 2, COMPONENT_UINT16, false }, { 3, COMPONENT_UINT16, false }, { 4, COMPONENT_UINT16, false },
+        { 1, COMPONENT_FLOAT,  false }, { 2, COMPONENT_FLOAT,  false }, { 3, COMPONENT_FLOAT,  false }, { 4, COMPONENT_FLOAT,  false }
+    };
+
+    switch (fmt) {
+        case FORMAT_R_8:        out = layouts[0];  return true;
+        case FORMAT_RG_8:       out = layouts[1];  return true;
+        case FORMAT_RGB_8:      out = layouts[2];  return true;
+        case FORMAT_RGBA_8:     out = layouts[3];  return true;
+        case FORMAT_BGR_8:      out = layouts[4];  return true;
+        case FORMAT_BGRA_8:     out = layouts[5];  return true;
+        case FORMAT_R_16:       out = layouts[6];  return true;
+        case FORMAT_RG_16:      out = layouts[7];  return true;
+        case FORMAT_RGB_16:     out = layouts[8];  return true;
+        case FORMAT_RGBA_16:    out = layouts[9];  return true;
+        case FORMAT_R_32F:      out = layouts[10]; return true;
+        case FORMAT_RG_32F:     out = layouts[11]; return true;
+        case FORMAT_RGB_32F:    out = layouts[12]; return true;
+        case FORMAT_RGBA_32F:   out = layouts[13]; return true;
+        default:                return false;
+    }
+}
+
+scm::size_t
+component_size(component_type t)
+{
+    switch (t) {
+        case COMPONENT_UINT8:   return 1;
+        case COMPONENT_UINT16:  return 2;
+        default:                return 4;
+    }
+}
+
+scm::size_t
+pixel_size(const pixel_layout& p)
+{
+    return p._channels * component_size(p._type);
+}
+
+// position of the named channel c (0 = red, ..., 3 = alpha) in a pixel, the
+// mapping is its own inverse
+unsigned
+channel_index(const pixel_layout& p, unsigned c)
+{
+    return (p._bgr && c < 3) ? 2 - c : c;
+}
+
+// run f(begin, end) on ranges of rows of row_bytes bytes each
+template<typename range_function>
+void
+for_row_ranges(scm::size_t rows, scm::size_t row_bytes, const range_function& f)
+{
+    const scm::size_t rows_per_task = (std::max)(scm::size_t(1), task_bytes / (std::max)(scm::size_t(1), row_bytes));
+    const scm::size_t task_count    = (rows + rows_per_task - 1) / rows_per_task;
+
+    if (task_count < 2) {
+        f(scm::size_t(0), rows);
+        return;
+    }
+
+    scm::gl::util::parallel_for(task_count, [&](scm::size_t task, scm::size_t) {
+        f(task * rows_per_task, (std::min)(rows, (task + 1) * rows_per_task));
+    });
+}
+
+// scalar kernels /////////////////////////////////////////////////////////////////////////////////
+
+inline uint16  to_uint16(uint8  v) { return static_cast<uint16>(v * 257u); }
+inline uint8   to_uint8(uint16  v) { return static_cast<uint8>((v * 255u + 32895u) >> 16); }
+inline float   to_float(uint8   v) { return static_cast<float>(v) / 255.0f; }
+inline float   to_float(uint16  v) { return static_cast<float>(v) / 65535.0f; }
+
+// max/min in the operand order of maxps/minps, nan becomes 0
+inline float   clamp_unit(float v) { v = v > 0.0f ? v : 0.0f; return v < 1.0f ? v : 1.0f; }
+inline uint8   to_uint8(float   v) { return static_cast<uint8>(static_cast<int32>(clamp_unit(v) * 255.0f + 0.5f)); }
+inline uint16  to_uint16(float  v) { return static_cast<uint16>(static_cast<int32>(clamp_unit(v) * 65535.0f + 0.5f)); }
+
+inline uint8   to_uint8(uint8   v) { return v; }
+inline uint16  to_uint16(uint16 v) { return v; }
+inline float   to_float(float   v) { return v; }
+
+template<typename value_type> struct value_one;
+template<> struct value_one<uint8>  { static uint8  get() { return 0xff; } };
+template<> struct value_one<uint16> { static uint16 get() { return 0xffff; } };
+template<> struct value_one<float>  { static float  get() { return 1.0f; } };
+
+template<typename src_type> inline void convert_value(src_type s, uint8&  d) { d = to_uint8(s); }
+template<typename src_type> inline void convert_value(src_type s, uint16& d) { d = to_uint16(s); }
+template<typename src_type> inline void convert_value(src_type s, float&  d) { d = to_float(s); }
+
+template<typename src_type, typename dst_type>
+void
+convert_components_scalar(const src_type* s, dst_type* d, scm::size_t count)
+{
+    for (scm::size_t i = 0; i < count; ++i) {
+        convert_value(s[i], d[i]);
+    }
+}
+
+// general pixel conversion, channels matched by name
+template<typename src_type, typename dst_type>
+void
+convert_pixels_scalar(const src_type* s, const pixel_layout& sl, dst_type* d, const pixel_layout& dl, scm::size_t pixels)
+{
+    for (scm::size_t p = 0; p < pixels; ++p, s += sl._channels, d += dl._channels) {
+        for (unsigned c = 0; c < dl._channels; ++c) {
+            const unsigned n = channel_index(dl, c);
+
+            if (n < sl._channels && !(n == 3 && sl._channels < 4)) {
+                convert_value(s[channel_index(sl, n)], d[c]);
+            }
+            else {
+                d[c] = (n == 3) ? value_one<dst_type>::get() : dst_type(0);
+            }
+        }
+    }
+}
+
+template<typename value_type>
+void
+swap_red_blue_scalar(value_type* d, unsigned channels, scm::size_t pixels)
+{
+    for (scm::size_t p = 0; p < pixels; ++p, d += channels) {
+        std::swap(d[0], d[2]);
+    }
+}
+
+// 8bit 3 <-> 4 channels, swap exchanges red and blue
+void
+expand_rgb_rgba_scalar(const uint8* s, uint8* d, scm::size_t pixels, bool swap)
+{
+    const unsigned r = swap ? 2 : 0;
+    const unsigned b = swap ? 0 : 2;
+    for (scm::size_t p = 0; p < pixels; ++p, s += 3, d += 4) {
+        d[0] = s[r]; d[1] = s[1]; d[2] = s[b]; d[3] = 0xff;
+    }
+}
+
+void
+pack_rgba_rgb_scalar(const uint8* s, uint8* d, scm::size_t pixels, bool swap)
+{
+    const unsigned r = swap ? 2 : 0;
+    const unsigned b = swap ? 0 : 2;
+    for (scm::size_t p = 0; p < pixels; ++p, s += 4, d += 3) {
+        d[0] = s[r]; d[1] = s[1]; d[2] = s[b];
+    }
+}
+
+// scale pattern for four pixels of c channels, physical component order
+void
+build_scale_pattern(const pixel_layout& p, const scm::math::vec4f& scale, float* pattern)
+{
+    for (unsigned i = 0; i < 4 * p._channels; ++i) {
+        pattern[i] = scale[channel_index(p, i % p._channels)];
+    }
+}
+
+void
+scale_components_scalar(uint8* d, scm::size_t count, const float* pattern, unsigned period)
+{
+    for (scm::size_t i = 0; i < count; ++i) {
+        float f = d[i] * pattern[i % period];
+        f = f > 0.0f   ? f : 0.0f;
+        f = f < 255.0f ? f : 255.0f;
+        d[i] = static_cast<uint8>(static_cast<int32>(f));
+    }
+}
+
+void
+scale_components_scalar(uint16* d, scm::size_t count, const float* pattern, unsigned period)
+{
+    for (scm::size_t i = 0; i < count; ++i) {
+        float f = d[i] * pattern[i % period];
+        f = f > 0.0f     ? f : 0.0f;
+        f = f < 65535.0f ? f : 65535.0f;
+        d[i] = static_cast<uint16>(static_cast<int32>(f));
+    }
+}
+
+// exchange through a small stack buffer, memcpy is vectorized by the runtime
+void
+swap_rows_scalar(uint8* a, uint8* b, scm::size_t bytes)
+{
+    uint8 tmp[1024];
+    for (scm::size_t i = 0; i < bytes; i += sizeof(tmp)) {
+        const scm::size_t n = (std::min)(sizeof(tmp), bytes - i);
+        memcpy(tmp,   a + i, n);
+        memcpy(a + i, b + i, n);
+        memcpy(b + i, tmp,   n);
+    }
+}
+
+void
+scale_components_scalar(float* d, scm::size_t count, const float* pattern, unsigned period)
+{
+    for (scm::size_t i = 0; i < count; ++i) {
+        d[i] = d[i] * pattern[i % period];
+    }
+}
+
+#if SCM_SIMD_X86
+
+// sse4.1 kernels /////////////////////////////////////////////////////////////////////////////////
+
+SCM_SIMD_TARGET("sse4.1")
+void
+swap_rows_sse41(uint8* a, uint8* b, scm::size_t bytes)
+{
+    scm::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), vb);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), va);
+    }
+    std::swap_ranges(a + i, a + bytes, b + i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_components_sse41(const uint8* s, uint16* d, scm::size_t count)
+{
+    const __m128i m = _mm_set1_epi16(257);
+    scm::size_t   i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_mullo_epi16(v, m));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_components_sse41(const uint8* s, float* d, scm::size_t count)
+{
+    const __m128 n = _mm_set1_ps(255.0f);
+    scm::size_t  i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32 w;
+        memcpy(&w, s + i, 4);
+        const __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(w));
+        _mm_storeu_ps(d + i, _mm_div_ps(_mm_cvtepi32_ps(v), n));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_components_sse41(const uint16* s, uint8* d, scm::size_t count)
+{
+    const __m128i m = _mm_set1_epi32(255);
+    const __m128i r = _mm_set1_epi32(32895);
+    scm::size_t   i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i lo = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu16_epi32(v), m), r), 16);
+        const __m128i hi = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)), m), r), 16);
+        const __m128i p  = _mm_packus_epi16(_mm_packus_epi32(lo, hi), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(d + i), p);
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_components_sse41(const uint16* s, float* d, scm::size_t count)
+{
+    const __m128 n = _mm_set1_ps(65535.0f);
+    scm::size_t  i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i)));
+        _mm_storeu_ps(d + i, _mm_div_ps(_mm_cvtepi32_ps(v), n));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+inline __m128i
+float_to_unorm_sse41(const float* s, __m128 n)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    __m128 v = _mm_loadu_ps(s);
+    v = _mm_min_ps(_mm_max_ps(v, zero), one);
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, n), half));
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_components_sse41(const float* s, uint8* d, scm::size_t count)
+{
+    const __m128 n = _mm_set1_ps(255.0f);
+    scm::size_t  i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = float_to_unorm_sse41(s + i,     n);
+        const __m128i hi = float_to_unorm_sse41(s + i + 4, n);
+        const __m128i p  = _mm_packus_epi16(_mm_packus_epi32(lo, hi), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(d + i), p);
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_components_sse41(const float* s, uint16* d, scm::size_t count)
+{
+    const __m128 n = _mm_set1_ps(65535.0f);
+    scm::size_t  i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = float_to_unorm_sse41(s + i,     n);
+        const __m128i hi = float_to_unorm_sse41(s + i + 4, n);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_packus_epi32(lo, hi));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+swap_red_blue_rgba8_sse41(uint8* d, scm::size_t pixels)
+{
+    const __m128i m = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    scm::size_t   p = 0;
+    for (; p + 4 <= pixels; p += 4) {
+        __m128i* v = reinterpret_cast<__m128i*>(d + p * 4);
+        _mm_storeu_si128(v, _mm_shuffle_epi8(_mm_loadu_si128(v), m));
+    }
+    swap_red_blue_scalar(d + p * 4, 4, pixels - p);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+swap_red_blue_rgb8_sse41(uint8* d, scm::size_t pixels)
+{
+    // 16 pixels in three vectors, the pixels crossing the vector boundaries
+    // are combined from both neighbours (-1 selects zero)
+    const __m128i m0a = _mm_setr_epi8( 2,  1,  0,  5,  4,  3,  8,  7,  6, 11, 10,  9, 14, 13, 12, -1);
+    const __m128i m0b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1);
+    const __m128i m1a = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m1b = _mm_setr_epi8( 0, -1,  4,  3,  2,  7,  6,  5, 10,  9,  8, 13, 12, 11, -1, 15);
+    const __m128i m1c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1);
+    const __m128i m2b = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m2c = _mm_setr_epi8(-1,  3,  2,  1,  6,  5,  4,  9,  8,  7, 12, 11, 10, 15, 14, 13);
+    scm::size_t   p = 0;
+    for (; p + 16 <= pixels; p += 16) {
+        __m128i*      v = reinterpret_cast<__m128i*>(d + p * 3);
+        const __m128i a = _mm_loadu_si128(v);
+        const __m128i b = _mm_loadu_si128(v + 1);
+        const __m128i c = _mm_loadu_si128(v + 2);
+        _mm_storeu_si128(v,     _mm_or_si128(_mm_shuffle_epi8(a, m0a), _mm_shuffle_epi8(b, m0b)));
+        _mm_storeu_si128(v + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m1a), _mm_shuffle_epi8(b, m1b)),
+                                             _mm_shuffle_epi8(c, m1c)));
+        _mm_storeu_si128(v + 2, _mm_or_si128(_mm_shuffle_epi8(b, m2b), _mm_shuffle_epi8(c, m2c)));
+    }
+    swap_red_blue_scalar(d + p * 3, 3, pixels - p);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+expand_rgb_rgba_sse41(const uint8* s, uint8* d, scm::size_t pixels, bool swap)
+{
+    // four pixels per vector, the source load reads four bytes ahead
+    const __m128i m = swap ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+                           : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i a = _mm_set1_epi32(static_cast<int>(0xff000000));
+    scm::size_t   p = 0;
+    for (; p * 3 + 16 <= pixels * 3; p += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + p * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + p * 4), _mm_or_si128(_mm_shuffle_epi8(v, m), a));
+    }
+    expand_rgb_rgba_scalar(s + p * 3, d + p * 4, pixels - p, swap);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+pack_rgba_rgb_sse41(const uint8* s, uint8* d, scm::size_t pixels, bool swap)
+{
+    // four pixels per vector, the store writes four bytes ahead that are
+    // overwritten by the next iteration
+    const __m128i m = swap ? _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)
+                           : _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    scm::size_t   p = 0;
+    for (; p * 3 + 16 <= pixels * 3 && p + 4 <= pixels; p += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + p * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + p * 3), _mm_shuffle_epi8(v, m));
+    }
+    pack_rgba_rgb_scalar(s + p * 4, d + p * 3, pixels - p, swap);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+scale_components_sse41(uint8* d, scm::size_t count, const float* pattern, unsigned period)
+{
+    // period (4 * channels) components per iteration, four at a time
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 upper = _mm_set1_ps(255.0f);
+    scm::size_t  i    = 0;
+    for (; i + period <= count; i += period) {
+        for (unsigned k = 0; k < period; k += 4) {
+            int32 w;
+            memcpy(&w, d + i + k, 4);
+            __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(w))), _mm_loadu_ps(pattern + k));
+            f = _mm_min_ps(_mm_max_ps(f, zero), upper);
+            const __m128i v = _mm_cvttps_epi32(f);
+            const __m128i w16 = _mm_packus_epi32(v, v);
+            w = _mm_cvtsi128_si32(_mm_packus_epi16(w16, w16));
+            memcpy(d + i + k, &w, 4);
+        }
+    }
+    scale_components_scalar(d + i, count - i, pattern, period);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+scale_components_sse41(float* d, scm::size_t count, const float* pattern, unsigned period)
+{
+    scm::size_t i = 0;
+    for (; i + period <= count; i += period) {
+        for (unsigned k = 0; k < period; k += 4) {
+            _mm_storeu_ps(d + i + k, _mm_mul_ps(_mm_loadu_ps(d + i + k), _mm_loadu_ps(pattern + k)));
+        }
+    }
+    scale_components_scalar(d + i, count - i, pattern, period);
+}
+
+// avx2 kernels ///////////////////////////////////////////////////////////////////////////////////
+
+SCM_SIMD_TARGET("avx2")
+void
+swap_rows_avx2(uint8* a, uint8* b, scm::size_t bytes)
+{
+    scm::size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), vb);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + i), va);
+    }
+    std::swap_ranges(a + i, a + bytes, b + i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_components_avx2(const uint8* s, uint16* d, scm::size_t count)
+{
+    const __m256i m = _mm256_set1_epi16(257);
+    scm::size_t   i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), _mm256_mullo_epi16(v, m));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_components_avx2(const uint8* s, float* d, scm::size_t count)
+{
+    const __m256 n = _mm256_set1_ps(255.0f);
+    scm::size_t  i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i)));
+        _mm256_storeu_ps(d + i, _mm256_div_ps(_mm256_cvtepi32_ps(v), n));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_components_avx2(const uint16* s, uint8* d, scm::size_t count)
+{
+    const __m256i m = _mm256_set1_epi32(255);
+    const __m256i r = _mm256_set1_epi32(32895);
+    scm::size_t   i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 8));
+        const __m256i w0 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvtepu16_epi32(v0), m), r), 16);
+        const __m256i w1 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvtepu16_epi32(v1), m), r), 16);
+        const __m128i p0 = _mm_packus_epi32(_mm256_castsi256_si128(w0), _mm256_extracti128_si256(w0, 1));
+        const __m128i p1 = _mm_packus_epi32(_mm256_castsi256_si128(w1), _mm256_extracti128_si256(w1, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_packus_epi16(p0, p1));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_components_avx2(const uint16* s, float* d, scm::size_t count)
+{
+    const __m256 n = _mm256_set1_ps(65535.0f);
+    scm::size_t  i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        _mm256_storeu_ps(d + i, _mm256_div_ps(_mm256_cvtepi32_ps(v), n));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+inline __m128i
+float_to_unorm_avx2(const float* s, __m256 n)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one  = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    __m256 v = _mm256_loadu_ps(s);
+    v = _mm256_min_ps(_mm256_max_ps(v, zero), one);
+
+    const __m256i i = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, n), half));
+    return _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_components_avx2(const float* s, uint8* d, scm::size_t count)
+{
+    const __m256 n = _mm256_set1_ps(255.0f);
+    scm::size_t  i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i p = _mm_packus_epi16(float_to_unorm_avx2(s + i, n), float_to_unorm_avx2(s + i + 8, n));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), p);
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_components_avx2(const float* s, uint16* d, scm::size_t count)
+{
+    const __m256 n = _mm256_set1_ps(65535.0f);
+    scm::size_t  i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), float_to_unorm_avx2(s + i, n));
+    }
+    convert_components_scalar(s + i, d + i, count - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+swap_red_blue_rgba8_avx2(uint8* d, scm::size_t pixels)
+{
+    const __m256i m = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                       2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    scm::size_t   p = 0;
+    for (; p + 8 <= pixels; p += 8) {
+        __m256i* v = reinterpret_cast<__m256i*>(d + p * 4);
+        _mm256_storeu_si256(v, _mm256_shuffle_epi8(_mm256_loadu_si256(v), m));
+    }
+    swap_red_blue_scalar(d + p * 4, 4, pixels - p);
+}
+
+#endif // SCM_SIMD_X86
+
+// dispatch ///////////////////////////////////////////////////////////////////////////////////////
+
+scm::cpu_simd_level
+effective_level(scm::cpu_simd_level l)
+{
+    return scm::math::min(l, scm::cpu_supported_simd_level());
+}
+
+void
+swap_red_blue_row(uint8* d, const pixel_layout& p, scm::size_t pixels, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    switch (p._type) {
+        case COMPONENT_UINT8:
+#if SCM_SIMD_X86
+            switch (effective_level(l)) {
+                case CPU_SIMD_AVX2:
+                    // three channels do not fit the 128bit lanes
+                    if (p._channels == 4) { swap_red_blue_rgba8_avx2(d, pixels); }
+                    else                  { swap_red_blue_rgb8_sse41(d, pixels); }
+                    return;
+                case CPU_SIMD_SSE4_1:
+                    if (p._channels == 4) { swap_red_blue_rgba8_sse41(d, pixels); }
+                    else                  { swap_red_blue_rgb8_sse41(d, pixels); }
+                    return;
+                default: break;
+            }
+#endif
+            swap_red_blue_scalar(d, p._channels, pixels);
+            break;
+        case COMPONENT_UINT16:
+            swap_red_blue_scalar(reinterpret_cast<uint16*>(d), p._channels, pixels);
+            break;
+        case COMPONENT_FLOAT:
+            swap_red_blue_scalar(reinterpret_cast<float*>(d), p._channels, pixels);
+            break;
+    }
+}
+
+template<typename src_type>
+void
+convert_pixels_from(const src_type* s, const pixel_layout& sl, uint8* d, const pixel_layout& dl, scm::size_t pixels)
+{
+    switch (dl._type) {
+        case COMPONENT_UINT8:   convert_pixels_scalar(s, sl, d, dl, pixels);                              break;
+        case COMPONENT_UINT16:  convert_pixels_scalar(s, sl, reinterpret_cast<uint16*>(d), dl, pixels);  break;
+        case COMPONENT_FLOAT:   convert_pixels_scalar(s, sl, reinterpret_cast<float*>(d), dl, pixels);   break;
+    }
+}
+
+void
+convert_row(const uint8* s, const pixel_layout& sl, uint8* d, const pixel_layout& dl, scm::size_t pixels, scm::cpu_simd_level l)
+{
+    using namespace scm;
+    using scm::gl::util::detail::convert_components;
+
+    const bool same_order = sl._bgr == dl._bgr || sl._channels < 3 || dl._channels < 3;
+
+    if (sl._channels == dl._channels && sl._type == dl._type) {
+        memcpy(d, s, pixels * pixel_size(dl));
+        if (!same_order) {
+            swap_red_blue_row(d, dl, pixels, l);
+        }
+    }
+    else if (   sl._type == COMPONENT_UINT8 && dl._type == COMPONENT_UINT8
+             && ((sl._channels == 3 && dl._channels == 4) || (sl._channels == 4 && dl._channels == 3))) {
+        const bool          swap = !same_order;
+#if SCM_SIMD_X86
+        if (effective_level(l) >= CPU_SIMD_SSE4_1) {
+            if (sl._channels == 3) { expand_rgb_rgba_sse41(s, d, pixels, swap); }
+            else                   { pack_rgba_rgb_sse41(s, d, pixels, swap); }
+            return;
+        }
+#endif
+        if (sl._channels == 3) { expand_rgb_rgba_scalar(s, d, pixels, swap); }
+        else                   { pack_rgba_rgb_scalar(s, d, pixels, swap); }
+    }
+    else if (sl._channels == dl._channels && same_order) {
+        const scm::size_t count = pixels * sl._channels;
+
+        switch (sl._type) {
+            case COMPONENT_UINT8:
+                if (dl._type == COMPONENT_UINT16)   convert_components(s, reinterpret_cast<uint16*>(d), count, l);
+                else                                convert_components(s, reinterpret_cast<float*>(d),  count, l);
+                break;
+            case COMPONENT_UINT16:
+                if (dl._type == COMPONENT_UINT8)    convert_components(reinterpret_cast<const uint16*>(s), d, count, l);
+                else                                convert_components(reinterpret_cast<const uint16*>(s), reinterpret_cast<float*>(d), count, l);
+                break;
+            case COMPONENT_FLOAT:
+                if (dl._type == COMPONENT_UINT8)    convert_components(reinterpret_cast<const float*>(s), d, count, l);
+                else                                convert_components(reinterpret_cast<const float*>(s), reinterpret_cast<uint16*>(d), count, l);
+                break;
+        }
+    }
+    else {
+        switch (sl._type) {
+            case COMPONENT_UINT8:   convert_pixels_from(s, sl, d, dl, pixels);                                  break;
+            case COMPONENT_UINT16:  convert_pixels_from(reinterpret_cast<const uint16*>(s), sl, d, dl, pixels); break;
+            case COMPONENT_FLOAT:   convert_pixels_from(reinterpret_cast<const float*>(s), sl, d, dl, pixels);  break;
+        }
+    }
+}
+
+void
+scale_row(uint8* d, const pixel_layout& p, scm::size_t pixels, const float* pattern, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    const scm::size_t count  = pixels * p._channels;
+    const unsigned    period = 4 * p._channels;
+
+    switch (p._type) {
+        case COMPONENT_UINT8:
+#if SCM_SIMD_X86
+            if (effective_level(l) >= CPU_SIMD_SSE4_1) {
+                scale_components_sse41(d, count, pattern, period);
+                return;
+            }
+#endif
+            scale_components_scalar(d, count, pattern, period);
+            break;
+        case COMPONENT_UINT16:
+            scale_components_scalar(reinterpret_cast<uint16*>(d), count, pattern, period);
+            break;
+        case COMPONENT_FLOAT:
+#if SCM_SIMD_X86
+            if (effective_level(l) >= CPU_SIMD_SSE4_1) {
+                scale_components_sse41(reinterpret_cast<float*>(d), count, pattern, period);
+                return;
+            }
+#endif
+            scale_components_scalar(reinterpret_cast<float*>(d), count, pattern, period);
+            break;
+    }
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace util {
+namespace detail {
+
+#if SCM_SIMD_X86
+#   define SCM_CONVERSION_DISPATCH(fn, ...)                            \
+    switch (effective_level(l)) {                                       \
+        case CPU_SIMD_AVX2:     fn##_avx2(__VA_ARGS__);     return;     \
+        case CPU_SIMD_SSE4_1:   fn##_sse41(__VA_ARGS__);    return;     \
+        default: break;                                                 \
+    }
+#else
+#   define SCM_CONVERSION_DISPATCH(fn, ...)
+#endif
+
+void
+swap_rows(uint8* a, uint8* b, scm::size_t bytes, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(swap_rows, a, b, bytes)
+    swap_rows_scalar(a, b, bytes);
+}
+
+void
+convert_components(const uint8* s, uint16* d, scm::size_t count, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(convert_components, s, d, count)
+    convert_components_scalar(s, d, count);
+}
+
+void
+convert_components(const uint8* s, float* d, scm::size_t count, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(convert_components, s, d, count)
+    convert_components_scalar(s, d, count);
+}
+
+void
+convert_components(const uint16* s, uint8* d, scm::size_t count, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(convert_components, s, d, count)
+    convert_components_scalar(s, d, count);
+}
+
+void
+convert_components(const uint16* s, float* d, scm::size_t count, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(convert_components, s, d, count)
+    convert_components_scalar(s, d, count);
+}
+
+void
+convert_components(const float* s, uint8* d, scm::size_t count, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(convert_components, s, d, count)
+    convert_components_scalar(s, d, count);
+}
+
+void
+convert_components(const float* s, uint16* d, scm::size_t count, cpu_simd_level l)
+{
+    SCM_CONVERSION_DISPATCH(convert_components, s, d, count)
+    convert_components_scalar(s, d, count);
+}
+
+#undef SCM_CONVERSION_DISPATCH
+
+} // namespace detail
+
+bool
+flip_rows(uint8*            data,
+          scm::size_t       row_bytes,
+          scm::size_t       rows,
+          cpu_simd_level    l)
+{
+    if (!data) {
+        return false;
+    }
+
+    for_row_ranges(rows / 2, 2 * row_bytes, [&](scm::size_t begin, scm::size_t end) {
+        for (scm::size_t r = begin; r < end; ++r) {
+            detail::swap_rows(data + r * row_bytes, data + (rows - (r + 1)) * row_bytes, row_bytes, l);
+        }
+    });
+
+    return true;
+}
+
+bool
+swap_red_blue_channels(const math::vec2ui&  dim,
+                       data_format          fmt,
+                       uint8*               data,
+                       cpu_simd_level       l)
+{
+    pixel_layout p;
+    if (!data || !layout_of(fmt, p) || p._channels < 3) {
+        return false;
+    }
+
+    const scm::size_t row_bytes = dim.x * pixel_size(p);
+
+    for_row_ranges(dim.y, row_bytes, [&](scm::size_t begin, scm::size_t end) {
+        for (scm::size_t r = begin; r < end; ++r) {
+            swap_red_blue_row(data + r * row_bytes, p, dim.x, l);
+        }
+    });
+
+    return true;
+}
+
+bool
+convert_image_format(const math::vec2ui&    dim,
+                           data_format      src_fmt,
+                     const uint8*           src_data,
+                           scm::size_t      src_pitch,
+                           data_format      dst_fmt,
+                           uint8*           dst_data,
+                           cpu_simd_level   l)
+{
+    pixel_layout sl;
+    pixel_layout dl;
+    if (!src_data || !dst_data || !layout_of(src_fmt, sl) || !layout_of(dst_fmt, dl)) {
+        return false;
+    }
+
+    const scm::size_t src_row_bytes = dim.x * pixel_size(sl);
+    const scm::size_t dst_row_bytes = dim.x * pixel_size(dl);
+    const scm::size_t src_stride    = src_pitch != 0 ? src_pitch : src_row_bytes;
+
+    if (src_stride < src_row_bytes) {
+        return false;
+    }
+
+    for_row_ranges(dim.y, (std::max)(src_row_bytes, dst_row_bytes), [&](scm::size_t begin, scm::size_t end) {
+        for (scm::size_t r = begin; r < end; ++r) {
+            convert_row(src_data + r * src_stride, sl, dst_data + r * dst_row_bytes, dl, dim.x, l);
+        }
+    });
+
+    return true;
+}
+
+bool
+scale_image_channels(const math::vec2ui&    dim,
+                     data_format            fmt,
+                     uint8*                 data,
+                     const math::vec4f&     scale,
+                     cpu_simd_level         l)
+{
+    pixel_layout p;
+    if (!data || !layout_of(fmt, p)) {
+        return false;
+    }
+
+    float pattern[16];
+    build_scale_pattern(p, scale, pattern);
+
+    const scm::size_t row_bytes = dim.x * pixel_size(p);
+
+    for_row_ranges(dim.y, row_bytes, [&](scm::size_t begin, scm::size_t end) {
+        for (scm::size_t r = begin; r < end; ++r) {
+            scale_row(data + r * row_bytes, p, dim.x, pattern, l);
+        }
+    });
+
+    return true;
+}
+
+} // namespace util
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,83 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_IMAGE_CONVERSION_H_INCLUDED
+#define SCM_GL_UTIL_IMAGE_CONVERSION_H_INCLUDED
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/platform/cpu_features.h>
+
+#include <scm/gl_core/data_formats.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+namespace util {
+namespace detail {
+
+// row kernels of the image conversions, vectorized for the simd level with
+// identical results for every level, none of them allocates memory
+// - swap_rows exchanges the contents of two non-overlapping rows
+// - convert_components converts count normalized components between the
+//   uint8, uint16 and float representations (same format families as
+//   image_conversion_supported), the float results are v / 255 or v / 65535,
+//   the integer results are clamped and rounded
+__scm_export(gl_util) void  swap_rows(uint8* a, uint8* b, scm::size_t bytes, cpu_simd_level l);
+
+__scm_export(gl_util) void  convert_components(const uint8*  s, uint16* d, scm::size_t count, cpu_simd_level l);
+__scm_export(gl_util) void  convert_components(const uint8*  s, float*  d, scm::size_t count, cpu_simd_level l);
+__scm_export(gl_util) void  convert_components(const uint16* s, uint8*  d, scm::size_t count, cpu_simd_level l);
+__scm_export(gl_util) void  convert_components(const uint16* s, float*  d, scm::size_t count, cpu_simd_level l);
+__scm_export(gl_util) void  convert_components(const float*  s, uint8*  d, scm::size_t count, cpu_simd_level l);
+__scm_export(gl_util) void  convert_components(const float*  s, uint16* d, scm::size_t count, cpu_simd_level l);
+
+} // namespace detail
+
+// reverse the row order of rows * row_bytes bytes in place
+bool __scm_export(gl_util)  flip_rows(uint8*            data,
+                                      scm::size_t       row_bytes,
+                                      scm::size_t       rows,
+                                      cpu_simd_level    l);
+
+// swap the red and blue channels in place (rows tightly packed), for the
+// 3 and 4 channel 8bit, 16bit and float formats, the format is not changed
+bool __scm_export(gl_util)  swap_red_blue_channels(const math::vec2ui&  dim,
+                                                   data_format          fmt,
+                                                   uint8*               data,
+                                                   cpu_simd_level       l);
+
+// convert a 2d image to dst_fmt (destination rows tightly packed, the source
+// rows src_pitch bytes apart)
+// - formats: FORMAT_R_8 to FORMAT_RGBA_8, FORMAT_BGR_8, FORMAT_BGRA_8,
+//   FORMAT_R_16 to FORMAT_RGBA_16 and FORMAT_R_32F to FORMAT_RGBA_32F
+// - channels are matched by name, missing green and blue channels become 0,
+//   a missing alpha channel becomes 1
+// - vectorized: identical layouts, 8bit rgb(a)/bgr(a) swizzles, 8bit 3 <-> 4
+//   channel expansion and packing, type conversions of identical layouts
+bool __scm_export(gl_util)  convert_image_format(const math::vec2ui&    dim,
+                                                       data_format      src_fmt,
+                                                 const uint8*           src_data,
+                                                       scm::size_t      src_pitch,
+                                                       data_format      dst_fmt,
+                                                       uint8*           dst_data,
+                                                       cpu_simd_level   l);
+
+// multiply the channels (in rgba order) in place, 8bit and 16bit results are
+// clamped to the value range and truncated, formats as convert_image_format
+bool __scm_export(gl_util)  scale_image_channels(const math::vec2ui&    dim,
+                                                 data_format            fmt,
+                                                 uint8*                 data,
+                                                 const math::vec4f&     scale,
+                                                 cpu_simd_level         l);
+
+} // namespace util
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_IMAGE_CONVERSION_H_INCLUDED
@@ -11,9 +11,11 @@ namespace scm {
 namespace gl {
 
 class texture_image_data;
+class texture_image_cache;
 
 typedef shared_ptr<texture_image_data>          texture_image_data_ptr;
 typedef shared_ptr<texture_image_data const>    texture_image_data_cptr;
+typedef shared_ptr<texture_image_cache>         texture_image_cache_ptr;
 
 } // namespace gl
 } // namespace scm
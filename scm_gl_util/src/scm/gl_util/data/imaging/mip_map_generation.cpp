@@ -0,0 +1,882 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "mip_map_generation.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if SCM_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+// all kernels reproduce the operation order of the original per texel filter
+// (including the accumulation starting at zero, which turns -0 into +0) so
+// the results are bit identical for every simd level
+
+namespace {
+
+const float float_lowest  = -(std::numeric_limits<float>::max)();
+const float float_highest =  (std::numeric_limits<float>::max)();
+
+// scalar kernels /////////////////////////////////////////////////////////////////////////////////
+
+template<typename vtype>
+void
+load_row_scalar(const vtype* s, float* d, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        d[i] = static_cast<float>(s[i]);
+    }
+}
+
+template<typename vtype>
+void
+store_row_scalar(const float* s, vtype* d, scm::size_t c, float vmin, float vmax)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        const float v = s[i];
+        d[i] = static_cast<vtype>((v > vmax) ? vmax : (v < vmin) ? vmin : v);
+    }
+}
+
+template<const unsigned channels>
+void
+filter_row_x_box_scalar(const float* s, float* d, unsigned first, unsigned width)
+{
+    for (unsigned x = first; x < width; ++x) {
+        for (unsigned k = 0; k < channels; ++k) {
+            float t = 0.0f;
+            t += s[(2 * x    ) * channels + k];
+            t += s[(2 * x + 1) * channels + k];
+            t *= 0.5f;
+            d[x * channels + k] = t;
+        }
+    }
+}
+
+template<const unsigned channels>
+void
+filter_row_x_poly_scalar(const float* s, float* d, unsigned first, unsigned width)
+{
+    const float scale = 1.0f / (2.0f * width + 1.0f);
+    const float w1    = static_cast<float>(width);
+
+    for (unsigned x = first; x < width; ++x) {
+        const float w0 = static_cast<float>(width - x);
+        const float w2 = static_cast<float>(1 + x);
+
+        for (unsigned k = 0; k < channels; ++k) {
+            float t = 0.0f;
+            t += w0 * s[(2 * x    ) * channels + k];
+            t += w1 * s[(2 * x + 1) * channels + k];
+            t += w2 * s[(2 * x + 2) * channels + k];
+            t *= scale;
+            d[x * channels + k] = t;
+        }
+    }
+}
+
+// the channel count as template argument lets the compiler unroll the channel loop
+void
+filter_row_x_box_scalar(const float* s, float* d, unsigned first, unsigned width, unsigned channels)
+{
+    switch (channels) {
+        case 1:  filter_row_x_box_scalar<1>(s, d, first, width); break;
+        case 2:  filter_row_x_box_scalar<2>(s, d, first, width); break;
+        case 3:  filter_row_x_box_scalar<3>(s, d, first, width); break;
+        case 4:  filter_row_x_box_scalar<4>(s, d, first, width); break;
+        default: break;
+    }
+}
+
+void
+filter_row_x_poly_scalar(const float* s, float* d, unsigned first, unsigned width, unsigned channels)
+{
+    switch (channels) {
+        case 1:  filter_row_x_poly_scalar<1>(s, d, first, width); break;
+        case 2:  filter_row_x_poly_scalar<2>(s, d, first, width); break;
+        case 3:  filter_row_x_poly_scalar<3>(s, d, first, width); break;
+        case 4:  filter_row_x_poly_scalar<4>(s, d, first, width); break;
+        default: break;
+    }
+}
+
+void
+filter_rows_box_scalar(const float* s0, const float* s1, float* d, scm::size_t first, scm::size_t c)
+{
+    for (scm::size_t i = first; i < c; ++i) {
+        float t = s0[i];
+        t += s1[i];
+        t *= 0.5f;
+        d[i] = t;
+    }
+}
+
+void
+filter_rows_poly_scalar(const float* s0, const float* s1, const float* s2, float* d, scm::size_t first, scm::size_t c,
+                        float w0, float w1, float w2, float scale)
+{
+    for (scm::size_t i = first; i < c; ++i) {
+        float t = w0 * s0[i];
+        t += w1 * s1[i];
+        t += w2 * s2[i];
+        t *= scale;
+        d[i] = t;
+    }
+}
+
+template<const unsigned channels>
+void
+resample_row_x_scalar(const float* s, float* d, unsigned first_x, unsigned width,
+                      const scm::int32* first, const float* weights, unsigned taps)
+{
+    for (unsigned x = first_x; x < width; ++x) {
+        const float* sx = s + first[x] * channels;
+        for (unsigned k = 0; k < channels; ++k) {
+            float t = 0.0f;
+            for (unsigned j = 0; j < taps; ++j) {
+                t += weights[j * width + x] * sx[j * channels + k];
+            }
+            d[x * channels + k] = t;
+        }
+    }
+}
+
+void
+resample_row_x_scalar(const float* s, float* d, unsigned first_x, unsigned width, unsigned channels,
+                      const scm::int32* first, const float* weights, unsigned taps)
+{
+    switch (channels) {
+        case 1:  resample_row_x_scalar<1>(s, d, first_x, width, first, weights, taps); break;
+        case 2:  resample_row_x_scalar<2>(s, d, first_x, width, first, weights, taps); break;
+        case 3:  resample_row_x_scalar<3>(s, d, first_x, width, first, weights, taps); break;
+        case 4:  resample_row_x_scalar<4>(s, d, first_x, width, first, weights, taps); break;
+        default: break;
+    }
+}
+
+void
+accumulate_row_scalar(const float* s, float* d, scm::size_t first, scm::size_t c, float w)
+{
+    for (scm::size_t i = first; i < c; ++i) {
+        d[i] += w * s[i];
+    }
+}
+
+#if SCM_SIMD_X86
+
+// sse4.1 kernels /////////////////////////////////////////////////////////////////////////////////
+
+SCM_SIMD_TARGET("sse4.1")
+void
+load_row_sse41(const scm::uint8* s, float* d, scm::size_t c)
+{
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i));
+        _mm_storeu_ps(d + i,     _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)));
+        _mm_storeu_ps(d + i + 4, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4))));
+    }
+    load_row_scalar(s + i, d + i, c - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+load_row_sse41(const scm::uint16* s, float* d, scm::size_t c)
+{
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        _mm_storeu_ps(d + i,     _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v)));
+        _mm_storeu_ps(d + i + 4, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8))));
+    }
+    load_row_scalar(s + i, d + i, c - i);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+store_row_sse41(const float* s, scm::uint8* d, scm::size_t c)
+{
+    const __m128 vmin = _mm_setzero_ps();
+    const __m128 vmax = _mm_set1_ps(255.0f);
+
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        const __m128i a = _mm_cvttps_epi32(_mm_min_ps(vmax, _mm_max_ps(vmin, _mm_loadu_ps(s + i))));
+        const __m128i b = _mm_cvttps_epi32(_mm_min_ps(vmax, _mm_max_ps(vmin, _mm_loadu_ps(s + i + 4))));
+        const __m128i p = _mm_packus_epi32(a, b);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(d + i), _mm_packus_epi16(p, p));
+    }
+    store_row_scalar(s + i, d + i, c - i, 0.0f, 255.0f);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+store_row_sse41(const float* s, scm::uint16* d, scm::size_t c)
+{
+    const __m128 vmin = _mm_setzero_ps();
+    const __m128 vmax = _mm_set1_ps(65535.0f);
+
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        const __m128i a = _mm_cvttps_epi32(_mm_min_ps(vmax, _mm_max_ps(vmin, _mm_loadu_ps(s + i))));
+        const __m128i b = _mm_cvttps_epi32(_mm_min_ps(vmax, _mm_max_ps(vmin, _mm_loadu_ps(s + i + 4))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_packus_epi32(a, b));
+    }
+    store_row_scalar(s + i, d + i, c - i, 0.0f, 65535.0f);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+store_row_sse41(const float* s, float* d, scm::size_t c)
+{
+    // min/max return the second operand for NaN, so NaN passes like in the scalar clamp
+    const __m128 vmin = _mm_set1_ps(float_lowest);
+    const __m128 vmax = _mm_set1_ps(float_highest);
+
+    scm::size_t i = 0;
+    for (; i + 4 <= c; i += 4) {
+        _mm_storeu_ps(d + i, _mm_min_ps(vmax, _mm_max_ps(vmin, _mm_loadu_ps(s + i))));
+    }
+    store_row_scalar(s + i, d + i, c - i, float_lowest, float_highest);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+filter_row_x_box_sse41(const float* s, float* d, unsigned width, unsigned channels)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    unsigned x = 0;
+    if (channels == 1) {
+        for (; x + 4 <= width; x += 4) {
+            const __m128 a = _mm_loadu_ps(s + 2 * x);
+            const __m128 b = _mm_loadu_ps(s + 2 * x + 4);
+            const __m128 e = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 o = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(d + x, _mm_mul_ps(_mm_add_ps(_mm_add_ps(zero, e), o), half));
+        }
+    }
+    else if (channels == 4) {
+        for (; x < width; ++x) {
+            const __m128 a = _mm_loadu_ps(s + 8 * x);
+            const __m128 b = _mm_loadu_ps(s + 8 * x + 4);
+            _mm_storeu_ps(d + 4 * x, _mm_mul_ps(_mm_add_ps(_mm_add_ps(zero, a), b), half));
+        }
+    }
+    filter_row_x_box_scalar(s, d, x, width, channels);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+filter_row_x_poly_sse41(const float* s, float* d, unsigned width, unsigned channels)
+{
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 scale = _mm_set1_ps(1.0f / (2.0f * width + 1.0f));
+    const __m128 w1    = _mm_set1_ps(static_cast<float>(width));
+
+    unsigned x = 0;
+    if (channels == 1) {
+        const __m128 step = _mm_set1_ps(4.0f);
+        __m128       w0   = _mm_setr_ps(static_cast<float>(width), static_cast<float>(width - 1),
+                                        static_cast<float>(width - 2), static_cast<float>(width - 3));
+        __m128       w2   = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+
+        // the third tap reads one value past the pairs of the last output
+        for (; x + 5 <= width; x += 4) {
+            const __m128 a  = _mm_loadu_ps(s + 2 * x);
+            const __m128 b  = _mm_loadu_ps(s + 2 * x + 4);
+            const __m128 a2 = _mm_loadu_ps(s + 2 * x + 2);
+            const __m128 b2 = _mm_loadu_ps(s + 2 * x + 6);
+            const __m128 v0 = _mm_shuffle_ps(a,  b,  _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 v1 = _mm_shuffle_ps(a,  b,  _MM_SHUFFLE(3, 1, 3, 1));
+            const __m128 v2 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0));
+
+            __m128 t = _mm_add_ps(zero, _mm_mul_ps(w0, v0));
+            t = _mm_add_ps(t, _mm_mul_ps(w1, v1));
+            t = _mm_add_ps(t, _mm_mul_ps(w2, v2));
+            _mm_storeu_ps(d + x, _mm_mul_ps(t, scale));
+
+            w0 = _mm_sub_ps(w0, step);
+            w2 = _mm_add_ps(w2, step);
+        }
+    }
+    else if (channels == 4) {
+        for (; x < width; ++x) {
+            const __m128 w0 = _mm_set1_ps(static_cast<float>(width - x));
+            const __m128 w2 = _mm_set1_ps(static_cast<float>(1 + x));
+
+            __m128 t = _mm_add_ps(zero, _mm_mul_ps(w0, _mm_loadu_ps(s + 8 * x)));
+            t = _mm_add_ps(t, _mm_mul_ps(w1, _mm_loadu_ps(s + 8 * x + 4)));
+            t = _mm_add_ps(t, _mm_mul_ps(w2, _mm_loadu_ps(s + 8 * x + 8)));
+            _mm_storeu_ps(d + 4 * x, _mm_mul_ps(t, scale));
+        }
+    }
+    filter_row_x_poly_scalar(s, d, x, width, channels);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+filter_rows_box_sse41(const float* s0, const float* s1, float* d, scm::size_t c)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    scm::size_t i = 0;
+    for (; i + 4 <= c; i += 4) {
+        _mm_storeu_ps(d + i, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s0 + i), _mm_loadu_ps(s1 + i)), half));
+    }
+    filter_rows_box_scalar(s0, s1, d, i, c);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+filter_rows_poly_sse41(const float* s0, const float* s1, const float* s2, float* d, scm::size_t c,
+                       float w0, float w1, float w2, float scale)
+{
+    const __m128 vw0    = _mm_set1_ps(w0);
+    const __m128 vw1    = _mm_set1_ps(w1);
+    const __m128 vw2    = _mm_set1_ps(w2);
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    scm::size_t i = 0;
+    for (; i + 4 <= c; i += 4) {
+        __m128 t = _mm_mul_ps(vw0, _mm_loadu_ps(s0 + i));
+        t = _mm_add_ps(t, _mm_mul_ps(vw1, _mm_loadu_ps(s1 + i)));
+        t = _mm_add_ps(t, _mm_mul_ps(vw2, _mm_loadu_ps(s2 + i)));
+        _mm_storeu_ps(d + i, _mm_mul_ps(t, vscale));
+    }
+    filter_rows_poly_scalar(s0, s1, s2, d, i, c, w0, w1, w2, scale);
+}
+
+// the weights of the resampling filters are stored tap major (weights[j * width + x]),
+// single channel rows are resampled for 4 (8) destination texels at once
+SCM_SIMD_TARGET("sse4.1")
+void
+resample_row_x_sse41(const float* s, float* d, unsigned width, unsigned channels,
+                     const scm::int32* first, const float* weights, unsigned taps)
+{
+    unsigned x = 0;
+    if (channels == 1) {
+        for (; x + 4 <= width; x += 4) {
+            const float* s0 = s + first[x];
+            const float* s1 = s + first[x + 1];
+            const float* s2 = s + first[x + 2];
+            const float* s3 = s + first[x + 3];
+            __m128 t = _mm_setzero_ps();
+            for (unsigned j = 0; j < taps; ++j) {
+                const __m128 v = _mm_setr_ps(s0[j], s1[j], s2[j], s3[j]);
+                t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(weights + j * width + x), v));
+            }
+            _mm_storeu_ps(d + x, t);
+        }
+    }
+    else if (channels == 4) {
+        for (; x < width; ++x) {
+            const float* sx = s + first[x] * 4;
+            __m128 t = _mm_setzero_ps();
+            for (unsigned j = 0; j < taps; ++j) {
+                t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(weights[j * width + x]), _mm_loadu_ps(sx + j * 4)));
+            }
+            _mm_storeu_ps(d + x * 4, t);
+        }
+    }
+    resample_row_x_scalar(s, d, x, width, channels, first, weights, taps);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+accumulate_row_sse41(const float* s, float* d, scm::size_t c, float w)
+{
+    const __m128 vw = _mm_set1_ps(w);
+
+    scm::size_t i = 0;
+    for (; i + 4 <= c; i += 4) {
+        _mm_storeu_ps(d + i, _mm_add_ps(_mm_loadu_ps(d + i), _mm_mul_ps(vw, _mm_loadu_ps(s + i))));
+    }
+    accumulate_row_scalar(s, d, i, c, w);
+}
+
+// avx2 kernels ///////////////////////////////////////////////////////////////////////////////////
+
+SCM_SIMD_TARGET("avx2")
+void
+load_row_avx2(const scm::uint8* s, float* d, scm::size_t c)
+{
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i));
+        _mm256_storeu_ps(d + i, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)));
+    }
+    load_row_scalar(s + i, d + i, c - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+load_row_avx2(const scm::uint16* s, float* d, scm::size_t c)
+{
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        _mm256_storeu_ps(d + i, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v)));
+    }
+    load_row_scalar(s + i, d + i, c - i);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+store_row_avx2(const float* s, scm::uint8* d, scm::size_t c)
+{
+    const __m256 vmin = _mm256_setzero_ps();
+    const __m256 vmax = _mm256_set1_ps(255.0f);
+
+    scm::size_t i = 0;
+    for (; i + 16 <= c; i += 16) {
+        const __m256i a = _mm256_cvttps_epi32(_mm256_min_ps(vmax, _mm256_max_ps(vmin, _mm256_loadu_ps(s + i))));
+        const __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(vmax, _mm256_max_ps(vmin, _mm256_loadu_ps(s + i + 8))));
+        const __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_packus_epi16(_mm256_castsi256_si128(p),
+                                                                             _mm256_extracti128_si256(p, 1)));
+    }
+    store_row_scalar(s + i, d + i, c - i, 0.0f, 255.0f);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+store_row_avx2(const float* s, scm::uint16* d, scm::size_t c)
+{
+    const __m256 vmin = _mm256_setzero_ps();
+    const __m256 vmax = _mm256_set1_ps(65535.0f);
+
+    scm::size_t i = 0;
+    for (; i + 16 <= c; i += 16) {
+        const __m256i a = _mm256_cvttps_epi32(_mm256_min_ps(vmax, _mm256_max_ps(vmin, _mm256_loadu_ps(s + i))));
+        const __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(vmax, _mm256_max_ps(vmin, _mm256_loadu_ps(s + i + 8))));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8));
+    }
+    store_row_scalar(s + i, d + i, c - i, 0.0f, 65535.0f);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+store_row_avx2(const float* s, float* d, scm::size_t c)
+{
+    const __m256 vmin = _mm256_set1_ps(float_lowest);
+    const __m256 vmax = _mm256_set1_ps(float_highest);
+
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        _mm256_storeu_ps(d + i, _mm256_min_ps(vmax, _mm256_max_ps(vmin, _mm256_loadu_ps(s + i))));
+    }
+    store_row_scalar(s + i, d + i, c - i, float_lowest, float_highest);
+}
+
+// even and odd elements of the 16 values at s (in order)
+SCM_SIMD_TARGET("avx2")
+inline void
+deinterleave_avx2(const float* s, __m256& e, __m256& o)
+{
+    const __m256 a = _mm256_loadu_ps(s);
+    const __m256 b = _mm256_loadu_ps(s + 8);
+
+    // lane wise shuffles leave the 64 bit pairs in the order 0 2 1 3
+    e = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), 0xd8));
+    o = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), 0xd8));
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+filter_row_x_box_avx2(const float* s, float* d, unsigned width, unsigned channels)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    unsigned x = 0;
+    if (channels == 1) {
+        for (; x + 8 <= width; x += 8) {
+            __m256 e, o;
+            deinterleave_avx2(s + 2 * x, e, o);
+            _mm256_storeu_ps(d + x, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(zero, e), o), half));
+        }
+    }
+    else if (channels == 4) {
+        for (; x + 2 <= width; x += 2) {
+            const __m256 a  = _mm256_loadu_ps(s + 8 * x);
+            const __m256 b  = _mm256_loadu_ps(s + 8 * x + 8);
+            const __m256 v0 = _mm256_permute2f128_ps(a, b, 0x20);
+            const __m256 v1 = _mm256_permute2f128_ps(a, b, 0x31);
+            _mm256_storeu_ps(d + 4 * x, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(zero, v0), v1), half));
+        }
+    }
+    filter_row_x_box_scalar(s, d, x, width, channels);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+filter_row_x_poly_avx2(const float* s, float* d, unsigned width, unsigned channels)
+{
+    const __m256 zero  = _mm256_setzero_ps();
+    const __m256 scale = _mm256_set1_ps(1.0f / (2.0f * width + 1.0f));
+    const __m256 w1    = _mm256_set1_ps(static_cast<float>(width));
+    const float  fw    = static_cast<float>(width);
+
+    unsigned x = 0;
+    if (channels == 1) {
+        const __m256 step = _mm256_set1_ps(8.0f);
+        __m256       w0   = _mm256_setr_ps(fw, fw - 1.0f, fw - 2.0f, fw - 3.0f, fw - 4.0f, fw - 5.0f, fw - 6.0f, fw - 7.0f);
+        __m256       w2   = _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+
+        // the third tap reads one value past the pairs of the last output
+        for (; x + 9 <= width; x += 8) {
+            __m256 v0, v1, v2, v3;
+            deinterleave_avx2(s + 2 * x,     v0, v1);
+            deinterleave_avx2(s + 2 * x + 2, v2, v3);
+
+            __m256 t = _mm256_add_ps(zero, _mm256_mul_ps(w0, v0));
+            t = _mm256_add_ps(t, _mm256_mul_ps(w1, v1));
+            t = _mm256_add_ps(t, _mm256_mul_ps(w2, v2));
+            _mm256_storeu_ps(d + x, _mm256_mul_ps(t, scale));
+
+            w0 = _mm256_sub_ps(w0, step);
+            w2 = _mm256_add_ps(w2, step);
+        }
+    }
+    else if (channels == 4) {
+        for (; x + 3 <= width; x += 2) {
+            const __m256 a  = _mm256_loadu_ps(s + 8 * x);
+            const __m256 b  = _mm256_loadu_ps(s + 8 * x + 8);
+            const __m256 c  = _mm256_loadu_ps(s + 8 * x + 16);
+            const __m256 v0 = _mm256_permute2f128_ps(a, b, 0x20);
+            const __m256 v1 = _mm256_permute2f128_ps(a, b, 0x31);
+            const __m256 v2 = _mm256_permute2f128_ps(b, c, 0x20);
+            const __m256 w0 = _mm256_insertf128_ps(_mm256_set1_ps(static_cast<float>(width - x)),
+                                                   _mm_set1_ps(static_cast<float>(width - x - 1)), 1);
+            const __m256 w2 = _mm256_insertf128_ps(_mm256_set1_ps(static_cast<float>(1 + x)),
+                                                   _mm_set1_ps(static_cast<float>(2 + x)), 1);
+
+            __m256 t = _mm256_add_ps(zero, _mm256_mul_ps(w0, v0));
+            t = _mm256_add_ps(t, _mm256_mul_ps(w1, v1));
+            t = _mm256_add_ps(t, _mm256_mul_ps(w2, v2));
+            _mm256_storeu_ps(d + 4 * x, _mm256_mul_ps(t, scale));
+        }
+    }
+    filter_row_x_poly_scalar(s, d, x, width, channels);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+filter_rows_box_avx2(const float* s0, const float* s1, float* d, scm::size_t c)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        _mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s0 + i), _mm256_loadu_ps(s1 + i)), half));
+    }
+    filter_rows_box_scalar(s0, s1, d, i, c);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+filter_rows_poly_avx2(const float* s0, const float* s1, const float* s2, float* d, scm::size_t c,
+                      float w0, float w1, float w2, float scale)
+{
+    const __m256 vw0    = _mm256_set1_ps(w0);
+    const __m256 vw1    = _mm256_set1_ps(w1);
+    const __m256 vw2    = _mm256_set1_ps(w2);
+    const __m256 vscale = _mm256_set1_ps(scale);
+
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        __m256 t = _mm256_mul_ps(vw0, _mm256_loadu_ps(s0 + i));
+        t = _mm256_add_ps(t, _mm256_mul_ps(vw1, _mm256_loadu_ps(s1 + i)));
+        t = _mm256_add_ps(t, _mm256_mul_ps(vw2, _mm256_loadu_ps(s2 + i)));
+        _mm256_storeu_ps(d + i, _mm256_mul_ps(t, vscale));
+    }
+    filter_rows_poly_scalar(s0, s1, s2, d, i, c, w0, w1, w2, scale);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+resample_row_x_avx2(const float* s, float* d, unsigned width, unsigned channels,
+                    const scm::int32* first, const float* weights, unsigned taps)
+{
+    unsigned x = 0;
+    if (channels == 1) {
+        for (; x + 8 <= width; x += 8) {
+            const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + x));
+            __m256 t = _mm256_setzero_ps();
+            for (unsigned j = 0; j < taps; ++j) {
+                const __m256 v = _mm256_i32gather_ps(s, _mm256_add_epi32(f, _mm256_set1_epi32(j)), 4);
+                t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_loadu_ps(weights + j * width + x), v));
+            }
+            _mm256_storeu_ps(d + x, t);
+        }
+    }
+    else if (channels == 4) {
+        for (; x + 2 <= width; x += 2) {
+            const float* s0 = s + first[x]     * 4;
+            const float* s1 = s + first[x + 1] * 4;
+            __m256 t = _mm256_setzero_ps();
+            for (unsigned j = 0; j < taps; ++j) {
+                const __m256 vw = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights[j * width + x])),
+                                                       _mm_set1_ps(weights[j * width + x + 1]), 1);
+                const __m256 v  = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(s0 + j * 4)),
+                                                       _mm_loadu_ps(s1 + j * 4), 1);
+                t = _mm256_add_ps(t, _mm256_mul_ps(vw, v));
+            }
+            _mm256_storeu_ps(d + x * 4, t);
+        }
+    }
+    resample_row_x_scalar(s, d, x, width, channels, first, weights, taps);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+accumulate_row_avx2(const float* s, float* d, scm::size_t c, float w)
+{
+    const __m256 vw = _mm256_set1_ps(w);
+
+    scm::size_t i = 0;
+    for (; i + 8 <= c; i += 8) {
+        _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_loadu_ps(d + i), _mm256_mul_ps(vw, _mm256_loadu_ps(s + i))));
+    }
+    accumulate_row_scalar(s, d, i, c, w);
+}
+
+#endif // SCM_SIMD_X86
+
+template<typename vtype>
+void
+load_row_dispatch(const vtype* s, float* d, scm::size_t c, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:     load_row_avx2(s, d, c);     break;
+        case CPU_SIMD_SSE4_1:   load_row_sse41(s, d, c);    break;
+#endif // SCM_SIMD_X86
+        default:                load_row_scalar(s, d, c);   break;
+    }
+}
+
+template<typename vtype>
+void
+store_row_dispatch(const float* s, vtype* d, scm::size_t c, float vmin, float vmax, scm::cpu_simd_level l)
+{
+    using namespace scm;
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:     store_row_avx2(s, d, c);                    break;
+        case CPU_SIMD_SSE4_1:   store_row_sse41(s, d, c);                   break;
+#endif // SCM_SIMD_X86
+        default:                store_row_scalar(s, d, c, vmin, vmax);      break;
+    }
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace util {
+namespace detail {
+
+void
+mip_load_row(const uint8* s, float* d, scm::size_t c, cpu_simd_level l)
+{
+    load_row_dispatch(s, d, c, l);
+}
+
+void
+mip_load_row(const uint16* s, float* d, scm::size_t c, cpu_simd_level l)
+{
+    load_row_dispatch(s, d, c, l);
+}
+
+void
+mip_load_row(const int16* s, float* d, scm::size_t c, cpu_simd_level)
+{
+    // signed 16bit images are rare (FreeImage FIT_INT16), no vector path
+    load_row_scalar(s, d, c);
+}
+
+void
+mip_store_row(const float* s, uint8* d, scm::size_t c, cpu_simd_level l)
+{
+    store_row_dispatch(s, d, c, 0.0f, 255.0f, l);
+}
+
+void
+mip_store_row(const float* s, uint16* d, scm::size_t c, cpu_simd_level l)
+{
+    store_row_dispatch(s, d, c, 0.0f, 65535.0f, l);
+}
+
+void
+mip_store_row(const float* s, int16* d, scm::size_t c, cpu_simd_level)
+{
+    store_row_scalar(s, d, c, -32768.0f, 32767.0f);
+}
+
+void
+mip_store_row(const float* s, float* d, scm::size_t c, cpu_simd_level l)
+{
+    store_row_dispatch(s, d, c, float_lowest, float_highest, l);
+}
+
+void
+mip_filter_row_x(const float*   s,
+                 float*         d,
+                 unsigned       width,
+                 unsigned       channels,
+                 unsigned       samples,
+                 cpu_simd_level l)
+{
+    if (samples == 1) {
+        memcpy(d, s, channels * sizeof(float));
+        return;
+    }
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:
+            if (samples == 2) filter_row_x_box_avx2(s, d, width, channels);
+            else              filter_row_x_poly_avx2(s, d, width, channels);
+            break;
+        case CPU_SIMD_SSE4_1:
+            if (samples == 2) filter_row_x_box_sse41(s, d, width, channels);
+            else              filter_row_x_poly_sse41(s, d, width, channels);
+            break;
+#endif // SCM_SIMD_X86
+        default:
+            if (samples == 2) filter_row_x_box_scalar(s, d, 0, width, channels);
+            else              filter_row_x_poly_scalar(s, d, 0, width, channels);
+            break;
+    }
+}
+
+void
+mip_filter_rows(const float*    s0,
+                const float*    s1,
+                const float*    s2,
+                float*          d,
+                scm::size_t     c,
+                unsigned        samples,
+                float           w0,
+                float           w1,
+                float           w2,
+                float           scale,
+                cpu_simd_level  l)
+{
+    if (samples == 1) {
+        if (d != s0) {
+            memcpy(d, s0, c * sizeof(float));
+        }
+        return;
+    }
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:
+            if (samples == 2) filter_rows_box_avx2(s0, s1, d, c);
+            else              filter_rows_poly_avx2(s0, s1, s2, d, c, w0, w1, w2, scale);
+            break;
+        case CPU_SIMD_SSE4_1:
+            if (samples == 2) filter_rows_box_sse41(s0, s1, d, c);
+            else              filter_rows_poly_sse41(s0, s1, s2, d, c, w0, w1, w2, scale);
+            break;
+#endif // SCM_SIMD_X86
+        default:
+            if (samples == 2) filter_rows_box_scalar(s0, s1, d, 0, c);
+            else              filter_rows_poly_scalar(s0, s1, s2, d, 0, c, w0, w1, w2, scale);
+            break;
+    }
+}
+
+mip_resample_weights::mip_resample_weights(unsigned src_size, unsigned dst_size)
+  : _taps(0)
+{
+    // lanczos3 windowed sinc, widened by the downsampling factor
+    const double pi      = 3.14159265358979323846;
+    const double scale   = static_cast<double>(dst_size) / static_cast<double>(src_size);
+    const double fscale  = math::min(1.0, scale);
+    const double support = 3.0 / fscale;
+
+    _taps = math::max(1u, math::min(src_size, static_cast<unsigned>(std::ceil(2.0 * support))));
+    _first.resize(dst_size);
+    _weights.resize(static_cast<scm::size_t>(_taps) * dst_size);
+
+    std::vector<double> w(_taps);
+
+    for (unsigned x = 0; x < dst_size; ++x) {
+        const double center = (x + 0.5) / scale;
+        const int    f      = math::clamp(static_cast<int>(std::ceil(center - support - 0.5)),
+                                          0, static_cast<int>(src_size - _taps));
+        double       sum    = 0.0;
+
+        for (unsigned j = 0; j < _taps; ++j) {
+            const double t = math::abs((center - (f + j + 0.5)) * fscale);
+
+            if (t < 1e-8) {
+                w[j] = 1.0;
+            }
+            else if (t < 3.0) {
+                w[j] = (3.0 * std::sin(pi * t) * std::sin(pi * t / 3.0)) / (pi * pi * t * t);
+            }
+            else {
+                w[j] = 0.0;
+            }
+            sum += w[j];
+        }
+
+        _first[x] = f;
+        for (unsigned j = 0; j < _taps; ++j) {
+            _weights[j * dst_size + x] = static_cast<float>(w[j] / sum);
+        }
+    }
+}
+
+void
+mip_resample_row_x(const float*                 s,
+                   float*                       d,
+                   unsigned                     width,
+                   unsigned                     channels,
+                   const mip_resample_weights&  w,
+                   cpu_simd_level               l)
+{
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:
+            resample_row_x_avx2(s, d, width, channels, &w._first.front(), &w._weights.front(), w._taps);
+            break;
+        case CPU_SIMD_SSE4_1:
+            resample_row_x_sse41(s, d, width, channels, &w._first.front(), &w._weights.front(), w._taps);
+            break;
+#endif // SCM_SIMD_X86
+        default:
+            resample_row_x_scalar(s, d, 0, width, channels, &w._first.front(), &w._weights.front(), w._taps);
+            break;
+    }
+}
+
+void
+mip_accumulate_row(const float* s, float* d, scm::size_t c, float w, cpu_simd_level l)
+{
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:     accumulate_row_avx2(s, d, c, w);        break;
+        case CPU_SIMD_SSE4_1:   accumulate_row_sse41(s, d, c, w);       break;
+#endif // SCM_SIMD_X86
+        default:                accumulate_row_scalar(s, d, 0, c, w);   break;
+    }
+}
+
+} // namespace detail
+} // namespace util
+} // namespace gl
+} // namespace scm
@@ -5,177 +5,312 @@
 #ifndef SCM_GL_UTIL_MIP_MAP_GENERATION_H_INCLUDED
 #define SCM_GL_UTIL_MIP_MAP_GENERATION_H_INCLUDED
 
-#include <boost/numeric/conversion/bounds.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/platform/cpu_features.h>
+
+#include <scm/gl_core/texture_objects/texture_image.h>
+
+#include <scm/gl_util/data/imaging/texture_data_util.h>
+#include <scm/gl_util/utilities/parallel_for.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
 
 namespace scm {
 namespace gl {
 namespace util {
+namespace detail {
+
+// row kernels of typed_generate_mip_slices, vectorized for the simd level
+// with identical results for every level
+// - load converts source values to float, store clamps to the value range
+//   of the destination type and truncates
+// - filter_row_x downsamples a row of width * 2 (+ 1) texels with samples
+//   taps to width texels (1-, 2- and 3-tap filters)
+// - filter_rows combines rows of samples lines (d may equal s0) using
+//   (s0 + s1) * 0.5 or (w0 * s0 + w1 * s1 + w2 * s2) * scale
+__scm_export(gl_util) void  mip_load_row(const uint8*  s, float* d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_load_row(const uint16* s, float* d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_load_row(const int16*  s, float* d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_store_row(const float* s, uint8*  d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_store_row(const float* s, uint16* d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_store_row(const float* s, int16*  d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_store_row(const float* s, float*  d, scm::size_t c, cpu_simd_level l);
+__scm_export(gl_util) void  mip_filter_row_x(const float*   s,
+                                             float*         d,
+                                             unsigned       width,
+                                             unsigned       channels,
+                                             unsigned       samples,
+                                             cpu_simd_level l);
+__scm_export(gl_util) void  mip_filter_rows(const float*    s0,
+                                            const float*    s1,
+                                            const float*    s2,
+                                            float*          d,
+                                            scm::size_t     c,
+                                            unsigned        samples,
+                                            float           w0,
+                                            float           w1,
+                                            float           w2,
+                                            float           scale,
+                                            cpu_simd_level  l);
+
+// lanczos3 resampling of src_size texels to dst_size texels, destination texel x
+// is the weighted sum of the _taps source texels starting at _first[x] with the
+// weights _weights[j * dst_size + x]
+struct __scm_export(gl_util) mip_resample_weights
+{
+    mip_resample_weights(unsigned src_size, unsigned dst_size);
+
+    unsigned                    _taps;
+    std::vector<scm::int32>     _first;
+    std::vector<float>          _weights;
+}; // struct mip_resample_weights
+
+// - resample_row_x resamples a row to width texels
+// - accumulate_row adds w * s to d
+__scm_export(gl_util) void  mip_resample_row_x(const float*                 s,
+                                               float*                       d,
+                                               unsigned                     width,
+                                               unsigned                     channels,
+                                               const mip_resample_weights&  w,
+                                               cpu_simd_level               l);
+__scm_export(gl_util) void  mip_accumulate_row(const float* s, float* d, scm::size_t c, float w, cpu_simd_level l);
+
+// float rows are filtered in place, other types are converted into the buffer
+template<typename vtype>
+inline const float*
+mip_source_row(const vtype* s, float* buffer, scm::size_t c, cpu_simd_level l)
+{
+    mip_load_row(s, buffer, c, l);
+    return buffer;
+}
+
+inline const float*
+mip_source_row(const float* s, float*, scm::size_t, cpu_simd_level)
+{
+    return s;
+}
+
+} // namespace detail
 
+// compute the slices [z_begin, z_end) of the mip level with dimensions dst_dim
+// from the next finer level with dimensions src_dim
+// - src_data holds the source slices starting at slice src_z_first, it has to
+//   contain all slices the destination range samples (2 * z to 2 * z + 2)
+// - dst_data receives the destination slices starting at z_begin
+// - the rows are distributed over the util::parallel_for pool, supported types are
+//   uint8, uint16 and float
 template<typename vtype,
          const unsigned vdim,
          const int kdim>
 void
-typed_generate_mipmaps(const math::vec3ui&        src_dim,
-                             uint8*               src_data,
-                             std::vector<uint8*>& dst_data)
+typed_generate_mip_slices(const math::vec3ui&        src_dim,
+                          const math::vec3ui&        dst_dim,
+                          const uint8*               src_data,
+                                unsigned             src_z_first,
+                                unsigned             z_begin,
+                                unsigned             z_end,
+                                uint8*               dst_data,
+                                cpu_simd_level       l = cpu_supported_simd_level())
 {
     // for non-power of two downsampling using http://developer.nvidia.com/content/non-power-two-mipmapping
+    // - every destination row is built from the x-filtered source rows
+    //   (up to 3 x 3), which are then combined along y and z
 
     using namespace scm::gl;
     using namespace scm::math;
 
-    const vtype vmax = boost::numeric::bounds<vtype>::highest();//(std::numeric_limits<vtype>::max)();
-    const vtype vmin = boost::numeric::bounds<vtype>::lowest();//(std::numeric_limits<vtype>::min)();
+    const int y_max_lines = 3;
+    const int z_max_lines = 3;
 
-    typedef math::vec<vtype, vdim> varr;
-    typedef math::vec<float, vdim> tarr;
-    tarr zero_arr = tarr(0.0f);
-    //std::fill(zero_arr.begin(), zero_arr.end(), size_t(0));
-    //for (int i = 0; i < vdim; ++i) zero_arr[i] = 0;
+    const vec3i  lsize  = vec3i(dst_dim);
+    const vec3i  slsize = vec3i(src_dim);
+    const int    sz0    = static_cast<int>(src_z_first);
 
-    dst_data.push_back(src_data);
+    const unsigned x_samples = min(slsize.x, (slsize.x & 1) ? 3 : 2);
+    const unsigned y_samples = min(slsize.y, (slsize.y & 1) ? 3 : 2);
+    const unsigned z_samples = min(slsize.z, (slsize.z & 1) ? 3 : 2);
 
-    const int y_max_lines = 3;
-    const int z_max_lines = 3;
+    const scm::size_t row_values  = static_cast<scm::size_t>(lsize.x) * vdim;
+    const scm::size_t srow_values = static_cast<scm::size_t>(slsize.x) * vdim;
+    const scm::size_t row_count   = static_cast<scm::size_t>(z_end - z_begin) * lsize.y;
 
-    for (int l = 1; l < static_cast<int>(util::max_mip_levels(src_dim)); ++l) {
-        const vec3i  lsize  = vec3i(util::mip_level_dimensions(src_dim, l));
-        const size_t ldsize = static_cast<size_t>(lsize.x) * static_cast<size_t>(lsize.y) * static_cast<size_t>(lsize.z);
-        const vec3i  slsize = vec3i(util::mip_level_dimensions(src_dim, l - 1));
+    if (row_count == 0) {
+        return;
+    }
 
-        uint8* lrawdata = new uint8[ldsize * sizeof(varr)];
-        varr*  ldata    = reinterpret_cast<varr*>(lrawdata);
+    // blocks of rows of at least ~64KiB source data per task
+    const scm::size_t rows_per_task = max<scm::size_t>(1, (64 * 1024) / (srow_values * sizeof(vtype) * y_samples * z_samples));
+    const scm::size_t task_count    = (row_count + rows_per_task - 1) / rows_per_task;
 
-        scoped_array<tarr>  tlines(new tarr[lsize.x * y_max_lines * z_max_lines]);
+    // per thread line buffers: one converted source row and the x-filtered lines
+    std::vector<std::vector<float> > thread_lines(util::parallel_worker_count(task_count));
 
-        const size_t x_samples = min(slsize.x, (slsize.x & 1) ? 3 : 2);
-        const size_t y_samples = min(slsize.y, (slsize.y & 1) ? 3 : 2);
-        const size_t z_samples = min(slsize.z, (slsize.z & 1) ? 3 : 2);
+    util::parallel_for(task_count, [&](scm::size_t task, scm::size_t thread) {
+        std::vector<float>& lines = thread_lines[thread];
+        lines.resize(srow_values + row_values * y_max_lines * z_max_lines);
 
-        for (int z = 0; z < lsize.z; ++z) {
-            for (int y = 0; y < lsize.y; ++y) {
-                const varr*  sldata  = reinterpret_cast<varr*>(dst_data[l - 1]);
-                {// clear lines
-                    memset(tlines.get(), 0, lsize.x * y_max_lines * z_max_lines * sizeof(tarr));
-                }
-                { // read and sample x-lines
-                    if (x_samples == 1) { // 
-                        for (int zs = 0; zs < z_samples; ++zs) {
-                            for (int ys = 0; ys < y_samples; ++ys) {
-                                const varr* ld  = sldata + ( static_cast<size_t>(2 * y + ys) * slsize.x
-                                                           + static_cast<size_t>(2 * z + zs) * slsize.x * slsize.y);
-                                tlines[(ys + zs * y_max_lines) * lsize.x] = ld[0];
-                            }
-                        }
-                    }
-                    else if (x_samples == 2) { // box filter
-                        for (int zs = 0; zs < z_samples; ++zs) {
-                            for (int ys = 0; ys < y_samples; ++ys) {
-                                const varr* ld  = sldata + ( static_cast<size_t>(2 * y + ys) * slsize.x
-                                                           + static_cast<size_t>(2 * z + zs) * slsize.x * slsize.y);
-                                const int   lo  = (ys + zs * y_max_lines) * lsize.x;
-                                for (int x = 0; x < lsize.x; ++x) {
-                                    tlines[lo + x] += ld[0];
-                                    tlines[lo + x] += ld[1];
-                                    tlines[lo + x] *= 0.5f;
-                                    ld += 2;
-                                }
-                            }
-                        }
-                    }
-                    else { // x_samples == 3 ==> polyphase box filter
-                        for (int zs = 0; zs < z_samples; ++zs) {
-                            for (int ys = 0; ys < y_samples; ++ys) {
-                                const varr* ld    = sldata + ( static_cast<size_t>(2 * y + ys) * slsize.x
-                                                             + static_cast<size_t>(2 * z + zs) * slsize.x * slsize.y);
-                                const int   lo    = (ys + zs * y_max_lines) * lsize.x;
-                                const float scale = 1.0f / (2.0f * lsize.x + 1.0f);
-                                for (int x = 0; x < lsize.x; ++x) {
-                                    const float w0 = static_cast<float>(lsize.x - x);
-                                    const float w1 = static_cast<float>(lsize.x);
-                                    const float w2 = static_cast<float>(1 + x);
-
-                                    tlines[lo + x] += w0 * tarr(ld[0]); //TODO fix cast
-                                    tlines[lo + x] += w1 * tarr(ld[1]);
-                                    tlines[lo + x] += w2 * tarr(ld[2]);
-                                    tlines[lo + x] *= scale;
-                                    ld += 2;
-                                }
-                            }
-                        }
-                    }
-                }
-                { // downsample y-lines
-                    if (y_samples == 1) { // nothing to do
-                    }
-                    else if (y_samples == 2) { // box filter
-                        for (int zs = 0; zs < z_samples; ++zs) {
-                            const int lo = (zs * y_max_lines) * lsize.x;
-                            for (int x = 0; x < lsize.x; ++x) {
-                                tlines[lo + x] += tlines[lo + lsize.x + x];
-                                tlines[lo + x] *= 0.5f;
-                            }
-                        }
-                    }
-                    else { // y_samples == 3 ==> polyphase box filter
-                        const float w0 = float(lsize.y - y);
-                        const float w1 = float(lsize.y);
-                        const float w2 = float(1 + y);
-                        for (int zs = 0; zs < z_samples; ++zs) {
-                            const int lo      = (zs * y_max_lines) * lsize.x;
-                            const float scale = 1.0f / (2.0f * lsize.y + 1.0f);
-                            for (int x = 0; x < lsize.x; ++x) {
-                                tlines[lo + x]  = w0 * tlines[lo +               x];
-                                tlines[lo + x] += w1 * tlines[lo +     lsize.x + x];
-                                tlines[lo + x] += w2 * tlines[lo + 2 * lsize.x + x];
-                                tlines[lo + x] *= scale;
-                            }
-                        }
+        float*          srow   = &lines.front();
+        float*          tlines = srow + srow_values;
+        const vtype*    sldata = reinterpret_cast<const vtype*>(src_data);
+        vtype*          ldata  = reinterpret_cast<vtype*>(dst_data);
+
+        const scm::size_t row_end = min(row_count, (task + 1) * rows_per_task);
+
+        for (scm::size_t r = task * rows_per_task; r < row_end; ++r) {
+            const int z = static_cast<int>(z_begin) + static_cast<int>(r / lsize.y);
+            const int y = static_cast<int>(r % lsize.y);
+
+            { // read and sample x-lines
+                for (unsigned zs = 0; zs < z_samples; ++zs) {
+                    for (unsigned ys = 0; ys < y_samples; ++ys) {
+                        const vtype* ld = sldata + ( static_cast<size_t>(2 * y + ys) * slsize.x
+                                                   + static_cast<size_t>(2 * z + zs - sz0) * slsize.x * slsize.y) * vdim;
+                        detail::mip_filter_row_x(detail::mip_source_row(ld, srow, srow_values, l),
+                                                 tlines + (ys + zs * y_max_lines) * row_values,
+                                                 lsize.x, vdim, x_samples, l);
                     }
                 }
-                { // downsample z-lines
-                    if (z_samples == 1) { // nothing to do
-                    }
-                    else if (z_samples == 2) { // box filter
-                        const int lo1 = y_max_lines * lsize.x;
-                        for (int x = 0; x < lsize.x; ++x) {
-                            tlines[x] += tlines[lo1 + x];
-                            tlines[x] *= 0.5f;
-                        }
-                    }
-                    else { // z_samples == 3 ==> polyphase box filter
-                        const float w0 = float(lsize.z - z);
-                        const float w1 = float(lsize.z);
-                        const float w2 = float(1 + z);
-
-                        const int lo1  =     y_max_lines * lsize.x;
-                        const int lo2  = 2 * y_max_lines * lsize.x;
-                        const float scale = 1.0f / (2.0f * lsize.z + 1.0f);
-
-                        for (int x = 0; x < lsize.x; ++x) {
-                            tlines[x]  = w0 * tlines[      x];
-                            tlines[x] += w1 * tlines[lo1 + x];
-                            tlines[x] += w2 * tlines[lo2 + x];
-                            tlines[x] *= scale;
-                        }
-                    }
+            }
+            { // downsample y-lines
+                const float w0    = float(lsize.y - y);
+                const float w1    = float(lsize.y);
+                const float w2    = float(1 + y);
+                const float scale = 1.0f / (2.0f * lsize.y + 1.0f);
+
+                for (unsigned zs = 0; zs < z_samples && y_samples > 1; ++zs) {
+                    float* lo = tlines + (zs * y_max_lines) * row_values;
+                    detail::mip_filter_rows(lo, lo + row_values, lo + 2 * row_values, lo, row_values,
+                                            y_samples, w0, w1, w2, scale, l);
                 }
-                { // write out samples
-                    const size_t dst_off =   static_cast<size_t>(y) * lsize.x
-                                           + static_cast<size_t>(z) * lsize.x * lsize.y;
-                    for (int x = 0; x < lsize.x; ++x) {
-                        ldata[dst_off + x] = varr(clamp(tlines[x], tarr(vmin), tarr(vmax)));
-                    }
+            }
+            { // downsample z-lines
+                const float w0    = float(lsize.z - z);
+                const float w1    = float(lsize.z);
+                const float w2    = float(1 + z);
+                const float scale = 1.0f / (2.0f * lsize.z + 1.0f);
+
+                if (z_samples > 1) {
+                    detail::mip_filter_rows(tlines, tlines + y_max_lines * row_values, tlines + 2 * y_max_lines * row_values,
+                                            tlines, row_values, z_samples, w0, w1, w2, scale, l);
                 }
             }
+            { // write out samples
+                const size_t dst_off =   static_cast<size_t>(y) * lsize.x
+                                       + static_cast<size_t>(z - static_cast<int>(z_begin)) * lsize.x * lsize.y;
+                detail::mip_store_row(tlines, ldata + dst_off * vdim, row_values, l);
+            }
         }
+    });
+}
+
+template<typename vtype,
+         const unsigned vdim,
+         const int kdim>
+void
+typed_generate_mipmaps(const math::vec3ui&        src_dim,
+                             uint8*               src_data,
+                             std::vector<uint8*>& dst_data,
+                             cpu_simd_level       l = cpu_supported_simd_level())
+{
+    using namespace scm::math;
+
+    typedef math::vec<vtype, vdim> varr;
+
+    dst_data.push_back(src_data);
+
+    for (int m = 1; m < static_cast<int>(util::max_mip_levels(src_dim)); ++m) {
+        const vec3ui lsize  = util::mip_level_dimensions(src_dim, m);
+        const size_t ldsize = static_cast<size_t>(lsize.x) * static_cast<size_t>(lsize.y) * static_cast<size_t>(lsize.z);
+        const vec3ui slsize = util::mip_level_dimensions(src_dim, m - 1);
+
+        uint8* lrawdata = new uint8[ldsize * sizeof(varr)];
+
+        typed_generate_mip_slices<vtype, vdim, kdim>(slsize, lsize, dst_data[m - 1], 0, 0, lsize.z, lrawdata, l);
 
         dst_data.push_back(lrawdata);
     }
 }
 
+// compute the mip level with dimensions dst_dim of a 2d image from the next
+// finer level with dimensions src_dim
+// - MIP_FILTER_BOX uses typed_generate_mip_slices
+// - MIP_FILTER_LANCZOS3 resamples separably: bands of destination rows are
+//   distributed over the util::parallel_for pool, every band resamples the source
+//   rows it covers along x and combines them along y
+template<typename vtype,
+         const unsigned vdim>
+void
+typed_generate_image_mip_level(const math::vec2ui&        src_dim,
+                               const math::vec2ui&        dst_dim,
+                               const uint8*               src_data,
+                                     uint8*               dst_data,
+                                     mip_filter_type      filter,
+                                     cpu_simd_level       l = cpu_supported_simd_level())
+{
+    using namespace scm::math;
+
+    if (filter == MIP_FILTER_BOX) {
+        typed_generate_mip_slices<vtype, vdim, 2>(vec3ui(src_dim, 1), vec3ui(dst_dim, 1), src_data, 0, 0, 1, dst_data, l);
+        return;
+    }
+
+    const detail::mip_resample_weights wx(src_dim.x, dst_dim.x);
+    const detail::mip_resample_weights wy(src_dim.y, dst_dim.y);
+
+    const scm::size_t row_values  = static_cast<scm::size_t>(dst_dim.x) * vdim;
+    const scm::size_t srow_values = static_cast<scm::size_t>(src_dim.x) * vdim;
+
+    // integer results are rounded by starting the accumulation at 0.5
+    const float       bias        = std::numeric_limits<vtype>::is_integer ? 0.5f : 0.0f;
+
+    const unsigned    band_rows   = 16;
+    const scm::size_t task_count  = (dst_dim.y + band_rows - 1) / band_rows;
+
+    // per thread line buffers: one converted source row, one accumulation row
+    // and the x-resampled source rows of the band
+    std::vector<std::vector<float> > thread_lines(util::parallel_worker_count(task_count));
+
+    util::parallel_for(task_count, [&](scm::size_t task, scm::size_t thread) {
+        const unsigned y_begin  = static_cast<unsigned>(task) * band_rows;
+        const unsigned y_end    = min(dst_dim.y, y_begin + band_rows);
+        const unsigned sy_begin = static_cast<unsigned>(wy._first[y_begin]);
+        const unsigned sy_end   = static_cast<unsigned>(wy._first[y_end - 1]) + wy._taps;
+
+        std::vector<float>& lines = thread_lines[thread];
+        lines.resize(srow_values + row_values * (1 + sy_end - sy_begin));
+
+        float*          srow   = &lines.front();
+        float*          drow   = srow + srow_values;
+        float*          xlines = drow + row_values;
+        const vtype*    sldata = reinterpret_cast<const vtype*>(src_data);
+        vtype*          ldata  = reinterpret_cast<vtype*>(dst_data);
+
+        for (unsigned sy = sy_begin; sy < sy_end; ++sy) {
+            detail::mip_resample_row_x(detail::mip_source_row(sldata + sy * srow_values, srow, srow_values, l),
+                                       xlines + (sy - sy_begin) * row_values,
+                                       dst_dim.x, vdim, wx, l);
+        }
+        for (unsigned y = y_begin; y < y_end; ++y) {
+            std::fill(drow, drow + row_values, bias);
+            for (unsigned j = 0; j < wy._taps; ++j) {
+                detail::mip_accumulate_row(xlines + (wy._first[y] + j - sy_begin) * row_values, drow, row_values,
+                                           wy._weights[j * dst_dim.y + y], l);
+            }
+            detail::mip_store_row(drow, ldata + y * row_values, row_values, l);
+        }
+    });
+}
+
 } // namespace util
 } // namespace gl
 } // namespace scm
 
+#include <scm/core/utilities/platform_warning_enable.h>
+
 #endif // SCM_GL_UTIL_MIP_MAP_GENERATION_H_INCLUDED
@@ -8,6 +8,8 @@
 
 #include <scm/gl_core/log.h>
 #include <scm/gl_core/texture_objects/texture_image.h>
+#include <scm/gl_util/data/imaging/block_compression.h>
+#include <scm/gl_util/data/imaging/image_conversion.h>
 #include <scm/gl_util/data/imaging/mip_map_generation.h>
 
 namespace scm {
@@ -33,17 +35,6 @@ typedef struct
     unsigned char row[6];
 } DXT5AlphaBlock_t;
 
-inline
-void
-SwapMem(void *byte1, void *byte2, int size)
-{
-    unsigned char *tmp=(unsigned char *)malloc(sizeof(unsigned char)*size);
-    memcpy(tmp, byte1, size);
-    memcpy(byte1, byte2, size);
-    memcpy(byte2, tmp, size);
-    free(tmp);
-}
-
 inline
 void
 SwapChar(unsigned char * x, unsigned char * y)
@@ -97,32 +88,16 @@ inline
 void
 flipDXT5Alpha(DXT5AlphaBlock_t *Block)
 {
-    unsigned long *Bits, Bits0=0, Bits1=0;
-
-    memcpy(&Bits0, &Block->row[0], sizeof(unsigned char)*3);
-    memcpy(&Bits1, &Block->row[3], sizeof(unsigned char)*3);
-
-    Bits=((unsigned long *)&(Block->row[0]));
-    *Bits&=0xff000000;
-    *Bits|=(unsigned char)(Bits1>>12)&0x00000007;
-    *Bits|=(unsigned char)((Bits1>>15)&0x00000007)<<3;
-    *Bits|=(unsigned char)((Bits1>>18)&0x00000007)<<6;
-    *Bits|=(unsigned char)((Bits1>>21)&0x00000007)<<9;
-    *Bits|=(unsigned char)(Bits1&0x00000007)<<12;
-    *Bits|=(unsigned char)((Bits1>>3)&0x00000007)<<15;
-    *Bits|=(unsigned char)((Bits1>>6)&0x00000007)<<18;
-    *Bits|=(unsigned char)((Bits1>>9)&0x00000007)<<21;
-
-    Bits=((unsigned long *)&(Block->row[3]));
-    *Bits&=0xff000000;
-    *Bits|=(unsigned char)(Bits0>>12)&0x00000007;
-    *Bits|=(unsigned char)((Bits0>>15)&0x00000007)<<3;
-    *Bits|=(unsigned char)((Bits0>>18)&0x00000007)<<6;
-    *Bits|=(unsigned char)((Bits0>>21)&0x00000007)<<9;
-    *Bits|=(unsigned char)(Bits0&0x00000007)<<12;
-    *Bits|=(unsigned char)((Bits0>>3)&0x00000007)<<15;
-    *Bits|=(unsigned char)((Bits0>>6)&0x00000007)<<18;
-    *Bits|=(unsigned char)((Bits0>>9)&0x00000007)<<21;
+    // the 16 3bit indices as one 48bit value (little endian), four indices per row
+    scm::uint64 Bits = 0;
+    memcpy(&Bits, Block->row, 6);
+
+    const scm::uint64 Flipped =   ((Bits & 0xfff) << 36)
+                                | (((Bits >> 12) & 0xfff) << 24)
+                                | (((Bits >> 24) & 0xfff) << 12)
+                                | ((Bits >> 36) & 0xfff);
+
+    memcpy(Block->row, &Flipped, 6);
 }
 
 inline
@@ -181,6 +156,41 @@ flipBC5Blocks(DXTColorBlock_t *Block, int NumBlocks)
 
 } // namespace nv
 
+typedef void (*block_row_flip)(nv::DXTColorBlock_t*, int);
+
+block_row_flip
+block_flip_function(data_format fmt)
+{
+    using namespace scm::gl::util::nv;
+
+    switch (fmt) {
+        case FORMAT_BC1_RGBA:
+        case FORMAT_BC1_SRGBA:  return flipDXT1Blocks;
+        case FORMAT_BC2_RGBA:
+        case FORMAT_BC2_SRGBA:  return flipDXT3Blocks;
+        case FORMAT_BC3_RGBA:
+        case FORMAT_BC3_SRGBA:  return flipDXT5Blocks;
+        case FORMAT_BC4_R:
+        case FORMAT_BC4_R_S:    return flipBC4Blocks;
+        case FORMAT_BC5_RG:
+        case FORMAT_BC5_RG_S:   return flipBC5Blocks;
+        default:                return 0;
+    }
+}
+
+scm::size_t
+image_layer_size(data_format fmt, unsigned w, unsigned h)
+{
+    if (is_compressed_format(fmt)) {
+        return static_cast<scm::size_t>((w + 3) / 4) * ((h + 3) / 4) * compressed_block_size(fmt);
+    }
+    else {
+        return static_cast<scm::size_t>(w) * h * size_of_format(fmt);
+    }
+}
+
+// the rows (block rows of compressed formats) are exchanged in place without
+// temporary buffers, the blocks themselves are flipped before
 bool
 image_layer_vert_flip_raw(scm::uint8*const data,
                           data_format      fmt,
@@ -188,121 +198,27 @@ image_layer_vert_flip_raw(scm::uint8*const data,
                           unsigned         h)
 {
     if (is_compressed_format(fmt)) {
-        using namespace scm::gl::util::nv;
-
-        int bw  = (w + 3) / 4;
-        int bh  = (h + 3) / 4;
-        int bs  = compressed_block_size(fmt);
-        int bls = bw * bs;
+        const block_row_flip flip_blocks = block_flip_function(fmt);
 
-        if (1 == h) {
-            return true;
-        }
-        else if (1 < h && h < 4) {
-            DXTColorBlock_t *line = reinterpret_cast<DXTColorBlock_t*>(data);
-            switch (fmt) {
-                case FORMAT_BC1_RGBA:
-                case FORMAT_BC1_SRGBA:
-                    flipDXT1Blocks(line, bw);
-                    break;
-                case FORMAT_BC2_RGBA:
-                case FORMAT_BC2_SRGBA:
-                    flipDXT3Blocks(line, bw);
-                    break;
-                case FORMAT_BC3_RGBA:
-                case FORMAT_BC3_SRGBA:
-                    flipDXT5Blocks(line, bw);
-                    break;
-                case FORMAT_BC4_R:
-                case FORMAT_BC4_R_S:
-                    flipBC4Blocks(line, bw);
-                    break;
-                case FORMAT_BC5_RG:
-                case FORMAT_BC5_RG_S:
-                    flipBC5Blocks(line, bw);
-                    break;
-                default:
-                    return false;
-            }
-            return true;
+        if (!flip_blocks) {
+            return false;
         }
-        else if (4 <= h) {
-            DXTColorBlock_t *top_line;
-            DXTColorBlock_t *bottom_line;
-
-            switch (fmt) {
-                case FORMAT_BC1_RGBA:
-                case FORMAT_BC1_SRGBA:
-                    for(int bl = 0; bl < (bh / 2); ++bl) {
-                        top_line    = reinterpret_cast<DXTColorBlock_t*>(data + bl * bls);
-                        bottom_line = reinterpret_cast<DXTColorBlock_t*>(data + (bh - (bl + 1)) * bls);
-                        flipDXT1Blocks(top_line,    bw);
-                        flipDXT1Blocks(bottom_line, bw);
-                        SwapMem(bottom_line, top_line, bls);
-                    }
-                    break;
-                case FORMAT_BC2_RGBA:
-                case FORMAT_BC2_SRGBA:
-                    for(int bl = 0; bl < (bh / 2); ++bl) {
-                        top_line    = reinterpret_cast<DXTColorBlock_t*>(data + bl * bls);
-                        bottom_line = reinterpret_cast<DXTColorBlock_t*>(data + (bh - (bl + 1)) * bls);
-                        flipDXT3Blocks(top_line,    bw);
-                        flipDXT3Blocks(bottom_line, bw);
-                        SwapMem(bottom_line, top_line, bls);
-                    }
-                    break;
-                case FORMAT_BC3_RGBA:
-                case FORMAT_BC3_SRGBA:
-                    for(int bl = 0; bl < (bh / 2); ++bl) {
-                        top_line    = reinterpret_cast<DXTColorBlock_t*>(data + bl * bls);
-                        bottom_line = reinterpret_cast<DXTColorBlock_t*>(data + (bh - (bl + 1)) * bls);
-                        flipDXT5Blocks(top_line,    bw);
-                        flipDXT5Blocks(bottom_line, bw);
-                        SwapMem(bottom_line, top_line, bls);
-                    }
-                    break;
-                case FORMAT_BC4_R:
-                case FORMAT_BC4_R_S:
-                    for(int bl = 0; bl < (bh / 2); ++bl) {
-                        top_line    = reinterpret_cast<DXTColorBlock_t*>(data + bl * bls);
-                        bottom_line = reinterpret_cast<DXTColorBlock_t*>(data + (bh - (bl + 1)) * bls);
-                        flipBC4Blocks(top_line,    bw);
-                        flipBC4Blocks(bottom_line, bw);
-                        SwapMem(bottom_line, top_line, bls);
-                    }
-                    break;
-                case FORMAT_BC5_RG:
-                case FORMAT_BC5_RG_S:
-                    for(int bl = 0; bl < (bh / 2); ++bl) {
-                        top_line    = reinterpret_cast<DXTColorBlock_t*>(data + bl * bls);
-                        bottom_line = reinterpret_cast<DXTColorBlock_t*>(data + (bh - (bl + 1)) * bls);
-                        flipBC5Blocks(top_line,    bw);
-                        flipBC5Blocks(bottom_line, bw);
-                        SwapMem(bottom_line, top_line, bls);
-                    }
-                    break;
-                default:
-                    return false;
-            }
+        if (1 == h) {
             return true;
         }
-        else {
-            return false;
-        }
-    }
-    else {
-        size_t              lsize = static_cast<size_t>(w) * size_of_format(fmt);
-        scoped_array<uint8> tmp_line(new uint8[lsize]);
 
-        for (unsigned l = 0; l < (h / 2); ++l) {
-            size_t r = lsize * l;
-            size_t w = lsize * (h - (l + 1));
+        const int           bw  = (w + 3) / 4;
+        const int           bh  = (h + 3) / 4;
+        const scm::size_t   bls = static_cast<scm::size_t>(bw) * compressed_block_size(fmt);
 
-            memcpy(tmp_line.get(), data + r,       lsize);
-            memcpy(data + r,       data + w,       lsize);
-            memcpy(data + w,       tmp_line.get(), lsize);
+        for (int bl = 0; bl < bh; ++bl) {
+            flip_blocks(reinterpret_cast<nv::DXTColorBlock_t*>(data + bl * bls), bw);
         }
-        return true;
+
+        return flip_rows(data, bls, bh, cpu_supported_simd_level());
+    }
+    else {
+        return flip_rows(data, static_cast<scm::size_t>(w) * size_of_format(fmt), h, cpu_supported_simd_level());
     }
 }
 
@@ -322,7 +238,7 @@ volume_flip_vertical(const shared_array<uint8>& data,
                            unsigned             h,
                            unsigned             d)
 {
-    size_t ssize = (static_cast<size_t>(w) * h * bit_per_pixel(fmt)) / 8;
+    const scm::size_t ssize = image_layer_size(fmt, w, h);
 
     for (unsigned s = 0; s < d; ++s) {
         if (!image_layer_vert_flip_raw(data.get() + ssize * s, fmt, w, h)) {
@@ -334,6 +250,58 @@ volume_flip_vertical(const shared_array<uint8>& data,
 }
 
 
+bool
+swap_red_blue_channels(const math::vec2ui&        dim,
+                             gl::data_format      fmt,
+                             uint8*               data)
+{
+    return swap_red_blue_channels(dim, fmt, data, cpu_supported_simd_level());
+}
+
+bool
+convert_image_format(const math::vec2ui&        dim,
+                           gl::data_format      src_fmt,
+                     const uint8*               src_data,
+                           gl::data_format      dst_fmt,
+                           uint8*               dst_data,
+                           scm::size_t          src_pitch)
+{
+    return convert_image_format(dim, src_fmt, src_data, src_pitch, dst_fmt, dst_data, cpu_supported_simd_level());
+}
+
+bool
+image_conversion_supported(gl::data_format fmt)
+{
+    switch (fmt) {
+    case FORMAT_R_8:
+    case FORMAT_RG_8:
+    case FORMAT_RGB_8:
+    case FORMAT_RGBA_8:
+    case FORMAT_BGR_8:
+    case FORMAT_BGRA_8:
+    case FORMAT_R_16:
+    case FORMAT_RG_16:
+    case FORMAT_RGB_16:
+    case FORMAT_RGBA_16:
+    case FORMAT_R_32F:
+    case FORMAT_RG_32F:
+    case FORMAT_RGB_32F:
+    case FORMAT_RGBA_32F:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool
+scale_image_channels(const math::vec2ui&        dim,
+                           gl::data_format      fmt,
+                           uint8*               data,
+                     const math::vec4f&         scale)
+{
+    return scale_image_channels(dim, fmt, data, scale, cpu_supported_simd_level());
+}
+
 bool
 generate_mipmaps(const math::vec3ui&        src_dim,
                        gl::data_format      src_fmt,
@@ -389,6 +357,190 @@ generate_mipmaps(const math::vec3ui&        src_dim,
     return true;
 }
 
+bool
+generate_mip_slices(const math::vec3ui&        src_dim,
+                    const math::vec3ui&        dst_dim,
+                          gl::data_format      src_fmt,
+                    const uint8*               src_data,
+                          unsigned             src_z_first,
+                          unsigned             z_begin,
+                          unsigned             z_end,
+                          uint8*               dst_data)
+{
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    switch (src_fmt) {
+    case FORMAT_R_32F:
+        typed_generate_mip_slices<float, 1, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RG_32F:
+        typed_generate_mip_slices<float, 2, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RGB_32F:
+        typed_generate_mip_slices<float, 3, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RGBA_32F:
+        typed_generate_mip_slices<float, 4, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_R_8:
+        typed_generate_mip_slices<uint8, 1, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RG_8:
+        typed_generate_mip_slices<uint8, 2, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RGB_8:
+        typed_generate_mip_slices<uint8, 3, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RGBA_8:
+        typed_generate_mip_slices<uint8, 4, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_R_16:
+        typed_generate_mip_slices<uint16, 1, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RG_16:
+        typed_generate_mip_slices<uint16, 2, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RGB_16:
+        typed_generate_mip_slices<uint16, 3, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    case FORMAT_RGBA_16:
+        typed_generate_mip_slices<uint16, 4, 2>(src_dim, dst_dim, src_data, src_z_first, z_begin, z_end, dst_data);
+        break;
+    default:
+        glerr() << log::error
+                << "generate_mip_slices(): error unsupported source data format (" << format_string(src_fmt) << ")." << log::end;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+generate_image_mip_level(const math::vec2ui&        src_dim,
+                         const math::vec2ui&        dst_dim,
+                               gl::data_format      src_fmt,
+                         const uint8*               src_data,
+                               uint8*               dst_data,
+                               mip_filter_type      filter)
+{
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    // the filters are channel order independent, bgr(a) images are handled as rgb(a)
+    switch (src_fmt) {
+    case FORMAT_R_32F:
+        typed_generate_image_mip_level<float, 1>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RG_32F:
+        typed_generate_image_mip_level<float, 2>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RGB_32F:
+        typed_generate_image_mip_level<float, 3>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RGBA_32F:
+        typed_generate_image_mip_level<float, 4>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_R_8:
+        typed_generate_image_mip_level<uint8, 1>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RG_8:
+        typed_generate_image_mip_level<uint8, 2>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RGB_8:
+    case FORMAT_BGR_8:
+        typed_generate_image_mip_level<uint8, 3>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RGBA_8:
+    case FORMAT_BGRA_8:
+        typed_generate_image_mip_level<uint8, 4>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_R_16:
+        typed_generate_image_mip_level<uint16, 1>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RG_16:
+        typed_generate_image_mip_level<uint16, 2>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RGB_16:
+        typed_generate_image_mip_level<uint16, 3>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_RGBA_16:
+        typed_generate_image_mip_level<uint16, 4>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    case FORMAT_R_16S:
+        typed_generate_image_mip_level<int16, 1>(src_dim, dst_dim, src_data, dst_data, filter);
+        break;
+    default:
+        glerr() << log::error
+                << "generate_image_mip_level(): error unsupported source data format (" << format_string(src_fmt) << ")." << log::end;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+mipmap_generation_supported(gl::data_format fmt)
+{
+    switch (fmt) {
+    case FORMAT_R_32F:
+    case FORMAT_RG_32F:
+    case FORMAT_RGB_32F:
+    case FORMAT_RGBA_32F:
+    case FORMAT_R_8:
+    case FORMAT_RG_8:
+    case FORMAT_RGB_8:
+    case FORMAT_RGBA_8:
+    case FORMAT_R_16:
+    case FORMAT_RG_16:
+    case FORMAT_RGB_16:
+    case FORMAT_RGBA_16:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool
+compress_image_blocks(const math::vec2ui&        src_dim,
+                            gl::data_format      src_fmt,
+                      const uint8*               src_data,
+                            gl::data_format      dst_fmt,
+                            uint8*               dst_data,
+                            block_compression_quality quality)
+{
+    return compress_image_blocks(src_dim, src_fmt, src_data, dst_fmt, dst_data, quality, cpu_supported_simd_level());
+}
+
+bool
+block_compression_supported(gl::data_format src_fmt,
+                            gl::data_format dst_fmt)
+{
+    switch (src_fmt) {
+    case FORMAT_R_8:
+    case FORMAT_RG_8:
+    case FORMAT_RGB_8:
+    case FORMAT_RGBA_8:
+    case FORMAT_BGR_8:
+    case FORMAT_BGRA_8:
+        break;
+    default:
+        return false;
+    }
+
+    switch (dst_fmt) {
+    case FORMAT_BC1_RGBA:
+    case FORMAT_BC1_SRGBA:
+    case FORMAT_BC3_RGBA:
+    case FORMAT_BC3_SRGBA:
+    case FORMAT_BC4_R:
+    case FORMAT_BC5_RG:
+        return true;
+    default:
+        return false;
+    }
+}
+
 } // namespace util
 } // namespace gl
 } // namespace scm
@@ -20,12 +20,59 @@ namespace scm {
 namespace gl {
 namespace util {
 
+enum mip_filter_type {
+    MIP_FILTER_BOX          = 0x00,     // 2x2 box (3-tap for odd dimensions), see typed_generate_mip_slices
+    MIP_FILTER_LANCZOS3                 // separable lanczos3, see typed_generate_image_mip_level
+}; // enum mip_filter_type
+
+enum block_compression_quality {
+    BLOCK_COMPRESSION_FAST      = 0x00, // bounding box endpoints
+    BLOCK_COMPRESSION_NORMAL            // principal axis endpoints, least squares refinement
+}; // enum block_compression_quality
+
+// flip in place without temporary buffers, the rows of large images are
+// exchanged on all hardware threads
 bool
 image_flip_vertical(const shared_array<uint8>& data, data_format fmt, unsigned w, unsigned h);
 
 bool
 volume_flip_vertical(const shared_array<uint8>& data, data_format fmt, unsigned w, unsigned h, unsigned d);
 
+// swap the red and blue channels of a 2d image in place (rows tightly packed),
+// 3 and 4 channel formats of image_conversion_supported
+bool
+__scm_export(gl_util)
+swap_red_blue_channels(const math::vec2ui&        dim,
+                             gl::data_format      fmt,
+                             uint8*               data);
+
+// convert a 2d image to dst_fmt (destination rows tightly packed), src_pitch
+// is the byte distance of the source rows (0 for tightly packed rows), see
+// convert_image_format in image_conversion.h for the channel mapping
+bool
+__scm_export(gl_util)
+convert_image_format(const math::vec2ui&        dim,
+                           gl::data_format      src_fmt,
+                     const uint8*               src_data,
+                           gl::data_format      dst_fmt,
+                           uint8*               dst_data,
+                           scm::size_t          src_pitch = 0);
+
+// FORMAT_R_8 to FORMAT_RGBA_8, FORMAT_BGR(A)_8, FORMAT_R_16 to FORMAT_RGBA_16
+// and FORMAT_R_32F to FORMAT_RGBA_32F
+bool
+__scm_export(gl_util)
+image_conversion_supported(gl::data_format fmt);
+
+// multiply the channels (in rgba order) of a 2d image in place, integer
+// results are clamped and truncated
+bool
+__scm_export(gl_util)
+scale_image_channels(const math::vec2ui&        dim,
+                           gl::data_format      fmt,
+                           uint8*               data,
+                     const math::vec4f&         scale);
+
 bool
 __scm_export(gl_util)
 generate_mipmaps(const math::vec3ui&        src_dim,
@@ -33,6 +80,52 @@ generate_mipmaps(const math::vec3ui&        src_dim,
                        uint8*               src_data,
                        std::vector<uint8*>& dst_data);
 
+// slice range variant of generate_mipmaps for building mip levels incrementally,
+// see typed_generate_mip_slices in mip_map_generation.h
+bool
+__scm_export(gl_util)
+generate_mip_slices(const math::vec3ui&        src_dim,
+                    const math::vec3ui&        dst_dim,
+                          gl::data_format      src_fmt,
+                    const uint8*               src_data,
+                          unsigned             src_z_first,
+                          unsigned             z_begin,
+                          unsigned             z_end,
+                          uint8*               dst_data);
+
+// build the mip level with dimensions dst_dim of a 2d image from the next finer
+// level with dimensions src_dim (rows tightly packed), formats as generate_mipmaps
+// plus FORMAT_BGR_8, FORMAT_BGRA_8 and FORMAT_R_16S
+bool
+__scm_export(gl_util)
+generate_image_mip_level(const math::vec2ui&        src_dim,
+                         const math::vec2ui&        dst_dim,
+                               gl::data_format      src_fmt,
+                         const uint8*               src_data,
+                               uint8*               dst_data,
+                               mip_filter_type      filter = MIP_FILTER_LANCZOS3);
+
+bool
+__scm_export(gl_util)
+mipmap_generation_supported(gl::data_format fmt);
+
+// compress a 2d image (rows tightly packed) to the block compressed format
+// dst_fmt, dst_data has to hold ((w + 3) / 4) * ((h + 3) / 4) blocks, see
+// compress_image_blocks in block_compression.h for the supported formats
+bool
+__scm_export(gl_util)
+compress_image_blocks(const math::vec2ui&        src_dim,
+                            gl::data_format      src_fmt,
+                      const uint8*               src_data,
+                            gl::data_format      dst_fmt,
+                            uint8*               dst_data,
+                            block_compression_quality quality = BLOCK_COMPRESSION_NORMAL);
+
+bool
+__scm_export(gl_util)
+block_compression_supported(gl::data_format src_fmt,
+                            gl::data_format dst_fmt);
+
 } // namespace util
 } // namespace gl
 } // namespace scm
@@ -0,0 +1,341 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "texture_image_cache.h"
+
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/static_assert.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <scm/core/io/file.h>
+#include <scm/core/io/file_mapping.h>
+
+#include <scm/gl_core/log.h>
+
+namespace {
+
+BOOST_STATIC_ASSERT(sizeof(scm::gl::texture_cache_header) == 72);
+BOOST_STATIC_ASSERT(sizeof(scm::gl::texture_cache_level)  == 32);
+
+const scm::uint64   data_page_alignment     = 4096;
+const scm::uint64   level_alignment         = 16;
+const scm::uint32   max_key_size            = 65536;
+const scm::uint32   max_level_count         = 32;
+
+scm::uint64
+align_ceil(scm::uint64 v, scm::uint64 a)
+{
+    return ((v + a - 1) / a) * a;
+}
+
+scm::size_t
+level_byte_size(scm::gl::data_format fmt, const scm::math::vec3ui& size, unsigned layers)
+{
+    using namespace scm::gl;
+
+    scm::size_t s = 0;
+    if (is_compressed_format(fmt)) {
+        s =   static_cast<scm::size_t>((size.x + 3) / 4) * ((size.y + 3) / 4)
+            * compressed_block_size(fmt);
+    }
+    else {
+        s = static_cast<scm::size_t>(size.x) * size.y * size_of_format(fmt);
+    }
+    return s * size.z * layers;
+}
+
+// 64bit fnv-1a
+scm::uint64
+key_hash(const std::string& key)
+{
+    scm::uint64 h = 14695981039346656037ull;
+    for (std::string::size_type i = 0; i < key.size(); ++i) {
+        h ^= static_cast<unsigned char>(key[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string
+entry_key(const std::string& image_path, const std::string& options)
+{
+    return boost::filesystem::absolute(image_path).string() + '\n' + options;
+}
+
+bool
+image_file_stamp(const std::string& image_path, scm::uint64& out_size, scm::int64& out_time)
+{
+    boost::system::error_code ec;
+
+    const boost::uintmax_t  s = boost::filesystem::file_size(image_path, ec);
+    if (ec) {
+        return false;
+    }
+    const std::time_t       t = boost::filesystem::last_write_time(image_path, ec);
+    if (ec) {
+        return false;
+    }
+    out_size = static_cast<scm::uint64>(s);
+    out_time = static_cast<scm::int64>(t);
+
+    return true;
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+texture_image_cache::entry::entry()
+  : _origin(texture_image_data::ORIGIN_LOWER_LEFT)
+  , _format(FORMAT_NULL)
+  , _internal_format(FORMAT_NULL)
+  , _layers(1)
+{
+}
+
+texture_image_data_ptr
+texture_image_cache::entry::copy_image_data() const
+{
+    texture_image_data::level_vector    mip_vec;
+
+    for (size_t l = 0; l < _level_sizes.size(); ++l) {
+        const size_t                lev_bytes = level_byte_size(_format, _level_sizes[l], _layers);
+        scm::shared_array<uint8>    lev_data(new uint8[lev_bytes]);
+
+        memcpy(lev_data.get(), _level_data[l], lev_bytes);
+        mip_vec.push_back(texture_image_data::level(_level_sizes[l], lev_data));
+    }
+
+    return texture_image_data_ptr(new texture_image_data(_origin, _format, static_cast<int>(_layers), mip_vec));
+}
+
+texture_image_cache::texture_image_cache(const std::string& cache_directory)
+  : _directory(cache_directory)
+{
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(_directory, ec);
+    if (ec) {
+        glerr() << log::warning << "texture_image_cache::texture_image_cache(): "
+                << "unable to create cache directory: " << _directory << " (" << ec.message() << ")" << log::end;
+    }
+}
+
+texture_image_cache::~texture_image_cache()
+{
+}
+
+bool
+texture_image_cache::find(const std::string&     image_path,
+                          const std::string&     options,
+                          entry&                 out_entry) const
+{
+    const std::string   key        = entry_key(image_path, options);
+    const std::string   cache_path = entry_path(image_path, options);
+    uint64              file_size  = 0;
+    int64               file_time  = 0;
+    io::file            cache_file;
+
+    if (   !image_file_stamp(image_path, file_size, file_time)
+        || !boost::filesystem::exists(cache_path)
+        || !cache_file.open(cache_path, std::ios_base::in, false)) {
+        return false;
+    }
+
+    texture_cache_header hdr;
+    if (cache_file.read(&hdr, 0, sizeof(texture_cache_header)) != sizeof(texture_cache_header)) {
+        return false;
+    }
+
+    if (   memcmp(hdr._magic, texture_cache_magic, sizeof(texture_cache_magic)) != 0
+        || hdr._version     != texture_cache_version
+        || hdr._file_size   != file_size
+        || hdr._file_time   != file_time
+        || hdr._key_size    != key.size()
+        || hdr._key_size    >  max_key_size
+        || hdr._level_count == 0
+        || hdr._level_count >  max_level_count
+        || hdr._layers      == 0
+        || hdr._data_size   == 0
+        || static_cast<uint64>(cache_file.size()) != hdr._data_offset + hdr._data_size) {
+        return false;
+    }
+
+    // key and level table in one read
+    const io::size_type         table_size = hdr._level_count * sizeof(texture_cache_level);
+    const io::size_type         meta_size  = hdr._key_size + table_size;
+    std::vector<char>           meta(static_cast<size_t>(meta_size));
+
+    if (   static_cast<uint64>(sizeof(texture_cache_header) + meta_size) > hdr._data_offset
+        || cache_file.read(&meta.front(), sizeof(texture_cache_header), meta_size) != meta_size
+        || key.compare(0, key.size(), &meta.front(), hdr._key_size) != 0) {
+        return false;
+    }
+
+    std::vector<texture_cache_level>    levels(hdr._level_count);
+    memcpy(&levels.front(), &meta[hdr._key_size], static_cast<size_t>(table_size));
+
+    const data_format   format = static_cast<data_format>(hdr._format);
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const math::vec3ui  s(levels[l]._size[0], levels[l]._size[1], levels[l]._size[2]);
+        if (   levels[l]._size_bytes != level_byte_size(format, s, hdr._layers)
+            || levels[l]._offset + levels[l]._size_bytes > hdr._data_size) {
+            return false;
+        }
+    }
+
+    io::file_mapping_ptr mapping = cache_file.map(hdr._data_offset, hdr._data_size);
+    if (!mapping) {
+        return false;
+    }
+
+    char* base = const_cast<char*>(mapping->data());
+
+    out_entry._origin           = static_cast<texture_image_data::data_origin>(hdr._origin);
+    out_entry._format           = format;
+    out_entry._internal_format  = static_cast<data_format>(hdr._internal_format);
+    out_entry._layers           = hdr._layers;
+    out_entry._mapping          = mapping;
+    out_entry._level_sizes.clear();
+    out_entry._level_data.clear();
+
+    for (size_t l = 0; l < levels.size(); ++l) {
+        out_entry._level_sizes.push_back(math::vec3ui(levels[l]._size[0], levels[l]._size[1], levels[l]._size[2]));
+        out_entry._level_data.push_back(base + levels[l]._offset);
+    }
+
+    return true;
+}
+
+bool
+texture_image_cache::store(const std::string&                image_path,
+                           const std::string&                options,
+                           texture_image_data::data_origin   origin,
+                           data_format                       format,
+                           data_format                       internal_format,
+                           unsigned                          layers,
+                           const std::vector<math::vec3ui>&  level_sizes,
+                           const std::vector<void*>&         level_data) const
+{
+    const std::string   key        = entry_key(image_path, options);
+    const std::string   cache_path = entry_path(image_path, options);
+
+    if (   level_sizes.empty()
+        || level_sizes.size() != level_data.size()
+        || level_sizes.size() > max_level_count
+        || key.size() > max_key_size) {
+        return false;
+    }
+
+    texture_cache_header hdr;
+    memset(&hdr, 0, sizeof(texture_cache_header));
+    memcpy(hdr._magic, texture_cache_magic, sizeof(texture_cache_magic));
+
+    hdr._version            = texture_cache_version;
+    hdr._origin             = origin;
+    hdr._format             = format;
+    hdr._internal_format    = internal_format;
+    hdr._layers             = math::max(1u, layers);
+    hdr._level_count        = static_cast<uint32>(level_sizes.size());
+    hdr._key_size           = static_cast<uint32>(key.size());
+
+    if (!image_file_stamp(image_path, hdr._file_size, hdr._file_time)) {
+        return false;
+    }
+
+    std::vector<texture_cache_level>    levels(level_sizes.size());
+    for (size_t l = 0; l < levels.size(); ++l) {
+        memset(&levels[l], 0, sizeof(texture_cache_level));
+        levels[l]._size[0]      = level_sizes[l].x;
+        levels[l]._size[1]      = level_sizes[l].y;
+        levels[l]._size[2]      = level_sizes[l].z;
+        levels[l]._offset       = align_ceil(hdr._data_size, level_alignment);
+        levels[l]._size_bytes   = level_byte_size(format, level_sizes[l], hdr._layers);
+        hdr._data_size          = levels[l]._offset + levels[l]._size_bytes;
+    }
+
+    const io::size_type table_size = static_cast<io::size_type>(levels.size() * sizeof(texture_cache_level));
+    hdr._data_offset = align_ceil(sizeof(texture_cache_header) + key.size() + table_size, data_page_alignment);
+
+    // header, key and level table in one write
+    std::vector<char>   meta(sizeof(texture_cache_header) + key.size() + static_cast<size_t>(table_size));
+    memcpy(&meta.front(),                                            &hdr,             sizeof(texture_cache_header));
+    memcpy(&meta[sizeof(texture_cache_header)],                      key.data(),       key.size());
+    memcpy(&meta[sizeof(texture_cache_header) + key.size()],         &levels.front(),  static_cast<size_t>(table_size));
+
+    // write to a temporary file first, readers never see partial entries and
+    // concurrent writers of the same entry do not interfere
+    boost::system::error_code ec;
+    const std::string tmp_path = boost::filesystem::unique_path(cache_path + ".%%%%%%%%.tmp", ec).string();
+    if (ec) {
+        return false;
+    }
+
+    {
+        io::file    cache_file;
+        bool        write_ok = cache_file.open(tmp_path, std::ios_base::out | std::ios_base::trunc, false);
+
+        write_ok = write_ok && cache_file.write(&meta.front(), 0, meta.size()) == static_cast<io::size_type>(meta.size());
+        for (size_t l = 0; l < levels.size() && write_ok; ++l) {
+            const io::size_type s = static_cast<io::size_type>(levels[l]._size_bytes);
+            write_ok = cache_file.write(level_data[l], hdr._data_offset + levels[l]._offset, s) == s;
+        }
+        cache_file.close();
+
+        if (!write_ok) {
+            glerr() << log::warning << "texture_image_cache::store(): "
+                    << "unable to write cache entry: " << tmp_path << log::end;
+            boost::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+
+    boost::filesystem::rename(tmp_path, cache_path, ec);
+    if (ec) {
+        boost::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+texture_image_cache::store(const std::string&                image_path,
+                           const std::string&                options,
+                           const texture_image_data&         image) const
+{
+    std::vector<math::vec3ui>   level_sizes;
+    std::vector<void*>          level_data;
+
+    for (int l = 0; l < image.mip_level_count(); ++l) {
+        level_sizes.push_back(image.mip_level(l).size());
+        level_data.push_back(image.mip_level(l).data().get());
+    }
+
+    return store(image_path, options, image.origin(), image.format(), image.format(),
+                 static_cast<unsigned>(image.array_layers()), level_sizes, level_data);
+}
+
+const std::string&
+texture_image_cache::directory() const
+{
+    return _directory;
+}
+
+std::string
+texture_image_cache::entry_path(const std::string&   image_path,
+                                const std::string&   options) const
+{
+    std::ostringstream  name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key_hash(entry_key(image_path, options)) << ".scmtex";
+
+    return (boost::filesystem::path(_directory) / name.str()).string();
+}
+
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,124 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_TEXTURE_IMAGE_CACHE_H_INCLUDED
+#define SCM_GL_UTIL_TEXTURE_IMAGE_CACHE_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/memory.h>
+#include <scm/core/io/io_fwd.h>
+
+#include <scm/gl_core/data_formats.h>
+
+#include <scm/gl_util/data/imaging/imaging_fwd.h>
+#include <scm/gl_util/data/imaging/texture_image_data.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+// on-disk cache of processed texture images (<cache directory>/<key hash>.scmtex)
+// - an entry holds the final mip levels of an image (decoded, resampled and
+//   possibly block compressed) as they are uploaded, loads map the entry
+//   instead of decoding the image again
+// - entries are keyed by the absolute image path and an options string
+//   describing the processing, an entry is only valid for the image file with
+//   the recorded size and modification time
+// - layout: header, key string, level table, level data (starting page
+//   aligned, every level 16 byte aligned), all values are stored in the native
+//   byte order of the writing host, entries of the other byte order fail the
+//   version check and are treated as missing
+
+const char          texture_cache_magic[8]  = { 'S', 'C', 'M', 'T', 'E', 'X', 'C', '\0' };
+const scm::uint32   texture_cache_version   = 1u;
+
+struct texture_cache_header
+{
+    char            _magic[8];
+    scm::uint32     _version;
+    scm::uint32     _origin;                // texture_image_data::data_origin
+    scm::uint64     _file_size;             // size of the image file
+    scm::int64      _file_time;             // last write time of the image file
+    scm::uint32     _format;                // data format of the levels
+    scm::uint32     _internal_format;       // texture format the levels are uploaded to
+    scm::uint32     _layers;
+    scm::uint32     _level_count;
+    scm::uint32     _key_size;              // key string following the header
+    scm::uint32     _reserved;
+    scm::uint64     _data_offset;
+    scm::uint64     _data_size;
+}; // struct texture_cache_header
+
+struct texture_cache_level
+{
+    scm::uint32     _size[3];
+    scm::uint32     _reserved;
+    scm::uint64     _offset;                // relative to the data offset
+    scm::uint64     _size_bytes;
+}; // struct texture_cache_level
+
+class __scm_export(gl_util) texture_image_cache
+{
+public:
+    // a mapped cache entry, the level data stays valid as long as the entry
+    // (or a copy of its mapping) is held
+    struct __scm_export(gl_util) entry
+    {
+        entry();
+
+        // copy the levels out of the mapping
+        texture_image_data_ptr                  copy_image_data() const;
+
+        texture_image_data::data_origin         _origin;
+        data_format                             _format;
+        data_format                             _internal_format;
+        unsigned                                _layers;
+        std::vector<math::vec3ui>               _level_sizes;
+        std::vector<void*>                      _level_data;    // read-only
+        io::file_mapping_ptr                    _mapping;
+    }; // struct entry
+
+public:
+    // the directory is created if it does not exist
+    texture_image_cache(const std::string& cache_directory);
+    ~texture_image_cache();
+
+    bool                        find(const std::string&     image_path,
+                                     const std::string&     options,
+                                     entry&                 out_entry) const;
+
+    // level_data holds the layers of each level consecutively
+    bool                        store(const std::string&                image_path,
+                                      const std::string&                options,
+                                      texture_image_data::data_origin   origin,
+                                      data_format                       format,
+                                      data_format                       internal_format,
+                                      unsigned                          layers,
+                                      const std::vector<math::vec3ui>&  level_sizes,
+                                      const std::vector<void*>&         level_data) const;
+    bool                        store(const std::string&                image_path,
+                                      const std::string&                options,
+                                      const texture_image_data&         image) const;
+
+    const std::string&          directory() const;
+    std::string                 entry_path(const std::string&   image_path,
+                                           const std::string&   options) const;
+
+private:
+    std::string                 _directory;
+
+}; // class texture_image_cache
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_TEXTURE_IMAGE_CACHE_H_INCLUDED
@@ -77,9 +77,11 @@ texture_image_data::array_layers() const
 bool
 texture_image_data::flip_vertical()
 {
+    // the layers of array images follow each other like volume slices
     unsigned img_mip_count = mip_level_count();
     for (unsigned l = 0; l < img_mip_count; ++l) {
-        if (!util::volume_flip_vertical(mip_level(l).data(), format(), mip_level(l).size().x, mip_level(l).size().y, mip_level(l).size().z)) {
+        const math::vec3ui& lsize = mip_level(l).size();
+        if (!util::volume_flip_vertical(mip_level(l).data(), format(), lsize.x, lsize.y, lsize.z * array_layers())) {
             return false;
         }
     }
@@ -12,12 +12,15 @@
 
 #include <scm/core/math.h>
 #include <scm/core/memory.h>
+#include <scm/core/io/file_mapping.h>
 
 #include <scm/gl_core/data_formats.h>
 #include <scm/gl_core/log.h>
 #include <scm/gl_core/render_device.h>
 #include <scm/gl_core/texture_objects.h>
 
+#include <scm/gl_util/data/imaging/texture_data_util.h>
+#include <scm/gl_util/data/imaging/texture_image_cache.h>
 #include <scm/gl_util/data/imaging/texture_image_data.h>
 
 namespace scm {
@@ -28,38 +31,50 @@ void scale_colors(float r, float g, float b,
                   int w, int h, data_format format,
                   void* data)
 {
-    unsigned channels = channel_count(format);
-
-    if (   format == FORMAT_RGB_8
-        || format == FORMAT_RGBA_8) {
-        unsigned char* cdata = reinterpret_cast<unsigned char*>(data);
-        for (unsigned i = 0; i < (w * h * channels); i += channels) {
-            cdata[i]       = static_cast<unsigned char>(cdata[i]     * r);
-            cdata[i + 1]   = static_cast<unsigned char>(cdata[i + 1] * g);
-            cdata[i + 2]   = static_cast<unsigned char>(cdata[i + 2] * b);
-        }
-    }
-    if (   format == FORMAT_BGR_8
-        || format == FORMAT_BGRA_8) {
-        unsigned char* cdata = reinterpret_cast<unsigned char*>(data);
-        for (unsigned i = 0; i < (w * h * channels); i += channels) {
-            cdata[i]       = static_cast<unsigned char>(cdata[i]     * b);
-            cdata[i + 1]   = static_cast<unsigned char>(cdata[i + 1] * g);
-            cdata[i + 2]   = static_cast<unsigned char>(cdata[i + 2] * r);
-        }
+    switch (format) {
+        case FORMAT_RGB_8:
+        case FORMAT_RGBA_8:
+        case FORMAT_BGR_8:
+        case FORMAT_BGRA_8:
+        case FORMAT_RGB_32F:
+        case FORMAT_RGBA_32F:
+            util::scale_image_channels(math::vec2ui(w, h), format, reinterpret_cast<uint8*>(data),
+                                       math::vec4f(r, g, b, 1.0f));
+            break;
+        default:
+            break;
     }
-    if (   format == FORMAT_RGB_32F
-        || format == FORMAT_RGBA_32F) {
-        float* cdata = reinterpret_cast<float*>(data);
-        for (unsigned i = 0; i < (w * h * channels); i += channels) {
-            cdata[i]       = cdata[i]     * r;
-            cdata[i + 1]   = cdata[i + 1] * g;
-            cdata[i + 2]   = cdata[i + 2] * b;
-        }
+}
+
+void copy_image_lines(fipImage&            image,
+                      const math::vec2ui&  size,
+                      data_format          format,
+                      void*                data)
+{
+    const size_t line_pitch = image.getScanWidth();
+    const size_t line_size  = static_cast<size_t>(size.x) * size_of_format(format);
+
+    for (unsigned l = 0; l < size.y; ++l) {
+        const uint8* s =   reinterpret_cast<const uint8*>(image.accessPixels())
+                         + line_pitch * l;
+        uint8*       d =   reinterpret_cast<uint8*>(data)
+                         + line_size * l;
+        memcpy(d, s, line_size);
     }
 }
 
-std::pair<std::vector<void*>, std::vector<shared_array<unsigned char> > > get_data(const std::string&   in_image_path,
+typedef std::pair<std::vector<void*>, std::vector<shared_array<unsigned char> > > level_data;
+
+// keeps a cache entry mapped as long as the level arrays referencing it live
+struct mapping_reference
+{
+    explicit mapping_reference(const io::file_mapping_ptr& m) : _mapping(m) {}
+    void operator()(unsigned char*) const {}
+
+    io::file_mapping_ptr    _mapping;
+}; // struct mapping_reference
+
+level_data get_data(const std::string&   in_image_path,
                             bool                 in_create_mips,
                             bool                 in_color_mips,
                             const data_format    in_force_internal_format,
@@ -77,7 +92,6 @@ std::pair<std::vector<void*>, std::vector<shared_array<unsigned char> > > get_da
     }
 
     FREE_IMAGE_TYPE  image_type = in_image->getImageType();
-    unsigned         image_bit_count = in_image->getInfoHeader()->biBitCount;
     out_image_size = math::vec2ui(in_image->getWidth(), in_image->getHeight());
     //int             image_pitch     = in_image->getScanWidth();
     
@@ -117,87 +131,56 @@ std::pair<std::vector<void*>, std::vector<shared_array<unsigned char> > > get_da
         out_num_mipmaps = util::max_mip_levels(out_image_size);
     }
 
-    for (unsigned i = 0; i < out_num_mipmaps; ++i) {
-        scm::size_t  cur_data_size = 0;
+    // base level, the freeimage scan lines are padded, bgr(a) lines are kept
+    // and uploaded as such (the driver swizzles them into the rgb(a) texture)
+    {
+        scm::size_t  cur_data_size =   out_image_size.x * out_image_size.y;
+        cur_data_size *=  channel_count(out_image_format);
+        cur_data_size *=  size_of_channel(out_image_format);
+
+        scm::shared_array<unsigned char> cur_data(new unsigned char[cur_data_size]);
+
+        copy_image_lines(*in_image, out_image_size, out_image_format, cur_data.get());
+
+        image_mip_data.push_back(cur_data);
+        image_mip_data_raw.push_back(cur_data.get());
+    }
+
+    // every level is resampled from the next finer one by the parallel pyramid builder
+    for (unsigned i = 1; i < out_num_mipmaps; ++i) {
+        math::vec2ui src_size = util::mip_level_dimensions(out_image_size, i - 1);
         math::vec2ui lev_size = util::mip_level_dimensions(out_image_size, i);
 
-        if (i == 0) {
-            lev_size      = out_image_size;
-            cur_data_size =   out_image_size.x * out_image_size.y;
-            cur_data_size *=  channel_count(out_image_format);
-            cur_data_size *=  size_of_channel(out_image_format);
-        }
-        else {
-            cur_data_size =   lev_size.x * lev_size.y;
-            cur_data_size *=  channel_count(out_image_format);
-            cur_data_size *=  size_of_channel(out_image_format);
-
-            if (FALSE == in_image->rescale(lev_size.x, lev_size.y, FILTER_LANCZOS3)) {
-                glerr() << log::error << "texture_loader::load_texture_2d(): "
-                        << "unable to scale image (level: " << i << ", dim: " << lev_size << ")" << log::end;
-                return {};
-            }
-            //image_pitch     = in_image->getScanWidth();
-    
-            ////glout() << log::info << "bitcount " << image_bit_count << " scan width " << static_cast<float>(image_pitch) / 3;
-
-            ////std::stringstream ofn;
-            ////ofn << in_image_path << "_" << i << ".png";
-            ////in_image->save(ofn.str().c_str());
-
-            if (in_image->getWidth() != lev_size.x || in_image->getHeight() != lev_size.y) {
-                glerr() << log::error << "texture_loader::load_texture_2d(): "
-                        << "image dimensions changed after resamling (level: " << i
-                        << ", dim: " << lev_size 
-                        << ", type: " << std::hex << in_image->getImageType() << ")" << log::end;
-                return {};
-            }
-            if (in_image->getInfoHeader()->biBitCount != image_bit_count) {
-                glerr() << log::error << "texture_loader::load_texture_2d(): "
-                        << "image bitcount changed after resamling (level: " << i
-                        << ", bit_count: " << image_bit_count 
-                        << ", img_bit_count: " << in_image->getInfoHeader()->biBitCount << ")" << log::end;
-                return {};
-            }
-            if (image_type != in_image->getImageType()) {
-                glerr() << log::error << "texture_loader::load_texture_2d(): "
-                        << "image type changed after resamling (level: " << i
-                        << ", dim: " << lev_size 
-                        << ", type: " << std::hex << in_image->getImageType() << ")" << log::end;
-                return {};
-            }
-        }
+        scm::size_t  cur_data_size =   lev_size.x * lev_size.y;
+        cur_data_size *=  channel_count(out_image_format);
+        cur_data_size *=  size_of_channel(out_image_format);
 
         scm::shared_array<unsigned char> cur_data(new unsigned char[cur_data_size]);
 
-        size_t line_pitch = in_image->getScanWidth();
-        for (unsigned l = 0; l < lev_size.y; ++l) {
-            size_t ls = static_cast<size_t>(lev_size.x) * size_of_format(out_image_format);
-            uint8* s =   reinterpret_cast<uint8*>(in_image->accessPixels())
-                       + line_pitch * l;
-            uint8* d =   reinterpret_cast<uint8*>(cur_data.get())
-                       + ls * l;
-            memcpy(d, s, ls);
-        }
-
-        //if (memcpy(cur_data.get(), in_image->accessPixels(), cur_data_size) != cur_data.get()) {
-        //    glerr() << log::error << "texture_loader::load_texture_2d(): "
-        //            << "unable to copy image data (level: " << i << ", size: " << cur_data_size << "byte)" << log::end;
-        //    return (texture_2d_ptr());
-        //}
-        if (0 != i && in_color_mips) {
-            if      (i % 6 == 1) scale_colors(1, 0, 0, lev_size.x, lev_size.y, out_image_format, cur_data.get());
-            else if (i % 6 == 2) scale_colors(0, 1, 0, lev_size.x, lev_size.y, out_image_format, cur_data.get());
-            else if (i % 6 == 3) scale_colors(0, 0, 1, lev_size.x, lev_size.y, out_image_format, cur_data.get());
-            else if (i % 6 == 4) scale_colors(1, 0, 1, lev_size.x, lev_size.y, out_image_format, cur_data.get());
-            else if (i % 6 == 5) scale_colors(0, 1, 1, lev_size.x, lev_size.y, out_image_format, cur_data.get());
-            else if (i % 6 == 0) scale_colors(1, 1, 0, lev_size.x, lev_size.y, out_image_format, cur_data.get());
+        if (!util::generate_image_mip_level(src_size, lev_size, out_image_format,
+                                            image_mip_data.back().get(), cur_data.get(), util::MIP_FILTER_LANCZOS3)) {
+            glerr() << log::error << "texture_loader::load_texture_2d(): "
+                    << "unable to scale image (level: " << i << ", dim: " << lev_size << ")" << log::end;
+            return {};
         }
 
         image_mip_data.push_back(cur_data);
         image_mip_data_raw.push_back(cur_data.get());
     }
 
+    // colored after building the chain, the levels are resampled from the uncolored data
+    for (unsigned i = 1; i < out_num_mipmaps && in_color_mips; ++i) {
+        math::vec2ui lev_size = util::mip_level_dimensions(out_image_size, i);
+        void*        cur_data = image_mip_data_raw[i];
+
+        if      (i % 6 == 1) scale_colors(1, 0, 0, lev_size.x, lev_size.y, out_image_format, cur_data);
+        else if (i % 6 == 2) scale_colors(0, 1, 0, lev_size.x, lev_size.y, out_image_format, cur_data);
+        else if (i % 6 == 3) scale_colors(0, 0, 1, lev_size.x, lev_size.y, out_image_format, cur_data);
+        else if (i % 6 == 4) scale_colors(1, 0, 1, lev_size.x, lev_size.y, out_image_format, cur_data);
+        else if (i % 6 == 5) scale_colors(0, 1, 1, lev_size.x, lev_size.y, out_image_format, cur_data);
+        else if (i % 6 == 0) scale_colors(1, 1, 0, lev_size.x, lev_size.y, out_image_format, cur_data);
+    }
+
     if (in_force_internal_format != FORMAT_NULL) {
         out_image_internal_format = in_force_internal_format;
     }
@@ -205,8 +188,139 @@ std::pair<std::vector<void*>, std::vector<shared_array<unsigned char> > > get_da
     return {image_mip_data_raw, image_mip_data};
 }
 
+// replace the levels by their block compressed versions
+bool compress_levels(const math::vec2ui&    image_size,
+                     data_format            image_format,
+                     data_format            compressed_format,
+                     level_data&            data)
+{
+    for (unsigned i = 0; i < data.first.size(); ++i) {
+        math::vec2ui lev_size = util::mip_level_dimensions(image_size, i);
+
+        scm::size_t  cur_data_size =   ((lev_size.x + 3) / 4) * ((lev_size.y + 3) / 4);
+        cur_data_size *=  compressed_block_size(compressed_format);
+
+        scm::shared_array<unsigned char> cur_data(new unsigned char[cur_data_size]);
+
+        if (!util::compress_image_blocks(lev_size, image_format, data.second[i].get(),
+                                         compressed_format, cur_data.get())) {
+            return false;
+        }
+
+        data.second[i] = cur_data;
+        data.first[i]  = cur_data.get();
+    }
+
+    return true;
+}
+
+std::string
+cache_options(const char*          kind,
+              bool                 create_mips,
+              bool                 color_mips,
+              bool                 compress,
+              const data_format    force_internal_format)
+{
+    std::ostringstream  o;
+    o << kind << " mips:" << create_mips << " color_mips:" << color_mips << " compress:" << compress
+      << " format:" << format_string(force_internal_format);
+    return o.str();
+}
+
+// the levels as uploaded, mapped from the cache or decoded and processed (and
+// then stored in the cache), compress replaces them by their block compressed
+// versions if the forced internal format allows it
+level_data
+get_processed_data(const texture_image_cache_ptr& cache,
+                   const std::string&   in_image_path,
+                   bool                 in_create_mips,
+                   bool                 in_color_mips,
+                   bool                 in_compress,
+                   const data_format    in_force_internal_format,
+                   math::vec2ui&        out_image_size,
+                   data_format&         out_image_format,
+                   data_format&         out_image_internal_format,
+                   unsigned&            out_num_mipmaps)
+{
+    std::string                 options;
+    texture_image_cache::entry  cached;
+
+    if (cache) {
+        options = cache_options("texture", in_create_mips, in_color_mips, in_compress, in_force_internal_format);
+
+        if (   cache->find(in_image_path, options, cached)
+            && cached._layers == 1
+            && cached._level_sizes.front().z == 1) {
+            out_image_size            = math::vec2ui(cached._level_sizes.front().x, cached._level_sizes.front().y);
+            out_image_format          = cached._format;
+            out_image_internal_format = cached._internal_format;
+            out_num_mipmaps           = static_cast<unsigned>(cached._level_sizes.size());
+
+            level_data data;
+            data.first = cached._level_data;
+            for (unsigned i = 0; i < data.first.size(); ++i) {
+                data.second.push_back(shared_array<unsigned char>(static_cast<unsigned char*>(data.first[i]),
+                                                                  mapping_reference(cached._mapping)));
+            }
+            return data;
+        }
+    }
+
+    level_data data(get_data(in_image_path, in_create_mips, in_color_mips,
+                             in_force_internal_format, out_image_size, out_image_format,
+                             out_image_internal_format, out_num_mipmaps));
+
+    if (data.first.empty()) {
+        return data;
+    }
+
+    // compressed on the cpu instead of by the driver, only the blocks are uploaded
+    if (   in_compress
+        && util::block_compression_supported(out_image_format, out_image_internal_format)) {
+        if (!compress_levels(out_image_size, out_image_format, out_image_internal_format, data)) {
+            glerr() << log::error << "texture_loader::load_texture_2d(): "
+                    << "unable to compress image (format: " << format_string(out_image_internal_format) << ")" << log::end;
+            return level_data();
+        }
+        out_image_format = out_image_internal_format;
+    }
+
+    if (cache) {
+        std::vector<math::vec3ui>   level_sizes;
+        for (unsigned i = 0; i < data.first.size(); ++i) {
+            level_sizes.push_back(math::vec3ui(util::mip_level_dimensions(out_image_size, i), 1));
+        }
+        cache->store(in_image_path, options, texture_image_data::ORIGIN_LOWER_LEFT,
+                     out_image_format, out_image_internal_format, 1, level_sizes, data.first);
+    }
+
+    return data;
+}
+
 } // namespace
 
+texture_loader::texture_loader()
+{
+}
+
+texture_loader::texture_loader(const std::string& in_cache_directory)
+{
+    if (!in_cache_directory.empty()) {
+        _cache.reset(new texture_image_cache(in_cache_directory));
+    }
+}
+
+texture_loader::texture_loader(const texture_image_cache_ptr& in_cache)
+  : _cache(in_cache)
+{
+}
+
+const texture_image_cache_ptr&
+texture_loader::cache() const
+{
+    return _cache;
+}
+
 texture_2d_ptr
 texture_loader::load_texture_2d(render_device&       in_device,
                                 const std::string&   in_image_path,
@@ -220,10 +334,14 @@ texture_loader::load_texture_2d(render_device&       in_device,
     data_format     internal_format = FORMAT_NULL;
     unsigned        num_mip_levels = 1;
 
-    auto data(get_data(in_image_path, in_create_mips, in_color_mips, 
-                       in_force_internal_format, image_size, image_format, 
-                       internal_format, num_mip_levels));
-    
+    auto data(get_processed_data(_cache, in_image_path, in_create_mips, in_color_mips, true,
+                                 in_force_internal_format, image_size, image_format,
+                                 internal_format, num_mip_levels));
+
+    if (data.first.empty()) {
+        return texture_2d_ptr();
+    }
+
     texture_2d_ptr new_tex = in_device.create_texture_2d(image_size, internal_format, num_mip_levels, 1, 1,
                                                          image_format, data.first);
 
@@ -262,12 +380,12 @@ texture_loader::load_texture_cube(render_device&       in_device,
 
     bool formats_match(true);
 
-    auto data_px(get_data(in_image_path_px, in_create_mips, in_color_mips, 
+    auto data_px(get_processed_data(_cache, in_image_path_px, in_create_mips, in_color_mips, false,
                           in_force_internal_format, image_size, image_format, 
                           internal_format, num_mip_levels));
 
 
-    auto data_nx(get_data(in_image_path_nx, in_create_mips, in_color_mips, 
+    auto data_nx(get_processed_data(_cache, in_image_path_nx, in_create_mips, in_color_mips, false,
                           in_force_internal_format, tmp_image_size, tmp_image_format, 
                           tmp_internal_format, tmp_num_mip_levels));
     if (tmp_image_size != image_size || tmp_image_format != image_format || tmp_internal_format != internal_format || tmp_num_mip_levels != num_mip_levels) {
@@ -275,7 +393,7 @@ texture_loader::load_texture_cube(render_device&       in_device,
     }
 
 
-    auto data_py(get_data(in_image_path_py, in_create_mips, in_color_mips, 
+    auto data_py(get_processed_data(_cache, in_image_path_py, in_create_mips, in_color_mips, false,
                           in_force_internal_format, tmp_image_size, tmp_image_format, 
                           tmp_internal_format, tmp_num_mip_levels));
     if (tmp_image_size != image_size || tmp_image_format != image_format || tmp_internal_format != internal_format || tmp_num_mip_levels != num_mip_levels) {
@@ -283,7 +401,7 @@ texture_loader::load_texture_cube(render_device&       in_device,
     }
 
 
-    auto data_ny(get_data(in_image_path_ny, in_create_mips, in_color_mips, 
+    auto data_ny(get_processed_data(_cache, in_image_path_ny, in_create_mips, in_color_mips, false,
                           in_force_internal_format, tmp_image_size, tmp_image_format, 
                           tmp_internal_format, tmp_num_mip_levels));
     if (tmp_image_size != image_size || tmp_image_format != image_format || tmp_internal_format != internal_format || tmp_num_mip_levels != num_mip_levels) {
@@ -291,7 +409,7 @@ texture_loader::load_texture_cube(render_device&       in_device,
     }
 
 
-    auto data_pz(get_data(in_image_path_pz, in_create_mips, in_color_mips, 
+    auto data_pz(get_processed_data(_cache, in_image_path_pz, in_create_mips, in_color_mips, false,
                           in_force_internal_format, tmp_image_size, tmp_image_format, 
                           tmp_internal_format, tmp_num_mip_levels));
     if (tmp_image_size != image_size || tmp_image_format != image_format || tmp_internal_format != internal_format || tmp_num_mip_levels != num_mip_levels) {
@@ -299,7 +417,7 @@ texture_loader::load_texture_cube(render_device&       in_device,
     }
 
 
-    auto data_nz(get_data(in_image_path_nz, in_create_mips, in_color_mips, 
+    auto data_nz(get_processed_data(_cache, in_image_path_nz, in_create_mips, in_color_mips, false,
                           in_force_internal_format, tmp_image_size, tmp_image_format, 
                           tmp_internal_format, tmp_num_mip_levels));
     if (tmp_image_size != image_size || tmp_image_format != image_format || tmp_internal_format != internal_format || tmp_num_mip_levels != num_mip_levels) {
@@ -428,8 +546,18 @@ texture_loader::load_texture_image(const render_device_ptr& in_device,
 }
 
 texture_image_data_ptr
-texture_loader::load_image_data(const std::string&  in_image_path)
+texture_loader::load_image_data(const std::string&  in_image_path,
+                                bool                in_create_mips)
 {
+    const std::string   cache_opts = _cache ? cache_options("image_data", in_create_mips, false, false, FORMAT_NULL) : std::string();
+
+    // the returned levels are owned (and may be modified) by the caller, they
+    // are copied out of the mapped entry
+    texture_image_cache::entry  cached;
+    if (_cache && _cache->find(in_image_path, cache_opts, cached)) {
+        return (cached.copy_image_data());
+    }
+
     scm::scoped_ptr<fipImage>   in_image(new fipImage);
 
     if (!in_image->load(in_image_path.c_str())) {
@@ -472,17 +600,34 @@ texture_loader::load_image_data(const std::string&  in_image_path)
     scm::size_t                 image_data_size = static_cast<size_t>(image_size.x) * image_size.y * size_of_format(image_format);
     scm::shared_array<uint8>    image_data(new uint8[image_data_size]);
 
-    if (memcpy(image_data.get(), in_image->accessPixels(), image_data_size) != image_data.get()) {
-        glerr() << log::error << "texture_loader::load_image_data(): "
-                << "unable to copy image data." << log::end;
-        return (texture_image_data_ptr());
-    }
+    copy_image_lines(*in_image, image_size, image_format, image_data.get());
 
     texture_image_data::level_vector    mip_vec;
     mip_vec.push_back(texture_image_data::level(math::vec3ui(image_size, 1), image_data));
 
+    const unsigned num_mip_levels = in_create_mips ? util::max_mip_levels(image_size) : 1;
+
+    for (unsigned i = 1; i < num_mip_levels; ++i) {
+        const math::vec2ui          src_size  = util::mip_level_dimensions(image_size, i - 1);
+        const math::vec2ui          lev_size  = util::mip_level_dimensions(image_size, i);
+        const scm::size_t           lev_bytes = static_cast<size_t>(lev_size.x) * lev_size.y * size_of_format(image_format);
+        scm::shared_array<uint8>    lev_data(new uint8[lev_bytes]);
+
+        if (!util::generate_image_mip_level(src_size, lev_size, image_format,
+                                            mip_vec.back().data().get(), lev_data.get(), util::MIP_FILTER_LANCZOS3)) {
+            glerr() << log::error << "texture_loader::load_image_data(): "
+                    << "unable to generate mip level (level: " << i << ", dim: " << lev_size << ")" << log::end;
+            return (texture_image_data_ptr());
+        }
+        mip_vec.push_back(texture_image_data::level(math::vec3ui(lev_size, 1), lev_data));
+    }
+
     texture_image_data_ptr ret_data(new texture_image_data(texture_image_data::ORIGIN_LOWER_LEFT, image_format, mip_vec));
-    
+
+    if (_cache) {
+        _cache->store(in_image_path, cache_opts, *ret_data);
+    }
+
     return (ret_data);
 }
 
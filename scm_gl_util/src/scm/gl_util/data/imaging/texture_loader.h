@@ -5,6 +5,8 @@
 #ifndef SCM_GL_UTIL_TEXTURE_LOADER_H_INCLUDED
 #define SCM_GL_UTIL_TEXTURE_LOADER_H_INCLUDED
 
+#include <string>
+
 #include <scm/core/math.h>
 #include <scm/core/numeric_types.h>
 #include <scm/core/memory.h>
@@ -22,11 +24,24 @@
 namespace scm {
 namespace gl {
 
+// - with a cache the processed images (decoded, resampled, compressed) are
+//   stored in the cache directory after the first load and later loads map
+//   them from there (see texture_image_cache), load_texture_image is not cached
 class __scm_export(gl_util) texture_loader
 {
 
 public:
+    texture_loader();
+    // an empty cache directory disables the cache
+    explicit texture_loader(const std::string&              in_cache_directory);
+    explicit texture_loader(const texture_image_cache_ptr&  in_cache);
+
+    const texture_image_cache_ptr&  cache() const;
 
+
+    // forcing FORMAT_BC1_RGBA, FORMAT_BC3_RGBA (or their srgb variants), FORMAT_BC4_R
+    // or FORMAT_BC5_RG compresses 8bit images on the cpu before the upload (see
+    // util::compress_image_blocks), other formats are converted by the driver
     texture_2d_ptr              load_texture_2d(render_device&       in_device,
                                                 const std::string&   in_image_path,
                                                 bool                 in_create_mips,
@@ -50,7 +65,11 @@ public:
                                                    const texture_region&    in_region,
                                                    const unsigned           in_level);
 
-    texture_image_data_ptr      load_image_data(const std::string&  in_image_path);
+    texture_image_data_ptr      load_image_data(const std::string&  in_image_path,
+                                                bool                in_create_mips = false);
+
+private:
+    texture_image_cache_ptr     _cache;
 
 }; // class texture_loader
 
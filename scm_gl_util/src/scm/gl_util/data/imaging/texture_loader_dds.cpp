@@ -8,6 +8,7 @@
 #include <exception>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <boost/static_assert.hpp>
 
@@ -15,6 +16,7 @@
 #include <scm/core/math.h>
 #include <scm/core/memory.h>
 #include <scm/core/io/file.h>
+#include <scm/core/io/file_mapping.h>
 
 #include <scm/gl_core/log.h>
 #include <scm/gl_core/render_device.h>
@@ -67,6 +69,11 @@
 #define DDSCAPS2_CUBEMAP_NEGATIVEZ  0x00008000
 #define DDSCAPS2_VOLUME             0x00200000
 
+//  DDS_HEADER.dwReserved1 tag of files storing the image data with lower-left
+//  origin (written by texture_loader_dds::save_image_data_dx9)
+#define SCM_DDS_ORIGIN_TAG_INDEX    8
+#define SCM_DDS_ORIGIN_LOWER_LEFT   SCM_MAKEFOURCC('S', 'C', 'M', 'L')
+
 namespace {
 
 enum D3DFORMAT
@@ -787,6 +794,154 @@ mip_level_size(const scm::math::vec3ui& lsize, scm::gl::data_format fmt)
     }
 }
 
+bool
+has_lower_left_origin(const dds_file& dds)
+{
+    return dds.dds_header()->dwReserved1[SCM_DDS_ORIGIN_TAG_INDEX] == SCM_DDS_ORIGIN_LOWER_LEFT;
+}
+
+// maps the image data of all layers and mip levels read-only into memory, the
+// image start pointers are returned layer major (as stored in the file), the
+// pointers are valid as long as the mapping is held
+scm::io::file_mapping_ptr
+map_image_data(const dds_file&             dds,
+               const scm::math::vec3ui&    img_size,
+               unsigned                    img_mip_count,
+               unsigned                    img_layer_count,
+               scm::gl::data_format        img_format,
+               std::vector<void*>&         img_data)
+{
+    using namespace scm;
+    using namespace scm::math;
+
+    std::vector<scm::size_t>    img_offsets;
+    scm::size_t                 map_size = 0;
+
+    for (unsigned a = 0; a < img_layer_count; ++a) {
+        vec3ui lsize = img_size;
+        for (unsigned l = 0; l < img_mip_count; ++l) {
+            img_offsets.push_back(map_size);
+            map_size += mip_level_size(lsize, img_format);
+
+            lsize.x = max(1u, lsize.x / 2);
+            lsize.y = max(1u, lsize.y / 2);
+            lsize.z = max(1u, lsize.z / 2);
+        }
+    }
+
+    if (map_size == 0 || map_size > dds.image_data_size()) {
+        return io::file_mapping_ptr();
+    }
+
+    io::file_mapping_ptr mapping = dds.file()->map(dds.image_data_offset(), map_size);
+
+    if (mapping) {
+        // the gl entry points take non-const pointers, the data is only read
+        char* base = const_cast<char*>(mapping->data());
+
+        img_data.clear();
+        for (scm::size_t i = 0; i < img_offsets.size(); ++i) {
+            img_data.push_back(base + img_offsets[i]);
+        }
+    }
+
+    return mapping;
+}
+
+// creates the texture straight from a mapping of the file without intermediate
+// copies, only possible for files already stored with lower-left origin
+scm::gl::texture_2d_ptr
+load_texture_2d_mapped(scm::gl::render_device&  in_device,
+                       const dds_file&          dds)
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    if (   !has_lower_left_origin(dds)
+        || !(dds.dds_header()->dwSurfaceFlags & DDSCAPS_TEXTURE)
+        ||  (dds.dds_header()->dwSurfaceFlags2 & DDSCAPS2_VOLUME)) {
+        return texture_2d_ptr();
+    }
+
+    data_format img_format = match_format(dds);
+    if (img_format == FORMAT_NULL) {
+        return texture_2d_ptr();
+    }
+
+    vec3ui   img_size           = retrieve_dimensions(dds);
+    unsigned img_mip_count      = retrieve_mipmap_count(dds);
+    unsigned img_layer_count    = retrieve_layer_count(dds);
+
+    std::vector<void*>      img_data;
+    io::file_mapping_ptr    mapping = map_image_data(dds, img_size, img_mip_count, img_layer_count, img_format, img_data);
+
+    if (!mapping) {
+        return texture_2d_ptr();
+    }
+
+    if (img_layer_count == 1) {
+        return in_device.create_texture_2d(vec2ui(img_size), img_format, img_mip_count, 1, 1, img_format, img_data);
+    }
+
+    // the layers of a mip level are not contiguous in the file, upload them one by one
+    texture_2d_ptr new_tex = in_device.create_texture_2d(vec2ui(img_size), img_format, img_mip_count, img_layer_count);
+
+    if (!new_tex) {
+        return texture_2d_ptr();
+    }
+
+    render_context_ptr context = in_device.main_context();
+
+    for (unsigned a = 0; a < img_layer_count; ++a) {
+        vec3ui lsize = img_size;
+        for (unsigned l = 0; l < img_mip_count; ++l) {
+            texture_region lregion(vec3ui(0u, 0u, a), vec3ui(lsize.x, lsize.y, 1u));
+
+            if (!context->update_sub_texture(new_tex, lregion, l, img_format, img_data[a * img_mip_count + l])) {
+                return texture_2d_ptr();
+            }
+
+            lsize.x = max(1u, lsize.x / 2);
+            lsize.y = max(1u, lsize.y / 2);
+        }
+    }
+
+    return new_tex;
+}
+
+scm::gl::texture_3d_ptr
+load_texture_3d_mapped(scm::gl::render_device&  in_device,
+                       const dds_file&          dds)
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    if (   !has_lower_left_origin(dds)
+        || !(dds.dds_header()->dwSurfaceFlags & DDSCAPS_TEXTURE)
+        || retrieve_layer_count(dds) != 1) {
+        return texture_3d_ptr();
+    }
+
+    data_format img_format = match_format(dds);
+    if (img_format == FORMAT_NULL) {
+        return texture_3d_ptr();
+    }
+
+    vec3ui   img_size           = retrieve_dimensions(dds);
+    unsigned img_mip_count      = retrieve_mipmap_count(dds);
+
+    std::vector<void*>      img_data;
+    io::file_mapping_ptr    mapping = map_image_data(dds, img_size, img_mip_count, 1, img_format, img_data);
+
+    if (!mapping) {
+        return texture_3d_ptr();
+    }
+
+    return in_device.create_texture_3d(img_size, img_format, img_mip_count, img_format, img_data);
+}
+
 } // namespace
 
 namespace scm {
@@ -876,24 +1031,34 @@ texture_loader_dds::load_image_data(const std::string& in_image_path) const
         }
     }
 
-    texture_image_data_ptr ret_img(new texture_image_data(texture_image_data::ORIGIN_UPPER_LEFT, img_format, img_layer_count, img_lev_data));
+    const bool             img_lower_left = has_lower_left_origin(raw_dds);
+    texture_image_data_ptr ret_img(new texture_image_data(img_lower_left ? texture_image_data::ORIGIN_LOWER_LEFT
+                                                                         : texture_image_data::ORIGIN_UPPER_LEFT,
+                                                          img_format, img_layer_count, img_lev_data));
     
-    // dds files use upper-left origin, we flip!
-    ret_img->flip_vertical();
+    // dds files use upper-left origin, we flip unless the file was stored flipped
+    if (!img_lower_left) {
+        ret_img->flip_vertical();
+    }
 
     return ret_img;
 }
 
 bool
 texture_loader_dds::save_image_data_dx9(const std::string&           in_image_path,
-                                        const texture_image_data_ptr in_img_data) const
+                                        const texture_image_data_ptr in_img_data,
+                                        bool                         in_lower_left_origin) const
 {
     using namespace scm;
     using namespace scm::gl;
     using namespace scm::io;
     using namespace scm::math;
 
-    if (in_img_data->origin() == texture_image_data::ORIGIN_LOWER_LEFT) {
+    const texture_image_data::data_origin   save_origin = in_lower_left_origin ? texture_image_data::ORIGIN_LOWER_LEFT
+                                                                               : texture_image_data::ORIGIN_UPPER_LEFT;
+    const bool                              save_flip   = in_img_data->origin() != save_origin;
+
+    if (save_flip) {
         if (!in_img_data->flip_vertical()) {
             glerr() << log::error
                     << "texture_loader_dds::save_image_data_dx9(): error flipping image data before save operation." << log::end;
@@ -966,6 +1131,7 @@ texture_loader_dds::save_image_data_dx9(const std::string&           in_image_pa
                                       | (in_img_data->mip_level_count() > 1 ? DDSCAPS_MIPMAP : 0)
                                       | (in_img_data->mip_level_count() > 1 ? DDSCAPS_COMPLEX : 0);
     dds9_header->dwSurfaceFlags2    = (in_img_data->mip_level(0).size().z > 1 ? DDSCAPS2_VOLUME : 0);
+    dds9_header->dwReserved1[SCM_DDS_ORIGIN_TAG_INDEX] = (in_lower_left_origin ? SCM_DDS_ORIGIN_LOWER_LEFT : 0);
 
     if (out_file->write(dds9_header.get(), dds_header_off, sizeof(DDS_HEADER)) != sizeof(DDS_HEADER)) {
         glerr() << log::error
@@ -992,7 +1158,7 @@ texture_loader_dds::save_image_data_dx9(const std::string&           in_image_pa
 
     out_file->close();
 
-    if (in_img_data->origin() == texture_image_data::ORIGIN_UPPER_LEFT) {
+    if (save_flip) {
         if (!in_img_data->flip_vertical()) {
             glerr() << log::error
                     << "texture_loader_dds::save_image_data_dx9(): error flipping image data after save operation." << log::end;
@@ -1008,6 +1174,17 @@ texture_2d_ptr
 texture_loader_dds::load_texture_2d(render_device&       in_device,
                                     const std::string&   in_image_path) const
 {
+    { // zero-copy path for files stored with lower-left origin
+        ::dds_file   raw_dds = ::dds_file(in_image_path);
+
+        if (raw_dds) {
+            texture_2d_ptr new_tex = load_texture_2d_mapped(in_device, raw_dds);
+            if (new_tex) {
+                return new_tex;
+            }
+        }
+    }
+
     texture_image_data_ptr img_data = load_image_data(in_image_path);
     if (!img_data) {
         glerr() << log::error
@@ -1042,6 +1219,17 @@ texture_3d_ptr
 texture_loader_dds::load_texture_3d(render_device&       in_device,
                                     const std::string&   in_image_path) const
 {
+    { // zero-copy path for files stored with lower-left origin
+        ::dds_file   raw_dds = ::dds_file(in_image_path);
+
+        if (raw_dds) {
+            texture_3d_ptr new_tex = load_texture_3d_mapped(in_device, raw_dds);
+            if (new_tex) {
+                return new_tex;
+            }
+        }
+    }
+
     texture_image_data_ptr img_data = load_image_data(in_image_path);
     if (!img_data) {
         glerr() << log::error
@@ -22,6 +22,12 @@
 namespace scm {
 namespace gl {
 
+// dds files store their image data with upper-left origin, the loaded image data
+// is flipped to the lower-left origin of OpenGL
+// - files saved with lower-left origin (see save_image_data_dx9) are tagged in the
+//   reserved header fields and not flipped on load, the texture functions upload
+//   their image data directly from a read-only mapping of the file
+// - other dds tools ignore the tag and show such files upside down
 class __scm_export(gl_util) texture_loader_dds
 {
 public:
@@ -32,7 +38,8 @@ public:
     texture_image_data_ptr      load_image_data(const std::string&  in_image_path) const;
 
     bool                        save_image_data_dx9(const std::string&           in_image_path,
-                                                    const texture_image_data_ptr in_img_data) const;
+                                                    const texture_image_data_ptr in_img_data,
+                                                    bool                         in_lower_left_origin = false) const;
 
 }; // class texture_loader_dds
 
@@ -0,0 +1,67 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_BRICKED_VOLUME_H_INCLUDED
+#define SCM_GL_UTIL_BRICKED_VOLUME_H_INCLUDED
+
+#include <vector>
+
+#include <scm/core/numeric_types.h>
+
+namespace scm {
+namespace gl {
+namespace data {
+
+// bricked multi-resolution volume (.bvol)
+// - every level of detail is split into cubic bricks of brick_size voxels,
+//   level 0 is the source volume, every further level halves the dimensions
+//   (rounded up, 2x2x2 box filter) until the level fits into a single brick
+// - bricks are stored with an apron of voxels from the neighboring bricks on
+//   all sides (clamped to the volume border), so every stored brick holds
+//   (brick_size + 2 * apron)^3 voxels and can be filtered without its neighbors
+// - every brick is stored contiguous and aligned to brick_alignment bytes,
+//   a brick at any level is fetched with a single read
+// - layout: header | level table | brick index | brick data ...
+//   bricks of a level are stored in x, y, z order, levels from fine to coarse
+
+const char          bricked_volume_magic[8]     = { 'S', 'C', 'M', 'B', 'V', 'O', 'L', '\0' };
+const scm::uint32   bricked_volume_version      = 1u;
+const scm::uint32   bricked_volume_alignment    = 4096u;
+
+struct bricked_volume_header
+{
+    char            _magic[8];
+    scm::uint32     _version;
+    scm::uint32     _data_format;           // scm::gl::data_format
+    scm::uint32     _bytes_per_voxel;
+    scm::uint32     _dimensions[3];         // level 0 dimensions
+    scm::uint32     _brick_size;            // inner brick size
+    scm::uint32     _apron;
+    scm::uint32     _level_count;
+    scm::uint32     _brick_alignment;
+    scm::uint64     _brick_count;           // bricks of all levels
+    scm::uint64     _index_offset;
+}; // struct bricked_volume_header
+
+struct bricked_volume_level
+{
+    scm::uint32     _dimensions[3];
+    scm::uint32     _brick_grid[3];
+    scm::uint64     _first_brick;           // index of the first brick of the level in the brick index
+}; // struct bricked_volume_level
+
+struct bricked_volume_brick
+{
+    scm::uint64     _offset;
+    scm::uint64     _size;
+}; // struct bricked_volume_brick
+
+typedef std::vector<bricked_volume_level>   bricked_volume_level_vec;
+typedef std::vector<bricked_volume_brick>   bricked_volume_brick_vec;
+
+} // namespace data
+} // namespace gl
+} // namespace scm
+
+#endif // SCM_GL_UTIL_BRICKED_VOLUME_H_INCLUDED
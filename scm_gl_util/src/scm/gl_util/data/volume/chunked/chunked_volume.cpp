@@ -0,0 +1,319 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "chunked_volume.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <boost/static_assert.hpp>
+
+namespace {
+
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::chunked_volume_header) == 64);
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::chunked_volume_chunk)  == 16);
+
+// lz77 parameters
+const scm::size_t   lz_min_match        = 4;
+const scm::size_t   lz_max_offset       = 65535;
+const int           lz_hash_bits        = 14;
+
+inline scm::uint32
+read_u32(const scm::uint8* p)
+{
+    scm::uint32 v;
+    std::memcpy(&v, p, sizeof(v));
+    return (v);
+}
+
+inline scm::uint32
+lz_hash(scm::uint32 v)
+{
+    return ((v * 2654435761u) >> (32 - lz_hash_bits));
+}
+
+inline void
+lz_write_length(std::vector<scm::uint8>& dst, scm::size_t len)
+{
+    // lengths >= 15 continue in extra bytes
+    while (len >= 255) {
+        dst.push_back(255);
+        len -= 255;
+    }
+    dst.push_back(static_cast<scm::uint8>(len));
+}
+
+void
+lz_write_sequence(std::vector<scm::uint8>&  dst,
+                  const scm::uint8*         literals,
+                  scm::size_t               literal_count,
+                  scm::size_t               match_offset,
+                  scm::size_t               match_length)
+{
+    // token: literal count (high nibble), match length - min match (low nibble)
+    const scm::size_t ml = match_length > 0 ? match_length - lz_min_match : 0;
+
+    dst.push_back(static_cast<scm::uint8>(  ((literal_count >= 15 ? 15 : literal_count) << 4)
+                                          |  (ml >= 15 ? 15 : ml)));
+    if (literal_count >= 15) {
+        lz_write_length(dst, literal_count - 15);
+    }
+    dst.insert(dst.end(), literals, literals + literal_count);
+
+    if (match_length > 0) {
+        dst.push_back(static_cast<scm::uint8>(match_offset & 0xff));
+        dst.push_back(static_cast<scm::uint8>(match_offset >> 8));
+        if (ml >= 15) {
+            lz_write_length(dst, ml - 15);
+        }
+    }
+}
+
+void
+lz_compress(const scm::uint8*           src,
+            scm::size_t                 src_size,
+            std::vector<scm::uint8>&    dst)
+{
+    std::vector<scm::uint32>    hash_table(1u << lz_hash_bits, 0u); // position + 1, 0 = empty
+
+    scm::size_t ip      = 0;
+    scm::size_t anchor  = 0;
+
+    while (ip + lz_min_match <= src_size) {
+        const scm::uint32   seq = read_u32(src + ip);
+        const scm::uint32   h   = lz_hash(seq);
+        const scm::size_t   ref = hash_table[h];
+
+        hash_table[h] = static_cast<scm::uint32>(ip + 1);
+
+        if (   ref > 0
+            && ip - (ref - 1) <= lz_max_offset
+            && read_u32(src + ref - 1) == seq) {
+
+            const scm::size_t   match = ref - 1;
+            scm::size_t         len   = lz_min_match;
+            while (ip + len < src_size && src[match + len] == src[ip + len]) {
+                ++len;
+            }
+
+            lz_write_sequence(dst, src + anchor, ip - anchor, ip - match, len);
+
+            ip     += len;
+            anchor  = ip;
+        }
+        else {
+            ++ip;
+        }
+    }
+
+    // trailing literals, the sequence without a match marks the end of the stream
+    lz_write_sequence(dst, src + anchor, src_size - anchor, 0, 0);
+}
+
+bool
+lz_read_length(const scm::uint8*& ip, const scm::uint8* ip_end, scm::size_t& len)
+{
+    scm::uint8 b = 0;
+    do {
+        if (ip >= ip_end) {
+            return (false);
+        }
+        b    = *ip++;
+        len += b;
+    } while (b == 255);
+
+    return (true);
+}
+
+bool
+lz_decompress(const scm::uint8*     src,
+              scm::size_t           src_size,
+              scm::uint8*           dst,
+              scm::size_t           dst_size)
+{
+    const scm::uint8*   ip      = src;
+    const scm::uint8*   ip_end  = src + src_size;
+    scm::uint8*         op      = dst;
+    scm::uint8*         op_end  = dst + dst_size;
+
+    while (ip < ip_end) {
+        const scm::uint8    token = *ip++;
+
+        scm::size_t literal_count = token >> 4;
+        if (literal_count == 15 && !lz_read_length(ip, ip_end, literal_count)) {
+            return (false);
+        }
+        if (   literal_count > static_cast<scm::size_t>(ip_end - ip)
+            || literal_count > static_cast<scm::size_t>(op_end - op)) {
+            return (false);
+        }
+        std::memcpy(op, ip, literal_count);
+        op += literal_count;
+        ip += literal_count;
+
+        if (ip == ip_end) {
+            // last sequence
+            break;
+        }
+
+        if (ip_end - ip < 2) {
+            return (false);
+        }
+        const scm::size_t offset = static_cast<scm::size_t>(ip[0]) | (static_cast<scm::size_t>(ip[1]) << 8);
+        ip += 2;
+
+        scm::size_t match_length = token & 0x0f;
+        if (match_length == 15 && !lz_read_length(ip, ip_end, match_length)) {
+            return (false);
+        }
+        match_length += lz_min_match;
+
+        if (   offset == 0
+            || offset > static_cast<scm::size_t>(op - dst)
+            || match_length > static_cast<scm::size_t>(op_end - op)) {
+            return (false);
+        }
+
+        // matches may overlap their source, copy byte wise
+        const scm::uint8* match = op - offset;
+        for (scm::size_t i = 0; i < match_length; ++i) {
+            op[i] = match[i];
+        }
+        op += match_length;
+    }
+
+    return (op == op_end);
+}
+
+void
+shuffle_delta_encode(const scm::uint8*  src,
+                     scm::size_t        src_size,
+                     scm::size_t        element_size,
+                     scm::uint8*        dst)
+{
+    // group the n-th byte of all elements together, differences of neighboring
+    // bytes in a plane are small for smooth data and compress much better
+    const scm::size_t element_count = src_size / element_size;
+
+    for (scm::size_t b = 0; b < element_size; ++b) {
+        scm::uint8* plane = dst + b * element_count;
+        scm::uint8  prev  = 0;
+        for (scm::size_t e = 0; e < element_count; ++e) {
+            const scm::uint8 v = src[e * element_size + b];
+            plane[e] = static_cast<scm::uint8>(v - prev);
+            prev     = v;
+        }
+    }
+    // bytes not forming a full element are passed through
+    std::memcpy(dst + element_count * element_size,
+                src + element_count * element_size,
+                src_size - element_count * element_size);
+}
+
+void
+shuffle_delta_decode(const scm::uint8*  src,
+                     scm::size_t        src_size,
+                     scm::size_t        element_size,
+                     scm::uint8*        dst)
+{
+    const scm::size_t element_count = src_size / element_size;
+
+    for (scm::size_t b = 0; b < element_size; ++b) {
+        const scm::uint8* plane = src + b * element_count;
+        scm::uint8        prev  = 0;
+        for (scm::size_t e = 0; e < element_count; ++e) {
+            prev = static_cast<scm::uint8>(prev + plane[e]);
+            dst[e * element_size + b] = prev;
+        }
+    }
+    std::memcpy(dst + element_count * element_size,
+                src + element_count * element_size,
+                src_size - element_count * element_size);
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace data {
+
+chunk_codec
+compress_chunk(const scm::uint8*        src,
+               scm::size_t              src_size,
+               scm::size_t              element_size,
+               chunk_codec              codec,
+               std::vector<scm::uint8>& dst)
+{
+    dst.clear();
+
+    if (element_size == 0) {
+        element_size = 1;
+    }
+
+    switch (codec) {
+        case CHUNK_CODEC_LZ:
+            dst.reserve(src_size + src_size / 255 + 16);
+            lz_compress(src, src_size, dst);
+            break;
+        case CHUNK_CODEC_SHUFFLE_DELTA_LZ: {
+                std::vector<scm::uint8> shuffled(src_size);
+                if (src_size > 0) {
+                    shuffle_delta_encode(src, src_size, element_size, &shuffled.front());
+                }
+                dst.reserve(src_size + src_size / 255 + 16);
+                lz_compress(shuffled.empty() ? 0 : &shuffled.front(), src_size, dst);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (codec == CHUNK_CODEC_NONE || dst.size() >= src_size) {
+        dst.assign(src, src + src_size);
+        return (CHUNK_CODEC_NONE);
+    }
+
+    return (codec);
+}
+
+bool
+decompress_chunk(const scm::uint8*          src,
+                 scm::size_t                src_size,
+                 scm::size_t                element_size,
+                 chunk_codec                codec,
+                 scm::uint8*                dst,
+                 scm::size_t                dst_size,
+                 std::vector<scm::uint8>&   scratch)
+{
+    if (element_size == 0) {
+        element_size = 1;
+    }
+
+    switch (codec) {
+        case CHUNK_CODEC_NONE:
+            if (src_size != dst_size) {
+                return (false);
+            }
+            std::memcpy(dst, src, dst_size);
+            return (true);
+        case CHUNK_CODEC_LZ:
+            return (lz_decompress(src, src_size, dst, dst_size));
+        case CHUNK_CODEC_SHUFFLE_DELTA_LZ:
+            scratch.resize(dst_size);
+            if (dst_size == 0) {
+                return (src_size == 1);
+            }
+            if (!lz_decompress(src, src_size, &scratch.front(), dst_size)) {
+                return (false);
+            }
+            shuffle_delta_decode(&scratch.front(), dst_size, element_size, dst);
+            return (true);
+        default:
+            return (false);
+    }
+}
+
+} // namespace data
+} // namespace gl
+} // namespace scm
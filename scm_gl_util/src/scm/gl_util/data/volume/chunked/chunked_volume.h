@@ -0,0 +1,79 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_CHUNKED_VOLUME_H_INCLUDED
+#define SCM_GL_UTIL_CHUNKED_VOLUME_H_INCLUDED
+
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+
+namespace scm {
+namespace gl {
+namespace data {
+
+// chunked volume container (.cvol)
+// - the volume is split into fixed size 3d chunks (x fastest, then y and z),
+//   chunks at the upper volume borders are stored cropped to the volume
+// - every chunk is compressed on its own, so single chunks can be decoded
+//   without touching the rest of the file
+// - layout: header | chunk data ... | chunk table (one entry per chunk)
+// - all values (header, table and voxel data) are stored in the native byte
+//   order of the writing host, readers reject files of the other byte order
+//   (the version field reads byte swapped)
+
+const char          chunked_volume_magic[8]     = { 'S', 'C', 'M', 'C', 'V', 'O', 'L', '\0' };
+const scm::uint32   chunked_volume_version      = 1u;
+
+enum chunk_codec {
+    CHUNK_CODEC_NONE                = 0,    // uncompressed
+    CHUNK_CODEC_LZ                  = 1,    // lz77 (lz4 style byte aligned sequences)
+    CHUNK_CODEC_SHUFFLE_DELTA_LZ    = 2     // byte shuffle, per byte plane delta, lz77
+};
+
+struct chunked_volume_header
+{
+    char            _magic[8];
+    scm::uint32     _version;
+    scm::uint32     _data_format;           // scm::gl::data_format
+    scm::uint32     _bytes_per_voxel;
+    scm::uint32     _dimensions[3];
+    scm::uint32     _chunk_size[3];
+    scm::uint32     _codec;                 // codec requested on creation
+    scm::uint64     _chunk_count;
+    scm::uint64     _table_offset;
+}; // struct chunked_volume_header
+
+struct chunked_volume_chunk
+{
+    scm::uint64     _offset;
+    scm::uint32     _size;                  // compressed size in bytes
+    scm::uint32     _codec;                 // codec used for this chunk
+}; // struct chunked_volume_chunk
+
+typedef std::vector<chunked_volume_chunk>   chunked_volume_chunk_vec;
+
+// compress size bytes of voxel data (elements of element_size bytes), returns
+// the codec actually used, which falls back to none if compression does not pay off
+chunk_codec         compress_chunk(const scm::uint8*        src,
+                                   scm::size_t              src_size,
+                                   scm::size_t              element_size,
+                                   chunk_codec              codec,
+                                   std::vector<scm::uint8>& dst);
+
+// decompress into exactly dst_size bytes, returns false on corrupt data
+bool                decompress_chunk(const scm::uint8*          src,
+                                     scm::size_t                src_size,
+                                     scm::size_t                element_size,
+                                     chunk_codec                codec,
+                                     scm::uint8*                dst,
+                                     scm::size_t                dst_size,
+                                     std::vector<scm::uint8>&   scratch);
+
+} // namespace data
+} // namespace gl
+} // namespace scm
+
+#endif // SCM_GL_UTIL_CHUNKED_VOLUME_H_INCLUDED
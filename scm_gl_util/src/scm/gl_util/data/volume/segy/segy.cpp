@@ -212,7 +212,8 @@ segy_trace::~segy_trace()
     _header.reset();
 }
 
-segy_data::segy_data(const io::file_ptr& segy_file)
+segy_data::segy_data(const io::file_ptr& segy_file,
+                     bool                use_trace_index)
   : _swap_bytes_required(false)
   , _is_ebcdic(false)
   , _volume_size(math::vec3ui(0u))
@@ -303,7 +304,29 @@ segy_data::segy_data(const io::file_ptr& segy_file)
     scm::size_t     num_traces = (segy_file->size() - traces_start_offset) / trace_size;
     vec3ui          vdim       = vec3ui(0u);
 
-    { // read/parse traces
+    if (use_trace_index && trace_size > 0) { // survey grid from the trace index
+        const std::string   index_path = segy_trace_index::sidecar_path(segy_file->file_path());
+        shared_ptr<segy_trace_index> index = make_shared<segy_trace_index>();
+
+        if (!index->load(index_path, *segy_file, traces_start_offset, trace_size)) {
+            if (index->build(*segy_file, traces_start_offset, trace_size, _swap_bytes_required)) {
+                // failing to store the sidecar (e.g. read only location) only
+                // means the index is built again on the next open
+                index->save(index_path);
+            }
+            else {
+                index.reset();
+            }
+        }
+        if (index && index->grid_valid()) {
+            vdim.x       = _binary_header->_samples_per_trace;
+            vdim.y       = index->grid_dimensions().x;
+            vdim.z       = index->grid_dimensions().y;
+            _trace_index = index;
+        }
+    }
+
+    if (!_trace_index) { // read/parse traces
         io::offset_type next_trace_offset = traces_start_offset;
 
         segy_format     trace_fmt  = to_segy_format(_binary_header->_data_format);
@@ -392,6 +415,7 @@ segy_data::segy_data(const io::file_ptr& segy_file)
 
 segy_data::~segy_data()
 {
+    _trace_index.reset();
     _extended_text_headers.clear();
     _binary_header.reset();
     _text_header.reset();
@@ -14,6 +14,8 @@
 
 #include <scm/gl_core/data_formats.h>
 
+#include <scm/gl_util/data/volume/segy/segy_index.h>
+
 namespace scm {
 namespace gl {
 namespace data {
@@ -203,7 +205,13 @@ struct segy_data
     bool                        _swap_bytes_required;
     bool                        _is_ebcdic;
 
-    segy_data(const io::file_ptr& segy_file);
+    // survey grid of the traces, only set if the trace numbers form a valid grid
+    shared_ptr<segy_trace_index> _trace_index;
+
+    // the trace index is loaded from the sidecar next to the segy file or
+    // built and stored there if it is missing or outdated
+    segy_data(const io::file_ptr& segy_file,
+              bool                use_trace_index = true);
     ~segy_data();
 
     int                         size_of_format(segy_format d) const;
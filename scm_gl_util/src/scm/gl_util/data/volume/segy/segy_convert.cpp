@@ -0,0 +1,156 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "segy_convert.h"
+
+#include <cstring>
+
+#include <scm/core/math/common.h>
+#include <scm/core/platform/byte_swap.h>
+
+#if SCM_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+namespace {
+
+// branchless ibm to ieee conversion of a single (already byte swapped) value:
+// - the 24bit ibm fraction is normalized by converting it to an ieee float,
+//   which is exact for all 24bit integers, the float exponent then yields
+//   the normalization shift and the float mantissa the normalized fraction
+// - t = 4 * ibm exponent - 130 is the ieee exponent of the unnormalized fraction
+inline
+scm::uint32
+ibm_to_ieee(scm::uint32 v)
+{
+    const scm::uint32   sign    = v & 0x80000000u;
+    const scm::int32    fmant   = static_cast<scm::int32>(v & 0x00ffffffu);
+    const scm::int32    t       = static_cast<scm::int32>((v & 0x7f000000u) >> 22) - 130;
+
+    const float         f       = static_cast<float>(fmant);
+    scm::uint32         fb;
+    memcpy(&fb, &f, sizeof(float));
+
+    const scm::int32    tn      = t + static_cast<scm::int32>(fb >> 23) - 150;
+
+    const scm::uint32   res     = sign | (static_cast<scm::uint32>(tn) << 23) | (fb & 0x007fffffu);
+    const scm::uint32   ovf     = sign | 0x7f7fffffu;
+
+    return (fmant == 0 || tn <= 0) ? 0u : (tn > 254 ? ovf : res);
+}
+
+void
+swap_bytes_array_ibm_to_ieee_scalar(scm::uint32* d, const scm::uint32* s, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        scm::uint32 v = s[i];
+        scm::swap_bytes_4(&v, &v);
+        d[i] = ibm_to_ieee(v);
+    }
+}
+
+#if SCM_SIMD_X86
+
+SCM_SIMD_TARGET("sse4.1")
+void
+swap_bytes_array_ibm_to_ieee_sse41(scm::uint32* d, const scm::uint32* s, scm::size_t c)
+{
+    const __m128i   swap_mask   = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m128i   sign_mask   = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    const __m128i   fmant_mask  = _mm_set1_epi32(0x00ffffff);
+    const __m128i   exp_mask    = _mm_set1_epi32(0x7f000000);
+    const __m128i   mant_mask   = _mm_set1_epi32(0x007fffff);
+    const __m128i   flt_max     = _mm_set1_epi32(0x7f7fffff);
+    const __m128i   t_bias      = _mm_set1_epi32(130 + 150);
+    const __m128i   exp_max     = _mm_set1_epi32(254);
+    const __m128i   one         = _mm_set1_epi32(1);
+    const __m128i   zero        = _mm_setzero_si128();
+
+    const scm::size_t vec_count = c / 4;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        const __m128i v     = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 4 * i)), swap_mask);
+        const __m128i sign  = _mm_and_si128(v, sign_mask);
+        const __m128i fmant = _mm_and_si128(v, fmant_mask);
+        const __m128i fb    = _mm_castps_si128(_mm_cvtepi32_ps(fmant));
+        const __m128i tn    = _mm_sub_epi32(_mm_add_epi32(_mm_srli_epi32(_mm_and_si128(v, exp_mask), 22),
+                                                          _mm_srli_epi32(fb, 23)),
+                                            t_bias);
+
+        __m128i res = _mm_or_si128(_mm_or_si128(sign, _mm_slli_epi32(tn, 23)), _mm_and_si128(fb, mant_mask));
+        res = _mm_blendv_epi8(res, _mm_or_si128(sign, flt_max), _mm_cmpgt_epi32(tn, exp_max));
+        res = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(fmant, zero), _mm_cmplt_epi32(tn, one)), res);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 4 * i), res);
+    }
+
+    swap_bytes_array_ibm_to_ieee_scalar(d + 4 * vec_count, s + 4 * vec_count, c - 4 * vec_count);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+swap_bytes_array_ibm_to_ieee_avx2(scm::uint32* d, const scm::uint32* s, scm::size_t c)
+{
+    const __m256i   swap_mask   = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                   3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i   sign_mask   = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i   fmant_mask  = _mm256_set1_epi32(0x00ffffff);
+    const __m256i   exp_mask    = _mm256_set1_epi32(0x7f000000);
+    const __m256i   mant_mask   = _mm256_set1_epi32(0x007fffff);
+    const __m256i   flt_max     = _mm256_set1_epi32(0x7f7fffff);
+    const __m256i   t_bias      = _mm256_set1_epi32(130 + 150);
+    const __m256i   exp_max     = _mm256_set1_epi32(254);
+    const __m256i   one         = _mm256_set1_epi32(1);
+    const __m256i   zero        = _mm256_setzero_si256();
+
+    const scm::size_t vec_count = c / 8;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        const __m256i v     = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 8 * i)), swap_mask);
+        const __m256i sign  = _mm256_and_si256(v, sign_mask);
+        const __m256i fmant = _mm256_and_si256(v, fmant_mask);
+        const __m256i fb    = _mm256_castps_si256(_mm256_cvtepi32_ps(fmant));
+        const __m256i tn    = _mm256_sub_epi32(_mm256_add_epi32(_mm256_srli_epi32(_mm256_and_si256(v, exp_mask), 22),
+                                                                _mm256_srli_epi32(fb, 23)),
+                                               t_bias);
+
+        __m256i res = _mm256_or_si256(_mm256_or_si256(sign, _mm256_slli_epi32(tn, 23)), _mm256_and_si256(fb, mant_mask));
+        res = _mm256_blendv_epi8(res, _mm256_or_si256(sign, flt_max), _mm256_cmpgt_epi32(tn, exp_max));
+        res = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi32(fmant, zero), _mm256_cmpgt_epi32(one, tn)), res);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + 8 * i), res);
+    }
+
+    swap_bytes_array_ibm_to_ieee_scalar(d + 8 * vec_count, s + 8 * vec_count, c - 8 * vec_count);
+}
+
+#endif // SCM_SIMD_X86
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace data {
+
+void
+swap_bytes_array_ibm_to_ieee(float*              d,
+                             const float*        s,
+                             scm::size_t         c,
+                             cpu_simd_level      l)
+{
+    uint32*         d32 = reinterpret_cast<uint32*>(d);
+    const uint32*   s32 = reinterpret_cast<const uint32*>(s);
+
+    switch (math::min(l, cpu_supported_simd_level())) {
+#if SCM_SIMD_X86
+        case CPU_SIMD_AVX2:     swap_bytes_array_ibm_to_ieee_avx2(d32, s32, c);     break;
+        case CPU_SIMD_SSE4_1:   swap_bytes_array_ibm_to_ieee_sse41(d32, s32, c);    break;
+#endif // SCM_SIMD_X86
+        default:                swap_bytes_array_ibm_to_ieee_scalar(d32, s32, c);   break;
+    }
+}
+
+} // namespace data
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,33 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_SEGY_CONVERT_H_INCLUDED
+#define SCM_GL_UTIL_SEGY_CONVERT_H_INCLUDED
+
+#include <scm/core/numeric_types.h>
+#include <scm/core/platform/cpu_features.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+namespace data {
+
+// convert c big endian IBM single precision floats (SEGY format 1) from s to
+// IEEE floats in d, d and s may point to the same array
+// - results are identical for every simd level, values exceeding the IEEE
+//   range are clamped to +-FLT_MAX, values below are flushed to +0
+__scm_export(gl_util) void swap_bytes_array_ibm_to_ieee(float*              d,
+                                                        const float*        s,
+                                                        scm::size_t         c,
+                                                        cpu_simd_level      l = cpu_supported_simd_level());
+
+} // namespace data
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_SEGY_CONVERT_H_INCLUDED
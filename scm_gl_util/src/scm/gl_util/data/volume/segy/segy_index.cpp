@@ -0,0 +1,414 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "segy_index.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <scm/core/memory.h>
+#include <scm/core/io/file.h>
+#include <scm/core/platform/byte_swap.h>
+
+#include <scm/gl_util/utilities/parallel_for.h>
+#include <scm/gl_util/data/volume/segy/segy.h>
+
+namespace {
+
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::segy_index_header) == 80);
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::segy_index_entry)  == 8);
+
+// the inline and crossline numbers are consecutive in the trace header and
+// are read directly into the index entries
+const scm::size_t   inline_number_offset    = offsetof(scm::gl::data::segy_trace_header, _poststack_inline_num);
+BOOST_STATIC_ASSERT(   offsetof(scm::gl::data::segy_trace_header, _poststack_crline_num)
+                    == offsetof(scm::gl::data::segy_trace_header, _poststack_inline_num) + 4);
+
+const scm::size_t   traces_per_range        = 16384;
+
+// grids with more cells than this factor times the trace count are considered
+// garbage (e.g. uninitialized trace numbers)
+const scm::uint64   max_grid_sparsity       = 4;
+
+struct index_build_context
+{
+    typedef std::vector<scm::io::file_ptr>  file_vec;
+
+    file_vec                                _files;         // one per worker thread
+    scm::gl::data::segy_index_entry*        _entries;
+    scm::size_t                             _trace_count;
+    scm::io::offset_type                    _traces_start;
+    scm::size_t                             _trace_size;
+    bool                                    _swap_bytes;
+
+    boost::mutex                            _failed_mutex;
+    bool                                    _failed;
+}; // struct index_build_context
+
+void
+read_trace_range(index_build_context* ctx, scm::size_t range, scm::size_t thread_index)
+{
+    using namespace scm;
+
+    const size_t        t_begin = range * traces_per_range;
+    const size_t        t_end   = math::min(t_begin + traces_per_range, ctx->_trace_count);
+    io::file&           f       = *ctx->_files[thread_index];
+
+    io::file::read_extent_array extents;
+    extents.reserve(t_end - t_begin);
+
+    for (size_t t = t_begin; t < t_end; ++t) {
+        extents.push_back(io::file::read_extent(ctx->_traces_start + static_cast<io::offset_type>(t * ctx->_trace_size + inline_number_offset),
+                                                ctx->_entries + t,
+                                                sizeof(gl::data::segy_index_entry)));
+    }
+
+    if (f.read_batch(extents) != static_cast<io::size_type>(extents.size() * sizeof(gl::data::segy_index_entry))) {
+        boost::mutex::scoped_lock lock(ctx->_failed_mutex);
+        ctx->_failed = true;
+        return;
+    }
+
+    if (ctx->_swap_bytes) {
+        swap_bytes_array(reinterpret_cast<int32*>(ctx->_entries + t_begin), 2 * (t_end - t_begin));
+    }
+}
+
+scm::int64
+gcd(scm::int64 a, scm::int64 b)
+{
+    while (b != 0) {
+        const scm::int64 r = a % b;
+        a = b;
+        b = r;
+    }
+    return (a);
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace data {
+
+segy_trace_index::segy_trace_index()
+  : _grid_ordered(false)
+{
+    memset(&_header, 0, sizeof(segy_index_header));
+}
+
+segy_trace_index::~segy_trace_index()
+{
+}
+
+bool
+segy_trace_index::build(const io::file&       segy_file,
+                        io::offset_type       traces_start,
+                        scm::size_t           trace_size,
+                        bool                  swap_bytes)
+{
+    if (   !segy_file.is_open()
+        || trace_size == 0
+        || segy_file.size() <= traces_start) {
+        return (false);
+    }
+
+    const scm::size_t trace_count = static_cast<scm::size_t>((segy_file.size() - traces_start) / trace_size);
+    const scm::size_t range_count = (trace_count + traces_per_range - 1) / traces_per_range;
+
+    if (trace_count == 0) {
+        return (false);
+    }
+
+    _entries.resize(trace_count);
+
+    index_build_context ctx;
+    ctx._entries        = &_entries.front();
+    ctx._trace_count    = trace_count;
+    ctx._traces_start   = traces_start;
+    ctx._trace_size     = trace_size;
+    ctx._swap_bytes     = swap_bytes;
+    ctx._failed         = false;
+
+    // file cores are not thread safe, every worker reads through its own file
+    ctx._files.resize(util::parallel_worker_count(range_count));
+    for (scm::size_t i = 0; i < ctx._files.size(); ++i) {
+        ctx._files[i] = make_shared<io::file>();
+        if (!ctx._files[i]->open(segy_file.file_path(), std::ios_base::in, false)) {
+            _entries.clear();
+            return (false);
+        }
+    }
+
+    util::parallel_for(range_count, boost::bind(read_trace_range, &ctx, _1, _2));
+
+    for (scm::size_t i = 0; i < ctx._files.size(); ++i) {
+        ctx._files[i]->close();
+    }
+
+    if (ctx._failed) {
+        _entries.clear();
+        return (false);
+    }
+
+    memcpy(_header._magic, segy_index_magic, sizeof(segy_index_magic));
+    _header._version        = segy_index_version;
+    _header._file_size      = static_cast<scm::uint64>(segy_file.size());
+    _header._file_time      = file_time(segy_file.file_path());
+    _header._traces_start   = static_cast<scm::uint64>(traces_start);
+    _header._trace_size     = trace_size;
+    _header._trace_count    = trace_count;
+
+    build_grid();
+
+    return (true);
+}
+
+bool
+segy_trace_index::load(const std::string&     index_path,
+                       const io::file&        segy_file,
+                       io::offset_type        traces_start,
+                       scm::size_t            trace_size)
+{
+    io::file    index_file;
+
+    if (   !segy_file.is_open()
+        || trace_size == 0
+        || segy_file.size() <= traces_start
+        || !boost::filesystem::exists(index_path)
+        || !index_file.open(index_path, std::ios_base::in, false)) {
+        return (false);
+    }
+
+    segy_index_header hdr;
+    if (index_file.read(&hdr, 0, sizeof(segy_index_header)) != sizeof(segy_index_header)) {
+        return (false);
+    }
+
+    const scm::uint64 trace_count = static_cast<scm::uint64>((segy_file.size() - traces_start) / trace_size);
+    const io::size_type entries_size = static_cast<io::size_type>(trace_count * sizeof(segy_index_entry));
+
+    if (   memcmp(hdr._magic, segy_index_magic, sizeof(segy_index_magic)) != 0
+        || hdr._version      != segy_index_version
+        || hdr._file_size    != static_cast<scm::uint64>(segy_file.size())
+        || hdr._file_time    <  0
+        || hdr._file_time    != file_time(segy_file.file_path())
+        || hdr._traces_start != static_cast<scm::uint64>(traces_start)
+        || hdr._trace_size   != trace_size
+        || hdr._trace_count  != trace_count
+        || trace_count       == 0
+        || index_file.size() != static_cast<io::size_type>(sizeof(segy_index_header)) + entries_size) {
+        return (false);
+    }
+
+    _entries.resize(static_cast<scm::size_t>(trace_count));
+    if (index_file.read(&_entries.front(), sizeof(segy_index_header), entries_size) != entries_size) {
+        _entries.clear();
+        return (false);
+    }
+
+    _header = hdr;
+    build_grid();
+
+    return (true);
+}
+
+bool
+segy_trace_index::save(const std::string& index_path) const
+{
+    if (_entries.empty()) {
+        return (false);
+    }
+
+    // write to a temporary file first, readers never see partial sidecars
+    const std::string   tmp_path     = index_path + ".tmp";
+    const io::size_type entries_size = static_cast<io::size_type>(_entries.size() * sizeof(segy_index_entry));
+
+    {
+        io::file    index_file;
+
+        if (!index_file.open(tmp_path, std::ios_base::out | std::ios_base::trunc, false)) {
+            return (false);
+        }
+        if (   index_file.write(&_header, 0, sizeof(segy_index_header)) != sizeof(segy_index_header)
+            || index_file.write(&_entries.front(), sizeof(segy_index_header), entries_size) != entries_size) {
+            index_file.close();
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmp_path, ec);
+            return (false);
+        }
+        index_file.close();
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp_path, index_path, ec);
+    if (ec) {
+        boost::filesystem::remove(tmp_path, ec);
+        return (false);
+    }
+
+    return (true);
+}
+
+bool
+segy_trace_index::grid_valid() const
+{
+    return (_header._grid_valid != 0);
+}
+
+bool
+segy_trace_index::grid_ordered() const
+{
+    return (_grid_ordered);
+}
+
+const math::vec2ui
+segy_trace_index::grid_dimensions() const
+{
+    return (math::vec2ui(_header._crossline_count, _header._inline_count));
+}
+
+scm::int64
+segy_trace_index::cell_trace(unsigned crossline, unsigned inl) const
+{
+    assert(grid_valid());
+    assert(crossline < _header._crossline_count && inl < _header._inline_count);
+
+    return (_cells[crossline + static_cast<scm::size_t>(_header._crossline_count) * inl]);
+}
+
+const segy_index_header&
+segy_trace_index::header() const
+{
+    return (_header);
+}
+
+const segy_trace_index::entry_vec&
+segy_trace_index::entries() const
+{
+    return (_entries);
+}
+
+std::string
+segy_trace_index::sidecar_path(const std::string& segy_file_path)
+{
+    return (segy_file_path + ".scmidx");
+}
+
+void
+segy_trace_index::build_grid()
+{
+    using namespace scm::math;
+
+    _header._grid_valid = 0;
+    _grid_ordered       = false;
+    _cells.clear();
+
+    if (_entries.empty()) {
+        return;
+    }
+
+    // value ranges and the common spacing of the trace numbers
+    int32 il_min = _entries.front()._inline;
+    int32 il_max = il_min;
+    int32 xl_min = _entries.front()._crossline;
+    int32 xl_max = xl_min;
+
+    for (entry_vec::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+        il_min = min(il_min, e->_inline);
+        il_max = max(il_max, e->_inline);
+        xl_min = min(xl_min, e->_crossline);
+        xl_max = max(xl_max, e->_crossline);
+    }
+
+    // garbage trace numbers (e.g. wrong header byte locations) may span more
+    // than the int32 range, the steps and cell offsets have to fit the header
+    const int64 il_range = static_cast<int64>(il_max) - il_min;
+    const int64 xl_range = static_cast<int64>(xl_max) - xl_min;
+
+    if (   il_range > std::numeric_limits<int32>::max()
+        || xl_range > std::numeric_limits<int32>::max()) {
+        return;
+    }
+
+    int64 il_step = 0;
+    int64 xl_step = 0;
+    for (entry_vec::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+        il_step = gcd(il_step, static_cast<int64>(e->_inline)    - il_min);
+        xl_step = gcd(xl_step, static_cast<int64>(e->_crossline) - xl_min);
+    }
+    il_step = max<int64>(1, il_step);
+    xl_step = max<int64>(1, xl_step);
+
+    const uint64 il_count  = static_cast<uint64>(il_range / il_step) + 1;
+    const uint64 xl_count  = static_cast<uint64>(xl_range / xl_step) + 1;
+    const uint64 max_cells = max_grid_sparsity * _entries.size();
+
+    if (   il_count > max_cells
+        || xl_count > max_cells
+        || il_count * xl_count > max_cells
+        || il_count * xl_count < 2) {
+        return;
+    }
+
+    // keep the file orientation: the grid starts at the first trace
+    int32 il_first = il_min;
+    int32 xl_first = xl_min;
+    if (_entries.front()._inline == il_max && il_max != il_min) {
+        il_first = il_max;
+        il_step  = -il_step;
+    }
+    if (   _entries.size() > 1
+        && _entries[0]._inline    == _entries[1]._inline
+        && _entries[0]._crossline >  _entries[1]._crossline) {
+        xl_first = xl_max;
+        xl_step  = -xl_step;
+    }
+
+    _cells.assign(static_cast<size_t>(il_count * xl_count), -1);
+    _grid_ordered = (il_count * xl_count == _entries.size());
+
+    for (size_t t = 0; t < _entries.size(); ++t) {
+        const size_t il = static_cast<size_t>((static_cast<int64>(_entries[t]._inline)    - il_first) / il_step);
+        const size_t xl = static_cast<size_t>((static_cast<int64>(_entries[t]._crossline) - xl_first) / xl_step);
+        const size_t c  = xl + static_cast<size_t>(xl_count) * il;
+
+        if (_cells[c] >= 0) {
+            // duplicate trace numbers, no usable grid
+            _cells.clear();
+            _grid_ordered = false;
+            return;
+        }
+        _cells[c]     = static_cast<int64>(t);
+        _grid_ordered = _grid_ordered && (c == t);
+    }
+
+    _header._grid_valid         = 1;
+    _header._inline_first       = il_first;
+    _header._inline_step        = static_cast<int32>(il_step);
+    _header._inline_count       = static_cast<uint32>(il_count);
+    _header._crossline_first    = xl_first;
+    _header._crossline_step     = static_cast<int32>(xl_step);
+    _header._crossline_count    = static_cast<uint32>(xl_count);
+}
+
+scm::int64
+segy_trace_index::file_time(const std::string& file_path)
+{
+    boost::system::error_code ec;
+    const std::time_t t = boost::filesystem::last_write_time(file_path, ec);
+
+    return (ec ? -1 : static_cast<scm::int64>(t));
+}
+
+} // namespace data
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,112 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_SEGY_INDEX_H_INCLUDED
+#define SCM_GL_UTIL_SEGY_INDEX_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/io/io_fwd.h>
+
+namespace scm {
+namespace gl {
+namespace data {
+
+// segy trace index sidecar (<segy file>.scmidx)
+// - holds the inline/crossline numbers of all (fixed length) traces, the
+//   trace at index t is located at traces_start + t * trace_size
+// - the survey grid (inline/crossline ranges and steps) is derived from the
+//   trace numbers, traces are mapped to grid cells independent of their file
+//   order, missing traces leave empty cells
+// - the sidecar is only valid for the segy file with the recorded size and
+//   modification time, all values are stored in the native byte order of the
+//   writing host, sidecars of the other byte order fail the version check
+//   and are rebuilt
+
+const char          segy_index_magic[8]     = { 'S', 'C', 'M', 'S', 'G', 'Y', 'I', '\0' };
+const scm::uint32   segy_index_version      = 1u;
+
+struct segy_index_header
+{
+    char            _magic[8];
+    scm::uint32     _version;
+    scm::uint32     _grid_valid;            // trace numbers form a usable survey grid
+    scm::uint64     _file_size;
+    scm::int64      _file_time;             // last write time of the segy file
+    scm::uint64     _traces_start;
+    scm::uint64     _trace_size;
+    scm::uint64     _trace_count;
+    scm::int32      _inline_first;
+    scm::int32      _inline_step;
+    scm::uint32     _inline_count;
+    scm::int32      _crossline_first;
+    scm::int32      _crossline_step;
+    scm::uint32     _crossline_count;
+}; // struct segy_index_header
+
+struct segy_index_entry
+{
+    scm::int32      _inline;
+    scm::int32      _crossline;
+}; // struct segy_index_entry
+
+class segy_trace_index
+{
+public:
+    typedef std::vector<segy_index_entry>   entry_vec;
+    typedef std::vector<scm::int64>         cell_vec;
+
+public:
+    segy_trace_index();
+    ~segy_trace_index();
+
+    // read the inline/crossline numbers of all traces, ranges of traces are
+    // read in parallel, every worker thread uses its own file
+    bool                        build(const io::file&       segy_file,
+                                      io::offset_type       traces_start,
+                                      scm::size_t           trace_size,
+                                      bool                  swap_bytes);
+
+    // load a sidecar, fails if it does not match the segy file and trace layout
+    bool                        load(const std::string&     index_path,
+                                     const io::file&        segy_file,
+                                     io::offset_type        traces_start,
+                                     scm::size_t            trace_size);
+    bool                        save(const std::string&     index_path) const;
+
+    bool                        grid_valid() const;
+    // all grid cells are present and the traces are stored in grid order
+    // (crosslines within inlines)
+    bool                        grid_ordered() const;
+
+    // (crossline count, inline count)
+    const math::vec2ui          grid_dimensions() const;
+    // trace index for grid cell (crossline, inline), -1 for missing traces
+    scm::int64                  cell_trace(unsigned crossline, unsigned inl) const;
+
+    const segy_index_header&    header() const;
+    const entry_vec&            entries() const;
+
+    static std::string          sidecar_path(const std::string& segy_file_path);
+
+private:
+    void                        build_grid();
+    static scm::int64           file_time(const std::string& file_path);
+
+private:
+    segy_index_header           _header;
+    entry_vec                   _entries;
+    cell_vec                    _cells;
+    bool                        _grid_ordered;
+
+}; // class segy_trace_index
+
+} // namespace data
+} // namespace gl
+} // namespace scm
+
+#endif // SCM_GL_UTIL_SEGY_INDEX_H_INCLUDED
@@ -0,0 +1,479 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_brick_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/data/volume/volume_reader.h>
+
+namespace {
+
+bool
+stale_request(const scm::uint64 frame, const scm::uint64 request_frame)
+{
+    // requests survive the frame following the one they were made in
+    return request_frame + 1 < frame;
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+volume_brick_cache::statistics::statistics()
+  : _requests(0)
+  , _hits(0)
+  , _loads(0)
+  , _evictions(0)
+  , _dropped_requests(0)
+  , _failed_loads(0)
+{
+}
+
+volume_brick_cache::brick_slot::brick_slot()
+  : _brick(0)
+  , _last_request(0)
+  , _used(false)
+  , _loading(false)
+{
+}
+
+bool
+volume_brick_cache::load_request::operator<(const load_request& rhs) const
+{
+    return _priority < rhs._priority;
+}
+
+volume_brick_cache::volume_brick_cache(const volume_reader_ptr&    reader,
+                                       const math::vec3ui&         brick_dimensions,
+                                       const scm::size_t           memory_budget,
+                                       const unsigned              brick_border)
+  : _reader(reader)
+  , _volume_dimensions(0u)
+  , _volume_format(FORMAT_NULL)
+  , _brick_dimensions(math::max(brick_dimensions, math::vec3ui(1u)))
+  , _grid_dimensions(0u)
+  , _brick_border(brick_border)
+  , _slot_size(0)
+  , _frame(0)
+  , _loader_idle(true)
+  , _shutdown(false)
+{
+    using namespace scm::math;
+
+    if (!_reader || !(*_reader) || _reader->format() == FORMAT_NULL) {
+        glerr() << log::error
+                << "volume_brick_cache::volume_brick_cache(): invalid volume reader." << log::end;
+        return;
+    }
+
+    _volume_dimensions = _reader->dimensions();
+    _volume_format     = _reader->format();
+    _grid_dimensions   = (_volume_dimensions + _brick_dimensions - vec3ui(1u)) / _brick_dimensions;
+
+    const vec3ui sdim  = slot_dimensions();
+    _slot_size         = static_cast<scm::size_t>(sdim.x) * sdim.y * sdim.z * size_of_format(_volume_format);
+
+    if (memory_budget < _slot_size) {
+        glerr() << log::error
+                << "volume_brick_cache::volume_brick_cache(): memory budget too small for a single brick slot "
+                << "(budget: " << memory_budget << "B, slot size: " << _slot_size << "B)." << log::end;
+        return;
+    }
+
+    const scm::size_t slot_count = memory_budget / _slot_size;
+
+    _slot_memory.reset(new uint8[slot_count * _slot_size]);
+    _slots.resize(slot_count);
+    _free_slots.reserve(slot_count);
+    for (scm::int32 i = static_cast<scm::int32>(slot_count) - 1; i >= 0; --i) {
+        _free_slots.push_back(i);
+    }
+    _read_buffer.resize(_slot_size);
+
+    _loader_thread.reset(new boost::thread(boost::bind(&volume_brick_cache::loader_thread, this)));
+}
+
+volume_brick_cache::~volume_brick_cache()
+{
+    {
+        boost::mutex::scoped_lock   lock(_mutex);
+
+        _shutdown = true;
+        _requests.clear();
+        _request_pending.notify_all();
+    }
+    if (_loader_thread) {
+        _loader_thread->join();
+        _loader_thread.reset();
+    }
+}
+
+scm::int32
+volume_brick_cache::request(const math::vec3ui& brick,
+                            const float         priority)
+{
+    if (   _slots.empty()
+        || brick.x >= _grid_dimensions.x || brick.y >= _grid_dimensions.y || brick.z >= _grid_dimensions.z) {
+        return -1;
+    }
+
+    const scm::uint64           b = brick_index(brick);
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    ++_statistics._requests;
+
+    brick_map::const_iterator   s = _bricks.find(b);
+    if (s != _bricks.end()) {
+        brick_slot& slot = _slots[s->second];
+        slot._last_request = _frame;
+        if (slot._loading) {
+            return -1;
+        }
+        _lru.splice(_lru.end(), _lru, slot._lru_entry);
+        ++_statistics._hits;
+        return static_cast<scm::int32>(s->second);
+    }
+
+    load_request r;
+    r._priority = priority;
+    r._brick    = b;
+    r._frame    = _frame;
+    _requests.push_back(r);
+    std::push_heap(_requests.begin(), _requests.end());
+
+    _loader_idle = false;
+    _request_pending.notify_one();
+
+    return -1;
+}
+
+scm::int32
+volume_brick_cache::brick_slot_index(const math::vec3ui& brick) const
+{
+    if (brick.x >= _grid_dimensions.x || brick.y >= _grid_dimensions.y || brick.z >= _grid_dimensions.z) {
+        return -1;
+    }
+
+    boost::mutex::scoped_lock   lock(_mutex);
+    brick_map::const_iterator   s = _bricks.find(brick_index(brick));
+
+    if (s == _bricks.end() || _slots[s->second]._loading) {
+        return -1;
+    }
+    return static_cast<scm::int32>(s->second);
+}
+
+void
+volume_brick_cache::update()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    _loaded_bricks.swap(_completed);
+    _evicted_bricks.swap(_evicted);
+    _completed.clear();
+    _evicted.clear();
+
+    ++_frame;
+
+    // reported bricks are kept at least until the next update
+    for (std::size_t i = 0; i < _loaded_bricks.size(); ++i) {
+        brick_slot& slot = _slots[_loaded_bricks[i]._slot];
+        slot._last_request = _frame;
+        _lru.splice(_lru.end(), _lru, slot._lru_entry);
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < _requests.size(); ++i) {
+        if (!stale_request(_frame, _requests[i]._frame)) {
+            _requests[kept++] = _requests[i];
+        }
+    }
+    _statistics._dropped_requests += _requests.size() - kept;
+    _requests.resize(kept);
+    std::make_heap(_requests.begin(), _requests.end());
+
+    // slots of the last frame may be reused now
+    _loader_idle = false;
+    _request_pending.notify_one();
+}
+
+const std::vector<volume_brick_cache::resident_brick>&
+volume_brick_cache::loaded_bricks() const
+{
+    return _loaded_bricks;
+}
+
+const std::vector<math::vec3ui>&
+volume_brick_cache::evicted_bricks() const
+{
+    return _evicted_bricks;
+}
+
+void
+volume_brick_cache::wait_idle() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (!_loader_idle && _loader_thread) {
+        _request_done.wait(lock);
+    }
+}
+
+const uint8*
+volume_brick_cache::slot_data(const scm::uint32 slot) const
+{
+    return _slot_memory.get() + slot * _slot_size;
+}
+
+const math::vec3ui&
+volume_brick_cache::volume_dimensions() const
+{
+    return _volume_dimensions;
+}
+
+data_format
+volume_brick_cache::volume_format() const
+{
+    return _volume_format;
+}
+
+const math::vec3ui&
+volume_brick_cache::grid_dimensions() const
+{
+    return _grid_dimensions;
+}
+
+const math::vec3ui&
+volume_brick_cache::brick_dimensions() const
+{
+    return _brick_dimensions;
+}
+
+unsigned
+volume_brick_cache::brick_border() const
+{
+    return _brick_border;
+}
+
+const math::vec3ui
+volume_brick_cache::slot_dimensions() const
+{
+    return _brick_dimensions + math::vec3ui(2 * _brick_border);
+}
+
+scm::size_t
+volume_brick_cache::slot_size() const
+{
+    return _slot_size;
+}
+
+scm::uint32
+volume_brick_cache::slot_count() const
+{
+    return static_cast<scm::uint32>(_slots.size());
+}
+
+scm::uint32
+volume_brick_cache::resident_count() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return static_cast<scm::uint32>(_lru.size());
+}
+
+scm::uint64
+volume_brick_cache::frame() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return _frame;
+}
+
+volume_brick_cache::statistics
+volume_brick_cache::current_statistics() const
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    return _statistics;
+}
+
+scm::uint64
+volume_brick_cache::brick_index(const math::vec3ui& brick) const
+{
+    return (static_cast<scm::uint64>(brick.z) * _grid_dimensions.y + brick.y) * _grid_dimensions.x + brick.x;
+}
+
+const math::vec3ui
+volume_brick_cache::brick_coordinates(scm::uint64 index) const
+{
+    const scm::uint64 slice_bricks = static_cast<scm::uint64>(_grid_dimensions.x) * _grid_dimensions.y;
+
+    return math::vec3ui(static_cast<unsigned>(index % _grid_dimensions.x),
+                        static_cast<unsigned>((index % slice_bricks) / _grid_dimensions.x),
+                        static_cast<unsigned>(index / slice_bricks));
+}
+
+bool
+volume_brick_cache::pop_request(load_request& r)
+{
+    while (!_requests.empty()) {
+        std::pop_heap(_requests.begin(), _requests.end());
+        r = _requests.back();
+        _requests.pop_back();
+
+        if (stale_request(_frame, r._frame)) {
+            ++_statistics._dropped_requests;
+            continue;
+        }
+        if (_bricks.find(r._brick) != _bricks.end()) {
+            continue; // repeated request of a resident or loading brick
+        }
+        return true;
+    }
+    return false;
+}
+
+scm::int32
+volume_brick_cache::allocate_slot()
+{
+    if (!_free_slots.empty()) {
+        const scm::int32 s = _free_slots.back();
+        _free_slots.pop_back();
+        return s;
+    }
+
+    // bricks requested in this frame stay resident
+    if (_lru.empty() || _slots[_lru.front()]._last_request >= _frame) {
+        return -1;
+    }
+
+    const scm::uint32 s    = _lru.front();
+    brick_slot&       slot = _slots[s];
+
+    _lru.pop_front();
+    _bricks.erase(slot._brick);
+    _evicted.push_back(brick_coordinates(slot._brick));
+    slot._used = false;
+    ++_statistics._evictions;
+
+    return static_cast<scm::int32>(s);
+}
+
+bool
+volume_brick_cache::read_brick(scm::uint64 index, uint8* slot_memory)
+{
+    using namespace scm::math;
+
+    // the brick including its border clamped to the volume
+    const vec3i       vdim   = vec3i(_volume_dimensions);
+    const vec3i       sdim   = vec3i(slot_dimensions());
+    const vec3i       sorig  = vec3i(brick_coordinates(index) * _brick_dimensions) - vec3i(_brick_border);
+    const vec3i       rorig  = max(sorig, vec3i(0));
+    const vec3i       rend   = min(sorig + sdim, vdim);
+    const vec3i       rdim   = rend - rorig;
+    const scm::size_t vsize  = size_of_format(_volume_format);
+
+    if (!_reader->read(vec3ui(rorig), vec3ui(rdim), &_read_buffer.front())) {
+        return false;
+    }
+
+    // copy into the slot replicating the volume edge voxels into the border
+    const int x_first = rorig.x - sorig.x;              // slot voxels before the read region
+    const int x_last  = x_first + rdim.x;
+
+    for (int z = 0; z < sdim.z; ++z) {
+        const int rz = clamp(sorig.z + z, 0, vdim.z - 1) - rorig.z;
+        for (int y = 0; y < sdim.y; ++y) {
+            const int    ry  = clamp(sorig.y + y, 0, vdim.y - 1) - rorig.y;
+            const uint8* src = &_read_buffer.front() + ((static_cast<scm::size_t>(rz) * rdim.y + ry) * rdim.x) * vsize;
+            uint8*       dst = slot_memory + ((static_cast<scm::size_t>(z) * sdim.y + y) * sdim.x) * vsize;
+
+            for (int x = 0; x < x_first; ++x) {
+                memcpy(dst + x * vsize, src, vsize);
+            }
+            memcpy(dst + x_first * vsize, src, rdim.x * vsize);
+            for (int x = x_last; x < sdim.x; ++x) {
+                memcpy(dst + x * vsize, src + (rdim.x - 1) * vsize, vsize);
+            }
+        }
+    }
+
+    return true;
+}
+
+void
+volume_brick_cache::loader_thread()
+{
+    boost::mutex::scoped_lock   lock(_mutex);
+
+    while (!_shutdown) {
+        load_request    r;
+        scm::int32      s = -1;
+
+        if (pop_request(r)) {
+            s = allocate_slot();
+            if (s < 0) {
+                // all slots hold bricks of this frame, retry after the next update
+                _requests.push_back(r);
+                std::push_heap(_requests.begin(), _requests.end());
+            }
+        }
+        if (s < 0) {
+            _loader_idle = true;
+            _request_done.notify_all();
+            _request_pending.wait(lock);
+            continue;
+        }
+
+        brick_slot& slot = _slots[s];
+        slot._brick        = r._brick;
+        slot._last_request = r._frame;
+        slot._used         = true;
+        slot._loading      = true;
+        _bricks[r._brick]  = static_cast<scm::uint32>(s);
+
+        lock.unlock();
+        const bool read_ok = read_brick(r._brick, _slot_memory.get() + s * _slot_size);
+        lock.lock();
+
+        slot._loading = false;
+        if (read_ok) {
+            // unreported bricks are not evicted before the next update
+            slot._last_request = _frame;
+            slot._lru_entry    = _lru.insert(_lru.end(), static_cast<scm::uint32>(s));
+
+            resident_brick rb;
+            rb._brick = brick_coordinates(r._brick);
+            rb._slot  = static_cast<scm::uint32>(s);
+            _completed.push_back(rb);
+            ++_statistics._loads;
+        }
+        else {
+            if (_statistics._failed_loads == 0) {
+                glerr() << log::error
+                        << "volume_brick_cache::loader_thread(): unable to read brick ("
+                        << brick_coordinates(r._brick) << ")." << log::end;
+            }
+            _bricks.erase(r._brick);
+            slot._used = false;
+            _free_slots.push_back(static_cast<scm::uint32>(s));
+            ++_statistics._failed_loads;
+        }
+    }
+
+    _loader_idle = true;
+    _request_done.notify_all();
+}
+
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,186 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_BRICK_CACHE_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_BRICK_CACHE_H_INCLUDED
+
+#include <list>
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/math.h>
+#include <scm/core/memory.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/unordered_containers.h>
+
+#include <scm/gl_core/data_formats.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+class volume_reader;
+class volume_brick_cache;
+
+typedef shared_ptr<volume_reader>       volume_reader_ptr;
+typedef shared_ptr<volume_brick_cache>  volume_brick_cache_ptr;
+
+// host memory cache of the bricks of an out-of-core volume
+// - the volume is split into a regular grid of bricks, every brick is stored
+//   with brick_border voxels of its neighbors on each side (clamped to the
+//   volume edge) so an atlas of bricks can be filtered without seams
+// - the memory budget is split into fixed size slots, a brick occupies one
+//   slot from being loaded until it is evicted (least recently requested),
+//   a budget below one slot is an error and leaves the cache without slots
+//   (all requests fail)
+// - requests are loaded by priority (largest first) on a background thread,
+//   requests not repeated in the following frame are dropped
+// - update() marks the frame boundary and reports the bricks loaded and
+//   evicted since the last update (a brick may be evicted and loaded again
+//   within one frame, evictions are to be applied first), the renderer only
+//   uploads the loaded bricks to the atlas position of their slot
+// - slots of bricks requested in the current frame are never reused, slot
+//   data of reported bricks stays valid until the next update()
+class __scm_export(gl_util) volume_brick_cache : boost::noncopyable
+{
+public:
+    struct resident_brick
+    {
+        math::vec3ui            _brick;
+        scm::uint32             _slot;
+    }; // struct resident_brick
+
+    struct __scm_export(gl_util) statistics
+    {
+        statistics();
+
+        scm::uint64             _requests;
+        scm::uint64             _hits;
+        scm::uint64             _loads;
+        scm::uint64             _evictions;
+        scm::uint64             _dropped_requests;
+        scm::uint64             _failed_loads;
+    }; // struct statistics
+
+private:
+    typedef scm::unordered_map<scm::uint64, scm::uint32>    brick_map;
+    typedef std::list<scm::uint32>                          lru_list;
+
+    struct brick_slot
+    {
+        brick_slot();
+
+        scm::uint64             _brick;
+        scm::uint64             _last_request;      // frame of the last request
+        bool                    _used;
+        bool                    _loading;
+        lru_list::iterator      _lru_entry;         // valid for resident slots
+    }; // struct brick_slot
+
+    struct load_request
+    {
+        float                   _priority;
+        scm::uint64             _brick;
+        scm::uint64             _frame;
+
+        bool                    operator<(const load_request& rhs) const;
+    }; // struct load_request
+
+public:
+    // the reader is exclusively used by the loader thread from here on
+    volume_brick_cache(const volume_reader_ptr&    reader,
+                       const math::vec3ui&         brick_dimensions,
+                       const scm::size_t           memory_budget,
+                       const unsigned              brick_border = 1);
+    virtual ~volume_brick_cache();
+
+    // returns the slot of a resident brick (marking it used in this frame) or
+    // queues the brick for loading and returns -1
+    scm::int32                  request(const math::vec3ui& brick,
+                                        const float         priority);
+    // slot of a resident brick or -1, does not count as a request
+    scm::int32                  brick_slot_index(const math::vec3ui& brick) const;
+
+    void                        update();
+    const std::vector<resident_brick>&  loaded_bricks() const;
+    const std::vector<math::vec3ui>&    evicted_bricks() const;
+
+    // blocks until the loader thread runs out of requests it can serve
+    void                        wait_idle() const;
+
+    // slot data holds the tightly packed voxels of slot_dimensions() (x fastest)
+    const uint8*                slot_data(const scm::uint32 slot) const;
+
+    const math::vec3ui&         volume_dimensions() const;
+    data_format                 volume_format() const;
+    const math::vec3ui&         grid_dimensions() const;
+    const math::vec3ui&         brick_dimensions() const;
+    unsigned                    brick_border() const;
+    const math::vec3ui          slot_dimensions() const;
+    scm::size_t                 slot_size() const;
+    scm::uint32                 slot_count() const;
+    scm::uint32                 resident_count() const;
+    scm::uint64                 frame() const;
+
+    statistics                  current_statistics() const;
+
+private:
+    scm::uint64                 brick_index(const math::vec3ui& brick) const;
+    const math::vec3ui          brick_coordinates(scm::uint64 index) const;
+
+    bool                        pop_request(load_request& r);
+    scm::int32                  allocate_slot();
+    bool                        read_brick(scm::uint64 index, uint8* slot_memory);
+    void                        loader_thread();
+
+private:
+    volume_reader_ptr           _reader;
+    math::vec3ui                _volume_dimensions;
+    data_format                 _volume_format;
+    math::vec3ui                _brick_dimensions;
+    math::vec3ui                _grid_dimensions;
+    unsigned                    _brick_border;
+    scm::size_t                 _slot_size;
+
+    mutable boost::mutex        _mutex;
+    boost::condition_variable   _request_pending;
+    mutable boost::condition_variable   _request_done;
+
+    scm::scoped_array<uint8>    _slot_memory;
+    std::vector<brick_slot>     _slots;
+    std::vector<scm::uint32>    _free_slots;
+    lru_list                    _lru;               // resident slots, least recently requested first
+    brick_map                   _bricks;            // resident and loading bricks
+
+    std::vector<load_request>   _requests;          // max heap
+    scm::uint64                 _frame;
+    bool                        _loader_idle;
+    bool                        _shutdown;
+
+    std::vector<resident_brick> _completed;         // loaded since the last update
+    std::vector<math::vec3ui>   _evicted;           // evicted since the last update
+    std::vector<resident_brick> _loaded_bricks;
+    std::vector<math::vec3ui>   _evicted_bricks;
+
+    std::vector<uint8>          _read_buffer;
+    scm::shared_ptr<boost::thread>  _loader_thread;
+
+    statistics                  _statistics;
+
+}; // class volume_brick_cache
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_VOLUME_BRICK_CACHE_H_INCLUDED
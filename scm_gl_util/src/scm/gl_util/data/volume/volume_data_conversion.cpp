@@ -0,0 +1,454 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_data_conversion.h"
+
+#include <cstring>
+#include <vector>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/data/analysis/volume_statistics.h>
+#include <scm/gl_util/utilities/parallel_for.h>
+
+#if SCM_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+namespace {
+
+const scm::size_t   conversion_chunk_values = 1024 * 1024;
+const float         half_max                = 65504.0f;
+
+struct conversion_params
+{
+    float   _lo;
+    float   _hi;
+    float   _offset;
+    float   _factor;
+}; // struct conversion_params
+
+// float to half conversion with round to nearest even (matches the f16c
+// conversion for all non-NaN values)
+inline
+scm::uint16
+float_to_half(float f)
+{
+    const scm::uint32   f32_infinity     = 255u << 23;
+    const scm::uint32   f16_overflow     = (127u + 16u) << 23;
+    const scm::uint32   f16_denorm_limit = 113u << 23;
+    const scm::uint32   denorm_magic     = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    scm::uint32 x;
+    memcpy(&x, &f, sizeof(float));
+
+    const scm::uint32 sign = x & 0x80000000u;
+    x ^= sign;
+
+    scm::uint32 h;
+    if (x >= f16_overflow) {
+        h = x > f32_infinity ? 0x7e00u : 0x7c00u;
+    }
+    else if (x < f16_denorm_limit) {
+        // the float addition rounds the value into the half denormal mantissa
+        float fx, fm;
+        memcpy(&fx, &x, sizeof(float));
+        memcpy(&fm, &denorm_magic, sizeof(float));
+        fx += fm;
+        memcpy(&h, &fx, sizeof(float));
+        h -= denorm_magic;
+    }
+    else {
+        const scm::uint32 mant_odd = (x >> 13) & 1u;
+        x += ((15u - 127u) << 23) + 0xfffu;
+        x += mant_odd;
+        h  = x >> 13;
+    }
+
+    return static_cast<scm::uint16>(h | (sign >> 16));
+}
+
+inline
+float
+clamp_map(const conversion_params& p, float v)
+{
+    v = v < p._lo ? p._lo : v;
+    v = v > p._hi ? p._hi : v;
+    return (v - p._offset) * p._factor;
+}
+
+template<typename stype, typename dtype>
+void
+convert_unorm_scalar(const conversion_params& p, const stype* s, dtype* d, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        d[i] = static_cast<dtype>(static_cast<int>(clamp_map(p, static_cast<float>(s[i])) + 0.5f));
+    }
+}
+
+template<typename stype>
+void
+convert_half_scalar(const conversion_params& p, const stype* s, scm::uint16* d, scm::size_t c)
+{
+    for (scm::size_t i = 0; i < c; ++i) {
+        d[i] = float_to_half(clamp_map(p, static_cast<float>(s[i])));
+    }
+}
+
+#if SCM_SIMD_X86
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_float_r16_sse41(const conversion_params& p, const float* s, scm::uint16* d, scm::size_t c)
+{
+    const __m128 lo     = _mm_set1_ps(p._lo);
+    const __m128 hi     = _mm_set1_ps(p._hi);
+    const __m128 offset = _mm_set1_ps(p._offset);
+    const __m128 factor = _mm_set1_ps(p._factor);
+    const __m128 half   = _mm_set1_ps(0.5f);
+
+    const scm::size_t vec_count = c / 8;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        __m128 a = _mm_loadu_ps(s + 8 * i);
+        __m128 b = _mm_loadu_ps(s + 8 * i + 4);
+        a = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_min_ps(_mm_max_ps(a, lo), hi), offset), factor), half);
+        b = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_min_ps(_mm_max_ps(b, lo), hi), offset), factor), half);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 8 * i), _mm_packus_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+
+    convert_unorm_scalar(p, s + 8 * vec_count, d + 8 * vec_count, c - 8 * vec_count);
+}
+
+SCM_SIMD_TARGET("sse4.1")
+void
+convert_float_r8_sse41(const conversion_params& p, const float* s, scm::uint8* d, scm::size_t c)
+{
+    const __m128 lo     = _mm_set1_ps(p._lo);
+    const __m128 hi     = _mm_set1_ps(p._hi);
+    const __m128 offset = _mm_set1_ps(p._offset);
+    const __m128 factor = _mm_set1_ps(p._factor);
+    const __m128 half   = _mm_set1_ps(0.5f);
+
+    const scm::size_t vec_count = c / 16;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        __m128i q[4];
+        for (int j = 0; j < 4; ++j) {
+            const __m128 v = _mm_loadu_ps(s + 16 * i + 4 * j);
+            q[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_min_ps(_mm_max_ps(v, lo), hi), offset), factor), half));
+        }
+        const __m128i r = _mm_packus_epi16(_mm_packus_epi32(q[0], q[1]), _mm_packus_epi32(q[2], q[3]));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16 * i), r);
+    }
+
+    convert_unorm_scalar(p, s + 16 * vec_count, d + 16 * vec_count, c - 16 * vec_count);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_float_r16_avx2(const conversion_params& p, const float* s, scm::uint16* d, scm::size_t c)
+{
+    const __m256 lo     = _mm256_set1_ps(p._lo);
+    const __m256 hi     = _mm256_set1_ps(p._hi);
+    const __m256 offset = _mm256_set1_ps(p._offset);
+    const __m256 factor = _mm256_set1_ps(p._factor);
+    const __m256 half   = _mm256_set1_ps(0.5f);
+
+    const scm::size_t vec_count = c / 16;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        __m256 a = _mm256_loadu_ps(s + 16 * i);
+        __m256 b = _mm256_loadu_ps(s + 16 * i + 8);
+        a = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(a, lo), hi), offset), factor), half);
+        b = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(b, lo), hi), offset), factor), half);
+
+        // the 128 bit lane wise pack interleaves the quarters of a and b
+        const __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b)), 0xd8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + 16 * i), r);
+    }
+
+    convert_unorm_scalar(p, s + 16 * vec_count, d + 16 * vec_count, c - 16 * vec_count);
+}
+
+SCM_SIMD_TARGET("avx2")
+void
+convert_float_r8_avx2(const conversion_params& p, const float* s, scm::uint8* d, scm::size_t c)
+{
+    const __m256  lo     = _mm256_set1_ps(p._lo);
+    const __m256  hi     = _mm256_set1_ps(p._hi);
+    const __m256  offset = _mm256_set1_ps(p._offset);
+    const __m256  factor = _mm256_set1_ps(p._factor);
+    const __m256  half   = _mm256_set1_ps(0.5f);
+    const __m256i order  = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    const scm::size_t vec_count = c / 32;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        __m256i q[4];
+        for (int j = 0; j < 4; ++j) {
+            const __m256 v = _mm256_loadu_ps(s + 32 * i + 8 * j);
+            q[j] = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(v, lo), hi), offset), factor), half));
+        }
+        // lane wise packing leaves groups of four values in the order q0 q1 q2 q3 (low), q0 q1 q2 q3 (high)
+        const __m256i r = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(_mm256_packus_epi32(q[0], q[1]),
+                                                                          _mm256_packus_epi32(q[2], q[3])), order);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + 32 * i), r);
+    }
+
+    convert_unorm_scalar(p, s + 32 * vec_count, d + 32 * vec_count, c - 32 * vec_count);
+}
+
+SCM_SIMD_TARGET("avx2,f16c")
+void
+convert_float_r16f_avx2(const conversion_params& p, const float* s, scm::uint16* d, scm::size_t c)
+{
+    const __m256 lo     = _mm256_set1_ps(p._lo);
+    const __m256 hi     = _mm256_set1_ps(p._hi);
+    const __m256 offset = _mm256_set1_ps(p._offset);
+    const __m256 factor = _mm256_set1_ps(p._factor);
+
+    const scm::size_t vec_count = c / 8;
+
+    for (scm::size_t i = 0; i < vec_count; ++i) {
+        const __m256 v = _mm256_loadu_ps(s + 8 * i);
+        const __m256 y = _mm256_mul_ps(_mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(v, lo), hi), offset), factor);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 8 * i), _mm256_cvtps_ph(y, _MM_FROUND_TO_NEAREST_INT));
+    }
+
+    convert_half_scalar(p, s + 8 * vec_count, d + 8 * vec_count, c - 8 * vec_count);
+}
+
+#endif // SCM_SIMD_X86
+
+void
+convert_float(const conversion_params&  p,
+              scm::gl::data_format      dst_fmt,
+              const float*              s,
+              void*                     d,
+              scm::size_t               c,
+              scm::cpu_simd_level       l)
+{
+    using namespace scm;
+    using namespace scm::gl;
+
+    switch (dst_fmt) {
+        case FORMAT_R_8:
+            switch (l) {
+#if SCM_SIMD_X86
+                case CPU_SIMD_AVX2:     convert_float_r8_avx2(p, s, static_cast<uint8*>(d), c);     break;
+                case CPU_SIMD_SSE4_1:   convert_float_r8_sse41(p, s, static_cast<uint8*>(d), c);    break;
+#endif // SCM_SIMD_X86
+                default:                convert_unorm_scalar(p, s, static_cast<uint8*>(d), c);      break;
+            }
+            break;
+        case FORMAT_R_16:
+            switch (l) {
+#if SCM_SIMD_X86
+                case CPU_SIMD_AVX2:     convert_float_r16_avx2(p, s, static_cast<uint16*>(d), c);   break;
+                case CPU_SIMD_SSE4_1:   convert_float_r16_sse41(p, s, static_cast<uint16*>(d), c);  break;
+#endif // SCM_SIMD_X86
+                default:                convert_unorm_scalar(p, s, static_cast<uint16*>(d), c);     break;
+            }
+            break;
+        default: // FORMAT_R_16F
+            switch (l) {
+#if SCM_SIMD_X86
+                case CPU_SIMD_AVX2:     convert_float_r16f_avx2(p, s, static_cast<uint16*>(d), c);  break;
+#endif // SCM_SIMD_X86
+                default:                convert_half_scalar(p, s, static_cast<uint16*>(d), c);      break;
+            }
+            break;
+    }
+}
+
+template<typename stype>
+void
+convert_typed(const conversion_params&  p,
+              scm::gl::data_format      dst_fmt,
+              const stype*              s,
+              void*                     d,
+              scm::size_t               c)
+{
+    using namespace scm;
+    using namespace scm::gl;
+
+    switch (dst_fmt) {
+        case FORMAT_R_8:    convert_unorm_scalar(p, s, static_cast<uint8*>(d), c);      break;
+        case FORMAT_R_16:   convert_unorm_scalar(p, s, static_cast<uint16*>(d), c);     break;
+        default:            convert_half_scalar(p, s, static_cast<uint16*>(d), c);      break;
+    }
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace util {
+
+bool
+volume_conversion_supported(data_format source_format,
+                            data_format target_format)
+{
+    if (   target_format != FORMAT_R_8
+        && target_format != FORMAT_R_16
+        && target_format != FORMAT_R_16F) {
+        return false;
+    }
+
+    switch (source_format) {
+        case FORMAT_R_8:    case FORMAT_R_8S:   case FORMAT_R_8I:   case FORMAT_R_8UI:
+        case FORMAT_R_16:   case FORMAT_R_16S:  case FORMAT_R_16I:  case FORMAT_R_16UI:
+        case FORMAT_R_32I:  case FORMAT_R_32UI: case FORMAT_R_32F:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool
+make_volume_value_mapping(data_format           source_format,
+                          data_format           target_format,
+                          const math::vec2d&    source_range,
+                          volume_value_mapping& mapping)
+{
+    if (!volume_conversion_supported(source_format, target_format)) {
+        glerr() << log::error
+                << "make_volume_value_mapping(): unsupported conversion ("
+                << format_string(source_format) << " -> " << format_string(target_format) << ")." << log::end;
+        return false;
+    }
+    if (!(source_range.x <= source_range.y)) {
+        glerr() << log::error
+                << "make_volume_value_mapping(): invalid source range (" << source_range << ")." << log::end;
+        return false;
+    }
+
+    mapping._source_format = source_format;
+    mapping._target_format = target_format;
+    mapping._source_range  = source_range;
+
+    const double range_size = source_range.y - source_range.x;
+
+    if (target_format == FORMAT_R_16F) {
+        const double max_abs = math::max(math::abs(source_range.x), math::abs(source_range.y));
+        const double scale   = max_abs > half_max ? max_abs / half_max : 1.0;
+
+        mapping._source_offset = 0.0f;
+        mapping._source_factor = static_cast<float>(1.0 / scale);
+        mapping._scale         = static_cast<float>(scale);
+        mapping._offset        = 0.0f;
+    }
+    else {
+        const double qmax = target_format == FORMAT_R_8 ? 255.0 : 65535.0;
+
+        mapping._source_offset = static_cast<float>(source_range.x);
+        mapping._source_factor = range_size > 0.0 ? static_cast<float>(qmax / range_size) : 0.0f;
+        mapping._scale         = static_cast<float>(range_size);
+        mapping._offset        = static_cast<float>(source_range.x);
+    }
+
+    return true;
+}
+
+math::vec2d
+percentile_range(const volume_statistics& vstats,
+                 double                   lower_percentile,
+                 double                   upper_percentile,
+                 unsigned                 channel)
+{
+    const volume_statistics::histogram_type&    hist    = vstats.histogram(channel);
+    const math::vec2d                           hrange  = vstats.histogram_range(channel);
+
+    scm::uint64 total = 0;
+    for (size_t b = 0; b < hist.size(); ++b) {
+        total += hist[b];
+    }
+    if (total == 0 || hist.empty()) {
+        return hrange;
+    }
+
+    const double bin_size    = (hrange.y - hrange.x) / static_cast<double>(hist.size());
+    const double lower_count = math::clamp(lower_percentile, 0.0, 1.0) * static_cast<double>(total);
+    const double upper_count = math::clamp(upper_percentile, 0.0, 1.0) * static_cast<double>(total);
+
+    math::vec2d  prange      = hrange;
+    scm::uint64  cum         = 0;
+    bool         lower_found = lower_percentile <= 0.0;
+
+    for (size_t b = 0; b < hist.size(); ++b) {
+        cum += hist[b];
+        if (!lower_found && static_cast<double>(cum) > lower_count) {
+            prange.x    = hrange.x + static_cast<double>(b) * bin_size;
+            lower_found = true;
+        }
+        if (upper_percentile < 1.0 && static_cast<double>(cum) >= upper_count) {
+            prange.y = math::min(hrange.y, hrange.x + static_cast<double>(b + 1) * bin_size);
+            break;
+        }
+    }
+
+    return prange;
+}
+
+bool
+convert_volume_data(const volume_value_mapping& mapping,
+                    scm::size_t                 count,
+                    const void*                 src,
+                    void*                       dst,
+                    cpu_simd_level              l)
+{
+    if (!volume_conversion_supported(mapping._source_format, mapping._target_format)) {
+        glerr() << log::error
+                << "convert_volume_data(): unsupported conversion ("
+                << format_string(mapping._source_format) << " -> " << format_string(mapping._target_format) << ")." << log::end;
+        return false;
+    }
+
+    conversion_params p;
+    p._lo     = static_cast<float>(mapping._source_range.x);
+    p._hi     = static_cast<float>(mapping._source_range.y);
+    p._offset = mapping._source_offset;
+    p._factor = mapping._source_factor;
+
+    const data_format    src_fmt  = mapping._source_format;
+    const data_format    dst_fmt  = mapping._target_format;
+    const scm::size_t    src_size = size_of_format(src_fmt);
+    const scm::size_t    dst_size = size_of_format(dst_fmt);
+    const cpu_simd_level level    = math::min(l, cpu_supported_simd_level());
+    const scm::size_t    chunks   = (count + conversion_chunk_values - 1) / conversion_chunk_values;
+
+    util::parallel_for(chunks, [&](scm::size_t chunk, scm::size_t) {
+        const scm::size_t first = chunk * conversion_chunk_values;
+        const scm::size_t c     = math::min(conversion_chunk_values, count - first);
+        const void*       s     = static_cast<const uint8*>(src) + first * src_size;
+        void*             d     = static_cast<uint8*>(dst) + first * dst_size;
+
+        switch (src_fmt) {
+            case FORMAT_R_32F:  convert_float(p, dst_fmt, static_cast<const float*>(s), d, c, level);   break;
+            case FORMAT_R_8:
+            case FORMAT_R_8UI:  convert_typed(p, dst_fmt, static_cast<const uint8*>(s), d, c);          break;
+            case FORMAT_R_8S:
+            case FORMAT_R_8I:   convert_typed(p, dst_fmt, static_cast<const int8*>(s), d, c);           break;
+            case FORMAT_R_16:
+            case FORMAT_R_16UI: convert_typed(p, dst_fmt, static_cast<const uint16*>(s), d, c);         break;
+            case FORMAT_R_16S:
+            case FORMAT_R_16I:  convert_typed(p, dst_fmt, static_cast<const int16*>(s), d, c);          break;
+            case FORMAT_R_32UI: convert_typed(p, dst_fmt, static_cast<const uint32*>(s), d, c);         break;
+            case FORMAT_R_32I:  convert_typed(p, dst_fmt, static_cast<const int32*>(s), d, c);          break;
+            default:                                                                                    break;
+        }
+    });
+
+    return true;
+}
+
+} // namespace util
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,72 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_DATA_CONVERSION_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_DATA_CONVERSION_H_INCLUDED
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+#include <scm/core/platform/cpu_features.h>
+
+#include <scm/gl_core/data_formats.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+namespace util {
+
+class volume_statistics;
+
+// mapping of single channel source values to a compact texture format
+// - FORMAT_R_8 and FORMAT_R_16 store the source range quantized to the
+//   normalized integer range, FORMAT_R_16F stores the clamped source values
+//   (scaled down if they exceed the half float range)
+// - shaders reconstruct physical values from sampled texture values with
+//   v * _scale + _offset
+struct volume_value_mapping
+{
+    data_format         _source_format;
+    data_format         _target_format;
+    math::vec2d         _source_range;      // source values outside are clamped
+
+    float               _scale;
+    float               _offset;
+
+    // applied during conversion: (clamp(v, range) - _source_offset) * _source_factor
+    float               _source_offset;
+    float               _source_factor;
+}; // struct volume_value_mapping
+
+__scm_export(gl_util) bool          volume_conversion_supported(data_format source_format,
+                                                                data_format target_format);
+__scm_export(gl_util) bool          make_volume_value_mapping(data_format           source_format,
+                                                              data_format           target_format,
+                                                              const math::vec2d&    source_range,
+                                                              volume_value_mapping& mapping);
+
+// value range between the lower and upper percentile (in [0, 1]) of the
+// histogram of the channel, (0, 1) yields the histogram range
+__scm_export(gl_util) math::vec2d   percentile_range(const volume_statistics& vstats,
+                                                     double                   lower_percentile,
+                                                     double                   upper_percentile,
+                                                     unsigned                 channel = 0);
+
+// convert count values from src to dst using the mapping on all hardware
+// threads, float sources are vectorized for the given simd level
+// - results are identical for every simd level, NaN values are not supported
+__scm_export(gl_util) bool          convert_volume_data(const volume_value_mapping& mapping,
+                                                        scm::size_t                 count,
+                                                        const void*                 src,
+                                                        void*                       dst,
+                                                        cpu_simd_level              l = cpu_supported_simd_level());
+
+} // namespace util
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_VOLUME_DATA_CONVERSION_H_INCLUDED
@@ -14,8 +14,7 @@
 #include <scm/core/memory.h>
 
 
-#include <boost/filesystem.hpp>
-#include <boost/algorithm/string.hpp>
+#include <boost/function.hpp>
 #include <boost/numeric/conversion/bounds.hpp>
 
 #include <scm/log.h>
@@ -25,6 +24,7 @@
 #include <scm/core/numeric_types.h>
 #include <scm/core/time/high_res_timer.h>
 
+#include <scm/gl_util/data/analysis/volume_statistics.h>
 #include <scm/gl_util/data/analysis/transfer_function/build_lookup_table.h>
 
 #include <scm/gl_core/data_formats.h>
@@ -38,12 +38,218 @@
 #include <scm/gl_util/primitives/box.h>
 #include <scm/gl_util/primitives/box_volume.h>
 #include <scm/gl_util/viewer/camera.h>
-#include <scm/gl_util/data/volume/volume_reader_raw.h>
-#include <scm/gl_util/data/volume/volume_reader_segy.h>
-#include <scm/gl_util/data/volume/volume_reader_vgeo.h>
+#include <scm/gl_util/data/volume/volume_reader.h>
 
 #include <scm/gl_util/data/imaging/texture_image_data.h>
 
+namespace {
+
+// incremental mip map construction for slab wise volume loading
+// - slices of a level are pushed in z order, every level keeps the slices
+//   still required for the next coarser level pending
+// - coarser level slices are built as soon as all their source slices are
+//   available, all finished slices are passed to the slice function
+class mip_slab_cascade
+{
+public:
+    typedef boost::function<void (unsigned                      level,
+                                  const scm::gl::texture_region& region,
+                                  const scm::uint8*             data)>   slice_function;
+
+    mip_slab_cascade(const scm::math::vec3ui&   dim,
+                     scm::gl::data_format       fmt,
+                     unsigned                   level_count,
+                     const slice_function&      slice_func)
+      : _format(fmt)
+      , _slice_func(slice_func)
+      , _levels(level_count)
+    {
+        for (unsigned l = 0; l < level_count; ++l) {
+            _levels[l]._dim           = scm::gl::util::mip_level_dimensions(dim, l);
+            _levels[l]._slice_size    =   static_cast<scm::size_t>(_levels[l]._dim.x) * _levels[l]._dim.y
+                                        * scm::gl::size_of_format(fmt);
+            _levels[l]._pending_first = 0;
+            _levels[l]._pending_count = 0;
+            _levels[l]._next_z        = 0;
+        }
+    }
+
+    bool push(unsigned level, unsigned z_first, unsigned z_count, const scm::uint8* data)
+    {
+        using namespace scm::math;
+
+        level_state& cur = _levels[level];
+
+        _slice_func(level, scm::gl::texture_region(vec3ui(0, 0, z_first), vec3ui(cur._dim.x, cur._dim.y, z_count)), data);
+
+        if (level + 1 >= _levels.size()) {
+            return true;
+        }
+
+        assert(z_first == cur._pending_first + cur._pending_count);
+
+        cur._pending.insert(cur._pending.end(), data, data + z_count * cur._slice_size);
+        cur._pending_count += z_count;
+
+        const vec3ui&  dst_dim   = _levels[level + 1]._dim;
+        const unsigned z_samples = min(cur._dim.z, (cur._dim.z & 1) ? 3u : 2u);
+        const unsigned z_begin   = cur._next_z;
+        unsigned       z_end     = z_begin;
+
+        while (   z_end < dst_dim.z
+               && 2 * z_end + z_samples <= cur._pending_first + cur._pending_count) {
+            ++z_end;
+        }
+        if (z_end == z_begin) {
+            return true;
+        }
+
+        cur._output.resize((z_end - z_begin) * _levels[level + 1]._slice_size);
+
+        scm::time::high_res_timer timer;
+        timer.start();
+        // the slices are built in parallel rows by the mip map generation
+        bool gen_ok = scm::gl::util::generate_mip_slices(cur._dim, dst_dim, _format,
+                                                         &cur._pending.front(), cur._pending_first,
+                                                         z_begin, z_end, &cur._output.front());
+        timer.stop();
+        _mip_time += timer.get_time();
+
+        if (!gen_ok) {
+            return false;
+        }
+
+        // drop the source slices not required by any following output slice
+        const unsigned drop = min(2 * z_end, cur._pending_first + cur._pending_count) - cur._pending_first;
+        cur._pending.erase(cur._pending.begin(), cur._pending.begin() + drop * cur._slice_size);
+        cur._pending_first += drop;
+        cur._pending_count -= drop;
+        cur._next_z         = z_end;
+
+        return push(level + 1, z_begin, z_end - z_begin, &cur._output.front());
+    }
+
+    bool complete() const
+    {
+        for (size_t l = 0; l + 1 < _levels.size(); ++l) {
+            if (_levels[l]._next_z != _levels[l + 1]._dim.z) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const scm::time::time_duration& mip_time() const { return _mip_time; }
+
+private:
+    struct level_state {
+        scm::math::vec3ui           _dim;
+        scm::size_t                 _slice_size;
+        std::vector<scm::uint8>     _pending;       // slices [_pending_first, _pending_first + _pending_count)
+        unsigned                    _pending_first;
+        unsigned                    _pending_count;
+        unsigned                    _next_z;        // next slice of the coarser level to build
+        std::vector<scm::uint8>     _output;
+    }; // struct level_state
+
+    scm::gl::data_format            _format;
+    slice_function                  _slice_func;
+    std::vector<level_state>        _levels;
+    scm::time::time_duration        _mip_time;
+
+}; // class mip_slab_cascade
+
+// finished slices of a level in the source format are converted into the
+// upload format, returns the converted data
+typedef boost::function<const scm::uint8* (const scm::gl::texture_region& region,
+                                           const scm::uint8*             data)>     slice_conversion;
+
+struct mip_stream_times
+{
+    scm::time::time_duration    _read;
+    scm::time::time_duration    _mip;
+    scm::time::time_duration    _convert;
+    scm::time::time_duration    _upload;
+}; // struct mip_stream_times
+
+enum mip_stream_result
+{
+    MIP_STREAM_OK,
+    MIP_STREAM_READ_FAILED,
+    MIP_STREAM_UPLOAD_FAILED
+}; // enum mip_stream_result
+
+// streams the volume slab wise through the mip cascade into the preallocated
+// mip levels of the texture, the optional conversion is applied to the
+// finished slices of every level before the upload, the optional slab
+// function sees every source slab before it enters the cascade
+// - the cascade builds the levels [0, level_count), level base_level and
+//   the following are uploaded to the texture levels starting at 0, the finer
+//   levels are kept just as long as the filter needs them
+// - the slab buffers take two thirds of the slab budget, the slices pending
+//   in the cascade take up to the last third
+mip_stream_result
+stream_mip_levels(scm::gl::render_device&           device,
+                  scm::gl::volume_reader&           reader,
+                  const scm::gl::texture_3d_ptr&    texture,
+                  unsigned                          level_count,
+                  unsigned                          base_level,
+                  scm::gl::data_format              upload_format,
+                  const slice_conversion&           convert,
+                  const scm::gl::volume_slab_function& slab_func,
+                  scm::size_t                       slab_budget,
+                  mip_stream_times&                 out_times)
+{
+    using namespace scm::gl;
+
+    render_context_ptr  context   = device.main_context();
+    bool                upload_ok = true;
+
+    mip_slab_cascade cascade(reader.dimensions(), reader.format(), level_count,
+        [&](unsigned level, const texture_region& region, const scm::uint8* data) {
+            if (level < base_level) {
+                return;
+            }
+            if (convert) {
+                scm::time::high_res_timer convert_timer;
+                convert_timer.start();
+                data = convert(region, data);
+                convert_timer.stop();
+                out_times._convert += convert_timer.get_time();
+            }
+
+            scm::time::high_res_timer upload_timer;
+            upload_timer.start();
+            upload_ok = context->update_sub_texture(texture, region, level - base_level, upload_format, data) && upload_ok;
+            upload_timer.stop();
+            out_times._upload += upload_timer.get_time();
+        });
+
+    bool mip_ok = true;
+    bool read_ok = stream_volume_slabs(reader, slab_budget - slab_budget / 3,
+        [&](unsigned z_first, unsigned z_count, const scm::uint8* data) -> bool {
+            if (slab_func && !slab_func(z_first, z_count, data)) {
+                return false;
+            }
+            mip_ok = cascade.push(0, z_first, z_count, data);
+            return mip_ok && upload_ok;
+        },
+        &out_times._read);
+
+    out_times._mip = cascade.mip_time();
+
+    if (!mip_ok || !upload_ok || !cascade.complete()) {
+        return MIP_STREAM_UPLOAD_FAILED;
+    }
+    if (!read_ok) {
+        return MIP_STREAM_READ_FAILED;
+    }
+
+    return MIP_STREAM_OK;
+}
+
+} // namespace
+
 namespace scm {
 namespace gl {
 
@@ -54,37 +260,32 @@ volume_loader::load_texture_3d(render_device&       in_device,
                                 bool                 in_color_mips,
                                 const data_format    in_force_internal_format)
 {
+    math::vec3f scale;
+    return load_texture_3d(in_device, in_image_path, scale, in_create_mips, in_color_mips, in_force_internal_format);
+}
+
+texture_3d_ptr
+volume_loader::load_texture_3d(render_device&       in_device,
+                                const std::string&   in_image_path,
+                                math::vec3f&         out_scale,
+                                bool                 in_create_mips,
+                                bool                 in_color_mips,
+                                const data_format    in_force_internal_format)
+{
  
     using namespace scm;
     using namespace scm::gl;
     using namespace scm::math;
-    using namespace boost::filesystem;
-
-    scoped_ptr<gl::volume_reader> vol_reader;
-    path                    file_path(in_image_path);
-    std::string             file_name       = file_path.filename().string();
-    std::string             file_extension  = file_path.extension().string();
 
-    data_format volume_data_format     = FORMAT_NULL;
+    out_scale = vec3f(1.0f);
 
-    boost::algorithm::to_lower(file_extension);
+    volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
 
-    if (file_extension == ".raw") {
-        vol_reader.reset(new scm::gl::volume_reader_raw(file_path.string(), false));
-    }
-    else if (file_extension == ".vol") {
-        vol_reader.reset(new scm::gl::volume_reader_vgeo(file_path.string(), true));
-    }
-    else {
-        err() << log::error
-              << "volume_loader::load_texture_3d(): unsupported volume file format ('" << file_extension << "')." << log::end;
+    if (!vol_reader) {
         return (texture_3d_ptr());
     }
 
-    if (!(*vol_reader)) {
-        std::cout << "volume_loader::load_texture_3d(): unable to open file ('" << in_image_path << "')." << log::end;
-        return (texture_3d_ptr());
-    }
+    data_format volume_data_format     = FORMAT_NULL;
 
     int    max_volume_dim  = in_device.capabilities()._max_texture_3d_size;
     vec3ui data_offset = vec3ui(0);
@@ -92,9 +293,17 @@ volume_loader::load_texture_3d(render_device&       in_device,
     volume_data_format     = vol_reader->format();
 
     if (max(max(data_dimensions.x, data_dimensions.y), data_dimensions.z) > static_cast<unsigned>(max_volume_dim)) {
-        err() << log::error
-              << "volume_loader::load_texture_3d(): volume too large to load as single texture ('" << data_dimensions << "')." << log::end;
-        return (texture_3d_ptr());
+        out() << log::warning
+              << "volume_loader::load_texture_3d(): volume too large to load as single texture ('" << data_dimensions << "'), "
+              << "loading downsampled copy." << log::end;
+        vol_reader.reset();
+        texture_3d_ptr new_volume_tex = load_texture_3d_downsampled(in_device, in_image_path, 0, out_scale);
+        if (new_volume_tex) {
+            out() << log::warning
+                  << "volume_loader::load_texture_3d(): loaded downsampled copy ('" << new_volume_tex->descriptor()._size << "', "
+                  << "scale: " << out_scale << ")." << log::end;
+        }
+        return new_volume_tex;
     }
 
     scm::shared_array<unsigned char>    read_buffer;
@@ -129,44 +338,21 @@ volume_loader::load_volume_data(render_device&      in_device,
 {
     using namespace scm::gl;
     using namespace scm::math;
-    using namespace boost::filesystem;
-   
-    path                    file_path(in_image_path);
-    std::string             file_name       = file_path.filename().string();
-    std::string             file_extension  = file_path.extension().string();
-    
-    boost::algorithm::to_lower(file_extension);
 
     vec3ui      data_dimensions = vec3ui(0u);
     data_format data_format     = FORMAT_NULL;
     scm::shared_array<unsigned char> read_buffer;
     scm::size_t                      read_buffer_size = 0;
 
-    scoped_ptr<gl::volume_reader> vol_reader;
-
-    out() << log::indent;
-    time::high_res_timer timer;
+    volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
 
-    if (file_extension == ".raw") {
-        vol_reader.reset(new volume_reader_raw(file_path.string(), false));
-    }
-    else if (file_extension == ".vol") {
-        vol_reader.reset(new volume_reader_vgeo(file_path.string(), true));
-    }
-    else if (file_extension == ".segy" || file_extension == ".sgy") {
-        vol_reader.reset(new volume_reader_segy(file_path.string(), true));
-    }
-    else {
-        err() << log::error
-              << "volume_data::load_volume(): unable to open file ('" << in_image_path << "')." << log::end;
+    if (!vol_reader) {
         return texture_3d_ptr();
     }
 
-    if (!(*vol_reader)) {
-        err() << log::error
-                << "volume_data::load_volume(): unable to open file ('" << in_image_path << "')." << log::end;
-        return texture_3d_ptr();
-    }
+    out() << log::indent;
+    time::high_res_timer timer;
+
     out() << "source data dimensions: " << vol_reader->dimensions() << log::end;
 
     vec3ui data_offset = vec3ui(0);
@@ -195,36 +381,17 @@ volume_loader::load_volume_data(render_device&      in_device,
           << time::to_seconds(timer.get_time()) << "s, "
           << (static_cast<double>(read_buffer_size) / (1024.0*1024.0)) / time::to_seconds(timer.get_time()) << "MiB/s)" << log::end;
 
-    //_min_value = 0.0f;
-    //_max_value = 1.0f;
-    //if (is_float_type(data_format)) {
-    //    out() << "determining floating point value range..." << log::end;
-    //    timer.start();
-
-    //    float* fp_data = reinterpret_cast<float*>(read_buffer.get());
-    //    size_t dcount  = static_cast<scm::size_t>(data_dimensions.x) * data_dimensions.y * data_dimensions.z * channel_count(data_format);
-    //    _min_value = boost::numeric::bounds<float>::highest();//(std::numeric_limits<float>::max)();
-    //    _max_value = boost::numeric::bounds<float>::lowest();//(std::numeric_limits<float>::min)();
-
-    //    for (size_t i = 0; i < dcount; ++i) {
-    //        _min_value = min(_min_value, fp_data[i]);
-    //        _max_value = max(_max_value, fp_data[i]);
-    //    }
-
-    //    if (abs(_min_value) > abs(_max_value)) {
-    //        _max_value = abs(_min_value);
-    //    }
-    //    else {
-    //        _min_value = -abs(_max_value);
-    //    }
-
-    //    timer.stop();
-    //    out() << "etermining floating point value range"
-    //          << " (elapsed time: " << std::fixed << std::setprecision(3)
-    //          << time::to_seconds(timer.get_time()) << "s)" << log::end;
-
-    //}
-    //out() << "min_value: " << _min_value << ", max_value: " << _max_value << log::end;
+    if (is_float_type(data_format)) {
+        out() << "determining floating point value range..." << log::end;
+        timer.start();
+        util::volume_statistics vol_stats(data_dimensions, data_format);
+        vol_stats.compute(read_buffer.get());
+        timer.stop();
+        out() << "determining floating point value range done"
+              << " (elapsed time: " << std::fixed << std::setprecision(3)
+              << time::to_seconds(timer.get_time()) << "s)" << log::end;
+        out() << "min_value: " << vol_stats.min_value() << ", max_value: " << vol_stats.max_value() << log::end;
+    }
 
     std::vector<uint8*> mip_data;
     std::vector<void*>  mip_init_data;
@@ -265,55 +432,447 @@ volume_loader::load_volume_data(render_device&      in_device,
     return new_volume_tex;
 }
 
-scm::math::vec3ui
-volume_loader::read_dimensions(const std::string&  in_image_path)
+texture_3d_ptr
+volume_loader::load_volume_data_streaming(render_device&              in_device,
+                                          const std::string&          in_image_path,
+                                          const scm::size_t           in_slab_budget,
+                                          volume_occupancy_grid_ptr*  out_occupancy_grid,
+                                          const math::vec3ui&         in_brick_dimensions)
 {
-	using namespace scm::gl;
-	using namespace scm::math;
-	using namespace boost::filesystem;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
+
+    if (!vol_reader) {
+        return texture_3d_ptr();
+    }
+
+    const vec3ui      data_dimensions = vol_reader->dimensions();
+    const data_format vol_format      = vol_reader->format();
 
-	path                    file_path(in_image_path);
-	std::string             file_name = file_path.filename().string();
-	std::string             file_extension = file_path.extension().string();
+    if (vol_format == FORMAT_NULL) {
+        err() << log::error
+              << "volume_loader::load_volume_data_streaming(): unable to determine volume data format ('" << in_image_path << "')." << log::end;
+        return texture_3d_ptr();
+    }
 
-	boost::algorithm::to_lower(file_extension);
+    unsigned mip_count = util::max_mip_levels(data_dimensions);
 
-	vec3ui      data_dimensions = vec3ui(0u);
-	data_format data_format = FORMAT_NULL;
-	scm::shared_array<unsigned char> read_buffer;
-	scm::size_t                      read_buffer_size = 0;
+    if (!util::mipmap_generation_supported(vol_format)) {
+        out() << log::warning
+              << "volume_loader::load_volume_data_streaming(): mip map generation not supported for format ("
+              << format_string(vol_format) << "), loading base level only." << log::end;
+        mip_count = 1;
+    }
 
-	scoped_ptr<gl::volume_reader> vol_reader;
+    const scm::size_t volume_size  =   static_cast<scm::size_t>(data_dimensions.x) * data_dimensions.y * data_dimensions.z
+                                     * size_of_format(vol_format);
 
-	out() << log::indent;
-	time::high_res_timer timer;
+    out() << log::indent;
+    out() << "streaming volume data "
+          << "(dimensions: " << data_dimensions << ", format: " << format_string(vol_format)
+          << ", mip-level: " << mip_count
+          << ", size : " << std::fixed << std::setprecision(3) << static_cast<double>(volume_size) / (1024.0*1024.0) << "MiB"
+          << ", slab slices: " << volume_slab_slices(*vol_reader, in_slab_budget - in_slab_budget / 3) << ")..." << log::end;
 
-	if (file_extension == ".raw") {
-		vol_reader.reset(new volume_reader_raw(file_path.string(), false));
-	}
-	else if (file_extension == ".vol") {
-		vol_reader.reset(new volume_reader_vgeo(file_path.string(), true));
-	}
-	else if (file_extension == ".segy" || file_extension == ".sgy") {
-		vol_reader.reset(new volume_reader_segy(file_path.string(), true));
-	}
-	else {
-		err() << log::error
-			<< "volume_data::load_volume(): unable to open file ('" << in_image_path << "')." << log::end;
-		return scm::math::vec3ui::zero();
-	}
+    time::high_res_timer total_timer;
+    time::high_res_timer timer;
+    total_timer.start();
+
+    timer.start();
+    texture_3d_ptr new_volume_tex = in_device.create_texture_3d(data_dimensions, vol_format, mip_count);
+    timer.stop();
+    if (!new_volume_tex) {
+        err() << log::error
+              << "volume_loader::load_volume_data_streaming(): unable to allocate texture storage ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+    const time::time_duration alloc_time = timer.get_time();
+
+    mip_stream_times        times;
+    // statistics of the occupancy grid from the same slabs
+    scm::scoped_ptr<util::volume_statistics>    vol_stats;
+    volume_slab_function                        stats_func;
+    time::time_duration                         stats_time;
+
+    if (out_occupancy_grid) {
+        out_occupancy_grid->reset();
+        if (util::volume_statistics::format_supported(vol_format)) {
+            vol_stats.reset(new util::volume_statistics(data_dimensions, vol_format, 256, in_brick_dimensions));
+            vol_stats->begin_accumulation();
+            stats_func = [&](unsigned z_first, unsigned z_count, const uint8* data) -> bool {
+                time::high_res_timer stats_timer;
+                stats_timer.start();
+                if (vol_stats && !vol_stats->accumulate(vec3ui(0, 0, z_first), vec3ui(data_dimensions.x, data_dimensions.y, z_count), data)) {
+                    vol_stats.reset();
+                }
+                stats_timer.stop();
+                stats_time += stats_timer.get_time();
+                return true;
+            };
+        }
+        else {
+            out() << log::warning
+                  << "volume_loader::load_volume_data_streaming(): occupancy grid not supported for format ("
+                  << format_string(vol_format) << ")." << log::end;
+        }
+    }
+
+    const mip_stream_result result = stream_mip_levels(in_device, *vol_reader, new_volume_tex, mip_count, 0, vol_format,
+                                                       slice_conversion(), stats_func, in_slab_budget, times);
+
+    if (result == MIP_STREAM_OK && vol_stats) {
+        time::high_res_timer grid_timer;
+        grid_timer.start();
+        vol_stats->end_accumulation();
+        *out_occupancy_grid = make_shared<volume_occupancy_grid>(*vol_stats, 0u);
+        grid_timer.stop();
+        stats_time += grid_timer.get_time();
+    }
+
+    total_timer.stop();
+
+    if (result == MIP_STREAM_READ_FAILED) {
+        err() << log::error
+              << "volume_loader::load_volume_data_streaming(): unable to read data from file ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+    if (result == MIP_STREAM_UPLOAD_FAILED) {
+        err() << log::error
+              << "volume_loader::load_volume_data_streaming(): unable to build or upload mip map hierarchy ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+
+    out() << "allocating texture storage done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(alloc_time) << "s)" << log::end;
+    out() << "reading volume data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._read) << "s, "
+          << (static_cast<double>(volume_size) / (1024.0*1024.0)) / time::to_seconds(times._read) << "MiB/s)" << log::end;
+    out() << "generating mip map hierarchy done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._mip) << "s)" << log::end;
+    out() << "uploading texture data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._upload) << "s)" << log::end;
+    if (out_occupancy_grid && *out_occupancy_grid) {
+        out() << "building occupancy grid done"
+              << " (grid dimensions: " << (*out_occupancy_grid)->grid_dimensions()
+              << ", elapsed time: " << std::fixed << std::setprecision(3)
+              << time::to_seconds(stats_time) << "s)" << log::end;
+    }
+    out() << "streaming volume data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(total_timer.get_time()) << "s)" << log::end;
+
+    out() << log::outdent;
+
+    return new_volume_tex;
+}
+
+texture_3d_ptr
+volume_loader::load_texture_3d_downsampled(render_device&       in_device,
+                                           const std::string&   in_image_path,
+                                           const scm::size_t    in_memory_budget,
+                                           math::vec3f&         out_scale,
+                                           const scm::size_t    in_slab_budget)
+{
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    out_scale = vec3f(1.0f);
 
-	if (!(*vol_reader)) {
-		err() << log::error
-			<< "volume_data::load_volume(): unable to open file ('" << in_image_path << "')." << log::end;
+    volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
+
+    if (!vol_reader) {
+        return texture_3d_ptr();
+    }
+
+    const vec3ui      data_dimensions = vol_reader->dimensions();
+    const data_format vol_format      = vol_reader->format();
+
+    if (vol_format == FORMAT_NULL) {
+        err() << log::error
+              << "volume_loader::load_texture_3d_downsampled(): unable to determine volume data format ('" << in_image_path << "')." << log::end;
+        return texture_3d_ptr();
+    }
+
+    // first mip level fitting the device limit and the memory budget
+    const unsigned max_volume_dim = static_cast<unsigned>(in_device.capabilities()._max_texture_3d_size);
+    const unsigned level_count    = util::max_mip_levels(data_dimensions);
+    unsigned       target_level   = 0;
+    vec3ui         target_dim     = data_dimensions;
+
+    while (target_level + 1 < level_count) {
+        const scm::size_t target_size =   static_cast<scm::size_t>(target_dim.x) * target_dim.y * target_dim.z
+                                        * size_of_format(vol_format);
+        if (   max(max(target_dim.x, target_dim.y), target_dim.z) <= max_volume_dim
+            && (in_memory_budget == 0 || target_size <= in_memory_budget)) {
+            break;
+        }
+        target_dim = util::mip_level_dimensions(data_dimensions, ++target_level);
+    }
+
+    if (target_level > 0 && !util::mipmap_generation_supported(vol_format)) {
+        err() << log::error
+              << "volume_loader::load_texture_3d_downsampled(): downsampling not supported for format ("
+              << format_string(vol_format) << ")." << log::end;
+        return texture_3d_ptr();
+    }
+
+    out_scale = vec3f(data_dimensions) / vec3f(target_dim);
+
+    out() << log::indent;
+    out() << "downsampling volume data "
+          << "(dimensions: " << data_dimensions << " -> " << target_dim
+          << ", format: " << format_string(vol_format)
+          << ", scale: " << out_scale
+          << ", slab slices: " << volume_slab_slices(*vol_reader, in_slab_budget - in_slab_budget / 3) << ")..." << log::end;
+
+    time::high_res_timer timer;
+    timer.start();
+
+    texture_3d_ptr new_volume_tex = in_device.create_texture_3d(target_dim, vol_format, 1);
+    if (!new_volume_tex) {
+        err() << log::error
+              << "volume_loader::load_texture_3d_downsampled(): unable to allocate texture storage ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+
+    // only the slices of the target level are uploaded
+    mip_stream_times        times;
+    const mip_stream_result result = stream_mip_levels(in_device, *vol_reader, new_volume_tex, target_level + 1, target_level, vol_format,
+                                                       slice_conversion(), volume_slab_function(), in_slab_budget, times);
+
+    timer.stop();
+
+    if (result == MIP_STREAM_READ_FAILED) {
+        err() << log::error
+              << "volume_loader::load_texture_3d_downsampled(): unable to read data from file ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+    if (result == MIP_STREAM_UPLOAD_FAILED) {
+        err() << log::error
+              << "volume_loader::load_texture_3d_downsampled(): unable to build or upload downsampled volume ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+
+    out() << "downsampling volume data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(timer.get_time()) << "s, filter time: "
+          << time::to_seconds(times._mip) << "s)" << log::end;
+    out() << log::outdent;
+
+    return new_volume_tex;
+}
+
+texture_3d_ptr
+volume_loader::load_volume_data_converted(render_device&               in_device,
+                                          const std::string&           in_image_path,
+                                          const data_format            in_target_format,
+                                          const math::vec2d&           in_percentiles,
+                                          util::volume_value_mapping&  out_mapping,
+                                          const scm::size_t            in_slab_budget)
+{
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
+
+    if (!vol_reader) {
+        return texture_3d_ptr();
+    }
+
+    const vec3ui      data_dimensions = vol_reader->dimensions();
+    const data_format vol_format      = vol_reader->format();
+
+    if (   !util::volume_conversion_supported(vol_format, in_target_format)
+        || !util::volume_statistics::format_supported(vol_format)) {
+        err() << log::error
+              << "volume_loader::load_volume_data_converted(): unsupported conversion ("
+              << format_string(vol_format) << " -> " << format_string(in_target_format) << ")." << log::end;
+        return texture_3d_ptr();
+    }
+
+    // mip levels are built at source precision and converted afterwards
+    unsigned mip_count = util::max_mip_levels(data_dimensions);
+
+    if (!util::mipmap_generation_supported(vol_format)) {
+        out() << log::warning
+              << "volume_loader::load_volume_data_converted(): mip map generation not supported for format ("
+              << format_string(vol_format) << "), loading base level only." << log::end;
+        mip_count = 1;
+    }
+
+    const scm::size_t volume_size  =   static_cast<scm::size_t>(data_dimensions.x) * data_dimensions.y * data_dimensions.z
+                                     * size_of_format(vol_format);
+
+    out() << log::indent;
+    out() << "streaming volume data "
+          << "(dimensions: " << data_dimensions << ", format: " << format_string(vol_format)
+          << " -> " << format_string(in_target_format)
+          << ", mip-level: " << mip_count
+          << ", size : " << std::fixed << std::setprecision(3) << static_cast<double>(volume_size) / (1024.0*1024.0) << "MiB"
+          << ", slab slices: " << volume_slab_slices(*vol_reader, in_slab_budget - in_slab_budget / 3) << ")..." << log::end;
+
+    time::high_res_timer total_timer;
+    time::high_res_timer timer;
+    total_timer.start();
+
+    // statistics pass for the source value range
+    timer.start();
+    util::volume_statistics vol_stats(data_dimensions, vol_format, 65536);
+    if (!vol_stats.compute(*vol_reader, in_slab_budget)) {
+        err() << log::error
+              << "volume_loader::load_volume_data_converted(): unable to read data from file ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+    const vec2d source_range = (in_percentiles.x <= 0.0 && in_percentiles.y >= 1.0)
+                             ? vec2d(vol_stats.min_value(), vol_stats.max_value())
+                             : util::percentile_range(vol_stats, in_percentiles.x, in_percentiles.y);
+    timer.stop();
+    const time::time_duration stats_time = timer.get_time();
+
+    if (!util::make_volume_value_mapping(vol_format, in_target_format, source_range, out_mapping)) {
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+
+    timer.start();
+    texture_3d_ptr new_volume_tex = in_device.create_texture_3d(data_dimensions, in_target_format, mip_count);
+    timer.stop();
+    if (!new_volume_tex) {
+        err() << log::error
+              << "volume_loader::load_volume_data_converted(): unable to allocate texture storage ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+    const time::time_duration alloc_time = timer.get_time();
+
+    // per slice conversion step on top of the streamed mip levels
+    std::vector<uint8>      convert_buffer;
+    const slice_conversion  convert =
+        [&](const texture_region& region, const uint8* data) -> const uint8* {
+            const scm::size_t count = static_cast<scm::size_t>(region._dimensions.x) * region._dimensions.y * region._dimensions.z;
+            convert_buffer.resize(math::max(convert_buffer.size(), count * size_of_format(in_target_format)));
+            util::convert_volume_data(out_mapping, count, data, &convert_buffer.front());
+            return &convert_buffer.front();
+        };
+
+    mip_stream_times        times;
+    const mip_stream_result result = stream_mip_levels(in_device, *vol_reader, new_volume_tex, mip_count, 0, in_target_format,
+                                                       convert, volume_slab_function(), in_slab_budget, times);
+
+    total_timer.stop();
+
+    if (result == MIP_STREAM_READ_FAILED) {
+        err() << log::error
+              << "volume_loader::load_volume_data_converted(): unable to read data from file ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+    if (result == MIP_STREAM_UPLOAD_FAILED) {
+        err() << log::error
+              << "volume_loader::load_volume_data_converted(): unable to build or upload mip map hierarchy ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return texture_3d_ptr();
+    }
+
+    out() << "computing value range done"
+          << " (range: " << source_range << ", elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(stats_time) << "s)" << log::end;
+    out() << "allocating texture storage done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(alloc_time) << "s)" << log::end;
+    out() << "reading volume data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._read) << "s)" << log::end;
+    out() << "generating mip map hierarchy done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._mip) << "s)" << log::end;
+    out() << "converting volume data done"
+          << " (scale: " << out_mapping._scale << ", offset: " << out_mapping._offset
+          << ", elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._convert) << "s)" << log::end;
+    out() << "uploading texture data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(times._upload) << "s)" << log::end;
+    out() << "streaming volume data done"
+          << " (elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(total_timer.get_time()) << "s)" << log::end;
+
+    out() << log::outdent;
+
+    return new_volume_tex;
+}
+
+volume_occupancy_grid_ptr
+volume_loader::load_occupancy_grid(const std::string&   in_image_path,
+                                   const math::vec3ui&  in_brick_dimensions,
+                                   const bool           in_distance_field)
+{
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
+
+    if (!vol_reader) {
+        return volume_occupancy_grid_ptr();
+    }
+
+    if (!util::volume_statistics::format_supported(vol_reader->format())) {
+        err() << log::error
+              << "volume_loader::load_occupancy_grid(): unsupported volume data format ("
+              << format_string(vol_reader->format()) << ")." << log::end;
+        return volume_occupancy_grid_ptr();
+    }
+
+    out() << log::indent;
+    time::high_res_timer timer;
+
+    out() << "building occupancy grid (brick dimensions: " << in_brick_dimensions << ")..." << log::end;
+    timer.start();
+    util::volume_statistics vol_stats(vol_reader->dimensions(), vol_reader->format(), 256, in_brick_dimensions);
+    if (!vol_stats.compute(*vol_reader)) {
+        err() << log::error
+              << "volume_loader::load_occupancy_grid(): unable to read data from file ('" << in_image_path << "')." << log::end;
+        out() << log::outdent;
+        return volume_occupancy_grid_ptr();
+    }
+    volume_occupancy_grid_ptr grid = make_shared<volume_occupancy_grid>(vol_stats, 0u, in_distance_field);
+    timer.stop();
+    out() << "building occupancy grid done"
+          << " (grid dimensions: " << grid->grid_dimensions()
+          << ", elapsed time: " << std::fixed << std::setprecision(3)
+          << time::to_seconds(timer.get_time()) << "s)" << log::end;
+
+    out() << log::outdent;
+
+    return grid;
+}
+
+scm::math::vec3ui
+volume_loader::read_dimensions(const std::string&  in_image_path)
+{
+	using namespace scm::gl;
+	using namespace scm::math;
+
+	volume_reader_ptr vol_reader = open_volume_reader(in_image_path);
+
+	if (!vol_reader) {
 		return scm::math::vec3ui::zero();
 	}
-	//out() << "source data dimensions: " << vol_reader->dimensions() << log::end;
-
-	data_dimensions = vol_reader->dimensions();
-	data_format = vol_reader->format();
 
-	return data_dimensions;
+	return vol_reader->dimensions();
 }
 
 } // namespace gl
@@ -15,6 +15,8 @@
 #include <scm/gl_core/texture_objects/texture_objects_fwd.h>
 
 #include <scm/gl_util/data/imaging/imaging_fwd.h>
+#include <scm/gl_util/data/volume/volume_data_conversion.h>
+#include <scm/gl_util/data/volume/volume_occupancy_grid.h>
 
 #include <scm/core/platform/platform.h>
 #include <scm/core/utilities/platform_warning_disable.h>
@@ -27,15 +29,67 @@ class __scm_export(gl_util) volume_loader
 
 public:
 
+    // volumes exceeding the device 3d texture size limit are loaded as
+    // downsampled copy (see load_texture_3d_downsampled), the second variant
+    // returns the source to texture dimension ratio per axis in out_scale
+    // (1 for volumes loaded at full resolution)
     texture_3d_ptr              load_texture_3d(render_device&       in_device,
                                                 const std::string&   in_image_path,
                                                 bool                 in_create_mips,
                                                 bool                 in_color_mips  = false,
                                                 const data_format    in_force_internal_format = FORMAT_NULL);
+    texture_3d_ptr              load_texture_3d(render_device&       in_device,
+                                                const std::string&   in_image_path,
+                                                math::vec3f&         out_scale,
+                                                bool                 in_create_mips,
+                                                bool                 in_color_mips  = false,
+                                                const data_format    in_force_internal_format = FORMAT_NULL);
 
 	texture_3d_ptr              load_volume_data(render_device&       in_device,
 											     const std::string&  in_volume_path);
 
+    // streaming variant of load_volume_data, the volume is read in slabs of
+    // z-slices on a separate thread while the mip levels of the previous slab
+    // are built and uploaded into the preallocated texture storage, the memory
+    // used for volume data stays within roughly in_slab_budget bytes
+    // - with out_occupancy_grid the empty space skipping grid of the first
+    //   channel is built from the same slabs (see load_occupancy_grid), it
+    //   stays empty for unsupported formats
+    texture_3d_ptr              load_volume_data_streaming(render_device&              in_device,
+                                                           const std::string&          in_volume_path,
+                                                           const scm::size_t           in_slab_budget      = 64 * 1024 * 1024,
+                                                           volume_occupancy_grid_ptr*  out_occupancy_grid  = 0,
+                                                           const math::vec3ui&         in_brick_dimensions = math::vec3ui(16u));
+
+    // loads a filtered downsampled copy of the volume fitting the device 3d
+    // texture size limit and in_memory_budget bytes (0: device limit only),
+    // the volume is streamed in slabs of z-slices and reduced by repeated
+    // non-power-of-two mip level filtering, out_scale receives the source to
+    // texture dimension ratio per axis
+    texture_3d_ptr              load_texture_3d_downsampled(render_device&       in_device,
+                                                            const std::string&   in_volume_path,
+                                                            const scm::size_t    in_memory_budget,
+                                                            math::vec3f&         out_scale,
+                                                            const scm::size_t    in_slab_budget = 64 * 1024 * 1024);
+
+    // loads single channel volumes converted to the compact in_target_format
+    // (FORMAT_R_8, FORMAT_R_16 or FORMAT_R_16F), a statistics pass determines
+    // the source range between the lower and upper percentile (0, 1: min/max)
+    // before the volume is streamed, mip mapped at source precision and
+    // converted slice wise, out_mapping receives the value reconstruction
+    texture_3d_ptr              load_volume_data_converted(render_device&               in_device,
+                                                           const std::string&           in_volume_path,
+                                                           const data_format            in_target_format,
+                                                           const math::vec2d&           in_percentiles,
+                                                           util::volume_value_mapping&  out_mapping,
+                                                           const scm::size_t            in_slab_budget = 64 * 1024 * 1024);
+
+    // reads the volume once to build the empty space skipping grid of the
+    // first channel, all bricks are occupied until it is classified
+    volume_occupancy_grid_ptr   load_occupancy_grid(const std::string&   in_volume_path,
+                                                    const math::vec3ui&  in_brick_dimensions = math::vec3ui(16u),
+                                                    const bool           in_distance_field   = true);
+
 	scm::math::vec3ui			read_dimensions(const std::string&  in_volume_path);
 
 }; // class volume_loader
@@ -0,0 +1,270 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_occupancy_grid.h"
+
+#include <scm/gl_core/log.h>
+#include <scm/gl_core/render_device.h>
+#include <scm/gl_core/texture_objects.h>
+
+#include <scm/gl_util/data/analysis/volume_statistics.h>
+
+namespace {
+
+const scm::uint8    max_distance = 255u;
+
+// value returned by texture sampling for a raw channel value of the format
+double
+sampled_value(scm::gl::data_format fmt, double v)
+{
+    using namespace scm::gl;
+
+    if (!is_normalized(fmt)) {
+        return v;
+    }
+    switch (fmt) {
+    case FORMAT_R_8S:   case FORMAT_RG_8S:  case FORMAT_RGB_8S:  case FORMAT_RGBA_8S:
+        return scm::math::max(-1.0, v / 127.0);
+    case FORMAT_R_16S:  case FORMAT_RG_16S: case FORMAT_RGB_16S: case FORMAT_RGBA_16S:
+        return scm::math::max(-1.0, v / 32767.0);
+    default:
+        return v / static_cast<double>((1u << (8 * size_of_channel(fmt))) - 1u);
+    }
+}
+
+// union of the ranges of direct neighbors along one axis
+void
+dilate_ranges(std::vector<scm::math::vec2f>& r,
+              const scm::size_t              stride,
+              const unsigned                 axis_size)
+{
+    using namespace scm::math;
+
+    const std::vector<vec2f> src(r);
+
+    for (scm::size_t i = 0; i < r.size(); ++i) {
+        const unsigned a = static_cast<unsigned>((i / stride) % axis_size);
+        if (a > 0) {
+            r[i].x = min(r[i].x, src[i - stride].x);
+            r[i].y = max(r[i].y, src[i - stride].y);
+        }
+        if (a + 1 < axis_size) {
+            r[i].x = min(r[i].x, src[i + stride].x);
+            r[i].y = max(r[i].y, src[i + stride].y);
+        }
+    }
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+volume_occupancy_grid::volume_occupancy_grid(const util::volume_statistics&    vstats,
+                                             const unsigned                    channel,
+                                             const bool                        distance_field)
+  : _volume_dimensions(vstats.volume_dimensions())
+  , _brick_dimensions(vstats.brick_dimensions())
+  , _grid_dimensions(vstats.brick_grid_dimensions())
+  , _distance_field(distance_field)
+  , _occupied_count(0)
+{
+    using namespace scm::math;
+
+    const scm::size_t brick_count = static_cast<scm::size_t>(_grid_dimensions.x) * _grid_dimensions.y * _grid_dimensions.z;
+
+    _brick_ranges.resize(brick_count);
+    _distances.assign(brick_count, 0u);
+
+    if (channel >= vstats.channel_count()) {
+        glerr() << log::error
+                << "volume_occupancy_grid::volume_occupancy_grid(): invalid channel (" << channel << ")." << log::end;
+        _occupied_count = brick_count;
+        return;
+    }
+
+    const data_format fmt = vstats.volume_format();
+    scm::size_t       b   = 0;
+    for (unsigned z = 0; z < _grid_dimensions.z; ++z) {
+        for (unsigned y = 0; y < _grid_dimensions.y; ++y) {
+            for (unsigned x = 0; x < _grid_dimensions.x; ++x, ++b) {
+                const vec2d& r = vstats.brick_range(vec3ui(x, y, z), channel);
+                _brick_ranges[b] = r.x <= r.y ? vec2f(static_cast<float>(sampled_value(fmt, r.x)),
+                                                      static_cast<float>(sampled_value(fmt, r.y)))
+                                              : vec2f(1.0f, -1.0f); // no voxels
+            }
+        }
+    }
+
+    // separable 26-neighborhood dilation
+    const scm::size_t slice_size = static_cast<scm::size_t>(_grid_dimensions.x) * _grid_dimensions.y;
+    dilate_ranges(_brick_ranges, 1,                   _grid_dimensions.x);
+    dilate_ranges(_brick_ranges, _grid_dimensions.x,  _grid_dimensions.y);
+    dilate_ranges(_brick_ranges, slice_size,          _grid_dimensions.z);
+
+    // everything is occupied until classified
+    _occupied_count = brick_count;
+}
+
+volume_occupancy_grid::~volume_occupancy_grid()
+{
+    _texture.reset();
+}
+
+void
+volume_occupancy_grid::classify(const float*           alpha_lut,
+                                const unsigned         lut_size,
+                                const math::vec2f&     lut_value_range,
+                                const float            alpha_threshold)
+{
+    using namespace scm::math;
+
+    if (lut_size == 0) {
+        return;
+    }
+
+    // next_occupied[i]: first lookup table entry >= i with alpha above the threshold
+    std::vector<unsigned> next_occupied(lut_size + 1);
+    next_occupied[lut_size] = lut_size;
+    for (int i = static_cast<int>(lut_size) - 1; i >= 0; --i) {
+        next_occupied[i] = alpha_lut[i] > alpha_threshold ? i : next_occupied[i + 1];
+    }
+
+    // linear filtering of the lookup table touches entries floor(u * n - 0.5) and the next one
+    const float  lut_scale = lut_value_range.y > lut_value_range.x ? 1.0f / (lut_value_range.y - lut_value_range.x) : 0.0f;
+    const float  n         = static_cast<float>(lut_size);
+    const int    last      = static_cast<int>(lut_size) - 1;
+
+    _occupied_count = 0;
+    for (scm::size_t b = 0; b < _brick_ranges.size(); ++b) {
+        const vec2f& r = _brick_ranges[b];
+        bool         occupied = false;
+
+        if (r.x <= r.y) {
+            const float u_lo = (r.x - lut_value_range.x) * lut_scale;
+            const float u_hi = (r.y - lut_value_range.x) * lut_scale;
+            const int   i_lo = clamp(static_cast<int>(floor(u_lo * n - 0.5f)),        0, last);
+            const int   i_hi = clamp(static_cast<int>(floor(u_hi * n - 0.5f)) + 1,    0, last);
+
+            occupied = static_cast<int>(next_occupied[i_lo]) <= i_hi;
+        }
+
+        _distances[b] = occupied ? 0u : max_distance;
+        _occupied_count += occupied ? 1 : 0;
+    }
+
+    update_distances();
+}
+
+void
+volume_occupancy_grid::update_distances()
+{
+    using namespace scm::math;
+
+    if (!_distance_field) {
+        for (scm::size_t b = 0; b < _distances.size(); ++b) {
+            _distances[b] = _distances[b] > 0 ? 1u : 0u;
+        }
+        return;
+    }
+
+    // two pass chamfer transform with unit weights over the 26-neighborhood,
+    // exact for the chessboard distance
+    const int gx = static_cast<int>(_grid_dimensions.x);
+    const int gy = static_cast<int>(_grid_dimensions.y);
+    const int gz = static_cast<int>(_grid_dimensions.z);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        const int step = pass == 0 ? 1 : -1;
+        const int z0   = pass == 0 ? 0 : gz - 1;
+        const int y0   = pass == 0 ? 0 : gy - 1;
+        const int x0   = pass == 0 ? 0 : gx - 1;
+
+        for (int z = z0; z >= 0 && z < gz; z += step) {
+            for (int y = y0; y >= 0 && y < gy; y += step) {
+                for (int x = x0; x >= 0 && x < gx; x += step) {
+                    uint8& d = _distances[(static_cast<scm::size_t>(z) * gy + y) * gx + x];
+                    if (d == 0) {
+                        continue;
+                    }
+                    unsigned dmin = d;
+                    // neighbors preceding (x, y, z) in the scan order of this pass
+                    for (int dz = -1; dz <= 0; ++dz) {
+                        for (int dy = -1; dy <= 1; ++dy) {
+                            for (int dx = -1; dx <= 1; ++dx) {
+                                if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0))) {
+                                    continue;
+                                }
+                                const int nx = x + dx * step;
+                                const int ny = y + dy * step;
+                                const int nz = z + dz * step;
+                                if (nx < 0 || nx >= gx || ny < 0 || ny >= gy || nz < 0 || nz >= gz) {
+                                    continue;
+                                }
+                                dmin = min(dmin, _distances[(static_cast<scm::size_t>(nz) * gy + ny) * gx + nx] + 1u);
+                            }
+                        }
+                    }
+                    d = static_cast<uint8>(min(dmin, static_cast<unsigned>(max_distance)));
+                }
+            }
+        }
+    }
+}
+
+const math::vec3ui&
+volume_occupancy_grid::grid_dimensions() const
+{
+    return _grid_dimensions;
+}
+
+const math::vec3ui&
+volume_occupancy_grid::brick_dimensions() const
+{
+    return _brick_dimensions;
+}
+
+const math::vec3f
+volume_occupancy_grid::texture_to_grid_scale() const
+{
+    return math::vec3f(_volume_dimensions) / math::vec3f(_brick_dimensions);
+}
+
+scm::size_t
+volume_occupancy_grid::occupied_brick_count() const
+{
+    return _occupied_count;
+}
+
+const std::vector<uint8>&
+volume_occupancy_grid::distances() const
+{
+    return _distances;
+}
+
+bool
+volume_occupancy_grid::update_texture(render_device&             device,
+                                      const render_context_ptr&  context)
+{
+    if (!_texture) {
+        _texture = device.create_texture_3d(_grid_dimensions, FORMAT_R_8UI, 1);
+        if (!_texture) {
+            glerr() << log::error
+                    << "volume_occupancy_grid::update_texture(): unable to create texture (dimensions: "
+                    << _grid_dimensions << ")." << log::end;
+            return false;
+        }
+    }
+
+    return context->update_sub_texture(_texture, texture_region(math::vec3ui(0u), _grid_dimensions), 0u, FORMAT_R_8UI, &_distances.front());
+}
+
+const texture_3d_ptr&
+volume_occupancy_grid::texture() const
+{
+    return _texture;
+}
+
+} // namespace gl
+} // namespace scm
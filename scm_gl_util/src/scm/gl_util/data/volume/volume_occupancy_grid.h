@@ -0,0 +1,92 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_OCCUPANCY_GRID_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_OCCUPANCY_GRID_H_INCLUDED
+
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/memory.h>
+#include <scm/core/numeric_types.h>
+
+#include <scm/gl_core/data_formats.h>
+#include <scm/gl_core/render_device/render_device_fwd.h>
+#include <scm/gl_core/texture_objects/texture_objects_fwd.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+namespace util {
+class volume_statistics;
+} // namespace util
+
+class volume_occupancy_grid;
+
+typedef shared_ptr<volume_occupancy_grid>   volume_occupancy_grid_ptr;
+
+// coarse brick grid for empty space skipping
+// - built from the brick value ranges of a volume_statistics, every brick
+//   range is extended by the ranges of its neighbor bricks to cover the
+//   footprint of trilinear filtering across brick borders
+// - classify() marks the bricks whose value range maps to non-transparent
+//   lookup table entries, it only touches the brick ranges and is cheap
+//   enough to run on every transfer function change
+// - the texture (FORMAT_R_8UI, one texel per brick) holds the chessboard
+//   distance in bricks to the next occupied brick, 0 for occupied bricks,
+//   without distance field it only holds 0 (occupied) and 1 (empty)
+class __scm_export(gl_util) volume_occupancy_grid
+{
+public:
+    volume_occupancy_grid(const util::volume_statistics&    vstats,
+                          const unsigned                    channel         = 0,
+                          const bool                        distance_field  = true);
+    ~volume_occupancy_grid();
+
+    // alpha_lut holds the opacity of the lookup table entries, lut_value_range
+    // is the range of sampled volume texture values mapped to the lookup table
+    void                        classify(const float*           alpha_lut,
+                                         const unsigned         lut_size,
+                                         const math::vec2f&     lut_value_range,
+                                         const float            alpha_threshold = 0.0f);
+
+    const math::vec3ui&         grid_dimensions() const;
+    const math::vec3ui&         brick_dimensions() const;
+    // scale from normalized texture coordinates to brick grid coordinates
+    const math::vec3f           texture_to_grid_scale() const;
+
+    scm::size_t                 occupied_brick_count() const;
+    const std::vector<uint8>&   distances() const;
+
+    // creates the texture on first use and uploads the current classification
+    bool                        update_texture(render_device&             device,
+                                               const render_context_ptr&  context);
+    const texture_3d_ptr&       texture() const;
+
+private:
+    void                        update_distances();
+
+private:
+    math::vec3ui                _volume_dimensions;
+    math::vec3ui                _brick_dimensions;
+    math::vec3ui                _grid_dimensions;
+    bool                        _distance_field;
+
+    std::vector<math::vec2f>    _brick_ranges;      // dilated, in sampled texture values
+    std::vector<uint8>          _distances;
+    scm::size_t                 _occupied_count;
+
+    texture_3d_ptr              _texture;
+
+}; // class volume_occupancy_grid
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_VOLUME_OCCUPANCY_GRID_H_INCLUDED
@@ -4,6 +4,19 @@
 
 #include "volume_reader.h"
 
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <scm/log.h>
+#include <scm/core/time/high_res_timer.h>
+
+#include <scm/gl_util/data/volume/volume_reader_bricked.h>
+#include <scm/gl_util/data/volume/volume_reader_chunked.h>
+#include <scm/gl_util/data/volume/volume_reader_raw.h>
+#include <scm/gl_util/data/volume/volume_reader_segy.h>
+#include <scm/gl_util/data/volume/volume_reader_vgeo.h>
+
 namespace scm {
 namespace gl {
 
@@ -42,5 +55,117 @@ volume_reader::operator! () const
     return _file.get() == 0;
 }
 
+volume_reader_ptr
+open_volume_reader(const std::string& file_path)
+{
+    using namespace boost::filesystem;
+
+    std::string file_extension = path(file_path).extension().string();
+
+    boost::algorithm::to_lower(file_extension);
+
+    volume_reader_ptr vol_reader;
+
+    if (file_extension == ".raw") {
+        vol_reader.reset(new volume_reader_raw(file_path, false));
+    }
+    else if (file_extension == ".vol") {
+        vol_reader.reset(new volume_reader_vgeo(file_path, true));
+    }
+    else if (file_extension == ".segy" || file_extension == ".sgy") {
+        vol_reader.reset(new volume_reader_segy(file_path, true));
+    }
+    else if (file_extension == ".cvol") {
+        vol_reader.reset(new volume_reader_chunked(file_path, false));
+    }
+    else if (file_extension == ".bvol") {
+        vol_reader.reset(new volume_reader_bricked(file_path, false));
+    }
+    else {
+        err() << log::error
+              << "open_volume_reader(): unsupported volume file format ('" << file_extension << "')." << log::end;
+        return volume_reader_ptr();
+    }
+
+    if (!(*vol_reader)) {
+        err() << log::error
+              << "open_volume_reader(): unable to open file ('" << file_path << "')." << log::end;
+        return volume_reader_ptr();
+    }
+
+    return vol_reader;
+}
+
+unsigned
+volume_slab_slices(const volume_reader& reader,
+                   const scm::size_t    slab_budget)
+{
+    const math::vec3ui& dim        = reader.dimensions();
+    const scm::size_t   slice_size = static_cast<scm::size_t>(dim.x) * dim.y * size_of_format(reader.format());
+
+    if (slice_size == 0) {
+        return 0;
+    }
+
+    return static_cast<unsigned>(math::min<scm::size_t>(dim.z, math::max<scm::size_t>(1, slab_budget / (2 * slice_size))));
+}
+
+bool
+stream_volume_slabs(volume_reader&              reader,
+                    const scm::size_t           slab_budget,
+                    const volume_slab_function& slab_func,
+                    time::time_duration*        out_read_time)
+{
+    using namespace scm::math;
+
+    const vec3ui      dim         = reader.dimensions();
+    const scm::size_t slice_size  = static_cast<scm::size_t>(dim.x) * dim.y * size_of_format(reader.format());
+    const unsigned    slab_slices = volume_slab_slices(reader, slab_budget);
+
+    if (slab_slices == 0) {
+        return dim.z == 0;
+    }
+
+    scm::scoped_array<scm::uint8> slab_buffers[2];
+    slab_buffers[0].reset(new scm::uint8[slab_slices * slice_size]);
+    slab_buffers[1].reset(new scm::uint8[slab_slices * slice_size]);
+    time::time_duration           read_time;
+    bool                          read_ok = true;
+
+    const auto read_slab = [&](unsigned z_first, unsigned z_count, scm::uint8* buffer) {
+        time::high_res_timer read_timer;
+        read_timer.start();
+        read_ok = reader.read(vec3ui(0, 0, z_first), vec3ui(dim.x, dim.y, z_count), buffer) && read_ok;
+        read_timer.stop();
+        read_time += read_timer.get_time();
+    };
+
+    read_slab(0, slab_slices, slab_buffers[0].get());
+
+    bool slab_ok = true;
+    for (unsigned z = 0, s = 0; z < dim.z && read_ok && slab_ok; z += slab_slices, s ^= 1) {
+        const unsigned z_count = min(slab_slices, dim.z - z);
+        const unsigned z_next  = z + z_count;
+
+        // read the next slab while the current one is processed
+        scm::scoped_ptr<boost::thread> read_thread;
+        if (z_next < dim.z) {
+            read_thread.reset(new boost::thread(read_slab, z_next, min(slab_slices, dim.z - z_next), slab_buffers[s ^ 1].get()));
+        }
+
+        slab_ok = slab_func(z, z_count, slab_buffers[s].get());
+
+        if (read_thread) {
+            read_thread->join();
+        }
+    }
+
+    if (out_read_time) {
+        *out_read_time = read_time;
+    }
+
+    return read_ok && slab_ok;
+}
+
 } // namespace gl
 } // namespace scm
@@ -7,10 +7,15 @@
 
 #include <string>
 
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/function.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
 #include <scm/core/math.h>
 #include <scm/core/numeric_types.h>
 #include <scm/core/memory.h>
 #include <scm/core/io/io_fwd.h>
+#include <scm/core/time/time_types.h>
 
 #include <scm/gl_core/data_formats.h>
 #include <scm/gl_core/data_types.h>
@@ -49,6 +54,32 @@ protected:
 
 }; // struct volume_reader
 
+typedef shared_ptr<volume_reader>   volume_reader_ptr;
+
+// opens the reader matching the file extension (.raw, .vol, .segy/.sgy, .cvol
+// or .bvol), logs the error and returns an empty pointer for unsupported or
+// unreadable files
+__scm_export(gl_util) volume_reader_ptr open_volume_reader(const std::string& file_path);
+
+// streams the whole volume front to back in slabs of z-slices
+// - two slab buffers of at most slab_budget / 2 bytes (at least one slice
+//   each), the next slab is read on a separate thread while slab_func
+//   processes the current one
+// - slab_func receives the tightly packed slices [z_first, z_first + z_count),
+//   returning false stops the streaming
+// - returns false if a read failed or slab_func stopped the streaming,
+//   out_read_time (optional) receives the time spent reading
+typedef boost::function<bool (unsigned          z_first,
+                              unsigned          z_count,
+                              const scm::uint8* data)>  volume_slab_function;
+
+__scm_export(gl_util) unsigned  volume_slab_slices(const volume_reader&         reader,
+                                                   const scm::size_t            slab_budget);
+__scm_export(gl_util) bool      stream_volume_slabs(volume_reader&              reader,
+                                                    const scm::size_t           slab_budget,
+                                                    const volume_slab_function& slab_func,
+                                                    time::time_duration*        out_read_time = 0);
+
 } // namespace gl
 } // namespace scm
 
@@ -4,9 +4,15 @@
 
 #include "volume_reader_blocked.h"
 
+#include <cassert>
 #include <memory.h>
 
 #include <scm/core/io/file.h>
+#include <scm/core/io/file_mapping.h>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/utilities/parallel_for.h>
 
 namespace {
 
@@ -20,11 +26,18 @@ volume_reader_blocked::volume_reader_blocked(const std::string& file_path,
                                                    bool         file_unbuffered)
   : volume_reader(file_path, file_unbuffered)
   , _data_start_offset(0)
+  , _file_unbuffered(file_unbuffered)
+  , _read_thread_count(detail::default_read_thread_count)
 {
 }
 
 volume_reader_blocked::~volume_reader_blocked()
 {
+    boost::mutex::scoped_lock lock(_file_pool_mutex);
+    for (size_t i = 0; i < _file_pool.size(); ++i) {
+        _file_pool[i]->close();
+    }
+    _file_pool.clear();
 }
 
 bool
@@ -46,132 +59,268 @@ volume_reader_blocked::read(const scm::math::vec3ui& o,
         return true;
     }
 
-    if (   o == vec3ui(0u)
-        && s == _dimensions) {
-        // read complete volume
-        scm::int64 read_size =    static_cast<scm::int64>(_dimensions.x)
-                                * static_cast<scm::int64>(_dimensions.y)
-                                * static_cast<scm::int64>(_dimensions.z)
-                                * static_cast<scm::int64>(size_of_format(_format));
+    const vec3ui read_dim = clamp(s + o, vec3ui(0u), _dimensions) - o;
 
-        if (_file->read(d, _data_start_offset, read_size) != read_size) {
+    if (read_dim.x == 0 || read_dim.y == 0 || read_dim.z == 0) {
+        return true;
+    }
+
+    // split larger file reads into slabs of slices read in parallel, mapped
+    // data is copied by the calling thread (bound by memory bandwidth)
+    const int64     read_size = static_cast<int64>(size_of_format(_format))
+                              * read_dim.x * read_dim.y * read_dim.z;
+    const unsigned  slabs     = _data_mapping ? 1u
+                              : static_cast<unsigned>(max<int64>(1, min<int64>(min(_read_thread_count, read_dim.z),
+                                                                               read_size / detail::parallel_read_min_size)));
+
+    if (slabs <= 1) {
+        bool result = false;
+        read_slab(o, s, read_dim, d, 0, read_dim.z, &result);
+        return result;
+    }
+
+    // the slabs are read on the parallel_for pool, every thread working on the
+    // read acquires one file handle and keeps it for all its slabs
+    std::vector<io::file_ptr>   thread_files(util::parallel_worker_count(slabs));
+    scoped_array<bool>          results(new bool[slabs]);
+
+    util::parallel_for(slabs, [&](scm::size_t slab, scm::size_t thread_index) {
+        io::file_ptr& f = thread_files[thread_index];
+        if (!f) {
+            f = acquire_file();
+        }
+        const unsigned z_begin = static_cast<unsigned>((read_dim.z * slab)       / slabs);
+        const unsigned z_end   = static_cast<unsigned>((read_dim.z * (slab + 1)) / slabs);
+
+        results[slab] = f && read_slab_file(*f, o, s, read_dim, d, z_begin, z_end);
+    });
+
+    for (size_t t = 0; t < thread_files.size(); ++t) {
+        if (thread_files[t]) {
+            release_file(thread_files[t]);
+        }
+    }
+    for (unsigned t = 0; t < slabs; ++t) {
+        if (!results[t]) {
             return false;
         }
     }
-#if 1
-    else if (o.x == 0 && s.x == _dimensions.x) {
-        // we can read complete sets of lines/traces
-        scm::int64 offset_src;
-        scm::int64 offset_dst;
 
-        const int64             data_value_size = static_cast<int64>(size_of_format(_format));
-        const vec<int64, 3>     o64(o);
-        const vec<int64, 3>     d64(_dimensions);
-        const vec<int64, 3>     s64(s);
-        const vec3ui            read_dim = clamp(s + o, vec3ui(0u), _dimensions) - o;
-        const int64             dstart = _data_start_offset;
+    return true;
+}
 
-        for (unsigned int s = 0; s < read_dim.z; ++s) {
-            offset_src  =   o64.x
-                         +  o64.y      * d64.x
-                         + (o64.z + s) * d64.x * d64.y;
-            offset_src *= data_value_size;
+unsigned
+volume_reader_blocked::read_thread_count() const
+{
+    return _read_thread_count;
+}
 
-            offset_dst  = s64.x * s64.y * s;
-            offset_dst *= data_value_size;
+void
+volume_reader_blocked::read_thread_count(unsigned n)
+{
+    _read_thread_count = math::max(1u, n);
+}
 
-            char* dst_data = reinterpret_cast<char*>(d) + offset_dst;
+bool
+volume_reader_blocked::map_volume_data()
+{
+    using namespace scm::math;
 
-            scm::int64 read_off      = dstart + offset_src;
-            scm::int64 line_size_raw = data_value_size * read_dim.x;
-            scm::int64 read_size     = line_size_raw   * read_dim.y;
+    if (!(*this)) {
+        return false;
+    }
 
-            if (_file->read(dst_data, read_off, read_size) != read_size) {
-                return false;
-            }
-        }
+    const scm::int64 data_size =   static_cast<scm::int64>(_dimensions.x)
+                                 * static_cast<scm::int64>(_dimensions.y)
+                                 * static_cast<scm::int64>(_dimensions.z)
+                                 * static_cast<scm::int64>(size_of_format(_format));
+
+    // no read-ahead hints for the whole range, most readers only touch parts of
+    // the volume, the reads announce their ranges (read_slab_mapped)
+    _data_mapping = _file->map(_data_start_offset, data_size, io::file_mapping::access_normal);
+
+    if (!_data_mapping) {
+        glout() << log::warning
+                << "volume_reader_blocked::map_volume_data(): "
+                << "unable to map volume data, falling back to buffered reads (" << _file_path << ")." << log::end;
+        return false;
+    }
+
+    return true;
+}
+
+void
+volume_reader_blocked::read_slab(const scm::math::vec3ui& o,
+                                 const scm::math::vec3ui& s,
+                                 const scm::math::vec3ui& read_dim,
+                                       void*              d,
+                                       unsigned           z_begin,
+                                       unsigned           z_end,
+                                       bool*              result)
+{
+    if (_data_mapping) {
+        *result = read_slab_mapped(o, s, read_dim, d, z_begin, z_end);
+        return;
+    }
+
+    io::file_ptr f = acquire_file();
+    if (!f) {
+        *result = false;
+        return;
     }
-    else if (o.x == 0 && s.x > _dimensions.x) {
 
-#else
-    else if (o.x == 0 && s.x >= _dimensions.x) {
-#endif
+    *result = read_slab_file(*f, o, s, read_dim, d, z_begin, z_end);
+
+    release_file(f);
+}
+
+bool
+volume_reader_blocked::read_slab_file(io::file&                f,
+                                      const scm::math::vec3ui& o,
+                                      const scm::math::vec3ui& s,
+                                      const scm::math::vec3ui& read_dim,
+                                            void*              d,
+                                            unsigned           z_begin,
+                                            unsigned           z_end) const
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    const int64             data_value_size = static_cast<int64>(size_of_format(_format));
+    const vec<int64, 3>     o64(o);
+    const vec<int64, 3>     d64(_dimensions);
+    const vec<int64, 3>     s64(s);
+    const int64             slice_size      = data_value_size * d64.x * d64.y;
+
+    char*                   dst_base        = reinterpret_cast<char*>(d);
+
+    if (   read_dim.x == _dimensions.x
+        && s.x        == _dimensions.x
+        && read_dim.y == _dimensions.y
+        && s.y        == _dimensions.y) {
+        // source and destination slabs are contiguous, read them at once
+        const int64 read_off  = _data_start_offset + slice_size * (o64.z + z_begin);
+        const int64 read_size = slice_size * (z_end - z_begin);
+
+        if (f.read(dst_base + slice_size * z_begin, read_off, read_size) != read_size) {
+            return false;
+        }
+    }
+    else if (read_dim.x == _dimensions.x && s.x == _dimensions.x) {
         // we can read complete sets of lines/traces
-        scm::int64 offset_src;
-        scm::int64 offset_dst;
-
-        const int64             data_value_size = static_cast<int64>(size_of_format(_format));
-        const vec<int64, 3>     o64(o);
-        const vec<int64, 3>     d64(_dimensions);
-        const vec<int64, 3>     s64(s);
-        const vec3ui            read_dim = clamp(s + o, vec3ui(0u), _dimensions) - o;
-        const int64             dstart = _data_start_offset;
-
-        for (unsigned int s = 0; s < read_dim.z; ++s) {
-            offset_src =   o64.x
-                        +  o64.y      * d64.x
-                        + (o64.z + s) * d64.x * d64.y;
-            offset_src *= data_value_size;
-
-            scm::int64 read_off      = dstart + offset_src;
-            scm::int64 line_size_raw = data_value_size * read_dim.x;
-            scm::int64 read_size     = line_size_raw   * read_dim.y;
-
-            if (_file->read(_slice_buffer.get(), read_off, read_size) != read_size) {
+        const int64 read_size = data_value_size * d64.x * read_dim.y;
+
+        for (unsigned z = z_begin; z < z_end; ++z) {
+            const int64 read_off   = _data_start_offset
+                                   + data_value_size * o64.y * d64.x
+                                   + slice_size      * (o64.z + z);
+            const int64 offset_dst = data_value_size * s64.x * s64.y * z;
+
+            if (f.read(dst_base + offset_dst, read_off, read_size) != read_size) {
                 return false;
             }
-            else {
-                for (unsigned i = 0; i < read_dim.y; ++i) {
-                    offset_dst =  s64.x * i
-                                + s64.x * s64.y * s;
-                    offset_dst *= data_value_size;
+        }
+    }
+    else {
+        // gather all lines into a single batch, the file coalesces neighboring lines
+        io::file::read_extent_array line_extents;
+        line_extents.reserve(static_cast<size_t>(read_dim.y) * (z_end - z_begin));
+
+        const int64 read_size = data_value_size * read_dim.x;
+
+        for (unsigned z = z_begin; z < z_end; ++z) {
+            for (unsigned y = 0; y < read_dim.y; ++y) {
+                const int64 offset_src =  o64.x
+                                        + d64.x * (o64.y + y)
+                                        + d64.x * d64.y * (o64.z + z);
+                const int64 offset_dst =  s64.x * y
+                                        + s64.x * s64.y * z;
+
+                line_extents.push_back(io::file::read_extent(_data_start_offset + offset_src * data_value_size,
+                                                             dst_base + offset_dst * data_value_size,
+                                                             read_size));
+            }
+        }
+
+        if (f.read_batch(line_extents) != read_size * static_cast<int64>(line_extents.size())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+volume_reader_blocked::read_slab_mapped(const scm::math::vec3ui& o,
+                                        const scm::math::vec3ui& s,
+                                        const scm::math::vec3ui& read_dim,
+                                              void*              d,
+                                              unsigned           z_begin,
+                                              unsigned           z_end) const
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    assert(_data_mapping);
+
+    const int64             data_value_size = static_cast<int64>(size_of_format(_format));
+    const vec<int64, 3>     o64(o);
+    const vec<int64, 3>     d64(_dimensions);
+    const vec<int64, 3>     s64(s);
+
+    const char*             src_base = _data_mapping->data();
+    char*                   dst_base = reinterpret_cast<char*>(d);
 
-                    char* dst_data = reinterpret_cast<char*>(d) + offset_dst;
-                    char* src_data = reinterpret_cast<char*>(_slice_buffer.get());
+    // start reading in the lines of the slab before copying them
+    const int64 slice_span = data_value_size * d64.x * read_dim.y;
+    const int64 span_begin = data_value_size * (o64.y * d64.x + (o64.z + z_begin) * d64.x * d64.y);
 
-                    memcpy(dst_data, src_data + line_size_raw * i, line_size_raw);
-                }
+    if (read_dim.y == _dimensions.y) {
+        _data_mapping->will_need(span_begin, slice_span * (z_end - z_begin));
+    }
+    else {
+        for (unsigned int z = z_begin; z < z_end; ++z) {
+            _data_mapping->will_need(span_begin + data_value_size * d64.x * d64.y * (z - z_begin), slice_span);
+        }
+    }
+
+    if (   read_dim.x == _dimensions.x
+        && s.x        == _dimensions.x
+        && read_dim.y == s.y) {
+        // source and destination slices are contiguous, copy complete slabs
+        const int64 slice_size = data_value_size * d64.x * d64.y;
+        const int64 src_offset = data_value_size * (o64.y * d64.x + o64.z * d64.x * d64.y);
+        const int64 copy_size  = data_value_size * d64.x * read_dim.y;
+
+        if (read_dim.y == _dimensions.y) {
+            memcpy(dst_base   + copy_size  * z_begin,
+                   src_base   + src_offset + slice_size * z_begin,
+                   static_cast<size_t>(copy_size * (z_end - z_begin)));
+        }
+        else {
+            for (unsigned int z = z_begin; z < z_end; ++z) {
+                memcpy(dst_base   + copy_size  * z,
+                       src_base   + src_offset + slice_size * z,
+                       static_cast<size_t>(copy_size));
             }
         }
     }
     else {
-        // we have to read indivudual lines, should be the slowest
-
-        // read subvolume
-        //if (   (o.x + s.x > _dimensions.x)
-        //    || (o.y + s.y > _dimensions.y)
-        //    || (o.z + s.z > _dimensions.z)) {
-        //    return false;
-        //}
-
-        scm::int64 offset_src;
-        scm::int64 offset_dst;
-
-        const int64             data_value_size = static_cast<int64>(size_of_format(_format));
-        const vec<int64, 3>     offset64(o);
-        const vec<int64, 3>     dimensions64(_dimensions);
-        const vec<int64, 3>     buf_dimensions64(s);
-        const vec3ui            read_dim = clamp(s + o, vec3ui(0u), _dimensions) - o;
-
-        for (unsigned int s = 0; s < read_dim.z; ++s) {
-            for (unsigned int l = 0; l < read_dim.y; ++l) {
-                offset_src =  offset64.x
-                            + dimensions64.x * (offset64.y + l)
-                            + dimensions64.x * dimensions64.y * (offset64.z + s);
-                offset_src *= data_value_size;
-
-                offset_dst =  buf_dimensions64.x * l
-                            + buf_dimensions64.x * buf_dimensions64.y * s;
-                offset_dst *= data_value_size;
-
-                scm::int64 read_off  = _data_start_offset + offset_src;
-                scm::int64 read_size = data_value_size * read_dim.x;
-
-                char* dst_data = reinterpret_cast<char*>(d) + offset_dst;
-
-                if (_file->read(dst_data, read_off, read_size) != read_size) {
-                    return false;
-                }
+        const int64 line_size = data_value_size * read_dim.x;
+
+        for (unsigned int z = z_begin; z < z_end; ++z) {
+            for (unsigned int y = 0; y < read_dim.y; ++y) {
+                int64 offset_src =  o64.x
+                                  + d64.x * (o64.y + y)
+                                  + d64.x * d64.y * (o64.z + z);
+                int64 offset_dst =  s64.x * y
+                                  + s64.x * s64.y * z;
+
+                memcpy(dst_base + offset_dst * data_value_size,
+                       src_base + offset_src * data_value_size,
+                       static_cast<size_t>(line_size));
             }
         }
     }
@@ -179,5 +328,37 @@ volume_reader_blocked::read(const scm::math::vec3ui& o,
     return true;
 }
 
+io::file_ptr
+volume_reader_blocked::acquire_file()
+{
+    {
+        boost::mutex::scoped_lock lock(_file_pool_mutex);
+        if (!_file_pool.empty()) {
+            io::file_ptr f = _file_pool.back();
+            _file_pool.pop_back();
+            return f;
+        }
+    }
+
+    // file cores are not thread safe, every concurrent read uses its own file
+    io::file_ptr f = make_shared<io::file>();
+
+    if (!f->open(_file->file_path(), std::ios_base::in, _file_unbuffered)) {
+        glerr() << log::error
+                << "volume_reader_blocked::acquire_file(): "
+                << "error opening volume file (" << _file->file_path() << ")." << log::end;
+        return io::file_ptr();
+    }
+
+    return f;
+}
+
+void
+volume_reader_blocked::release_file(const io::file_ptr& f)
+{
+    boost::mutex::scoped_lock lock(_file_pool_mutex);
+    _file_pool.push_back(f);
+}
+
 } // namespace gl
 } // namespace scm
@@ -5,8 +5,15 @@
 #ifndef SCM_GL_UTIL_VOLUME_READER_BLOCKED_H_INCLUDED
 #define SCM_GL_UTIL_VOLUME_READER_BLOCKED_H_INCLUDED
 
+#include <vector>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/thread/mutex.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
 #include <scm/core/memory.h>
 #include <scm/core/numeric_types.h>
+#include <scm/core/io/io_fwd.h>
 
 #include <scm/gl_util/data/volume/volume_reader.h>
 
@@ -16,6 +23,17 @@
 namespace scm {
 namespace gl {
 
+namespace detail {
+
+const unsigned      default_read_thread_count   = 4;
+const scm::int64    parallel_read_min_size      = 4 * 1024 * 1024;  // min bytes per read thread
+
+} // namespace detail
+
+// reader for volumes stored as plain voxel arrays (x fastest, then y and z)
+// - larger file reads are split into slabs of slices read on the
+//   util::parallel_for pool, every thread uses its own file handle
+// - read is reentrant, it may be called concurrently by multiple threads
 class __scm_export(gl_util) volume_reader_blocked : public volume_reader
 {
 public:
@@ -29,9 +47,53 @@ public:
                              const scm::math::vec3ui& s,
                                    void*              d);
 
+    // max slabs a read is split into, the parallel_for pool bounds the threads
+    unsigned            read_thread_count() const;
+    void                read_thread_count(unsigned n);
+
+protected:
+    // map the complete volume data into memory, reads are then served
+    // directly from the mapping without any intermediate buffers, only the
+    // ranges of the reads are read in (no read-ahead of the whole volume)
+    bool                map_volume_data();
+
+private:
+    void                read_slab(const scm::math::vec3ui& o,
+                                  const scm::math::vec3ui& s,
+                                  const scm::math::vec3ui& read_dim,
+                                        void*              d,
+                                        unsigned           z_begin,
+                                        unsigned           z_end,
+                                        bool*              result);
+    bool                read_slab_file(io::file&                f,
+                                       const scm::math::vec3ui& o,
+                                       const scm::math::vec3ui& s,
+                                       const scm::math::vec3ui& read_dim,
+                                             void*              d,
+                                             unsigned           z_begin,
+                                             unsigned           z_end) const;
+    bool                read_slab_mapped(const scm::math::vec3ui& o,
+                                         const scm::math::vec3ui& s,
+                                         const scm::math::vec3ui& read_dim,
+                                               void*              d,
+                                               unsigned           z_begin,
+                                               unsigned           z_end) const;
+
+    io::file_ptr        acquire_file();
+    void                release_file(const io::file_ptr& f);
+
 protected:
     int64               _data_start_offset;
-    shared_array<uint8> _slice_buffer;
+    bool                _file_unbuffered;
+
+    io::file_mapping_ptr _data_mapping;
+
+private:
+    unsigned                    _read_thread_count;
+
+    // additional file handles for concurrent reads
+    std::vector<io::file_ptr>   _file_pool;
+    boost::mutex                _file_pool_mutex;
 
 }; // struct volume_reader_blocked
 
@@ -0,0 +1,298 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_reader_bricked.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/static_assert.hpp>
+
+#include <scm/core/io/file.h>
+
+#include <scm/gl_core/log.h>
+
+namespace {
+
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::bricked_volume_header) == 64);
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::bricked_volume_level)  == 32);
+BOOST_STATIC_ASSERT(sizeof(scm::gl::data::bricked_volume_brick)  == 16);
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+volume_reader_bricked::volume_reader_bricked(const std::string& file_path,
+                                                   bool         file_unbuffered)
+  : volume_reader(file_path, file_unbuffered)
+{
+    using namespace boost::filesystem;
+    using namespace scm::math;
+
+    path            fpath(file_path);
+
+    _file = make_shared<io::file>();
+
+    if (!_file->open(fpath.string(), std::ios_base::in, file_unbuffered)) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_bricked::volume_reader_bricked(): "
+                << "error opening volume file (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    if (_file->read(&_header, 0, sizeof(data::bricked_volume_header)) != sizeof(data::bricked_volume_header)) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_bricked::volume_reader_bricked(): "
+                << "error reading bricked volume header (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    if (   memcmp(_header._magic, data::bricked_volume_magic, sizeof(data::bricked_volume_magic)) != 0
+        || _header._version != data::bricked_volume_version) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_bricked::volume_reader_bricked(): "
+                << "not a bricked volume file or unsupported version (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    _format     = static_cast<data_format>(_header._data_format);
+    _dimensions = vec3ui(_header._dimensions[0], _header._dimensions[1], _header._dimensions[2]);
+
+    if (   _format <= FORMAT_NULL
+        || _format >= FORMAT_COUNT
+        || static_cast<scm::uint32>(size_of_format(_format)) != _header._bytes_per_voxel
+        || _header._brick_size  == 0
+        || _header._level_count == 0) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_bricked::volume_reader_bricked(): "
+                << "invalid data format or brick layout in header (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    const scm::int64 levels_size = static_cast<scm::int64>(_header._level_count * sizeof(data::bricked_volume_level));
+    const scm::int64 index_size  = static_cast<scm::int64>(_header._brick_count * sizeof(data::bricked_volume_brick));
+
+    _levels.resize(_header._level_count);
+    _brick_index.resize(static_cast<size_t>(_header._brick_count));
+
+    if (   static_cast<scm::int64>(_header._index_offset) + index_size > _file->size()
+        || _file->read(&_levels.front(), sizeof(data::bricked_volume_header), levels_size) != levels_size
+        || (   index_size > 0
+            && _file->read(&_brick_index.front(), _header._index_offset, index_size) != index_size)) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_bricked::volume_reader_bricked(): "
+                << "error reading level table or brick index (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    const scm::uint64 brick_size = brick_data_size();
+    for (unsigned l = 0; l < level_count(); ++l) {
+        const data::bricked_volume_level& lvl = _levels[l];
+        const scm::uint64 level_bricks =   static_cast<scm::uint64>(lvl._brick_grid[0])
+                                         * static_cast<scm::uint64>(lvl._brick_grid[1])
+                                         * static_cast<scm::uint64>(lvl._brick_grid[2]);
+        if (lvl._first_brick + level_bricks > _header._brick_count) {
+            _file.reset();
+            glerr() << scm::log::error
+                    << "volume_reader_bricked::volume_reader_bricked(): "
+                    << "level " << l << " exceeds the brick index (" << fpath.string() << ")." << scm::log::end;
+            return;
+        }
+    }
+    for (size_t b = 0; b < _brick_index.size(); ++b) {
+        if (   _brick_index[b]._size != brick_size
+            || static_cast<scm::int64>(_brick_index[b]._offset + _brick_index[b]._size) > _file->size()) {
+            _file.reset();
+            glerr() << scm::log::error
+                    << "volume_reader_bricked::volume_reader_bricked(): "
+                    << "invalid brick index entry " << b << " (" << fpath.string() << ")." << scm::log::end;
+            return;
+        }
+    }
+}
+
+volume_reader_bricked::~volume_reader_bricked()
+{
+    if (_file) {
+        _file->close();
+        _file.reset();
+    }
+}
+
+unsigned
+volume_reader_bricked::level_count() const
+{
+    return static_cast<unsigned>(_levels.size());
+}
+
+const math::vec3ui
+volume_reader_bricked::level_dimensions(unsigned level) const
+{
+    assert(level < _levels.size());
+    const data::bricked_volume_level& lvl = _levels[level];
+    return math::vec3ui(lvl._dimensions[0], lvl._dimensions[1], lvl._dimensions[2]);
+}
+
+const math::vec3ui
+volume_reader_bricked::brick_grid(unsigned level) const
+{
+    assert(level < _levels.size());
+    const data::bricked_volume_level& lvl = _levels[level];
+    return math::vec3ui(lvl._brick_grid[0], lvl._brick_grid[1], lvl._brick_grid[2]);
+}
+
+unsigned
+volume_reader_bricked::brick_size() const
+{
+    return _header._brick_size;
+}
+
+unsigned
+volume_reader_bricked::apron() const
+{
+    return _header._apron;
+}
+
+const math::vec3ui
+volume_reader_bricked::padded_brick_dimensions() const
+{
+    return math::vec3ui(_header._brick_size + 2 * _header._apron);
+}
+
+scm::size_t
+volume_reader_bricked::brick_data_size() const
+{
+    const scm::size_t p = _header._brick_size + 2 * _header._apron;
+    return p * p * p * _header._bytes_per_voxel;
+}
+
+bool
+volume_reader_bricked::read_brick(unsigned                 level,
+                                  const scm::math::vec3ui& brick,
+                                        void*              d)
+{
+    if (!(*this)) {
+        return false;
+    }
+
+    if (level >= level_count()) {
+        glerr() << scm::log::error
+                << "volume_reader_bricked::read_brick(): "
+                << "invalid level " << level << " (level count: " << level_count() << ")." << scm::log::end;
+        return false;
+    }
+
+    const math::vec3ui grid = brick_grid(level);
+    if (   brick.x >= grid.x
+        || brick.y >= grid.y
+        || brick.z >= grid.z) {
+        glerr() << scm::log::error
+                << "volume_reader_bricked::read_brick(): "
+                << "brick " << brick << " outside of brick grid " << grid << " at level " << level << "." << scm::log::end;
+        return false;
+    }
+
+    const scm::size_t b =   _levels[level]._first_brick
+                          + brick.x
+                          + static_cast<scm::size_t>(grid.x) * (brick.y + static_cast<scm::size_t>(grid.y) * brick.z);
+    const data::bricked_volume_brick& e = _brick_index[b];
+
+    if (_file->read(d, e._offset, e._size) != static_cast<io::file::size_type>(e._size)) {
+        glerr() << scm::log::error
+                << "volume_reader_bricked::read_brick(): "
+                << "error reading brick " << brick << " at level " << level << " (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+volume_reader_bricked::read(const scm::math::vec3ui& o,
+                            const scm::math::vec3ui& s,
+                                  void*              d)
+{
+    return read_level(0, o, s, d);
+}
+
+bool
+volume_reader_bricked::read_level(unsigned                 level,
+                                  const scm::math::vec3ui& o,
+                                  const scm::math::vec3ui& s,
+                                        void*              d)
+{
+    using namespace scm::math;
+
+    if (!(*this) || level >= level_count()) {
+        return false;
+    }
+
+    const vec3ui ldim = level_dimensions(level);
+
+    if (   o.x >= ldim.x
+        || o.y >= ldim.y
+        || o.z >= ldim.z) {
+        return true;
+    }
+
+    const vec3ui read_dim = clamp(s + o, vec3ui(0u), ldim) - o;
+
+    if (read_dim.x == 0 || read_dim.y == 0 || read_dim.z == 0) {
+        return true;
+    }
+
+    const unsigned      bs         = brick_size();
+    const unsigned      a          = apron();
+    const unsigned      p          = bs + 2 * a;
+    const scm::size_t   value_size = size_of_format(_format);
+
+    const vec3ui        bb = o / bs;
+    const vec3ui        be = (o + read_dim - vec3ui(1u)) / bs;
+
+    _brick_buffer.resize(brick_data_size());
+
+    scm::uint8*         dst_base = reinterpret_cast<scm::uint8*>(d);
+
+    for (unsigned bz = bb.z; bz <= be.z; ++bz) {
+        for (unsigned by = bb.y; by <= be.y; ++by) {
+            for (unsigned bx = bb.x; bx <= be.x; ++bx) {
+                if (!read_brick(level, vec3ui(bx, by, bz), &_brick_buffer.front())) {
+                    return false;
+                }
+
+                // copy the inner brick voxels intersecting the requested region
+                const vec3ui borigin = vec3ui(bx, by, bz) * bs;
+                const vec3ui lo      = max(o, borigin);
+                const vec3ui hi      = min(o + read_dim, borigin + vec3ui(bs));
+
+                const scm::size_t line_size = (hi.x - lo.x) * value_size;
+
+                for (unsigned z = lo.z; z < hi.z; ++z) {
+                    for (unsigned y = lo.y; y < hi.y; ++y) {
+                        const scm::size_t src_off =   (lo.x - borigin.x + a)
+                                                    + static_cast<scm::size_t>(p) * (y - borigin.y + a)
+                                                    + static_cast<scm::size_t>(p) * p * (z - borigin.z + a);
+                        const scm::size_t dst_off =   (lo.x - o.x)
+                                                    + static_cast<scm::size_t>(s.x) * (y - o.y)
+                                                    + static_cast<scm::size_t>(s.x) * s.y * (z - o.z);
+
+                        memcpy(dst_base + dst_off * value_size, &_brick_buffer[src_off * value_size], line_size);
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace gl
+} // namespace scm
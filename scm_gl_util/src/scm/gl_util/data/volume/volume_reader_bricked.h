@@ -0,0 +1,67 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_READER_BRICKED_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_READER_BRICKED_H_INCLUDED
+
+#include <vector>
+
+#include <scm/core/numeric_types.h>
+
+#include <scm/gl_util/data/volume/volume_reader.h>
+#include <scm/gl_util/data/volume/bricked/bricked_volume.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+// reader for bricked multi-resolution volumes (.bvol, see bricked/bricked_volume.h)
+// - read_brick fetches a single brick including its apron with one contiguous read
+// - read/read_level assemble arbitrary sub volumes of a level from its bricks
+class __scm_export(gl_util) volume_reader_bricked : public volume_reader
+{
+public:
+    volume_reader_bricked(const std::string& file_path,
+                                bool         file_unbuffered = false);
+    virtual ~volume_reader_bricked();
+
+    unsigned                    level_count() const;
+    const math::vec3ui          level_dimensions(unsigned level) const;
+    const math::vec3ui          brick_grid(unsigned level) const;
+
+    unsigned                    brick_size() const;
+    unsigned                    apron() const;
+    const math::vec3ui          padded_brick_dimensions() const;
+    scm::size_t                 brick_data_size() const;
+
+    // d has to hold brick_data_size() bytes
+    bool                        read_brick(unsigned                 level,
+                                           const scm::math::vec3ui& brick,
+                                                 void*              d);
+
+    bool                        read(const scm::math::vec3ui& o,
+                                     const scm::math::vec3ui& s,
+                                           void*              d);
+    bool                        read_level(unsigned                 level,
+                                           const scm::math::vec3ui& o,
+                                           const scm::math::vec3ui& s,
+                                                 void*              d);
+
+private:
+    data::bricked_volume_header     _header;
+    data::bricked_volume_level_vec  _levels;
+    data::bricked_volume_brick_vec  _brick_index;
+
+    std::vector<scm::uint8>         _brick_buffer;
+
+}; // struct volume_reader_bricked
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // #define SCM_GL_UTIL_VOLUME_READER_BRICKED_H_INCLUDED
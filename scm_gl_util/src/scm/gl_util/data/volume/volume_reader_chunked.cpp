@@ -0,0 +1,316 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_reader_chunked.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <scm/core/io/file.h>
+#include <scm/core/platform/byte_swap.h>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/utilities/parallel_for.h>
+
+namespace {
+
+// compressed bytes fetched with a single batched read
+const scm::int64 chunk_batch_size = 64 * 1024 * 1024;
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+volume_reader_chunked::volume_reader_chunked(const std::string& file_path,
+                                                   bool         file_unbuffered)
+  : volume_reader(file_path, file_unbuffered)
+  , _chunk_size(0u)
+  , _chunk_grid(0u)
+{
+    using namespace boost::filesystem;
+    using namespace scm::math;
+
+    path            fpath(file_path);
+
+    _file = make_shared<io::file>();
+
+    if (!_file->open(fpath.string(), std::ios_base::in, file_unbuffered)) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_chunked::volume_reader_chunked(): "
+                << "error opening volume file (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    if (_file->read(&_header, 0, sizeof(data::chunked_volume_header)) != sizeof(data::chunked_volume_header)) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_chunked::volume_reader_chunked(): "
+                << "error reading chunked volume header (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    if (   memcmp(_header._magic, data::chunked_volume_magic, sizeof(data::chunked_volume_magic)) != 0
+        || _header._version != data::chunked_volume_version) {
+        // a byte swapped version marks a file written with the other byte order
+        scm::uint32 swapped_version = _header._version;
+        swap_bytes(&swapped_version);
+
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_chunked::volume_reader_chunked(): "
+                << (swapped_version == data::chunked_volume_version ? "chunked volume written with the other byte order ("
+                                                                    : "not a chunked volume file or unsupported version (")
+                << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    _format     = static_cast<data_format>(_header._data_format);
+    _dimensions = vec3ui(_header._dimensions[0], _header._dimensions[1], _header._dimensions[2]);
+    _chunk_size = vec3ui(_header._chunk_size[0], _header._chunk_size[1], _header._chunk_size[2]);
+
+    if (   _format <= FORMAT_NULL
+        || _format >= FORMAT_COUNT
+        || static_cast<scm::uint32>(size_of_format(_format)) != _header._bytes_per_voxel
+        || _chunk_size.x == 0 || _chunk_size.y == 0 || _chunk_size.z == 0) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_chunked::volume_reader_chunked(): "
+                << "invalid data format or chunk size in header (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    _chunk_grid = (_dimensions + _chunk_size - vec3ui(1u)) / _chunk_size;
+
+    const scm::uint64 chunk_count =   static_cast<scm::uint64>(_chunk_grid.x)
+                                    * static_cast<scm::uint64>(_chunk_grid.y)
+                                    * static_cast<scm::uint64>(_chunk_grid.z);
+    const scm::int64  table_size  = static_cast<scm::int64>(chunk_count * sizeof(data::chunked_volume_chunk));
+
+    if (   _header._chunk_count != chunk_count
+        || static_cast<scm::int64>(_header._table_offset) + table_size > _file->size()) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_chunked::volume_reader_chunked(): "
+                << "chunk table does not match volume dimensions or file size (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    _chunk_table.resize(static_cast<size_t>(chunk_count));
+    if (   chunk_count > 0
+        && _file->read(&_chunk_table.front(), _header._table_offset, table_size) != table_size) {
+        _file.reset();
+        glerr() << scm::log::error
+                << "volume_reader_chunked::volume_reader_chunked(): "
+                << "error reading chunk table (" << fpath.string() << ")." << scm::log::end;
+        return;
+    }
+
+    for (size_t c = 0; c < _chunk_table.size(); ++c) {
+        if (_chunk_table[c]._offset + _chunk_table[c]._size > _header._table_offset) {
+            _file.reset();
+            glerr() << scm::log::error
+                    << "volume_reader_chunked::volume_reader_chunked(): "
+                    << "chunk " << c << " exceeds the chunk data section (" << fpath.string() << ")." << scm::log::end;
+            return;
+        }
+    }
+}
+
+volume_reader_chunked::~volume_reader_chunked()
+{
+    if (_file) {
+        _file->close();
+        _file.reset();
+    }
+}
+
+const math::vec3ui&
+volume_reader_chunked::chunk_size() const
+{
+    return _chunk_size;
+}
+
+const math::vec3ui&
+volume_reader_chunked::chunk_grid() const
+{
+    return _chunk_grid;
+}
+
+bool
+volume_reader_chunked::read(const scm::math::vec3ui& o,
+                            const scm::math::vec3ui& s,
+                                  void*              d)
+{
+    using namespace scm::math;
+
+    if (!(*this)) {
+        return false;
+    }
+
+    if (   o.x >= _dimensions.x
+        || o.y >= _dimensions.y
+        || o.z >= _dimensions.z) {
+        return true;
+    }
+
+    const vec3ui read_dim = clamp(s + o, vec3ui(0u), _dimensions) - o;
+
+    if (read_dim.x == 0 || read_dim.y == 0 || read_dim.z == 0) {
+        return true;
+    }
+
+    // touched chunk range, chunks are visited in file order
+    const vec3ui cb = o / _chunk_size;
+    const vec3ui ce = (o + read_dim - vec3ui(1u)) / _chunk_size;
+
+    chunk_batch     batch;
+    scm::int64      batch_bytes = 0;
+
+    for (unsigned z = cb.z; z <= ce.z; ++z) {
+        for (unsigned y = cb.y; y <= ce.y; ++y) {
+            for (unsigned x = cb.x; x <= ce.x; ++x) {
+                const scm::size_t c =   x
+                                      + static_cast<scm::size_t>(_chunk_grid.x) * y
+                                      + static_cast<scm::size_t>(_chunk_grid.x) * _chunk_grid.y * z;
+
+                if (   !batch._chunks.empty()
+                    && batch_bytes + _chunk_table[c]._size > chunk_batch_size) {
+                    if (!read_batch(batch, o, s, read_dim, d)) {
+                        return false;
+                    }
+                    batch._chunks.clear();
+                    batch_bytes = 0;
+                }
+                batch._chunks.push_back(c);
+                batch_bytes += _chunk_table[c]._size;
+            }
+        }
+    }
+
+    return read_batch(batch, o, s, read_dim, d);
+}
+
+bool
+volume_reader_chunked::read_batch(chunk_batch&             b,
+                                  const scm::math::vec3ui& o,
+                                  const scm::math::vec3ui& s,
+                                  const scm::math::vec3ui& read_dim,
+                                        void*              d)
+{
+    if (b._chunks.empty()) {
+        return true;
+    }
+
+    // fetch all compressed chunks of the batch with a single batched read
+    scm::size_t total_size = 0;
+    b._data_offsets.resize(b._chunks.size());
+    for (scm::size_t i = 0; i < b._chunks.size(); ++i) {
+        b._data_offsets[i]  = total_size;
+        total_size         += _chunk_table[b._chunks[i]]._size;
+    }
+    b._data.resize(total_size + 1);
+
+    io::file::read_extent_array chunk_extents;
+    chunk_extents.reserve(b._chunks.size());
+
+    for (scm::size_t i = 0; i < b._chunks.size(); ++i) {
+        const data::chunked_volume_chunk& c = _chunk_table[b._chunks[i]];
+        chunk_extents.push_back(io::file::read_extent(c._offset, &b._data[b._data_offsets[i]], c._size));
+    }
+
+    if (_file->read_batch(chunk_extents) != static_cast<io::file::size_type>(total_size)) {
+        glerr() << scm::log::error
+                << "volume_reader_chunked::read_batch(): "
+                << "error reading chunk data (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    // decompress in parallel
+    const scm::size_t workers = util::parallel_worker_count(b._chunks.size());
+    if (_decode_buffers.size() < workers) {
+        _decode_buffers.resize(workers);
+        _scratch_buffers.resize(workers);
+    }
+    b._decoded.assign(b._chunks.size(), 0);
+
+    util::parallel_for(b._chunks.size(),
+                       boost::bind(&volume_reader_chunked::decode_chunk, this,
+                                   &b, boost::cref(o), boost::cref(s), boost::cref(read_dim), d, _1, _2));
+
+    for (scm::size_t i = 0; i < b._chunks.size(); ++i) {
+        if (!b._decoded[i]) {
+            glerr() << scm::log::error
+                    << "volume_reader_chunked::read_batch(): "
+                    << "error decompressing chunk " << b._chunks[i] << " (" << _file_path << ")." << scm::log::end;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+volume_reader_chunked::decode_chunk(chunk_batch*             b,
+                                    const scm::math::vec3ui& o,
+                                    const scm::math::vec3ui& s,
+                                    const scm::math::vec3ui& read_dim,
+                                          void*              d,
+                                          scm::size_t        i,
+                                          scm::size_t        thread_index)
+{
+    using namespace scm::math;
+
+    const scm::size_t                   c     = b->_chunks[i];
+    const data::chunked_volume_chunk&   chunk = _chunk_table[c];
+
+    // chunk position and extent, border chunks are cropped to the volume
+    const vec3ui cidx(static_cast<unsigned>(c % _chunk_grid.x),
+                      static_cast<unsigned>((c / _chunk_grid.x) % _chunk_grid.y),
+                      static_cast<unsigned>(c / (static_cast<scm::size_t>(_chunk_grid.x) * _chunk_grid.y)));
+    const vec3ui corigin = cidx * _chunk_size;
+    const vec3ui cdim     = min(_chunk_size, _dimensions - corigin);
+
+    const scm::size_t value_size = size_of_format(_format);
+    const scm::size_t chunk_size =   static_cast<scm::size_t>(cdim.x) * cdim.y * cdim.z * value_size;
+
+    std::vector<scm::uint8>& decoded = _decode_buffers[thread_index];
+    decoded.resize(chunk_size);
+
+    if (!data::decompress_chunk(&b->_data[b->_data_offsets[i]], chunk._size, value_size,
+                                static_cast<data::chunk_codec>(chunk._codec),
+                                &decoded.front(), chunk_size, _scratch_buffers[thread_index])) {
+        return;
+    }
+
+    // copy the lines intersecting the requested region, chunks never share destination lines
+    const vec3ui lo = max(o, corigin);
+    const vec3ui hi = min(o + read_dim, corigin + cdim);
+
+    const scm::size_t line_size = (hi.x - lo.x) * value_size;
+    scm::uint8*       dst_base  = reinterpret_cast<scm::uint8*>(d);
+
+    for (unsigned z = lo.z; z < hi.z; ++z) {
+        for (unsigned y = lo.y; y < hi.y; ++y) {
+            const scm::size_t src_off =   (lo.x - corigin.x)
+                                        + static_cast<scm::size_t>(cdim.x) * (y - corigin.y)
+                                        + static_cast<scm::size_t>(cdim.x) * cdim.y * (z - corigin.z);
+            const scm::size_t dst_off =   (lo.x - o.x)
+                                        + static_cast<scm::size_t>(s.x) * (y - o.y)
+                                        + static_cast<scm::size_t>(s.x) * s.y * (z - o.z);
+
+            memcpy(dst_base + dst_off * value_size, &decoded[src_off * value_size], line_size);
+        }
+    }
+
+    b->_decoded[i] = 1;
+}
+
+} // namespace gl
+} // namespace scm
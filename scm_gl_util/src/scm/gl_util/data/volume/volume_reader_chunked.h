@@ -0,0 +1,78 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_READER_CHUNKED_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_READER_CHUNKED_H_INCLUDED
+
+#include <vector>
+
+#include <scm/core/numeric_types.h>
+
+#include <scm/gl_util/data/volume/volume_reader.h>
+#include <scm/gl_util/data/volume/chunked/chunked_volume.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+// reader for chunked compressed volumes (.cvol, see chunked/chunked_volume.h)
+// - only the chunks intersecting a requested sub volume are read and decompressed
+// - the compressed chunks are fetched in large batches and decoded in parallel
+class __scm_export(gl_util) volume_reader_chunked : public volume_reader
+{
+    struct chunk_batch
+    {
+        std::vector<scm::size_t>    _chunks;        // chunk indices
+        std::vector<scm::size_t>    _data_offsets;  // chunk data offset in _data
+        std::vector<scm::uint8>     _data;
+        std::vector<char>           _decoded;       // per chunk decode result
+    }; // struct chunk_batch
+
+public:
+    volume_reader_chunked(const std::string& file_path,
+                                bool         file_unbuffered = false);
+    virtual ~volume_reader_chunked();
+
+    const math::vec3ui&         chunk_size() const;
+    const math::vec3ui&         chunk_grid() const;
+
+    bool                        read(const scm::math::vec3ui& o,
+                                     const scm::math::vec3ui& s,
+                                           void*              d);
+
+private:
+    bool                        read_batch(chunk_batch&             b,
+                                           const scm::math::vec3ui& o,
+                                           const scm::math::vec3ui& s,
+                                           const scm::math::vec3ui& read_dim,
+                                                 void*              d);
+    void                        decode_chunk(chunk_batch*             b,
+                                             const scm::math::vec3ui& o,
+                                             const scm::math::vec3ui& s,
+                                             const scm::math::vec3ui& read_dim,
+                                                   void*              d,
+                                                   scm::size_t        i,
+                                                   scm::size_t        thread_index);
+
+private:
+    data::chunked_volume_header             _header;
+    data::chunked_volume_chunk_vec          _chunk_table;
+
+    math::vec3ui                            _chunk_size;
+    math::vec3ui                            _chunk_grid;
+
+    // per decode thread buffers
+    std::vector<std::vector<scm::uint8> >   _decode_buffers;
+    std::vector<std::vector<scm::uint8> >   _scratch_buffers;
+
+}; // struct volume_reader_chunked
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // #define SCM_GL_UTIL_VOLUME_READER_CHUNKED_H_INCLUDED
@@ -158,8 +158,10 @@ volume_reader_raw::volume_reader_raw(const std::string& file_path,
         return;
     }
 
-    size_t slice_size = static_cast<size_t>(_dimensions.x) * _dimensions.y * size_of_format(_format);
-    _slice_buffer.reset(new uint8[slice_size]);
+    // system buffered files are served directly from a memory mapping
+    if (!file_unbuffered) {
+        map_volume_data();
+    }
 }
 
 volume_reader_raw::volume_reader_raw(
@@ -210,13 +212,14 @@ volume_reader_raw::volume_reader_raw(
         return;
     }
 
-    size_t slice_size = static_cast<size_t>(_dimensions.x) * _dimensions.y * size_of_format(_format);
-    _slice_buffer.reset(new uint8[slice_size]);
+    // system buffered files are served directly from a memory mapping
+    if (!file_unbuffered) {
+        map_volume_data();
+    }
 }
 
 volume_reader_raw::~volume_reader_raw()
 {
-    _slice_buffer.reset();
     _file->close();
     _file.reset();
 }
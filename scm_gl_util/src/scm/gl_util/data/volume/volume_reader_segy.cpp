@@ -4,6 +4,7 @@
 
 #include "volume_reader_segy.h"
 
+#include <cstring>
 #include <exception>
 #include <stdexcept>
 
@@ -17,54 +18,51 @@
 #include <scm/gl_core/log.h>
 
 #include <scm/gl_util/data/volume/segy/segy.h>
+#include <scm/gl_util/data/volume/segy/segy_convert.h>
+#include <scm/gl_util/data/volume/segy/segy_index.h>
 
 namespace {
 
-inline void
-ibm_to_ieee(float* f)
+// convert big endian trace samples in place
+bool
+swap_trace_samples(void*                           d,
+                   scm::int64                      size,
+                   const scm::gl::data::segy_data& sd,
+                   scm::gl::data_format            fmt)
 {
-    register int fc;
-    register int fmant;
-    register int t;
-
-    fc = *reinterpret_cast<int*>(f);
-    if (fc) {
-        fmant = 0x00ffffff & fc;
-        t = ((0x7f000000 & fc) >> 22) - 130;
-        if (t <= 0) {
-            fc = 0;
-        } else {
-            while (!(fmant & 0x00800000) && t != -1) {
-                --t;
-                fmant <<= 1;
-            }
-            if (t > 254) {
-                fc = (0x80000000 & fc) | 0x7f7fffff;
-            }
-            else if (t <= 0) {
-                fc = 0;
+    using namespace scm;
+
+    switch (gl::size_of_channel(fmt)) {
+        case 1:
+            break;
+        case 2:
+            swap_bytes_array(reinterpret_cast<uint16*>(d),
+                             size / sizeof(uint16));
+            break;
+        case 4:
+            if (sd._trace_format == gl::data::segy_data::SEGY_FORMAT_IBM) {
+                gl::data::swap_bytes_array_ibm_to_ieee(reinterpret_cast<float*>(d),
+                                                       reinterpret_cast<float*>(d),
+                                                       size / sizeof(float));
             }
             else {
-                fc = (0x80000000 & fc) | (t << 23) | (0x007fffff & fmant);
+                swap_bytes_array(reinterpret_cast<uint32*>(d),
+                                 size / sizeof(uint32));
             }
-        }
-        *f = *reinterpret_cast<float*>(&fc);
+            break;
+        case 8:
+            swap_bytes_array(reinterpret_cast<uint64*>(d),
+                             size / sizeof(uint64));
+            break;
+        default:
+            return false;
     }
-}
 
-inline
-void
-swap_bytes_array_ibm_to_ieee(float* d, float* s, scm::size_t c)
-{
-    for (scm::size_t i = 0; i < c; ++i) {
-        scm::do_swap_bytes<float, sizeof(float)>()(d + i, s + i);
-        ibm_to_ieee(d + i);
-    }
+    return true;
 }
 
 } // namespace
 
-
 namespace scm {
 namespace gl {
 
@@ -125,6 +123,12 @@ volume_reader_segy::read(const scm::math::vec3ui& o,
         return false;
     }
 
+    if (   _segy_data->_trace_index
+        && !_segy_data->_trace_index->grid_ordered()) {
+        // traces are missing or not stored in grid order
+        return read_indexed(o, sz, d);
+    }
+
     {
         // read subvolume
         //if (   (o.x + s.x > _dimensions.x)
@@ -200,9 +204,9 @@ volume_reader_segy::read(const scm::math::vec3ui& o,
                                         char* src_data = reinterpret_cast<char*>(_segy_slice_buffer.get());
 
                                         if (_segy_data->_trace_format == data::segy_data::SEGY_FORMAT_IBM) {
-                                            swap_bytes_array_ibm_to_ieee(reinterpret_cast<float*>(dst_data),
-                                                                            reinterpret_cast<float*>(src_data + line_size_sgy * i + thsize),
-                                                                            line_size_raw / sizeof(float));
+                                            data::swap_bytes_array_ibm_to_ieee(reinterpret_cast<float*>(dst_data),
+                                                                               reinterpret_cast<float*>(src_data + line_size_sgy * i + thsize),
+                                                                               line_size_raw / sizeof(float));
                                         }
                                         else {
                                             swap_bytes_array(reinterpret_cast<uint32*> (dst_data),
@@ -258,66 +262,42 @@ volume_reader_segy::read(const scm::math::vec3ui& o,
             const int64             dstart = _segy_data->_traces_start;
             const int64             thsize = sizeof(data::segy_trace_header);
 
+            // gather the sample ranges of all traces into a single batch, skipping
+            // the trace headers. the samples land directly in the destination buffer
+            io::file::read_extent_array line_extents;
+            line_extents.reserve(static_cast<size_t>(read_dim.y) * read_dim.z);
+
+            const scm::int64 read_size = data_value_size * read_dim.x;
+
             for (unsigned int s = 0; s < read_dim.z; ++s) {
                 for (unsigned int l = 0; l < read_dim.y; ++l) {
                     offset_src =  o64.x
                                 + d64.x * (o64.y + l)
                                 + d64.x * d64.y * (o64.z + s);
                     offset_src *= data_value_size;
-                    offset_src += thsize * ((o64.y + l) + d64.y * (o64.z + s)); // consider the trace headers
+                    offset_src += thsize * ((o64.y + l) + d64.y * (o64.z + s) + 1); // consider the trace headers
 
                     offset_dst =  s64.x * l
                                 + s64.x * s64.y * s;
                     offset_dst *= data_value_size;
 
                     scm::int64 read_off  = dstart + offset_src;
-                    scm::int64 read_size = data_value_size * read_dim.x + thsize;
 
+                    char* dst_data = reinterpret_cast<char*>(d) + offset_dst;
 
-                    if (_file->read(_segy_slice_buffer.get(), read_off, read_size) != read_size) {
+                    line_extents.push_back(io::file::read_extent(read_off, dst_data, read_size));
+                }
+            }
+
+            if (_file->read_batch(line_extents) != read_size * static_cast<scm::int64>(line_extents.size())) {
+                return false;
+            }
+
+            if (_segy_data->_swap_bytes_required) {
+                for (io::file::read_extent_array::const_iterator e = line_extents.begin(); e != line_extents.end(); ++e) {
+                    if (!swap_trace_samples(e->_buffer, read_size, *_segy_data, _format)) {
                         return false;
                     }
-                    else {
-                        char* dst_data = reinterpret_cast<char*>(d) + offset_dst;
-                        char* src_data = reinterpret_cast<char*>(_segy_slice_buffer.get()) + thsize;
-
-                        if (_segy_data->_swap_bytes_required) {
-                            switch (size_of_channel(_format)) {
-                                case 1: 
-                                    swap_bytes_array(reinterpret_cast<uint8*>(dst_data),
-                                                     reinterpret_cast<uint8*>(src_data),
-                                                     (read_size - thsize) / sizeof(uint8));
-                                    break;
-                                case 2:
-                                    swap_bytes_array(reinterpret_cast<uint16*>(dst_data),
-                                                     reinterpret_cast<uint16*>(src_data),
-                                                     (read_size - thsize) / sizeof(uint16));
-                                    break;
-                                case 4:
-                                    if (_segy_data->_trace_format == data::segy_data::SEGY_FORMAT_IBM) {
-                                        swap_bytes_array_ibm_to_ieee(reinterpret_cast<float*>(dst_data),
-                                                                     reinterpret_cast<float*>(src_data),
-                                                                     (read_size - thsize) / sizeof(float));
-                                    }
-                                    else {
-                                        swap_bytes_array(reinterpret_cast<uint32*>(dst_data),
-                                                         reinterpret_cast<uint32*>(src_data),
-                                                         (read_size - thsize) / sizeof(uint32));
-                                    }
-                                    break;
-                                case 8:
-                                    swap_bytes_array(reinterpret_cast<uint64*>(dst_data),
-                                                     reinterpret_cast<uint64*>(src_data),
-                                                     (read_size - thsize) / sizeof(uint64));
-                                    break;
-                            default:
-                                return false;
-                            }
-                        }
-                        else {
-                            memcpy(dst_data, src_data, read_size - thsize);
-                        }
-                    }
                 }
             }
         }
@@ -327,5 +307,69 @@ volume_reader_segy::read(const scm::math::vec3ui& o,
     return true;
 }
 
+bool
+volume_reader_segy::read_indexed(const scm::math::vec3ui& o,
+                                 const scm::math::vec3ui& sz,
+                                       void*              d)
+{
+    using namespace scm;
+    using namespace scm::gl;
+    using namespace scm::math;
+
+    if (   o.x >= _dimensions.x
+        || o.y >= _dimensions.y
+        || o.z >= _dimensions.z) {
+        return true;
+    }
+
+    const data::segy_trace_index&   index           = *_segy_data->_trace_index;
+    const int64                     data_value_size = static_cast<int64>(size_of_format(_format));
+    const vec<int64, 3>             s64(sz);
+    const vec3ui                    read_dim        = clamp(sz + o, vec3ui(0u), _dimensions) - o;
+    const int64                     dstart          = _segy_data->_traces_start;
+    const int64                     tsize           = static_cast<int64>(_segy_data->_trace_size);
+    const int64                     thsize          = sizeof(data::segy_trace_header);
+    const int64                     read_size       = data_value_size * read_dim.x;
+
+    if (read_dim.x == 0 || read_dim.y == 0 || read_dim.z == 0) {
+        return true;
+    }
+
+    // look up the traces of all lines in the trace index, lines without a
+    // trace in the survey are cleared
+    io::file::read_extent_array line_extents;
+    line_extents.reserve(static_cast<size_t>(read_dim.y) * read_dim.z);
+
+    for (unsigned int s = 0; s < read_dim.z; ++s) {
+        for (unsigned int l = 0; l < read_dim.y; ++l) {
+            const int64 offset_dst = (s64.x * l + s64.x * s64.y * s) * data_value_size;
+            char*       dst_data   = reinterpret_cast<char*>(d) + offset_dst;
+            const int64 trace      = index.cell_trace(o.y + l, o.z + s);
+
+            if (trace < 0) {
+                memset(dst_data, 0, static_cast<size_t>(read_size));
+            }
+            else {
+                const int64 read_off = dstart + tsize * trace + thsize + data_value_size * o.x;
+                line_extents.push_back(io::file::read_extent(read_off, dst_data, read_size));
+            }
+        }
+    }
+
+    if (_file->read_batch(line_extents) != read_size * static_cast<scm::int64>(line_extents.size())) {
+        return false;
+    }
+
+    if (_segy_data->_swap_bytes_required) {
+        for (io::file::read_extent_array::const_iterator e = line_extents.begin(); e != line_extents.end(); ++e) {
+            if (!swap_trace_samples(e->_buffer, read_size, *_segy_data, _format)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 } // namespace gl
 } // namespace scm
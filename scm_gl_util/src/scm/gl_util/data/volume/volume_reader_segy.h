@@ -28,6 +28,12 @@ public:
     bool                read(const scm::math::vec3ui& o,
                              const scm::math::vec3ui& s,
                                    void*              d);
+protected:
+    // sub volume reads through the survey grid of the trace index
+    bool                read_indexed(const scm::math::vec3ui& o,
+                                     const scm::math::vec3ui& s,
+                                           void*              d);
+
 protected:
     shared_ptr<data::segy_data> _segy_data;
     shared_array<uint8>         _segy_slice_buffer;
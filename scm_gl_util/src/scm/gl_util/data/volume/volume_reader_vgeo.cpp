@@ -110,8 +110,10 @@ volume_reader_vgeo::volume_reader_vgeo(const std::string& file_path,
         return;
     }
 
-    size_t slice_size = static_cast<size_t>(_dimensions.x) * _dimensions.y * size_of_format(_format);
-    _slice_buffer.reset(new uint8[slice_size]);
+    // system buffered files are served directly from a memory mapping
+    if (!file_unbuffered) {
+        map_volume_data();
+    }
 
     //_vol_desc._volume_origin.x = vgeo_vol_hdr->xoffset;
     //_vol_desc._volume_origin.y = vgeo_vol_hdr->yoffset;
@@ -0,0 +1,411 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_writer_bricked.h"
+
+#include <cstring>
+#include <sstream>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <scm/core/math.h>
+#include <scm/core/io/file.h>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/data/volume/volume_reader.h>
+#include <scm/gl_util/data/volume/volume_reader_raw.h>
+
+namespace {
+
+scm::uint64
+align_size(scm::uint64 s, scm::uint64 a)
+{
+    return ((s + a - 1) / a) * a;
+}
+
+// 2x2x2 box filter of the slices [z_begin, z_begin + src_slices) of a slab,
+// samples beyond the volume border are clamped
+template<typename vtype>
+void
+typed_downsample_slices(const scm::uint8*           src,
+                        const scm::math::vec3ui&    slab_dim,
+                        int                         channels,
+                        unsigned                    z_begin,
+                        unsigned                    src_slices,
+                        const scm::math::vec3ui&    dst_dim,
+                        scm::uint8*                 dst)
+{
+    const vtype*    s           = reinterpret_cast<const vtype*>(src);
+    vtype*          d           = reinterpret_cast<vtype*>(dst);
+    const float     rounding    = boost::is_integral<vtype>::value ? 0.5f : 0.0f;
+    const unsigned  dst_slices  = (src_slices + 1) / 2;
+
+    for (unsigned z = 0; z < dst_slices; ++z) {
+        const unsigned sz0 = z_begin + 2 * z;
+        const unsigned sz1 = scm::math::min(sz0 + 1, slab_dim.z - 1);
+        for (unsigned y = 0; y < dst_dim.y; ++y) {
+            const unsigned sy0 = 2 * y;
+            const unsigned sy1 = scm::math::min(sy0 + 1, slab_dim.y - 1);
+            for (unsigned x = 0; x < dst_dim.x; ++x) {
+                const unsigned sx0 = 2 * x;
+                const unsigned sx1 = scm::math::min(sx0 + 1, slab_dim.x - 1);
+
+                const scm::size_t l00 = (static_cast<scm::size_t>(sz0) * slab_dim.y + sy0) * slab_dim.x;
+                const scm::size_t l01 = (static_cast<scm::size_t>(sz0) * slab_dim.y + sy1) * slab_dim.x;
+                const scm::size_t l10 = (static_cast<scm::size_t>(sz1) * slab_dim.y + sy0) * slab_dim.x;
+                const scm::size_t l11 = (static_cast<scm::size_t>(sz1) * slab_dim.y + sy1) * slab_dim.x;
+
+                for (int c = 0; c < channels; ++c) {
+                    const float sum =   static_cast<float>(s[(l00 + sx0) * channels + c]) + static_cast<float>(s[(l00 + sx1) * channels + c])
+                                      + static_cast<float>(s[(l01 + sx0) * channels + c]) + static_cast<float>(s[(l01 + sx1) * channels + c])
+                                      + static_cast<float>(s[(l10 + sx0) * channels + c]) + static_cast<float>(s[(l10 + sx1) * channels + c])
+                                      + static_cast<float>(s[(l11 + sx0) * channels + c]) + static_cast<float>(s[(l11 + sx1) * channels + c]);
+
+                    d[((static_cast<scm::size_t>(z) * dst_dim.y + y) * dst_dim.x + x) * channels + c] = static_cast<vtype>(sum * 0.125f + rounding);
+                }
+            }
+        }
+    }
+}
+
+bool
+downsample_supported(scm::gl::data_format fmt)
+{
+    using namespace scm::gl;
+
+    switch (fmt) {
+    case FORMAT_R_8:    case FORMAT_RG_8:    case FORMAT_RGB_8:    case FORMAT_RGBA_8:
+    case FORMAT_R_16:   case FORMAT_RG_16:   case FORMAT_RGB_16:   case FORMAT_RGBA_16:
+    case FORMAT_R_32F:  case FORMAT_RG_32F:  case FORMAT_RGB_32F:  case FORMAT_RGBA_32F:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool
+downsample_slices(scm::gl::data_format          fmt,
+                  const scm::uint8*             src,
+                  const scm::math::vec3ui&      slab_dim,
+                  unsigned                      z_begin,
+                  unsigned                      src_slices,
+                  const scm::math::vec3ui&      dst_dim,
+                  scm::uint8*                   dst)
+{
+    using namespace scm::gl;
+
+    const int channels = channel_count(fmt);
+
+    switch (fmt) {
+    case FORMAT_R_8:
+    case FORMAT_RG_8:
+    case FORMAT_RGB_8:
+    case FORMAT_RGBA_8:
+        typed_downsample_slices<scm::uint8>(src, slab_dim, channels, z_begin, src_slices, dst_dim, dst);
+        break;
+    case FORMAT_R_16:
+    case FORMAT_RG_16:
+    case FORMAT_RGB_16:
+    case FORMAT_RGBA_16:
+        typed_downsample_slices<scm::uint16>(src, slab_dim, channels, z_begin, src_slices, dst_dim, dst);
+        break;
+    case FORMAT_R_32F:
+    case FORMAT_RG_32F:
+    case FORMAT_RGB_32F:
+    case FORMAT_RGBA_32F:
+        typed_downsample_slices<float>(src, slab_dim, channels, z_begin, src_slices, dst_dim, dst);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+// copy a line of padded brick voxels starting at x_start (may be negative),
+// voxels outside the volume replicate the border voxels
+void
+copy_brick_line(const scm::uint8*   src_line,
+                unsigned            src_width,
+                int                 x_start,
+                unsigned            count,
+                scm::size_t         value_size,
+                scm::uint8*         dst)
+{
+    const int x_end = x_start + static_cast<int>(count);
+    const int x0    = scm::math::max(x_start, 0);
+    const int x1    = scm::math::min(x_end, static_cast<int>(src_width));
+
+    for (int x = x_start; x < x0; ++x) {
+        memcpy(dst, src_line, value_size);
+        dst += value_size;
+    }
+    if (x1 > x0) {
+        memcpy(dst, src_line + x0 * value_size, (x1 - x0) * value_size);
+        dst += (x1 - x0) * value_size;
+    }
+    for (int x = scm::math::max(x1, x0); x < x_end; ++x) {
+        memcpy(dst, src_line + (src_width - 1) * value_size, value_size);
+        dst += value_size;
+    }
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+
+volume_writer_bricked::volume_writer_bricked(const std::string&    file_path,
+                                             unsigned              brick_size,
+                                             unsigned              apron)
+  : _file_path(file_path)
+  , _brick_size(math::max(brick_size, 2u))
+  , _apron(math::min(apron, math::max(brick_size, 2u) / 2))
+{
+    // even brick sizes keep the brick layers aligned to the 2x2x2 level downsampling
+    _brick_size += _brick_size & 1u;
+}
+
+volume_writer_bricked::~volume_writer_bricked()
+{
+}
+
+bool
+volume_writer_bricked::write(volume_reader& src)
+{
+    using namespace boost::filesystem;
+    using namespace scm::math;
+
+    if (!src) {
+        glerr() << scm::log::error
+                << "volume_writer_bricked::write(): "
+                << "invalid source volume (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    const data_format   fmt        = src.format();
+    const scm::size_t   value_size = size_of_format(fmt);
+
+    if (!downsample_supported(fmt)) {
+        glerr() << scm::log::error
+                << "volume_writer_bricked::write(): "
+                << "unsupported volume data format (" << format_string(fmt) << ")." << scm::log::end;
+        return false;
+    }
+
+    // level and brick layout
+    data::bricked_volume_level_vec  levels;
+    vec3ui                          ldim = src.dimensions();
+    scm::uint64                     brick_count = 0;
+
+    while (true) {
+        data::bricked_volume_level lvl;
+        const vec3ui grid = (ldim + vec3ui(_brick_size - 1)) / _brick_size;
+        for (int c = 0; c < 3; ++c) {
+            lvl._dimensions[c] = ldim[c];
+            lvl._brick_grid[c] = grid[c];
+        }
+        lvl._first_brick = brick_count;
+        levels.push_back(lvl);
+
+        brick_count += static_cast<scm::uint64>(grid.x) * grid.y * grid.z;
+
+        if (ldim.x <= _brick_size && ldim.y <= _brick_size && ldim.z <= _brick_size) {
+            break;
+        }
+        ldim = max(vec3ui(1u), (ldim + vec3ui(1u)) / 2u);
+    }
+
+    const scm::uint64 padded_size = _brick_size + 2 * _apron;
+    const scm::uint64 brick_bytes = padded_size * padded_size * padded_size * value_size;
+    const scm::uint64 index_offset = sizeof(data::bricked_volume_header) + levels.size() * sizeof(data::bricked_volume_level);
+    const scm::uint64 data_offset  = align_size(index_offset + brick_count * sizeof(data::bricked_volume_brick),
+                                                data::bricked_volume_alignment);
+
+    data::bricked_volume_brick_vec bricks(static_cast<size_t>(brick_count));
+    for (scm::uint64 b = 0; b < brick_count; ++b) {
+        bricks[static_cast<size_t>(b)]._offset = data_offset + b * align_size(brick_bytes, data::bricked_volume_alignment);
+        bricks[static_cast<size_t>(b)]._size   = brick_bytes;
+    }
+
+    data::bricked_volume_header hdr;
+    memset(&hdr, 0, sizeof(data::bricked_volume_header));
+    memcpy(hdr._magic, data::bricked_volume_magic, sizeof(data::bricked_volume_magic));
+    hdr._version         = data::bricked_volume_version;
+    hdr._data_format     = static_cast<scm::uint32>(fmt);
+    hdr._bytes_per_voxel = static_cast<scm::uint32>(value_size);
+    hdr._brick_size      = _brick_size;
+    hdr._apron           = _apron;
+    hdr._level_count     = static_cast<scm::uint32>(levels.size());
+    hdr._brick_alignment = data::bricked_volume_alignment;
+    hdr._brick_count     = brick_count;
+    hdr._index_offset    = index_offset;
+    for (int c = 0; c < 3; ++c) {
+        hdr._dimensions[c] = src.dimensions()[c];
+    }
+
+    io::file out_file;
+
+    if (!out_file.open(_file_path, std::ios_base::out | std::ios_base::trunc, false)) {
+        glerr() << scm::log::error
+                << "volume_writer_bricked::write(): "
+                << "error opening output file (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    const io::file::size_type levels_size = static_cast<io::file::size_type>(levels.size() * sizeof(data::bricked_volume_level));
+    const io::file::size_type index_size  = static_cast<io::file::size_type>(bricks.size() * sizeof(data::bricked_volume_brick));
+
+    if (   out_file.write(&hdr, 0, sizeof(data::bricked_volume_header)) != sizeof(data::bricked_volume_header)
+        || out_file.write(&levels.front(), sizeof(data::bricked_volume_header), levels_size) != levels_size
+        || out_file.write(&bricks.front(), index_offset, index_size) != index_size) {
+        glerr() << scm::log::error
+                << "volume_writer_bricked::write(): "
+                << "error writing header and brick index (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    // levels, every level is read from the temporary file written by the previous one
+    bool        success = true;
+    std::string level_path;
+
+    for (unsigned l = 0; l < levels.size() && success; ++l) {
+        std::string next_level_path;
+        if (l + 1 < levels.size()) {
+            std::ostringstream p;
+            p << _file_path << ".level" << (l + 1) << ".tmp";
+            next_level_path = p.str();
+        }
+
+        if (l == 0) {
+            success = write_level(src, l, levels[l], bricks, out_file, next_level_path);
+        }
+        else {
+            const data::bricked_volume_level& lvl = levels[l];
+            volume_reader_raw level_reader(level_path,
+                                           vec3ui(lvl._dimensions[0], lvl._dimensions[1], lvl._dimensions[2]),
+                                           fmt, false);
+            success =    level_reader
+                      && write_level(level_reader, l, lvl, bricks, out_file, next_level_path);
+        }
+
+        if (!level_path.empty()) {
+            remove(path(level_path));
+        }
+        level_path = next_level_path;
+    }
+    if (!level_path.empty() && exists(path(level_path))) {
+        remove(path(level_path));
+    }
+
+    out_file.close();
+
+    return success;
+}
+
+bool
+volume_writer_bricked::write_level(volume_reader&                          src,
+                                   unsigned                                level,
+                                   const data::bricked_volume_level&       lvl,
+                                   const data::bricked_volume_brick_vec&   bricks,
+                                   io::file&                               out_file,
+                                   const std::string&                      next_level_path)
+{
+    using namespace scm::math;
+
+    const data_format   fmt        = src.format();
+    const scm::size_t   value_size = size_of_format(fmt);
+    const vec3ui        ldim(lvl._dimensions[0], lvl._dimensions[1], lvl._dimensions[2]);
+    const vec3ui        grid(lvl._brick_grid[0], lvl._brick_grid[1], lvl._brick_grid[2]);
+    const vec3ui        ndim = max(vec3ui(1u), (ldim + vec3ui(1u)) / 2u);
+    const unsigned      bs   = _brick_size;
+    const unsigned      a    = _apron;
+    const unsigned      p    = bs + 2 * a;
+
+    io::file next_file;
+    if (   !next_level_path.empty()
+        && !next_file.open(next_level_path, std::ios_base::out | std::ios_base::trunc, false)) {
+        glerr() << scm::log::error
+                << "volume_writer_bricked::write_level(): "
+                << "error opening temporary level file (" << next_level_path << ")." << scm::log::end;
+        return false;
+    }
+
+    const scm::size_t           slice_size = static_cast<scm::size_t>(ldim.x) * ldim.y * value_size;
+    std::vector<scm::uint8>     slab;
+    std::vector<scm::uint8>     brick(static_cast<size_t>(p) * p * p * value_size);
+    std::vector<scm::uint8>     next_slab;
+
+    for (unsigned bz = 0; bz < grid.z; ++bz) {
+        // one layer of bricks including the apron slices
+        const unsigned z0         = bz * bs;
+        const unsigned slab_begin = z0 >= a ? z0 - a : 0;
+        const unsigned slab_end   = min(ldim.z, z0 + bs + a);
+        const vec3ui   slab_dim(ldim.x, ldim.y, slab_end - slab_begin);
+
+        slab.resize(slice_size * slab_dim.z);
+        if (!src.read(vec3ui(0u, 0u, slab_begin), slab_dim, &slab.front())) {
+            glerr() << scm::log::error
+                    << "volume_writer_bricked::write_level(): "
+                    << "error reading source slices " << slab_begin << " to " << slab_end
+                    << " at level " << level << "." << scm::log::end;
+            return false;
+        }
+
+        for (unsigned by = 0; by < grid.y; ++by) {
+            for (unsigned bx = 0; bx < grid.x; ++bx) {
+                const int x_start = static_cast<int>(bx * bs) - static_cast<int>(a);
+
+                for (unsigned k = 0; k < p; ++k) {
+                    const unsigned vz = clamp(static_cast<int>(z0 + k) - static_cast<int>(a), 0, static_cast<int>(ldim.z) - 1) - slab_begin;
+                    for (unsigned j = 0; j < p; ++j) {
+                        const unsigned vy = clamp(static_cast<int>(by * bs + j) - static_cast<int>(a), 0, static_cast<int>(ldim.y) - 1);
+
+                        copy_brick_line(&slab[(static_cast<scm::size_t>(vz) * ldim.y + vy) * ldim.x * value_size],
+                                        ldim.x, x_start, p, value_size,
+                                        &brick[(static_cast<scm::size_t>(k) * p + j) * p * value_size]);
+                    }
+                }
+
+                const scm::size_t b = static_cast<scm::size_t>(lvl._first_brick) + bx + static_cast<scm::size_t>(grid.x) * (by + static_cast<scm::size_t>(grid.y) * bz);
+                const io::file::size_type brick_size = static_cast<io::file::size_type>(brick.size());
+
+                if (out_file.write(&brick.front(), bricks[b]._offset, brick_size) != brick_size) {
+                    glerr() << scm::log::error
+                            << "volume_writer_bricked::write_level(): "
+                            << "error writing brick " << vec3ui(bx, by, bz) << " at level " << level
+                            << " (" << _file_path << ")." << scm::log::end;
+                    return false;
+                }
+            }
+        }
+
+        // next coarser level from the inner slices of the slab
+        if (!next_level_path.empty()) {
+            const unsigned inner_slices = min(ldim.z, z0 + bs) - z0;
+            const unsigned next_slices  = (inner_slices + 1) / 2;
+            const scm::size_t next_slice_size = static_cast<scm::size_t>(ndim.x) * ndim.y * value_size;
+
+            next_slab.resize(next_slice_size * next_slices);
+            downsample_slices(fmt, &slab.front(), slab_dim, z0 - slab_begin, inner_slices, ndim, &next_slab.front());
+
+            const io::file::size_type next_size = static_cast<io::file::size_type>(next_slab.size());
+            if (next_file.write(&next_slab.front(), static_cast<io::file::offset_type>(z0 / 2) * next_slice_size, next_size) != next_size) {
+                glerr() << scm::log::error
+                        << "volume_writer_bricked::write_level(): "
+                        << "error writing temporary level file (" << next_level_path << ")." << scm::log::end;
+                return false;
+            }
+        }
+    }
+
+    next_file.close();
+
+    return true;
+}
+
+} // namespace gl
+} // namespace scm
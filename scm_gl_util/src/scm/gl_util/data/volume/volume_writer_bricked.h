@@ -0,0 +1,61 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_WRITER_BRICKED_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_WRITER_BRICKED_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <scm/core/numeric_types.h>
+#include <scm/core/io/io_fwd.h>
+
+#include <scm/gl_util/data/volume/bricked/bricked_volume.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+class volume_reader;
+
+// converts volumes of any volume_reader (raw, vgeo, segy, chunked) to the
+// bricked multi-resolution format (.bvol)
+// - works out-of-core: the source is read in slabs of one brick layer
+//   (plus apron), the next coarser level is written to a temporary raw file
+//   next to the output and converted the same way
+// - level generation supports the 8/16 bit unsigned and 32 bit float
+//   formats with one to four channels
+class __scm_export(gl_util) volume_writer_bricked
+{
+public:
+    volume_writer_bricked(const std::string&    file_path,
+                          unsigned              brick_size  = 64u,
+                          unsigned              apron       = 1u);
+    virtual ~volume_writer_bricked();
+
+    bool                        write(volume_reader& src);
+
+private:
+    bool                        write_level(volume_reader&                      src,
+                                            unsigned                            level,
+                                            const data::bricked_volume_level&   lvl,
+                                            const data::bricked_volume_brick_vec& bricks,
+                                            io::file&                           out_file,
+                                            const std::string&                  next_level_path);
+
+private:
+    std::string                 _file_path;
+    unsigned                    _brick_size;
+    unsigned                    _apron;
+
+}; // class volume_writer_bricked
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // #define SCM_GL_UTIL_VOLUME_WRITER_BRICKED_H_INCLUDED
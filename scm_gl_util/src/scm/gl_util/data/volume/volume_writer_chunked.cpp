@@ -0,0 +1,194 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "volume_writer_chunked.h"
+
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+#include <scm/core/io/file.h>
+
+#include <scm/gl_core/log.h>
+
+#include <scm/gl_util/data/volume/volume_reader.h>
+#include <scm/gl_util/utilities/parallel_for.h>
+
+namespace scm {
+namespace gl {
+
+volume_writer_chunked::volume_writer_chunked(const std::string&    file_path,
+                                             const math::vec3ui&   chunk_size,
+                                             data::chunk_codec     codec)
+  : _file_path(file_path)
+  , _chunk_size(math::max(chunk_size, math::vec3ui(1u)))
+  , _codec(codec)
+  , _uncompressed_size(0)
+  , _compressed_size(0)
+{
+}
+
+volume_writer_chunked::~volume_writer_chunked()
+{
+}
+
+bool
+volume_writer_chunked::write(volume_reader& src)
+{
+    using namespace scm::math;
+
+    _uncompressed_size = 0;
+    _compressed_size   = 0;
+
+    if (!src) {
+        glerr() << scm::log::error
+                << "volume_writer_chunked::write(): "
+                << "invalid source volume (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    const vec3ui        dims       = src.dimensions();
+    const scm::size_t   value_size = size_of_format(src.format());
+    const vec3ui        grid       = (dims + _chunk_size - vec3ui(1u)) / _chunk_size;
+
+    data::chunked_volume_header hdr;
+    memset(&hdr, 0, sizeof(data::chunked_volume_header));
+    memcpy(hdr._magic, data::chunked_volume_magic, sizeof(data::chunked_volume_magic));
+    hdr._version         = data::chunked_volume_version;
+    hdr._data_format     = static_cast<scm::uint32>(src.format());
+    hdr._bytes_per_voxel = static_cast<scm::uint32>(value_size);
+    hdr._codec           = static_cast<scm::uint32>(_codec);
+    hdr._chunk_count     =   static_cast<scm::uint64>(grid.x)
+                           * static_cast<scm::uint64>(grid.y)
+                           * static_cast<scm::uint64>(grid.z);
+    for (int c = 0; c < 3; ++c) {
+        hdr._dimensions[c] = dims[c];
+        hdr._chunk_size[c] = _chunk_size[c];
+    }
+
+    io::file out_file;
+
+    if (!out_file.open(_file_path, std::ios_base::out | std::ios_base::trunc, false)) {
+        glerr() << scm::log::error
+                << "volume_writer_chunked::write(): "
+                << "error opening output file (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    data::chunked_volume_chunk_vec  chunk_table(static_cast<size_t>(hdr._chunk_count));
+    io::file::offset_type           write_pos = sizeof(data::chunked_volume_header);
+
+    std::vector<scm::uint8>                 row_data;
+    std::vector<std::vector<scm::uint8> >   row_chunks(grid.x);
+    std::vector<data::chunk_codec>          row_codecs(grid.x);
+
+    _gather_buffers.resize(util::parallel_worker_count(grid.x));
+
+    for (unsigned z = 0; z < grid.z; ++z) {
+        for (unsigned y = 0; y < grid.y; ++y) {
+            const vec3ui row_origin(0u, y * _chunk_size.y, z * _chunk_size.z);
+            const vec3ui row_dim(dims.x,
+                                 min(_chunk_size.y, dims.y - row_origin.y),
+                                 min(_chunk_size.z, dims.z - row_origin.z));
+
+            row_data.resize(static_cast<size_t>(row_dim.x) * row_dim.y * row_dim.z * value_size);
+            if (!src.read(row_origin, row_dim, &row_data.front())) {
+                glerr() << scm::log::error
+                        << "volume_writer_chunked::write(): "
+                        << "error reading source volume (" << _file_path << ")." << scm::log::end;
+                return false;
+            }
+
+            util::parallel_for(grid.x,
+                               boost::bind(&volume_writer_chunked::compress_chunk, this,
+                                           &row_data, boost::cref(row_dim), value_size,
+                                           &row_chunks, &row_codecs, _1, _2));
+
+            for (unsigned x = 0; x < grid.x; ++x) {
+                const size_t                    c     = x + grid.x * (y + static_cast<size_t>(grid.y) * z);
+                const std::vector<scm::uint8>&  cdata = row_chunks[x];
+                const io::file::size_type       csize = static_cast<io::file::size_type>(cdata.size());
+
+                if (out_file.write(&cdata.front(), write_pos, csize) != csize) {
+                    glerr() << scm::log::error
+                            << "volume_writer_chunked::write(): "
+                            << "error writing chunk data (" << _file_path << ")." << scm::log::end;
+                    return false;
+                }
+
+                chunk_table[c]._offset = static_cast<scm::uint64>(write_pos);
+                chunk_table[c]._size   = static_cast<scm::uint32>(csize);
+                chunk_table[c]._codec  = static_cast<scm::uint32>(row_codecs[x]);
+
+                write_pos          += csize;
+                _compressed_size   += csize;
+            }
+            _uncompressed_size += static_cast<scm::int64>(row_data.size());
+        }
+    }
+
+    // chunk table at the end, then the final header
+    hdr._table_offset = static_cast<scm::uint64>(write_pos);
+
+    const io::file::size_type table_size = static_cast<io::file::size_type>(chunk_table.size() * sizeof(data::chunked_volume_chunk));
+
+    if (   (   table_size > 0
+            && out_file.write(&chunk_table.front(), write_pos, table_size) != table_size)
+        || out_file.write(&hdr, 0, sizeof(data::chunked_volume_header)) != sizeof(data::chunked_volume_header)) {
+        glerr() << scm::log::error
+                << "volume_writer_chunked::write(): "
+                << "error writing chunk table (" << _file_path << ")." << scm::log::end;
+        return false;
+    }
+
+    out_file.close();
+
+    return true;
+}
+
+scm::int64
+volume_writer_chunked::uncompressed_size() const
+{
+    return _uncompressed_size;
+}
+
+scm::int64
+volume_writer_chunked::compressed_size() const
+{
+    return _compressed_size;
+}
+
+void
+volume_writer_chunked::compress_chunk(const std::vector<scm::uint8>*          row_data,
+                                      const math::vec3ui&                     row_dim,
+                                      scm::size_t                             value_size,
+                                      std::vector<std::vector<scm::uint8> >*  row_chunks,
+                                      std::vector<data::chunk_codec>*         row_codecs,
+                                      scm::size_t                             i,
+                                      scm::size_t                             thread_index)
+{
+    using namespace scm::math;
+
+    // gather the chunk lines into a contiguous block
+    const unsigned      x0    = static_cast<unsigned>(i) * _chunk_size.x;
+    const unsigned      cdimx = min(_chunk_size.x, row_dim.x - x0);
+    const scm::size_t   line  = cdimx * value_size;
+
+    std::vector<scm::uint8>& gathered = _gather_buffers[thread_index];
+    gathered.resize(line * row_dim.y * row_dim.z);
+
+    for (unsigned z = 0; z < row_dim.z; ++z) {
+        for (unsigned y = 0; y < row_dim.y; ++y) {
+            const scm::size_t src_off = x0 + static_cast<scm::size_t>(row_dim.x) * (y + static_cast<scm::size_t>(row_dim.y) * z);
+            const scm::size_t dst_off = static_cast<scm::size_t>(cdimx) * (y + static_cast<scm::size_t>(row_dim.y) * z);
+
+            memcpy(&gathered[dst_off * value_size], &(*row_data)[src_off * value_size], line);
+        }
+    }
+
+    (*row_codecs)[i] = data::compress_chunk(&gathered.front(), gathered.size(), value_size, _codec, (*row_chunks)[i]);
+}
+
+} // namespace gl
+} // namespace scm
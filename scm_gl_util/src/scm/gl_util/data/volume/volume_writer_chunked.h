@@ -0,0 +1,69 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_VOLUME_WRITER_CHUNKED_H_INCLUDED
+#define SCM_GL_UTIL_VOLUME_WRITER_CHUNKED_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <scm/core/math.h>
+#include <scm/core/numeric_types.h>
+
+#include <scm/gl_util/data/volume/chunked/chunked_volume.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+
+class volume_reader;
+
+// converts volumes of any volume_reader (raw, vgeo, segy) to the chunked
+// compressed container format (.cvol)
+// - the source is read one row of chunks at a time, the chunks of a row
+//   are compressed in parallel
+class __scm_export(gl_util) volume_writer_chunked
+{
+public:
+    volume_writer_chunked(const std::string&    file_path,
+                          const math::vec3ui&   chunk_size  = math::vec3ui(64u),
+                          data::chunk_codec     codec       = data::CHUNK_CODEC_SHUFFLE_DELTA_LZ);
+    virtual ~volume_writer_chunked();
+
+    bool                        write(volume_reader& src);
+
+    // statistics of the last write
+    scm::int64                  uncompressed_size() const;
+    scm::int64                  compressed_size() const;
+
+private:
+    void                        compress_chunk(const std::vector<scm::uint8>*          row_data,
+                                               const math::vec3ui&                     row_dim,
+                                               scm::size_t                             value_size,
+                                               std::vector<std::vector<scm::uint8> >*  row_chunks,
+                                               std::vector<data::chunk_codec>*         row_codecs,
+                                               scm::size_t                             i,
+                                               scm::size_t                             thread_index);
+
+private:
+    std::string                             _file_path;
+    math::vec3ui                            _chunk_size;
+    data::chunk_codec                       _codec;
+
+    scm::int64                              _uncompressed_size;
+    scm::int64                              _compressed_size;
+
+    // per compression thread chunk gather buffers
+    std::vector<std::vector<scm::uint8> >   _gather_buffers;
+
+}; // class volume_writer_chunked
+
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // #define SCM_GL_UTIL_VOLUME_WRITER_CHUNKED_H_INCLUDED
@@ -0,0 +1,226 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#include "parallel_for.h"
+
+#include <deque>
+#include <exception>
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/bind.hpp>
+#include <boost/utility.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/thread/thread.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/math.h>
+#include <scm/core/memory.h>
+
+namespace {
+
+// state of one parallel_for call, shared with the pool threads joining it
+struct parallel_loop : boost::noncopyable
+{
+    parallel_loop(const scm::gl::util::parallel_task& task, scm::size_t count)
+      : _task(task), _count(count), _next(0), _next_thread(1), _active(0) {}
+
+    const scm::gl::util::parallel_task& _task;          // valid while tasks are left
+    const scm::size_t                   _count;
+    scm::size_t                         _next;          // next task to run
+    scm::size_t                         _next_thread;   // thread index of the next joining thread
+    scm::size_t                         _active;        // pool threads working on the loop
+
+    std::exception_ptr                  _exception;    // first exception thrown by a task
+
+    boost::mutex                        _mutex;
+    boost::condition_variable           _pool_done;
+}; // struct parallel_loop
+
+typedef scm::shared_ptr<parallel_loop>  parallel_loop_ptr;
+
+// a throwing task stops the loop, the remaining tasks are skipped
+void
+run_tasks(parallel_loop& loop, scm::size_t thread_index)
+{
+    try {
+        while (true) {
+            scm::size_t i = 0;
+            {
+                boost::mutex::scoped_lock lock(loop._mutex);
+                if (loop._next >= loop._count) {
+                    return;
+                }
+                i = loop._next++;
+            }
+            loop._task(i, thread_index);
+        }
+    }
+    catch (...) {
+        boost::mutex::scoped_lock lock(loop._mutex);
+        if (!loop._exception) {
+            loop._exception = std::current_exception();
+        }
+        loop._next = loop._count;
+    }
+}
+
+// executed by a pool thread, loops without tasks left are not joined (the
+// task function may be gone already), exceptions are passed to the loop
+void
+join_loop(const parallel_loop_ptr& loop)
+{
+    scm::size_t thread_index = 0;
+    {
+        boost::mutex::scoped_lock lock(loop->_mutex);
+        if (loop->_next >= loop->_count) {
+            return;
+        }
+        thread_index = loop->_next_thread++;
+        ++loop->_active;
+    }
+
+    run_tasks(*loop, thread_index);
+
+    boost::mutex::scoped_lock lock(loop->_mutex);
+    --loop->_active;
+    loop->_pool_done.notify_all();
+}
+
+class worker_pool : boost::noncopyable
+{
+public:
+    typedef boost::function<void ()>    task;
+
+public:
+    worker_pool(scm::size_t thread_count)
+      : _thread_count(thread_count)
+      , _shutdown(false)
+    {
+        for (scm::size_t i = 0; i < _thread_count; ++i) {
+            _threads.create_thread(boost::bind(&worker_pool::worker, this));
+        }
+    }
+    ~worker_pool()
+    {
+        {
+            boost::mutex::scoped_lock   lock(_mutex);
+            _shutdown = true;
+            _tasks.clear();
+        }
+        _task_pending.notify_all();
+        _threads.join_all();
+    }
+
+    void submit(const task& t)
+    {
+        {
+            boost::mutex::scoped_lock   lock(_mutex);
+            _tasks.push_back(t);
+        }
+        _task_pending.notify_one();
+    }
+
+    scm::size_t thread_count() const
+    {
+        return _thread_count;
+    }
+
+private:
+    void worker()
+    {
+        while (true) {
+            task    next_task;
+            {
+                boost::mutex::scoped_lock   lock(_mutex);
+
+                while (!_shutdown && _tasks.empty()) {
+                    _task_pending.wait(lock);
+                }
+                if (_shutdown) {
+                    break;
+                }
+                next_task = _tasks.front();
+                _tasks.pop_front();
+            }
+
+            next_task();
+        }
+    }
+
+private:
+    boost::mutex                _mutex;
+    boost::condition_variable   _task_pending;
+
+    std::deque<task>            _tasks;
+    boost::thread_group         _threads;
+    scm::size_t                 _thread_count;
+    bool                        _shutdown;
+
+}; // class worker_pool
+
+scm::scoped_ptr<worker_pool>    global_worker_pool;
+boost::once_flag                global_worker_pool_flag = BOOST_ONCE_INIT;
+
+void
+create_worker_pool()
+{
+    const scm::size_t hw = boost::thread::hardware_concurrency();
+    global_worker_pool.reset(new worker_pool(hw > 1 ? hw - 1 : 0));
+}
+
+worker_pool&
+parallel_worker_pool()
+{
+    boost::call_once(create_worker_pool, global_worker_pool_flag);
+    return *global_worker_pool;
+}
+
+} // namespace
+
+namespace scm {
+namespace gl {
+namespace util {
+
+scm::size_t
+parallel_worker_count(scm::size_t count)
+{
+    return math::max<scm::size_t>(1, math::min(count, parallel_worker_pool().thread_count() + 1));
+}
+
+void
+parallel_for(scm::size_t            count,
+             const parallel_task&   task)
+{
+    const scm::size_t workers = parallel_worker_count(count);
+
+    parallel_loop_ptr loop(new parallel_loop(task, count));
+
+    if (workers > 1) {
+        worker_pool& pool = parallel_worker_pool();
+        for (scm::size_t t = 1; t < workers; ++t) {
+            pool.submit(boost::bind(join_loop, loop));
+        }
+    }
+
+    // the calling thread takes part in the work
+    run_tasks(*loop, 0);
+
+    {
+        // all tasks are taken, wait for the pool threads still working on the loop
+        boost::mutex::scoped_lock lock(loop->_mutex);
+        while (loop->_active > 0) {
+            loop->_pool_done.wait(lock);
+        }
+    }
+
+    if (loop->_exception) {
+        std::rethrow_exception(loop->_exception);
+    }
+}
+
+} // namespace util
+} // namespace gl
+} // namespace scm
@@ -0,0 +1,43 @@
+
+// Copyright (c) 2012 Christopher Lux <christopherlux@gmail.com>
+// Distributed under the Modified BSD License, see license.txt.
+
+#ifndef SCM_GL_UTIL_PARALLEL_FOR_H_INCLUDED
+#define SCM_GL_UTIL_PARALLEL_FOR_H_INCLUDED
+
+#include <scm/core/utilities/boost_warning_disable.h>
+#include <boost/function.hpp>
+#include <scm/core/utilities/boost_warning_enable.h>
+
+#include <scm/core/numeric_types.h>
+
+#include <scm/core/platform/platform.h>
+#include <scm/core/utilities/platform_warning_disable.h>
+
+namespace scm {
+namespace gl {
+namespace util {
+
+// parallel loops on a process wide pool of worker threads
+// - parallel_for runs task(i, thread_index) for all i in [0, count) and
+//   returns when all tasks are done, the calling thread takes part in the work
+// - the first exception thrown by a task is rethrown in the calling thread,
+//   the tasks not started at that point are skipped
+// - thread_index is unique among the threads working on one loop and below
+//   parallel_worker_count(count), so tasks can use per thread scratch memory
+// - the pool holds hardware concurrency - 1 threads started on first use,
+//   concurrent loops (from several threads or nested in tasks) share them, a
+//   loop never waits for pool threads busy with other loops
+typedef boost::function<void (scm::size_t, scm::size_t)>  parallel_task;
+
+__scm_export(gl_util) scm::size_t   parallel_worker_count(scm::size_t count);
+__scm_export(gl_util) void          parallel_for(scm::size_t            count,
+                                                 const parallel_task&   task);
+
+} // namespace util
+} // namespace gl
+} // namespace scm
+
+#include <scm/core/utilities/platform_warning_enable.h>
+
+#endif // SCM_GL_UTIL_PARALLEL_FOR_H_INCLUDED